@@ -1,12 +1,20 @@
 #pragma once
 
 #include "odb-cli/Actions.argdef.hpp"
+#include <memory>
 
 namespace odb::ast {
 class Block;
 }
+namespace odb::ir {
+class Program;
+}
 
 bool initCommandMatcher(const std::vector<std::string>& args);
+bool setParseJobs(const std::vector<std::string>& args);
+bool setASTCacheDir(const std::vector<std::string>& args);
+bool enableFastScanner(const std::vector<std::string>& args);
+bool enableStreaming(const std::vector<std::string>& args);
 bool parseDBA(const std::vector<std::string>& args);
 bool dumpASTDOT(const std::vector<std::string>& args);
 bool dumpASTJSON(const std::vector<std::string>& args);
@@ -15,3 +23,9 @@ ActionHandler parseDBPro(const std::vector<std::string>& args);
 ActionHandler autoDetectInput(const std::vector<std::string>& args);
 
 const odb::ast::Block* getAST();
+
+/*!
+ * The program produced while parsing with --stream, or nullptr if the AST was
+ * built instead.
+ */
+std::unique_ptr<odb::ir::Program> takeProgram();
@@ -6,4 +6,7 @@
 bool setOutputType(const std::vector<std::string>& args);
 bool setArch(const std::vector<std::string>& args);
 bool setPlatform(const std::vector<std::string>& args);
+bool setOptimizationLevel(const std::vector<std::string>& args);
+bool setCPU(const std::vector<std::string>& args);
+bool setCPUFeatures(const std::vector<std::string>& args);
 bool output(const std::vector<std::string>& args);
@@ -7,6 +7,8 @@ namespace odb::cmd {
     class CommandIndex;
 }
 
+bool setCommandCacheFile(const std::vector<std::string>& args);
+void setCommandLoadJobs(int jobs);
 bool loadCommands(const std::vector<std::string>& args);
 bool dumpCommandsJSON(const std::vector<std::string>& args);
 bool dumpCommandsINI(const std::vector<std::string> &args);
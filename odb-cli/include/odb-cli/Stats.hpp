@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+bool enableTimeReport(const std::vector<std::string>& args);
+bool enableStats(const std::vector<std::string>& args);
+bool setStatsJSONFile(const std::vector<std::string>& args);
+bool setTraceFile(const std::vector<std::string>& args);
+
+/*!
+ * Prints the reports requested with --time-report and --stats and writes the
+ * --stats-json and --trace files. Called once all actions have run, including
+ * when one of them failed.
+ */
+bool writeStatsReports();
@@ -1,19 +1,40 @@
 #include "odb-cli/AST.hpp"
 #include "odb-cli/Commands.hpp"
+#include "odb-compiler/ast/ASTCache.hpp"
+#include "odb-compiler/ast/Atom.hpp"
 #include "odb-compiler/ast/Block.hpp"
 #include "odb-compiler/ast/Exporters.hpp"
+#include "odb-compiler/ast/SourceFileTable.hpp"
+#include "odb-compiler/ir/SemanticChecker.hpp"
 #include "odb-compiler/parsers/db/Driver.hpp"
 #include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/Stats.hpp"
 #include "odb-sdk/Log.hpp"
+#include "odb-sdk/MappedFile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <thread>
 
 using namespace odb;
 
+// Statics are destroyed in reverse order, so this has to come before anything
+// holding an AST or IR for the identifiers to outlive them
+static ast::AtomTable::Scope atomScope_;
 static cmd::CommandMatcher cmdMatcher_;
 static Reference<ast::Block> ast_;
+static int parseJobs_ = 1;
+static std::string astCacheDir_;
+static bool useFastScanner_ = false;
+static bool streaming_ = false;
+static std::unique_ptr<ir::Program> program_;
 
 // ----------------------------------------------------------------------------
 bool initCommandMatcher(const std::vector<std::string>& args)
 {
+    PhaseTimer timer("init command matcher");
     Log::ast(Log::INFO, "Updating command matcher\n");
     cmdMatcher_.updateFromIndex(getCommandIndex());
 
@@ -21,16 +42,192 @@ bool initCommandMatcher(const std::vector<std::string>& args)
 }
 
 // ----------------------------------------------------------------------------
-bool parseDBA(const std::vector<std::string>& args)
+bool setParseJobs(const std::vector<std::string>& args)
+{
+    char* end;
+    long jobs = strtol(args[0].c_str(), &end, 10);
+    if (args[0].empty() || *end != '\0' || jobs < 0)
+    {
+        Log::ast(Log::ERROR, "Error: Invalid number of jobs `%s`\n", args[0].c_str());
+        return false;
+    }
+
+    // 0 means use all cores. hardware_concurrency() may return 0 if it can't
+    // be determined
+    if (jobs == 0)
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    parseJobs_ = (int)jobs;
+    setCommandLoadJobs((int)jobs);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool setASTCacheDir(const std::vector<std::string>& args)
+{
+    astCacheDir_ = args[0];
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool enableFastScanner(const std::vector<std::string>& args)
+{
+    useFastScanner_ = true;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool enableStreaming(const std::vector<std::string>& args)
+{
+    streaming_ = true;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static ast::Block* parseFile(db::FileParserDriver* driver,
+                             const std::string& fileName,
+                             const ast::ASTCache* cache)
+{
+    PhaseTimer timer("parse", fileName);
+    if (cache == nullptr)
+    {
+        Log::ast(Log::INFO, "Parsing file `%s`\n", fileName.c_str());
+        return driver->parse(fileName, cmdMatcher_);
+    }
+
+    // The contents are needed to look up the cache entry. If the file can't
+    // be opened, let the driver report it
+    Reference<MappedFile> file = MappedFile::open(fileName.c_str());
+    if (file.isNull())
+        return driver->parse(fileName, cmdMatcher_);
+
+    // Registering the mapping means the locations of a cached AST refer to
+    // it, so diagnostics don't need to read the file again. The locations
+    // hold their own references, this one is only needed during the load.
+    std::string_view source(file->data(), file->size());
+    ast::SourceFileId id = ast::SourceFileTable::addFile(fileName, file);
+    ast::Block* block = cache->load(fileName, source);
+    ast::SourceFileTable::release(id);
+    if (block)
+    {
+        Log::ast(Log::INFO, "Loaded file `%s` from AST cache\n", fileName.c_str());
+        return block;
+    }
+
+    // The driver scans the mapping that was already read for the lookup
+    Log::ast(Log::INFO, "Parsing file `%s`\n", fileName.c_str());
+    block = driver->parse(file, cmdMatcher_);
+    if (block)
+        cache->store(fileName, source, block);
+    return block;
+}
+
+// ----------------------------------------------------------------------------
+static bool parseFilesSequential(const std::vector<std::string>& fileNames,
+                                 std::vector<Reference<ast::Block>>* blocks,
+                                 const ast::ASTCache* cache)
 {
     db::FileParserDriver driver;
-    for (const auto& arg : args)
+    driver.setUseMemoryMap(true);
+    driver.setUseFastScanner(useFastScanner_);
+    for (size_t i = 0; i != fileNames.size(); ++i)
     {
-        Log::ast(Log::INFO, "Parsing file `%s`\n", arg.c_str());
-        Reference<ast::Block> block = driver.parse(arg, cmdMatcher_);
+        (*blocks)[i] = parseFile(&driver, fileNames[i], cache);
+        if ((*blocks)[i] == nullptr)
+            return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static bool parseFilesParallel(const std::vector<std::string>& fileNames,
+                               std::vector<Reference<ast::Block>>* blocks,
+                               const ast::ASTCache* cache,
+                               int jobs)
+{
+    // Each file gets its own driver, and with it its own reentrant scanner
+    // and push parser instance. The command matcher is only ever read from
+    // so it can be shared between all threads. Each thread writes its result
+    // into the slot belonging to the file, so the order of the blocks does
+    // not depend on which thread finishes first.
+    std::atomic<size_t> nextFile(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        db::FileParserDriver driver;
+        driver.setUseMemoryMap(true);
+        driver.setUseFastScanner(useFastScanner_);
+        for (size_t i = nextFile++; i < fileNames.size() && !failed; i = nextFile++)
+        {
+            (*blocks)[i] = parseFile(&driver, fileNames[i], cache);
+            if ((*blocks)[i] == nullptr)
+                failed = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    jobs = std::min(jobs, (int)fileNames.size());
+    for (int i = 0; i != jobs; ++i)
+        threads.emplace_back(worker);
+    for (auto& thread : threads)
+        thread.join();
+
+    return !failed;
+}
+
+// ----------------------------------------------------------------------------
+static bool parseFilesStreaming(const std::vector<std::string>& fileNames)
+{
+    // Statements are converted on another thread while the parser continues
+    ir::SemanticCheckPipeline pipeline(*getCommandIndex());
+    db::FileParserDriver driver;
+    driver.setUseMemoryMap(true);
+    driver.setUseFastScanner(useFastScanner_);
+    driver.setStatementConsumer(&pipeline);
+    for (const auto& fileName : fileNames)
+    {
+        PhaseTimer timer("parse", fileName);
+        Log::ast(Log::INFO, "Parsing file `%s`\n", fileName.c_str());
+        Reference<ast::Block> block = driver.parse(fileName, cmdMatcher_);
         if (block == nullptr)
             return false;
+    }
+
+    // Whatever the semantic checks couldn't do while parsing
+    PhaseTimer timer("finish semantic checks");
+    program_ = pipeline.finish();
+    return program_ != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+bool parseDBA(const std::vector<std::string>& args)
+{
+    PhaseTimer timer("parse");
+    if (streaming_)
+        return parseFilesStreaming(args);
+
+    std::unique_ptr<ast::ASTCache> cache;
+    if (!astCacheDir_.empty())
+        cache = std::make_unique<ast::ASTCache>(astCacheDir_, *getCommandIndex());
+
+    std::vector<Reference<ast::Block>> blocks(args.size());
+    if (parseJobs_ > 1 && args.size() > 1)
+    {
+        Log::ast(Log::INFO, "Parsing %d files using %d jobs\n",
+                 (int)args.size(), std::min(parseJobs_, (int)args.size()));
+        if (!parseFilesParallel(args, &blocks, cache.get(), parseJobs_))
+            return false;
+    }
+    else
+    {
+        if (!parseFilesSequential(args, &blocks, cache.get()))
+            return false;
+    }
 
+    // Merge in the order the files were given on the command line, so the
+    // resulting AST is identical to parsing them one after another
+    for (const auto& block : blocks)
+    {
         if (ast_.isNull())
             ast_ = block;
         else
@@ -123,3 +320,8 @@ bool dumpASTJSON(const std::vector<std::string>& args)
 const odb::ast::Block* getAST() {
     return ast_;
 }
+
+// ----------------------------------------------------------------------------
+std::unique_ptr<odb::ir::Program> takeProgram() {
+    return std::move(program_);
+}
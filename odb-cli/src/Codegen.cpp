@@ -5,6 +5,8 @@
 #include "odb-compiler/ir/Codegen.hpp"
 #include "odb-compiler/ir/Node.hpp"
 #include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/irpost/Process.hpp"
+#include "odb-compiler/Stats.hpp"
 #include "odb-sdk/Log.hpp"
 
 #include <fstream>
@@ -13,6 +15,8 @@
 static odb::ir::OutputType outputType_ = odb::ir::OutputType::ObjectFile;
 static std::optional<odb::ir::TargetTriple::Arch> targetTripleArch_;
 static std::optional<odb::ir::TargetTriple::Platform> targetTriplePlatform_;
+static odb::ir::CodegenOptions codegenOptions_;
+static bool cpuFeaturesSet_ = false;
 
 // ----------------------------------------------------------------------------
 bool setOutputType(const std::vector<std::string>& args)
@@ -75,6 +79,53 @@ bool setPlatform(const std::vector<std::string>& args)
     return true;
 }
 
+// ----------------------------------------------------------------------------
+bool setOptimizationLevel(const std::vector<std::string>& args)
+{
+    if (args[0] == "0")
+    {
+        codegenOptions_.optimizationLevel = odb::ir::OptimizationLevel::O0;
+    }
+    else if (args[0] == "1")
+    {
+        codegenOptions_.optimizationLevel = odb::ir::OptimizationLevel::O1;
+    }
+    else if (args[0] == "2")
+    {
+        codegenOptions_.optimizationLevel = odb::ir::OptimizationLevel::O2;
+    }
+    else if (args[0] == "3")
+    {
+        codegenOptions_.optimizationLevel = odb::ir::OptimizationLevel::O3;
+    }
+    else if (args[0] == "s")
+    {
+        codegenOptions_.optimizationLevel = odb::ir::OptimizationLevel::Os;
+    }
+    else
+    {
+        odb::Log::codegen(odb::Log::ERROR, "Unknown optimization level `%s`\n", args[0].c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool setCPU(const std::vector<std::string>& args)
+{
+    codegenOptions_.cpu = args[0];
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool setCPUFeatures(const std::vector<std::string>& args)
+{
+    codegenOptions_.features = args[0];
+    cpuFeaturesSet_ = true;
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 bool output(const std::vector<std::string>& args)
 {
@@ -142,13 +193,36 @@ bool output(const std::vector<std::string>& args)
         }
     }
 
-    // Generate IR program, then generate code.
-    auto program = odb::ir::runSemanticChecks(ast, *cmdIndex);
-    if (program)
+    // Targeting the host CPU without its features would miss out on most of
+    // what makes it worth targeting
+    if (codegenOptions_.cpu == "native" && !cpuFeaturesSet_)
+    {
+        codegenOptions_.features = "native";
+    }
+
+    // Generate IR program, then generate code. With --stream, this already
+    // happened while parsing.
+    auto program = takeProgram();
+    if (!program)
+    {
+        odb::PhaseTimer timer("semantic checks");
+        program = odb::ir::runSemanticChecks(ast, *cmdIndex);
+    }
+    if (!program)
+    {
+        return false;
+    }
+
+    bool processed;
+    {
+        odb::PhaseTimer timer("ir passes");
+        processed = odb::irpost::createDefaultProcessGroup().execute(program.get());
+    }
+    if (processed)
     {
         return odb::ir::generateCode(getSDKType(), outputType_,
                                      odb::ir::TargetTriple{*targetTripleArch_, *targetTriplePlatform_}, outputStream,
-                                     "input.dba", *program, *cmdIndex);
+                                     "input.dba", *program, *cmdIndex, codegenOptions_);
     }
 
     return false;
@@ -3,16 +3,33 @@
 #include "odb-compiler/commands/CommandIndex.hpp"
 #include "odb-compiler/commands/ODBCommandLoader.hpp"
 #include "odb-compiler/commands/DBPCommandLoader.hpp"
+#include "odb-compiler/Stats.hpp"
 #include "odb-sdk/Log.hpp"
 #include <algorithm>
 
 using namespace odb;
 
 static cmd::CommandIndex cmdIndex_;
+static std::string commandCacheFile_;
+static int loadJobs_ = 0;
+
+// ----------------------------------------------------------------------------
+bool setCommandCacheFile(const std::vector<std::string>& args)
+{
+    commandCacheFile_ = args[0];
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void setCommandLoadJobs(int jobs)
+{
+    loadJobs_ = jobs;
+}
 
 // ----------------------------------------------------------------------------
 bool loadCommands(const std::vector<std::string>& args)
 {
+    PhaseTimer timer("load commands");
     std::unique_ptr<odb::cmd::CommandLoader> loader;
     switch (getSDKType())
     {
@@ -24,6 +41,10 @@ bool loadCommands(const std::vector<std::string>& args)
             break;
     }
 
+    if (!commandCacheFile_.empty())
+        loader->setCommandCacheFile(commandCacheFile_);
+    loader->setJobs(loadJobs_);
+
     if (loader->populateIndex(&cmdIndex_) == false)
         return false;
 
@@ -0,0 +1,230 @@
+#include "odb-cli/Stats.hpp"
+#include "odb-compiler/Stats.hpp"
+#include "odb-compiler/Trace.hpp"
+#include "odb-sdk/Log.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace odb;
+
+static bool printTimeReport_ = false;
+static bool printStats_ = false;
+static std::string jsonFile_;
+static std::string traceFile_;
+static std::chrono::steady_clock::time_point startWall_;
+
+// ----------------------------------------------------------------------------
+static void enable()
+{
+    if (Stats::enabled())
+        return;
+
+    Stats::setEnabled(true);
+    startWall_ = std::chrono::steady_clock::now();
+}
+
+// ----------------------------------------------------------------------------
+bool enableTimeReport(const std::vector<std::string>& args)
+{
+    printTimeReport_ = true;
+    enable();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool enableStats(const std::vector<std::string>& args)
+{
+    printStats_ = true;
+    enable();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool setStatsJSONFile(const std::vector<std::string>& args)
+{
+    jsonFile_ = args[0];
+    enable();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool setTraceFile(const std::vector<std::string>& args)
+{
+    traceFile_ = args[0];
+    Trace::setEnabled(true);
+
+    // Makes sure the main thread is the first one in the trace
+    Trace::threadId();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static double totalWallSeconds()
+{
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - startWall_;
+    return wall.count();
+}
+
+// ----------------------------------------------------------------------------
+static void printTimeReport(const std::vector<Stats::Timing>& timings)
+{
+    Log::info.print(Log::FG_BRIGHT_WHITE, "Time report:\n");
+    Log::info.print("  %-40s %10s %10s\n", "Phase", "Wall (s)", "CPU (s)");
+    for (const auto& timing : timings)
+        if (timing.file.empty())
+            Log::info.print("  %-40s %10.4f %10.4f\n", timing.phase.c_str(), timing.wallSeconds, timing.cpuSeconds);
+    Log::info.print("  %-40s %10.4f %10.4f\n", "total", totalWallSeconds(), Stats::processCPUTime());
+
+    bool hasFiles = false;
+    for (const auto& timing : timings)
+    {
+        if (timing.file.empty())
+            continue;
+
+        if (!hasFiles)
+        {
+            Log::info.print("  %-40s %10s %10s\n", "File", "Wall (s)", "CPU (s)");
+            hasFiles = true;
+        }
+        std::string name = timing.phase + " " + timing.file;
+        Log::info.print("  %-40s %10.4f %10.4f\n", name.c_str(), timing.wallSeconds, timing.cpuSeconds);
+    }
+}
+
+// ----------------------------------------------------------------------------
+static void printStats()
+{
+    Log::info.print(Log::FG_BRIGHT_WHITE, "Statistics:\n");
+    for (int i = 0; i != Stats::COUNTER_COUNT; ++i)
+    {
+        Stats::Counter counter = (Stats::Counter)i;
+        Log::info.print("  %-40s %12llu\n", Stats::description(counter), (unsigned long long)Stats::get(counter));
+    }
+    Log::info.print("  %-40s %8.1f MiB\n", "Peak resident set size", Stats::peakResidentSetSize() / (1024.0 * 1024.0));
+}
+
+// ----------------------------------------------------------------------------
+static void writeJSONString(FILE* fp, const std::string& str)
+{
+    fputc('"', fp);
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if ((unsigned char)c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+// ----------------------------------------------------------------------------
+static bool writeJSON(const std::vector<Stats::Timing>& timings)
+{
+    FILE* fp = fopen(jsonFile_.c_str(), "w");
+    if (fp == nullptr)
+    {
+        Log::info.print("Error: Failed to open file `%s`\n", jsonFile_.c_str());
+        return false;
+    }
+
+    fprintf(fp, "{\n  \"phases\": [");
+    const char* sep = "\n";
+    for (const auto& timing : timings)
+    {
+        if (!timing.file.empty())
+            continue;
+        fprintf(fp, "%s    {\"name\": ", sep);
+        writeJSONString(fp, timing.phase);
+        fprintf(fp, ", \"wall\": %.6f, \"cpu\": %.6f}", timing.wallSeconds, timing.cpuSeconds);
+        sep = ",\n";
+    }
+    fprintf(fp, "\n  ],\n  \"files\": [");
+    sep = "\n";
+    for (const auto& timing : timings)
+    {
+        if (timing.file.empty())
+            continue;
+        fprintf(fp, "%s    {\"phase\": ", sep);
+        writeJSONString(fp, timing.phase);
+        fprintf(fp, ", \"file\": ");
+        writeJSONString(fp, timing.file);
+        fprintf(fp, ", \"wall\": %.6f, \"cpu\": %.6f}", timing.wallSeconds, timing.cpuSeconds);
+        sep = ",\n";
+    }
+    fprintf(fp, "\n  ],\n  \"total\": {\"wall\": %.6f, \"cpu\": %.6f},\n", totalWallSeconds(), Stats::processCPUTime());
+
+    fprintf(fp, "  \"counters\": {\n");
+    for (int i = 0; i != Stats::COUNTER_COUNT; ++i)
+    {
+        Stats::Counter counter = (Stats::Counter)i;
+        fprintf(fp, "    \"%s\": %llu,\n", Stats::key(counter), (unsigned long long)Stats::get(counter));
+    }
+    fprintf(fp, "    \"peak_rss_bytes\": %llu\n  }\n}\n", (unsigned long long)Stats::peakResidentSetSize());
+
+    bool success = ferror(fp) == 0;
+    if (fclose(fp) != 0 || !success)
+    {
+        Log::info.print("Error: Failed to write file `%s`\n", jsonFile_.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static bool writeTrace()
+{
+    FILE* fp = fopen(traceFile_.c_str(), "w");
+    if (fp == nullptr)
+    {
+        Log::info.print("Error: Failed to open file `%s`\n", traceFile_.c_str());
+        return false;
+    }
+
+    // Chrome trace event format. Every event is a complete event ("X") with
+    // its start and duration in microseconds
+    fprintf(fp, "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [\n");
+    fprintf(fp, "    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"main\"}}",
+            Trace::threadId());
+    for (const auto& event : Trace::events())
+    {
+        fprintf(fp, ",\n    {\"name\": ");
+        writeJSONString(fp, event.name);
+        fprintf(fp, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %lld, \"dur\": %lld, \"pid\": 1, \"tid\": %u}",
+                event.category, (long long)event.startMicros, (long long)event.durationMicros, event.threadId);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+
+    bool success = ferror(fp) == 0;
+    if (fclose(fp) != 0 || !success)
+    {
+        Log::info.print("Error: Failed to write file `%s`\n", traceFile_.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool writeStatsReports()
+{
+    bool success = true;
+    if (Trace::enabled() && !writeTrace())
+        success = false;
+
+    if (!Stats::enabled())
+        return success;
+
+    std::vector<Stats::Timing> timings = Stats::timings();
+    if (printTimeReport_)
+        printTimeReport(timings);
+    if (printStats_)
+        printStats();
+    if (!jsonFile_.empty() && !writeJSON(timings))
+        success = false;
+
+    return success;
+}
@@ -1,11 +1,15 @@
 #include "odb-cli/Actions.argdef.hpp"
+#include "odb-cli/Stats.hpp"
 #include "odb-sdk/Log.hpp"
 
 // ----------------------------------------------------------------------------
 int main(int argc, char** argv)
 {
-    if (parseCommandLine(argc, argv) == false)
-        return -1;
+    // Reports are also written if compilation failed, since knowing how far
+    // it got can be just as interesting
+    bool success = parseCommandLine(argc, argv);
+    if (writeStatsReports() == false)
+        success = false;
 
-    return 0;
+    return success ? 0 : -1;
 }
@@ -0,0 +1,85 @@
+/*
+ * Renders 10k diagnostics spread over a large generated source and compares
+ * the line index lookup against seeking from the start of the source for
+ * every diagnostic.
+ *
+ * Usage: odbc_bench_diagnostics [lines] [diagnostics]
+ */
+#include "odb-compiler/ast/SourceFileTable.hpp"
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-sdk/Log.hpp"
+#include "odb-sdk/Reference.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace odb;
+
+// ----------------------------------------------------------------------------
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    int lineCount = argc > 1 ? atoi(argv[1]) : 50000;
+    int diagnosticCount = argc > 2 ? atoi(argv[2]) : 10000;
+    if (lineCount < 1 || diagnosticCount < 1)
+    {
+        fprintf(stderr, "Usage: %s [lines] [diagnostics]\n", argv[0]);
+        return 1;
+    }
+
+    std::string code;
+    for (int i = 0; i != lineCount; ++i)
+        code += "loop object " + std::to_string(i) + ", 1, " + std::to_string(i * 3) + "\n";
+
+    // Spread the diagnostics evenly over the file
+    std::vector<int> lines;
+    for (int i = 0; i != diagnosticCount; ++i)
+        lines.push_back(1 + (int)((long long)i * lineCount / diagnosticCount));
+
+    FILE* devnull = fopen("/dev/null", "w");
+    if (devnull == nullptr)
+        devnull = tmpfile();
+    Log log(devnull);
+
+    // Line index
+    auto start = std::chrono::steady_clock::now();
+    ast::SourceFileId id = ast::SourceFileTable::addString("bench.dba", code);
+    for (int line : lines)
+    {
+        Reference<ast::SourceLocation> location = new ast::SourceLocation(id, line, line, 1, 5);
+        location->printUnderlinedSection(log);
+    }
+    double indexed = secondsSince(start);
+    ast::SourceFileTable::release(id);
+
+    // What rendering used to cost: getline() from the start of the source up
+    // to the diagnostic's line
+    start = std::chrono::steady_clock::now();
+    size_t checksum = 0;
+    for (int line : lines)
+    {
+        std::istringstream ss(code);
+        std::string text;
+        for (int l = 0; l < line; ++l)
+            std::getline(ss, text);
+        checksum += text.size();
+    }
+    double rescan = secondsSince(start);
+
+    printf("%d diagnostics over %d lines (%zu bytes)\n", diagnosticCount, lineCount, code.size());
+    printf("line index: %10.3fms (%.3fus/diagnostic)\n", indexed * 1000.0, indexed * 1e6 / diagnosticCount);
+    printf("rescan:     %10.3fms (%.3fus/diagnostic, seek only)\n", rescan * 1000.0, rescan * 1e6 / diagnosticCount);
+    printf("speedup:    %10.1fx\n", rescan / indexed);
+
+    fclose(devnull);
+    return checksum == 0;
+}
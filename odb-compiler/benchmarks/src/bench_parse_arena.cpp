@@ -0,0 +1,114 @@
+/*
+ * Compares parsing a DBA file with and without the AST arena.
+ *
+ * Usage: odbc_bench_parse_arena <file.dba> [odb-sdk-root] [iterations]
+ *
+ * If an SDK root is given, commands are loaded from its plugins so that files
+ * such as dba-sources/iced.dba parse the same way they would in odbc.
+ */
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/commands/ODBCommandLoader.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-sdk/Log.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace odb;
+
+static std::atomic<long> allocationCount_(0);
+
+// Count every heap allocation made by the process, including those made by
+// odb-compiler and odb-sdk
+void* operator new(size_t size)
+{
+    allocationCount_++;
+    if (void* ptr = malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+struct Result
+{
+    double seconds;
+    long allocations;
+};
+
+// ----------------------------------------------------------------------------
+static bool run(const std::string& fileName, const cmd::CommandMatcher& matcher,
+                bool useArena, int iterations, Result* result)
+{
+    db::FileParserDriver driver;
+    driver.setUseArena(useArena);
+
+    long allocationsBefore = allocationCount_;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != iterations; ++i)
+    {
+        // Destroying the AST is part of the measurement, since freeing the
+        // arena in bulk is one of the things being compared
+        Reference<ast::Block> ast = driver.parse(fileName, matcher);
+        if (ast == nullptr)
+            return false;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result->seconds = std::chrono::duration<double>(end - start).count() / iterations;
+    result->allocations = (allocationCount_ - allocationsBefore) / iterations;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <file.dba> [odb-sdk-root] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    std::string fileName = argv[1];
+    int iterations = argc > 3 ? atoi(argv[3]) : 20;
+    if (iterations < 1)
+        iterations = 1;
+
+    cmd::CommandIndex index;
+    if (argc > 2)
+    {
+        cmd::ODBCommandLoader loader(argv[2]);
+        if (!loader.populateIndex(&index))
+            return 1;
+    }
+    cmd::CommandMatcher matcher;
+    matcher.updateFromIndex(&index);
+
+    Result heap, arena;
+    if (!run(fileName, matcher, false, iterations, &heap))
+        return 1;
+    if (!run(fileName, matcher, true, iterations, &arena))
+        return 1;
+
+    printf("%-8s %14s %14s\n", "mode", "time/parse", "allocs/parse");
+    printf("%-8s %12.3fms %14ld\n", "heap", heap.seconds * 1000.0, heap.allocations);
+    printf("%-8s %12.3fms %14ld\n", "arena", arena.seconds * 1000.0, arena.allocations);
+    printf("speedup: %.2fx, allocations: %.1f%%\n",
+           heap.seconds / arena.seconds,
+           100.0 * arena.allocations / heap.allocations);
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * Times the semantic checks and code generation of a generated program. Both
+ * passes pick the class of every node they visit by its kind, so run this
+ * before and after changing how nodes are dispatched.
+ *
+ * Usage: odbc_bench_semantic_codegen [statements] [iterations]
+ */
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/ir/Codegen.hpp"
+#include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-sdk/Reference.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+using namespace odb;
+
+// ----------------------------------------------------------------------------
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    int statementCount = argc > 1 ? atoi(argv[1]) : 50000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    if (statementCount < 1 || iterations < 1)
+    {
+        fprintf(stderr, "Usage: %s [statements] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    // Every group is 8 statements, counting the ones nested in blocks
+    std::string code;
+    for (int i = 0; i < statementCount; i += 8)
+    {
+        std::string n = std::to_string(i);
+        code += "a = a + " + n + " * 2 - b\n";
+        code += "if a > 1000 and b < " + n + "\n    a = 0\nelse\n    b = b + 1\nendif\n";
+        code += "f# = f# * 0.5 + a\n";
+        code += "for j = 1 to 3\n    a = a + j * -b\nnext j\n";
+        code += "b = (a << 1) mod 7\n";
+    }
+
+    cmd::CommandIndex index;
+    cmd::CommandMatcher matcher;
+    matcher.updateFromIndex(&index);
+    db::StringParserDriver driver;
+    Reference<ast::Block> ast = driver.parse("bench.dba", code, matcher);
+    if (ast == nullptr)
+        return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    ir::Ptr<ir::Program> program;
+    for (int i = 0; i != iterations; ++i)
+    {
+        program = ir::runSemanticChecks(ast, index);
+        if (program == nullptr)
+            return 1;
+    }
+    double semantic = secondsSince(start) / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i != iterations; ++i)
+    {
+        std::ostringstream os;
+        if (!ir::generateCode(SDKType::ODB, ir::OutputType::LLVMIR,
+                              ir::TargetTriple{ir::TargetTriple::Arch::x86_64, ir::TargetTriple::Platform::Linux}, os,
+                              "bench.dba", *program, index))
+            return 1;
+    }
+    double codegen = secondsSince(start) / iterations;
+
+    printf("semantic checks: %10.3fms\n", semantic * 1000.0);
+    printf("codegen:         %10.3fms\n", codegen * 1000.0);
+
+    return 0;
+}
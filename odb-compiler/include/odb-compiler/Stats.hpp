@@ -0,0 +1,117 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/Trace.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define ODB_STATS_COUNTER_LIST                                                                           \
+    X(TokensLexed,               "tokens_lexed",                "Tokens lexed")                          \
+    X(CommandLookups,            "command_lookups",             "Command match lookups")                 \
+    X(ASTNodes,                  "ast_nodes",                   "AST nodes allocated")                   \
+    X(ASTAllocations,            "ast_allocations",             "AST allocations (nodes and locations)") \
+    X(ASTBytes,                  "ast_bytes",                   "AST bytes allocated")                   \
+    X(IRNodes,                   "ir_nodes",                    "IR nodes created")                      \
+    X(LLVMInstructionsGenerated, "llvm_instructions_generated", "LLVM instructions generated")           \
+    X(LLVMInstructionsOptimized, "llvm_instructions_optimized", "LLVM instructions after optimization")
+
+namespace odb {
+
+/*!
+ * @brief Process-wide compiler statistics, used by odbc's --time-report and
+ * --stats options.
+ *
+ * Nothing is recorded until setEnabled(true) is called, so the hooks spread
+ * throughout the compiler only cost a branch when instrumentation is off.
+ * All functions are thread safe.
+ */
+class ODBCOMPILER_PUBLIC_API Stats
+{
+public:
+    enum Counter
+    {
+#define X(name, key, description) name,
+        ODB_STATS_COUNTER_LIST
+#undef X
+        COUNTER_COUNT
+    };
+
+    struct Timing
+    {
+        std::string phase;
+        std::string file;  // Empty unless the phase processed a single file
+        double wallSeconds;
+        double cpuSeconds;
+    };
+
+    static void setEnabled(bool enable);
+    static bool enabled();
+
+    static void add(Counter counter, uint64_t amount);
+    static uint64_t get(Counter counter);
+
+    static const char* key(Counter counter);
+    static const char* description(Counter counter);
+
+    /*!
+     * @brief Returns the timings in the order the phases finished.
+     */
+    static std::vector<Timing> timings();
+    static void addTiming(Timing timing);
+
+    /*!
+     * @brief Returns the peak resident set size of the process in bytes, or 0
+     * if it can't be determined on this platform.
+     */
+    static uint64_t peakResidentSetSize();
+
+    /*!
+     * @brief CPU time consumed by all threads of the process, in seconds.
+     */
+    static double processCPUTime();
+
+    /*!
+     * @brief CPU time consumed by the calling thread, in seconds.
+     */
+    static double threadCPUTime();
+
+    /*!
+     * @brief Clears all counters and timings.
+     */
+    static void reset();
+};
+
+/*!
+ * @brief Measures the wall and CPU time from construction to destruction and
+ * records it with Stats::addTiming().
+ *
+ * A phase covers everything the process does in the meantime, including work
+ * done by other threads, so its CPU time is that of the whole process. A file
+ * is always processed on a single thread while other files may be processed
+ * in parallel, so for those only the calling thread's CPU time is counted.
+ *
+ * The scope also shows up as an event in the trace, if tracing is enabled.
+ */
+class ODBCOMPILER_PUBLIC_API PhaseTimer
+{
+public:
+    explicit PhaseTimer(const char* phase);
+    PhaseTimer(const char* phase, const std::string& file);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    const char* phase_;
+    std::string file_;
+    std::chrono::steady_clock::time_point startWall_;
+    double startCPU_;
+    bool threadCPU_;
+    bool enabled_;
+    TraceScope trace_;
+};
+
+}
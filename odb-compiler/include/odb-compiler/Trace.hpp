@@ -0,0 +1,77 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace odb {
+
+/*!
+ * @brief Process-wide recorder of scoped events, which odbc's --trace option
+ * writes out in the Chrome trace event format. The result can be opened in
+ * chrome://tracing or Perfetto to see what each thread was doing and when.
+ *
+ * Nothing is recorded until setEnabled(true) is called. All functions are
+ * thread safe.
+ */
+class ODBCOMPILER_PUBLIC_API Trace
+{
+public:
+    struct Event
+    {
+        const char* category;
+        std::string name;
+        int64_t startMicros;
+        int64_t durationMicros;
+        uint32_t threadId;
+    };
+
+    static void setEnabled(bool enable);
+    static bool enabled();
+
+    /*!
+     * @brief Microseconds since the first time this was called.
+     */
+    static int64_t now();
+
+    /*!
+     * @brief Small number identifying the calling thread. Threads are numbered
+     * in the order they first ask for their ID, starting at 1.
+     */
+    static uint32_t threadId();
+
+    static void addEvent(Event event);
+
+    /*!
+     * @brief Returns the events in the order they ended.
+     */
+    static std::vector<Event> events();
+
+    static void reset();
+};
+
+/*!
+ * @brief Records an event covering the lifetime of the scope on the calling
+ * thread. The detail, e.g. a file or function name, is appended to the name
+ * of the event.
+ */
+class ODBCOMPILER_PUBLIC_API TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name, std::string_view detail = {});
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category_;
+    std::string name_;
+    int64_t start_;
+    uint32_t threadId_;
+    bool enabled_;
+};
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace odb::cmd {
+class CommandIndex;
+}
+
+namespace odb::ast {
+
+class Block;
+
+/*!
+ * @brief On-disk cache of parsed ASTs, so unchanged source files don't have
+ * to be lexed and parsed again on the next invocation.
+ *
+ * Entries are keyed by the file name, a hash of the file's contents and a hash
+ * of the loaded commands. The commands are part of the key because command
+ * matching changes how the source is tokenized. The ASTs are stored in the
+ * format written by ast::serialize().
+ *
+ * Entries are written to a temporary file and renamed into place, so several
+ * threads or processes can share the same cache directory.
+ */
+class ODBCOMPILER_PUBLIC_API ASTCache
+{
+public:
+    ASTCache(const std::filesystem::path& directory, const cmd::CommandIndex& commandIndex);
+
+    /*!
+     * @brief Returns the cached AST for the given source, or nullptr if there
+     * is no valid entry for it.
+     */
+    Block* load(const std::string& fileName, std::string_view source) const;
+
+    /*!
+     * @brief Writes the AST parsed from the given source into the cache. This
+     * must be called before any passes modify the AST.
+     */
+    bool store(const std::string& fileName, std::string_view source, const Block* block) const;
+
+    static uint64_t hashCommandIndex(const cmd::CommandIndex& commandIndex);
+
+private:
+    std::filesystem::path entryPath(const std::string& fileName, uint64_t sourceHash) const;
+
+    std::filesystem::path directory_;
+    uint64_t commandIndexHash_;
+};
+
+}
@@ -10,6 +10,7 @@ class ODBCOMPILER_PUBLIC_API AnnotatedSymbol : public Symbol
 {
 public:
     AnnotatedSymbol(Annotation annotation, const std::string& name, SourceLocation* location);
+    AnnotatedSymbol(Annotation annotation, Atom atom, const std::string& name, SourceLocation* location);
 
     Annotation annotation() const;
 
@@ -14,7 +14,7 @@ class UDTRef;
 class ODBCOMPILER_PUBLIC_API ArrayDecl : public Statement
 {
 public:
-    ArrayDecl(ScopedAnnotatedSymbol* symbol, ArgList* dims, SourceLocation* location);
+    ArrayDecl(NodeKind kind, ScopedAnnotatedSymbol* symbol, ArgList* dims, SourceLocation* location);
 
     ScopedAnnotatedSymbol* symbol() const;
     ArgList* dims() const;
@@ -14,7 +14,7 @@ class VarRef;
 class ODBCOMPILER_PUBLIC_API Assignment : public Statement
 {
 public:
-    Assignment(LValue* lvalue, Expression* expr, SourceLocation* location);
+    Assignment(NodeKind kind, LValue* lvalue, Expression* expr, SourceLocation* location);
 
     LValue* lvalue() const;
     Expression* expression() const;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace odb::ast {
+
+/*!
+ * @brief An identifier interned in the AtomTable. DBP identifiers are case
+ * insensitive, so two atoms are equal if their names only differ in case.
+ * Comparing and hashing an atom doesn't look at the name at all.
+ */
+class Atom
+{
+public:
+    /*!
+     * @brief Leaves the ID undefined. Only here so atoms can be stored in the
+     * parser's value union; use AtomTable::intern() to make a valid one.
+     */
+    Atom() = default;
+
+    uint32_t id() const { return id_; }
+
+    bool operator==(Atom other) const { return id_ == other.id_; }
+    bool operator!=(Atom other) const { return id_ != other.id_; }
+    bool operator<(Atom other) const { return id_ < other.id_; }
+
+private:
+    friend class AtomTable;
+    explicit Atom(uint32_t id) : id_(id) {}
+
+    uint32_t id_;
+};
+
+/*!
+ * @brief Process-wide table of every identifier the compiler has seen. Each
+ * name is stored once, in lower case.
+ *
+ * Atoms and the views returned by name() stay valid until the table is
+ * cleared, either explicitly or by the end of the last Scope. All functions
+ * are thread safe, but nothing may intern or use an atom while the table is
+ * being cleared.
+ */
+class ODBCOMPILER_PUBLIC_API AtomTable
+{
+public:
+    /*!
+     * @brief Owns the atoms of one compilation. The table is cleared when the
+     * last scope ends, so every AST and IR that was built while a scope was
+     * alive has to be destroyed before then. Scopes may be nested.
+     */
+    class ODBCOMPILER_PUBLIC_API Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /*!
+     * @brief Returns the atom of the name. Names that were interned before by
+     * the same thread are found without locking or allocating.
+     */
+    static Atom intern(std::string_view name);
+
+    /*!
+     * @brief Returns the name of the atom in lower case. The spelling used in
+     * the source is kept by the AST nodes that refer to the identifier.
+     */
+    static std::string_view name(Atom atom);
+
+    /*!
+     * @brief Removes every atom. The ones interned afterwards may reuse the
+     * IDs of the removed ones.
+     */
+    static void clear();
+};
+
+}
+
+namespace std {
+template <> struct hash<odb::ast::Atom>
+{
+    size_t operator()(odb::ast::Atom atom) const { return atom.id(); }
+};
+}
@@ -10,7 +10,7 @@ class SourceLocation;
 class ODBCOMPILER_PUBLIC_API Expression : public Node
 {
 public:
-    Expression(SourceLocation* location);
+    Expression(NodeKind kind, SourceLocation* location);
 };
 
 }
@@ -9,7 +9,7 @@ namespace odb::ast {
 class ODBCOMPILER_PUBLIC_API Literal : public Expression
 {
 public:
-    Literal(SourceLocation* location);
+    Literal(NodeKind kind, SourceLocation* location);
 };
 
 #define X(dbname, cppname)                                                    \
@@ -15,7 +15,7 @@ class Assignment;
 class ODBCOMPILER_PUBLIC_API Loop : public Statement
 {
 public:
-    Loop(SourceLocation* location);
+    Loop(NodeKind kind, SourceLocation* location);
 };
 
 class ODBCOMPILER_PUBLIC_API InfiniteLoop : public Loop
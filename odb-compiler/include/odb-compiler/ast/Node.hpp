@@ -1,6 +1,7 @@
 #pragma once
 
 #include "odb-compiler/config.hpp"
+#include "odb-compiler/ast/Datatypes.hpp"
 #include "odb-sdk/Reference.hpp"
 #include <string>
 
@@ -10,10 +11,78 @@ class ConstVisitor;
 class SourceLocation;
 class Visitor;
 
+/*!
+ * Identifies the class of a node. Passes that handle many different kinds of
+ * nodes can switch on it instead of trying one dynamic_cast after the other.
+ *
+ * The values are also written to AST caches (see Serialization.hpp), so
+ * changing the list means bumping the cache format version.
+ */
+enum class NodeKind : uint8_t
+{
+    AnnotatedSymbol,
+    ArgList,
+    ArrayAssignment,
+    ArrayRef,
+    BinaryOp,
+    Block,
+    Case,
+    CaseList,
+    CommandExpr,
+    CommandStmnt,
+    Conditional,
+    ConstDecl,
+    ConstDeclExpr,
+    DefaultCase,
+    Exit,
+    ForLoop,
+    FuncCallExpr,
+    FuncCallExprOrArrayRef,
+    FuncCallStmnt,
+    FuncDecl,
+    FuncExit,
+    Goto,
+    InfiniteLoop,
+    InitializerList,
+    Label,
+    ScopedAnnotatedSymbol,
+    Select,
+    SubCall,
+    SubReturn,
+    Symbol,
+    UDTArrayDecl,
+    UDTDecl,
+    UDTDeclBody,
+    UDTFieldAssignment,
+    UDTFieldOuter,
+    UDTFieldInner,
+    UDTRef,
+    UDTVarDecl,
+    UnaryOp,
+    UntilLoop,
+    VarAssignment,
+    VarRef,
+    WhileLoop,
+
+#define X(dbname, cppname) \
+    dbname##Literal,       \
+    dbname##VarDecl,       \
+    dbname##ArrayDecl,
+    ODB_DATATYPE_LIST
+#undef X
+};
+
 class ODBCOMPILER_PUBLIC_API Node : public RefCounted
 {
 public:
-    Node(SourceLocation* location);
+    Node(NodeKind kind, SourceLocation* location);
+
+    /*!
+     * Nodes are allocated from the active odb::Arena if there is one (see
+     * Driver::setUseArena()), otherwise from the heap.
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
 
     template <typename T=Node>
     T* parent() const { return dynamic_cast<T*>(parent_); }
@@ -21,6 +90,11 @@ public:
     void setParent(Node* node);
     SourceLocation* location() const;
 
+    /*!
+     * @brief The class of the node, which every constructor sets.
+     */
+    NodeKind kind() const { return kind_; }
+
     virtual std::string toString() const = 0;
 
     virtual void accept(Visitor* visitor) = 0;
@@ -41,6 +115,7 @@ protected:
 private:
     Node* parent_;
     Reference<SourceLocation> location_;
+    NodeKind kind_;
 };
 
 }
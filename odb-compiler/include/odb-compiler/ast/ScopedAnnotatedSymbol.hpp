@@ -10,6 +10,7 @@ class ODBCOMPILER_PUBLIC_API ScopedAnnotatedSymbol : public Symbol
 {
 public:
     ScopedAnnotatedSymbol(Scope scope, Annotation annotation, const std::string& name, SourceLocation* location);
+    ScopedAnnotatedSymbol(Scope scope, Annotation annotation, Atom atom, const std::string& name, SourceLocation* location);
 
     Scope scope() const;
     Annotation annotation() const;
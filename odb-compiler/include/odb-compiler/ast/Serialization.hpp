@@ -0,0 +1,32 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace odb::ast {
+
+class Node;
+
+/*!
+ * @brief Writes the tree below root into a compact binary format that
+ * deserialize() turns back into an identical tree, including all literal
+ * values and source locations. Locations shared between nodes stay shared.
+ *
+ * The format uses the host's byte order and is versioned. It is meant for
+ * caching, not for exchanging ASTs between machines.
+ */
+ODBCOMPILER_PUBLIC_API void serialize(std::vector<uint8_t>* out, const Node* root);
+
+/*!
+ * @brief Reconstructs a tree written by serialize(). The sources that
+ * locations refer to are registered with the SourceFileTable. Files are
+ * registered by name and loaded lazily, so they aren't read from disk unless
+ * a diagnostic needs them.
+ * @return Returns nullptr if the data is truncated, corrupt or was written by
+ * a different version of the format.
+ */
+ODBCOMPILER_PUBLIC_API Node* deserialize(const void* data, size_t size);
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace odb {
+class MappedFile;
+}
+
+namespace odb::ast {
+
+/*!
+ * @brief Index into the SourceFileTable. Locations store this instead of a
+ * copy of the file name or source text.
+ */
+typedef uint32_t SourceFileId;
+
+/*!
+ * @brief Process-wide table holding the name and text of every source that a
+ * SourceLocation can refer to. Each source is stored exactly once, no matter
+ * how many locations point into it.
+ *
+ * Entries are reference counted. Every SourceLocation holds a reference on
+ * its source, and the add functions return an ID holding one reference for
+ * the caller, which has to give it back with release(). Once the last
+ * reference is gone the entry is removed and its ID may be reused, so IDs
+ * and the views returned by name() and text() are only valid while a
+ * reference is held.
+ *
+ * Adding the same name/text combination twice returns the existing ID, which
+ * keeps repeated parses of an unchanged source (e.g. from an editor) from
+ * growing the table.
+ *
+ * All functions are thread safe.
+ */
+class ODBCOMPILER_PUBLIC_API SourceFileTable
+{
+public:
+    /*!
+     * @brief Registers a file on disk whose contents are read lazily, the
+     * first time text() is called.
+     */
+    static SourceFileId addFile(const std::string& fileName);
+
+    /*!
+     * @brief Registers a file whose contents were already loaded.
+     */
+    static SourceFileId addFile(const std::string& fileName, std::string text);
+
+    /*!
+     * @brief Registers a file that was mapped into memory. The table keeps a
+     * reference to the mapping and serves the text directly from it instead
+     * of copying it.
+     */
+    static SourceFileId addFile(const std::string& fileName, MappedFile* file);
+
+    /*!
+     * @brief Registers source code that didn't come from a file.
+     */
+    static SourceFileId addString(const std::string& sourceName, const std::string& code);
+
+    /*!
+     * @brief Adds a reference to the source. Doesn't lock, so it is cheap
+     * enough to call for every location.
+     */
+    static void addRef(SourceFileId id);
+
+    /*!
+     * @brief Drops a reference to the source and removes it once the last
+     * one is gone.
+     */
+    static void release(SourceFileId id);
+
+    /*!
+     * @brief Returns the number of sources in the table.
+     */
+    static int count();
+
+    static const std::string& name(SourceFileId id);
+
+    /*!
+     * @brief Returns true if the source was registered with addFile(), and
+     * false if it was registered with addString().
+     */
+    static bool isFile(SourceFileId id);
+
+    /*!
+     * @brief Returns the entire text of the source. If the text could not be
+     * loaded, false is returned.
+     */
+    static bool text(SourceFileId id, std::string_view* text);
+
+    /*!
+     * @brief Provides the byte offset of the start of each line, which the
+     * parser collects while lexing. The first entry must be 0. If the source
+     * already has a line index, this does nothing.
+     */
+    static void setLineIndex(SourceFileId id, std::vector<uint32_t> lineStarts);
+
+    /*!
+     * @brief Returns a single line (1-based) without its trailing newline.
+     * This is an O(1) lookup in the source's line index. If the source
+     * wasn't lexed, the index is built the first time it is needed.
+     * @return Returns false if the line doesn't exist or the text could not
+     * be loaded.
+     */
+    static bool line(SourceFileId id, int lineNumber, std::string_view* line);
+};
+
+}
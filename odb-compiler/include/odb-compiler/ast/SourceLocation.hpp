@@ -1,11 +1,12 @@
 #pragma once
 
 #include "odb-compiler/config.hpp"
+#include "odb-compiler/ast/SourceFileTable.hpp"
 #include "odb-sdk/Log.hpp"
 #include "odb-sdk/RefCounted.hpp"
-#include <istream>
+#include <cstdint>
+#include <string_view>
 #include <vector>
-#include <memory>
 
 namespace odb {
 namespace ast {
@@ -19,11 +20,27 @@ namespace ast {
  * The first/last line range is inclusive, so lines 1-3 would mean lines 1, 2
  * and 3. The first/last column range is exclusive, so columns 1-3 would mean
  * columns 1 and 2. This is just an artefact of the way lexing is implemented.
+ *
+ * The file name and source text are not stored in the location. Instead, the
+ * location refers to an entry in the SourceFileTable, which holds each source
+ * exactly once.
  */
 class ODBCOMPILER_PUBLIC_API SourceLocation : public RefCounted
 {
 public:
-    SourceLocation(int firstLine, int lastLine, int firstColumn, int lastColumn, Log::Color color=Log::RESET);
+    /*!
+     * @brief The location holds a reference on the source in the
+     * SourceFileTable for as long as it exists.
+     */
+    SourceLocation(SourceFileId fileId, int firstLine, int lastLine, int firstColumn, int lastColumn, Log::Color color=Log::RESET);
+    ~SourceLocation();
+
+    /*!
+     * @brief Locations are allocated from the active odb::Arena if there is
+     * one, otherwise from the heap.
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
 
     /*!
      * @brief Returns the location in the format "fl-ll:fc-lc" where fl=first line,
@@ -35,19 +52,20 @@ public:
      * @brief Returns the location in the format "file:line:column" (first line
      * and first column)
      */
-    virtual std::string getFileLineColumn() const = 0;
+    std::string getFileLineColumn() const;
 
     /*!
      * @brief Returns the affected lines from the source file or source text,
      * and inserts "squiggles" to highlight the parts that are relevant. The
      * strings can be "\n".join()'d to produce a printable block.
      */
-    virtual std::vector<std::string> getUnderlinedSection() const = 0;
+    std::vector<std::string> getUnderlinedSection() const;
 
-    virtual SourceLocation* duplicate() const = 0;
+    SourceLocation* duplicate() const;
 
     void printUnderlinedSection(Log& log) const;
 
+    SourceFileId fileId() const;
     int firstLine() const;
     int lastLine() const;
     int firstColumn() const;
@@ -57,45 +75,40 @@ public:
     void unionize(const SourceLocation* other);
 
 protected:
-    std::vector<std::string> getUnderlinedSection(std::istream& code) const;
+    std::vector<std::string> getUnderlinedSection(std::vector<std::string> lines) const;
+    std::vector<std::string> invalidLocation() const;
 
 protected:
-    int firstLine_;
-    int lastLine_;
-    int firstColumn_;
-    int lastColumn_;
-    Log::Color color_;
+    // Columns are packed into 16 bits. Longer lines saturate at the maximum
+    // column, which only affects the squiggles drawn under diagnostics.
+    SourceFileId fileId_;
+    int32_t firstLine_;
+    int32_t lastLine_;
+    uint16_t firstColumn_;
+    uint16_t lastColumn_;
+    uint8_t color_;
 };
 
+/*!
+ * @brief Convenience for creating a location in a file on disk. The file is
+ * registered with the SourceFileTable and only read if a diagnostic needs it.
+ */
 class ODBCOMPILER_PUBLIC_API FileSourceLocation : public SourceLocation
 {
 public:
     FileSourceLocation(const std::string& fileName,
         int firstLine, int lastLine, int firstColumn, int lastColumn);
-
-    std::string getFileLineColumn() const override;
-    std::vector<std::string> getUnderlinedSection() const override;
-
-    SourceLocation* duplicate() const override;
-
-private:
-    std::string fileName_;
 };
 
+/*!
+ * @brief Convenience for creating a location in source code that didn't come
+ * from a file. The code is registered with the SourceFileTable.
+ */
 class ODBCOMPILER_PUBLIC_API InlineSourceLocation : public SourceLocation
 {
 public:
     InlineSourceLocation(const std::string& sourceName, const std::string& code,
         int firstLine, int lastLine, int firstColumn, int lastColumn);
-
-    std::string getFileLineColumn() const override;
-    std::vector<std::string> getUnderlinedSection() const override;
-
-    SourceLocation* duplicate() const override;
-
-private:
-    std::string sourceName_;
-    std::string code_;
 };
 
 }
@@ -10,7 +10,7 @@ namespace ast {
 class ODBCOMPILER_PUBLIC_API Statement : public Node
 {
 public:
-    Statement(SourceLocation* location);
+    Statement(NodeKind kind, SourceLocation* location);
 };
 
 }
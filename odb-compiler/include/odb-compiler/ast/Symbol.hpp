@@ -1,6 +1,7 @@
 #pragma once
 
 #include "odb-compiler/config.hpp"
+#include "odb-compiler/ast/Atom.hpp"
 #include "odb-compiler/ast/Node.hpp"
 
 namespace odb::ast {
@@ -9,19 +10,31 @@ class ODBCOMPILER_PUBLIC_API Symbol : public Node
 {
 public:
     Symbol(const std::string& name, SourceLocation* location);
+    Symbol(Atom atom, const std::string& name, SourceLocation* location);
 
     const std::string& name() const;
 
+    /*!
+     * @brief The interned name. Use this instead of name() to compare or look
+     * up identifiers, since it ignores case and doesn't touch the string.
+     */
+    Atom atom() const;
+
     std::string toString() const override;
     void accept(Visitor* visitor) override;
     void accept(ConstVisitor* visitor) const override;
     void swapChild(const Node* oldNode, Node* newNode) override;
 
 protected:
+    Symbol(NodeKind kind, const std::string& name, SourceLocation* location);
+    Symbol(NodeKind kind, Atom atom, const std::string& name, SourceLocation* location);
+
     Node* duplicateImpl() const override;
 
 protected:
+    // The spelling used in the source, for diagnostics and exported names
     const std::string name_;
+    const Atom atom_;
 };
 
 }
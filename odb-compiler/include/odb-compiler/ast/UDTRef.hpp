@@ -9,6 +9,7 @@ class UDTRef : public Symbol
 {
 public:
     UDTRef(const std::string& name, SourceLocation* location);
+    UDTRef(Atom atom, const std::string& name, SourceLocation* location);
 
     std::string toString() const override;
     void accept(Visitor* visitor) override;
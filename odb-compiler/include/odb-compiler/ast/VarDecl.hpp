@@ -16,8 +16,8 @@ class Symbol;
 class ODBCOMPILER_PUBLIC_API VarDecl : public Statement
 {
 public:
-    VarDecl(ScopedAnnotatedSymbol* symbol, InitializerList* initializer, SourceLocation* location);
-    VarDecl(ScopedAnnotatedSymbol* symbol, SourceLocation* location);
+    VarDecl(NodeKind kind, ScopedAnnotatedSymbol* symbol, InitializerList* initializer, SourceLocation* location);
+    VarDecl(NodeKind kind, ScopedAnnotatedSymbol* symbol, SourceLocation* location);
 
     ScopedAnnotatedSymbol* symbol() const;
     MaybeNull<InitializerList> initializer() const;
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include "odb-sdk/RefCounted.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace odb {
+class MappedFile;
+
+namespace cmd {
+
+class CommandIndex;
+
+/*!
+ * @brief Memory-mapped image of the commands exported by a set of plugins.
+ *
+ * The image stores one entry per plugin, keyed by the plugin's path,
+ * modification time and size, and sorted by path. Plugins that haven't
+ * changed since the image was written can be loaded from it without being
+ * opened at all. The commands created from the image refer to their plugin
+ * through a deferred DynamicLibrary, which is only loaded if something needs
+ * its symbols.
+ *
+ * The image also contains a sorted table of all case-folded command names,
+ * which is all a CommandMatcher needs.
+ *
+ * The layout is a flat set of fixed-size records followed by a string table,
+ * so opening an image only requires validating the offsets, not parsing it.
+ * Images use the byte order of the machine that wrote them and are rejected
+ * on machines with a different byte order.
+ */
+class ODBCOMPILER_PUBLIC_API CommandCache : public RefCounted
+{
+public:
+    ~CommandCache();
+
+    /*!
+     * @brief Maps an image written by write().
+     * @return Returns nullptr if the file doesn't exist, was written by a
+     * different version, or is corrupt.
+     */
+    static CommandCache* open(const std::filesystem::path& fileName);
+
+    /*!
+     * @brief Writes an image of all commands in the index. Commands are
+     * grouped by the library they came from, and each library is stat'ed to
+     * get its modification time and size. Commands without a library are
+     * skipped.
+     * @param scannedPlugins Every plugin that was scanned for commands. Each
+     * of them gets an entry, even if it failed to load or exports no
+     * commands, so it isn't opened again as long as it doesn't change.
+     */
+    static bool write(const std::filesystem::path& fileName, const CommandIndex& index,
+                      const std::vector<std::filesystem::path>& scannedPlugins = {});
+
+    int pluginCount() const;
+
+    /*!
+     * @brief Returns true if the image has an entry for the plugin, and the
+     * plugin's modification time and size on disk match the entry.
+     */
+    bool isUpToDate(const std::filesystem::path& plugin) const;
+
+    /*!
+     * @brief Adds the commands of a single plugin to the index.
+     * @return Returns false if the image has no entry for the plugin.
+     */
+    bool populateIndexFromPlugin(CommandIndex* index, const std::filesystem::path& plugin) const;
+
+    /*!
+     * @brief Adds the commands of all plugins in the image to the index.
+     */
+    void populateIndex(CommandIndex* index) const;
+
+    /*!
+     * @brief Number of unique command names. Overloads share a name.
+     */
+    int commandNameCount() const;
+
+    /*!
+     * @brief Returns a lower case command name. Names are sorted.
+     */
+    std::string_view commandNameAt(int idx) const;
+
+private:
+    struct Header;
+    struct PluginRecord;
+    struct CommandRecord;
+    struct ArgRecord;
+
+    explicit CommandCache(MappedFile* file);
+
+    const Header* header() const;
+    const PluginRecord* plugins() const;
+    const CommandRecord* commands() const;
+    const ArgRecord* args() const;
+    const char* string(uint32_t offset) const;
+
+    const PluginRecord* findPlugin(const std::filesystem::path& plugin) const;
+    void addPluginCommands(CommandIndex* index, const PluginRecord* plugin) const;
+
+private:
+    Reference<MappedFile> file_;
+};
+
+}
+}
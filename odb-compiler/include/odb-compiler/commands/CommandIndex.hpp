@@ -11,6 +11,8 @@
 namespace odb {
 namespace cmd {
 
+class CommandCache;
+
 /*!
  * This class is a generic container for all commands. It acts as an
  * intermediate storage when collecting commands from plugins or config files.
@@ -22,6 +24,14 @@ namespace cmd {
 class ODBCOMPILER_PUBLIC_API CommandIndex
 {
 public:
+    CommandIndex() = default;
+
+    /*!
+     * @brief Creates an index holding all commands stored in a command cache
+     * image. None of the plugins are loaded.
+     */
+    explicit CommandIndex(const CommandCache& cache);
+
     void addCommand(Command* command);
 
     /*!
@@ -23,9 +23,34 @@ public:
     virtual bool populateIndex(CommandIndex* index) = 0;
     virtual bool populateIndexFromLibrary(CommandIndex* index, DynamicLibrary* library) = 0;
 
+    /*!
+     * @brief Keep a command cache image (see CommandCache) in the specified
+     * file. Plugins whose path, modification time and size match an entry in
+     * the image are loaded from it without being opened. This includes
+     * plugins that failed to load or export no commands. If any plugin had to
+     * be opened, or a plugin disappeared, the image is rewritten.
+     */
+    void setCommandCacheFile(const std::filesystem::path& cacheFile);
+
+    /*!
+     * @brief Number of plugins to open and scan in parallel. Specify 0 to use
+     * one job per CPU core, which is the default. The resulting index is the
+     * same regardless of the number of jobs.
+     */
+    void setJobs(int jobs);
+
+protected:
+    /*!
+     * @brief Adds the commands of every plugin in the list to the index,
+     * going through the command cache if one was set.
+     */
+    bool populateIndexFromPlugins(CommandIndex* index, const std::vector<std::filesystem::path>& plugins);
+
 protected:
     const std::filesystem::path sdkRoot_;
     const std::vector<std::filesystem::path> pluginDirs_;
+    std::filesystem::path commandCacheFile_;
+    int jobs_ = 0;
 };
 
 }
@@ -8,14 +8,16 @@
 namespace odb {
 namespace cmd {
 
+class CommandCache;
 class CommandIndex;
 
 /*!
  * The Purpose of this class is to provide the lexer a way to determine if
  * a sequence of symbol tokens represents a command or not.
  *
- * This class only stores the commands as strings and sorts them lexicographically
- * to make matching fast.
+ * The command names are case-folded and stored in a trie with one node per
+ * character. The children of each node are stored contiguously and sorted, so
+ * a match runs in O(length of input) and does not allocate.
  */
 class ODBCOMPILER_PUBLIC_API CommandMatcher
 {
@@ -27,10 +29,59 @@ public:
     };
 
     /*!
-     * Loads all commands as strings and sorts them lexicographically.
+     * Position in the command trie. This lets the caller feed characters
+     * incrementally (e.g. one token at a time) instead of re-matching an ever
+     * growing string from the beginning.
+     *
+     * A cursor must not outlive the matcher that created it, and is invalidated
+     * by CommandMatcher::updateFromIndex().
+     */
+    class ODBCOMPILER_PUBLIC_API Cursor
+    {
+    public:
+        /*!
+         * Advances the cursor by the given characters.
+         * @return Returns false if no command begins with the characters fed
+         * so far. The cursor stays invalid from then on.
+         */
+        bool advance(std::string_view str);
+        bool advance(char c);
+
+        /*!
+         * Returns true if the characters fed so far exactly spell a command.
+         */
+        bool isCommand() const;
+
+        /*!
+         * Returns false once a character was fed that no command continues with.
+         */
+        bool isValid() const;
+
+        /*!
+         * Number of characters successfully matched so far.
+         */
+        int matchedLength() const;
+
+    private:
+        friend class CommandMatcher;
+        explicit Cursor(const CommandMatcher* matcher);
+
+        const CommandMatcher* matcher_;
+        int node_;
+        int matchedLength_;
+    };
+
+    /*!
+     * Builds the command trie from all command names in the index.
      */
     void updateFromIndex(const CommandIndex* index);
 
+    /*!
+     * Builds the command trie directly from the name table of a command cache
+     * image, without creating any Command objects.
+     */
+    void updateFromCache(const CommandCache* cache);
+
     /*!
      * Matches as many characters of the input string as possible.
      *
@@ -42,7 +93,13 @@ public:
      * but also exact matches shorter than the input string can occur
      * (matchedLength < str.length(), found=true).
      */
-    MatchResult findLongestCommandMatching(const std::string& str) const;
+    MatchResult findLongestCommandMatching(std::string_view str) const;
+
+    /*!
+     * Returns a cursor positioned at the root of the command trie, i.e. one
+     * that hasn't matched any characters yet.
+     */
+    Cursor cursor() const;
 
     /*!
      * Returns the longest possible match length. Useful for preallocating a
@@ -57,7 +114,18 @@ public:
     int longestCommandWordCount() const;
 
 private:
-    std::vector<std::string> commands_;
+    struct TrieNode
+    {
+        int firstChild;   // Index into nodes_. All children are contiguous
+        int childCount;
+        char c;           // Lower case character on the edge into this node
+        bool isCommand;   // A command ends at this node
+    };
+
+    void buildTrie(const std::vector<std::string_view>& commands);
+    int findChild(int node, char c) const;
+
+    std::vector<TrieNode> nodes_;
     int longestCommandLength_ = 0;
     int longestCommandWordCount_ = 0;
 };
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <unordered_set>
+
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+namespace odb::ir {
+// Adds every variable the statements assign to, including the counters of
+// nested for loops. Returns false if the statements contain a label or a
+// gosub, because then code outside of them can run in between and change any
+// variable.
+ODBCOMPILER_PUBLIC_API bool collectAssignedVariables(const StatementBlock& statements,
+                                                     std::unordered_set<const Variable*>& variables);
+} // namespace odb::ir
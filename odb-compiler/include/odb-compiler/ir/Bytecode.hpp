@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/ir/FlatIR.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+namespace odb::ir {
+// Opcodes of the bytecode. Arithmetic, comparison and conversion opcodes are
+// typed, the instruction's type selects which BuiltinType they operate on.
+#define ODB_BYTECODE_OP_LIST                                                                                           \
+    X(LoadConstant)     /* dst = constant                                    */                                        \
+    X(LoadString)       /* dst = strings[constant]                           */                                        \
+    X(Move)             /* dst = a                                           */                                        \
+    X(Cast)             /* dst = (type)(sourceType)a                         */                                        \
+    X(Negate)           /* dst = -a                                          */                                        \
+    X(BitwiseNot)       /* dst = ~a                                          */                                        \
+    X(LogicalNot)       /* dst = !a                                          */                                        \
+    X(Add)              /* dst = a + b                                       */                                        \
+    X(Sub)              /* dst = a - b                                       */                                        \
+    X(Mul)              /* dst = a * b                                       */                                        \
+    X(Div)              /* dst = a / b                                       */                                        \
+    X(Mod)              /* dst = a mod b                                     */                                        \
+    X(Pow)              /* dst = a ^ b                                       */                                        \
+    X(ShiftLeft)        /* dst = a << b                                      */                                        \
+    X(ShiftRight)       /* dst = a >> b                                      */                                        \
+    X(BitwiseOr)        /* dst = a | b                                       */                                        \
+    X(BitwiseAnd)       /* dst = a & b                                       */                                        \
+    X(BitwiseXor)       /* dst = a xor b                                     */                                        \
+    X(Less)             /* dst = a < b                                       */                                        \
+    X(LessEqual)        /* dst = a <= b                                      */                                        \
+    X(Greater)          /* dst = a > b                                       */                                        \
+    X(GreaterEqual)     /* dst = a >= b                                      */                                        \
+    X(Equal)            /* dst = a = b                                       */                                        \
+    X(NotEqual)         /* dst = a <> b                                      */                                        \
+    X(LogicalOr)        /* dst = a or b                                      */                                        \
+    X(LogicalAnd)       /* dst = a and b                                     */                                        \
+    X(LogicalXor)       /* dst = a xor b (booleans)                          */                                        \
+    X(Jump)             /* goto target                                       */                                        \
+    X(JumpIfFalse)      /* if not a then goto target                         */                                        \
+    X(BackEdge)         /* goto target, counts a loop iteration              */                                        \
+    X(BackEdgeIfFalse)  /* if not a then goto target, counts a loop iteration */                                       \
+    X(ForLoopCondition) /* if dst passed a (step b) then goto target         */                                        \
+    X(Gosub)            /* push return address, goto target                  */                                        \
+    X(SubReturn)        /* pop return address and jump to it                 */                                        \
+    X(Return)           /* return from the function                          */                                        \
+    X(ReturnValue)      /* return a from the function                        */                                        \
+    X(CallCommand)      /* dst = command of call site `target`               */                                        \
+    X(CallFunction)     /* dst = function of call site `target`              */
+
+enum class BytecodeOp : std::uint8_t
+{
+#define X(name) name,
+    ODB_BYTECODE_OP_LIST
+#undef X
+};
+
+ODBCOMPILER_PUBLIC_API const char* convertBytecodeOpToString(BytecodeOp op);
+
+// Operands are register indices into the frame of the function. Every register
+// holds one scalar value or a string pointer. Jump targets are instruction
+// indices.
+struct BytecodeInstruction
+{
+    BytecodeOp op = BytecodeOp::Return;
+    BuiltinType type = BuiltinType::Integer;
+    // Type of the operand for Cast.
+    BuiltinType sourceType = BuiltinType::Integer;
+    std::int32_t dst = 0;
+    std::int32_t a = 0;
+    std::int32_t b = 0;
+    std::int32_t target = 0;
+    // Raw bits of the value for LoadConstant, string index for LoadString.
+    std::uint64_t constant = 0;
+};
+
+struct BytecodeCallSite
+{
+    // Index into BytecodeModule::functions or BytecodeModule::commands,
+    // depending on whether it's called by CallFunction or CallCommand.
+    std::int32_t callee = 0;
+    std::vector<std::int32_t> argumentRegisters;
+};
+
+struct BytecodeFunction
+{
+    std::string name;
+    // Register of the variable each argument is bound to, or -1 if the
+    // argument is never used.
+    std::vector<std::int32_t> argumentRegisters;
+    // Registers of string variables, which start out as "" instead of null.
+    std::vector<std::int32_t> stringRegisters;
+    std::int32_t registerCount = 0;
+    // Whether the function returns a string. Together with the string
+    // registers, this lets the loader check that strings are only passed
+    // where strings are expected.
+    bool returnsString = false;
+    std::vector<BytecodeInstruction> code;
+    std::vector<BytecodeCallSite> callSites;
+};
+
+// A plugin command called by the module. Commands are bound by symbol when
+// the module is loaded, and the signature has to match exactly.
+using BytecodeCommand = FlatCommand;
+
+// The bytecode of a whole program. It doesn't refer to the IR it was
+// generated from, so it can be cached on disk and run without parsing (or
+// compiling) anything.
+struct BytecodeModule
+{
+    // The first entry is the main function.
+    std::vector<BytecodeFunction> functions;
+    std::vector<BytecodeCommand> commands;
+    std::vector<std::string> strings;
+    // Whether CodeGenerator supports everything the program uses, i.e.
+    // whether hot functions can be compiled with the JIT.
+    bool canCompile = false;
+};
+
+// Lowers the program to bytecode. Returns nullptr if the program uses
+// something the bytecode can't express (e.g. UDTs or string operations), in
+// which case it has to be compiled with LLVM instead.
+ODBCOMPILER_PUBLIC_API std::unique_ptr<BytecodeModule> generateBytecode(const Program& program);
+ODBCOMPILER_PUBLIC_API std::unique_ptr<BytecodeModule> generateBytecode(const FlatProgram& program);
+
+// Writes the module into a compact binary format. Like the AST cache, the
+// format uses the host's byte order and is versioned.
+ODBCOMPILER_PUBLIC_API void serializeBytecode(std::vector<std::uint8_t>* out, const BytecodeModule& module);
+
+// Reads a module written by serializeBytecode(). Returns nullptr if the data
+// is truncated, corrupt or was written by a different version of the format.
+// The code itself is validated when the module is loaded by the Interpreter.
+ODBCOMPILER_PUBLIC_API std::unique_ptr<BytecodeModule> deserializeBytecode(const void* data, std::size_t size);
+} // namespace odb::ir
@@ -68,6 +68,26 @@ struct TargetTriple
     }
 };
 
+enum class OptimizationLevel
+{
+    O0,
+    O1,
+    O2,
+    O3,
+    Os
+};
+
+struct CodegenOptions
+{
+    OptimizationLevel optimizationLevel = OptimizationLevel::O0;
+
+    // CPU and target features (e.g. "+avx2,-sse4a") to generate code for.
+    // Use "native" for both to target the host CPU.
+    std::string cpu = "generic";
+    std::string features;
+};
+
 ODBCOMPILER_PUBLIC_API bool generateCode(SDKType sdk_type, OutputType outputType, TargetTriple targetTriple, std::ostream& os, const std::string& moduleName,
-                                         Program& program, const cmd::CommandIndex& cmdIndex);
+                                         Program& program, const cmd::CommandIndex& cmdIndex,
+                                         const CodegenOptions& options = {});
 } // namespace odb::ir
\ No newline at end of file
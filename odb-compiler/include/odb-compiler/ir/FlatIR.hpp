@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+namespace odb::ir {
+// Nodes of the flat IR refer to each other by their index into one of the
+// pools of the function they belong to.
+using FlatIndex = std::uint32_t;
+constexpr FlatIndex noFlatIndex = ~FlatIndex(0);
+
+// Expressions of a function, stored as one array per field. What the operands
+// mean depends on the kind:
+//   Cast            a = expression, the target type is the type of the cast
+//   Unary           op = UnaryOp, a = expression
+//   Binary          op = BinaryOp, a = left, b = right
+//   VarRef          a = variable
+//   StringLiteral   a = index into FlatProgram::strings
+//   Other literals  a = offset of the value in FlatFunction::literalData
+//   FunctionCall    op = 0 if a is a function index, or 1 if a is an index
+//                   into FlatProgram::commands, b = list of arguments
+struct FlatExpressionPool
+{
+    std::vector<ExpressionKind> kinds;
+    std::vector<Type> types;
+    std::vector<std::uint8_t> ops;
+    std::vector<FlatIndex> a;
+    std::vector<FlatIndex> b;
+    std::vector<FlatIndex> locations;
+
+    FlatIndex size() const { return FlatIndex(kinds.size()); }
+};
+
+// Statements of a function. Blocks are lists of statements:
+//   VarAssignment   a = variable, b = expression
+//   Conditional     a = condition, b = true branch, c = false branch
+//   Select          a = expression, b = list of (condition, block) pairs,
+//                   where the condition of the default case is noFlatIndex
+//   ForLoop         a = VarAssignment of the counter (it isn't part of any
+//                   block), b = end value, c = step value, d = body
+//   WhileLoop       a = condition, d = body
+//   UntilLoop       a = condition, d = body
+//   InfiniteLoop    d = body
+//   Label           no operands, jumps refer to the statement itself
+//   Goto, Gosub     a = label, or noFlatIndex if it was never resolved
+//   FunctionCall    a = FunctionCall expression
+//   Exit            a = loop to break out of
+//   ExitFunction    a = returned expression, or noFlatIndex
+struct FlatStatementPool
+{
+    std::vector<StatementKind> kinds;
+    std::vector<FlatIndex> a;
+    std::vector<FlatIndex> b;
+    std::vector<FlatIndex> c;
+    std::vector<FlatIndex> d;
+    std::vector<FlatIndex> locations;
+
+    FlatIndex size() const { return FlatIndex(kinds.size()); }
+};
+
+struct FlatFunction
+{
+    std::string name;
+    FlatIndex location = noFlatIndex;
+
+    std::vector<Type> argumentTypes;
+    // Variable each argument is bound to, or noFlatIndex.
+    std::vector<FlatIndex> argumentVariables;
+
+    // Variables are in the same order as in the function's VariableScope.
+    std::vector<Type> variableTypes;
+    std::vector<FlatIndex> variableLocations;
+
+    FlatExpressionPool expressions;
+    FlatStatementPool statements;
+
+    // Argument lists and blocks. A list starts with the number of entries,
+    // followed by the entries.
+    std::vector<FlatIndex> lists;
+    // Values of the non-string literals.
+    std::vector<std::uint8_t> literalData;
+
+    FlatIndex body = noFlatIndex;
+    FlatIndex returnExpression = noFlatIndex;
+
+    FlatIndex listSize(FlatIndex list) const { return lists[list]; }
+    const FlatIndex* listBegin(FlatIndex list) const { return lists.data() + list + 1; }
+    const FlatIndex* listEnd(FlatIndex list) const { return listBegin(list) + lists[list]; }
+};
+
+// A plugin command called by the program. Only its symbols and signature are
+// kept, which is all the bytecode needs to bind it when it's loaded.
+struct FlatCommand
+{
+    std::string dbSymbol;
+    std::string cppSymbol;
+    cmd::Command::Type returnType = cmd::Command::Type::Void;
+    std::vector<cmd::Command::Type> argumentTypes;
+};
+
+// The IR of a whole program, flattened into contiguous pools for the bytecode
+// generator. Nodes refer to each other by index, and commands and locations
+// are stored by value, so it doesn't point back into the tree IR, the command
+// index or the source file table.
+struct FlatProgram
+{
+    // The first entry is the main function.
+    std::vector<FlatFunction> functions;
+    std::vector<FlatCommand> commands;
+    std::vector<std::string> strings;
+    // The file:line:column of each location, stored once no matter how many
+    // nodes share it.
+    std::vector<std::string> locations;
+};
+
+// Flattens the program. Returns nullptr if it uses UDTs, or if a function
+// refers to a variable, label or loop of a different function.
+ODBCOMPILER_PUBLIC_API std::unique_ptr<FlatProgram> flattenProgram(const Program& program);
+} // namespace odb::ir
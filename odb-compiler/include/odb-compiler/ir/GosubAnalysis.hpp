@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+namespace odb::ir {
+struct GosubUsage
+{
+    // True if the function contains a gosub or a return, and needs a stack
+    // for the return addresses.
+    bool usesGosub = false;
+    // Most return addresses that can be on the stack at the same time, or
+    // nullopt if that can't be determined from the IR, e.g. because
+    // subroutines recurse or contain gotos.
+    std::optional<std::uint32_t> maxDepth;
+};
+
+// A subroutine is made of the statements from the label a gosub jumps to up
+// to the next return at the top level of the function. Once inside, control
+// can only leave it through a return or a goto, so without gotos the depth is
+// the longest chain of subroutines that gosub into each other.
+ODBCOMPILER_PUBLIC_API GosubUsage analyzeGosubUsage(const FunctionDefinition& function);
+} // namespace odb::ir
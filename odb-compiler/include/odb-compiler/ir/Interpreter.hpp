@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/ir/Bytecode.hpp"
+#include "odb-compiler/ir/Codegen.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+namespace odb::ir {
+struct InterpreterData;
+
+// Executes a program's bytecode, which starts a lot faster than compiling it
+// with LLVM first. When the bytecode is loaded, every instruction is bound to
+// the handler for its opcode and type, so dispatching an instruction is a
+// single indirect call. Plugin commands are bound once at load time as well.
+//
+// The interpreter counts how often each function is entered and how often its
+// loops jump back. Once a function crosses the tier-up threshold, on entry or
+// on a back-edge, the program is compiled with JITProgram and all further
+// calls of the function run the compiled code instead. There is no on-stack
+// replacement: a function that is currently being interpreted keeps being
+// interpreted until it returns. The main function is never compiled, and
+// neither are functions that return a value, because compiled functions have
+// no way to hand the value back.
+//
+// The program (if any) and command index must outlive the interpreter.
+class ODBCOMPILER_PUBLIC_API Interpreter
+{
+public:
+    ~Interpreter();
+
+    // Generates bytecode for the program and loads it. Returns nullptr if the
+    // program uses something the interpreter can't execute (e.g. UDTs or
+    // string operations), in which case the program has to be compiled with
+    // JITProgram instead.
+    static std::unique_ptr<Interpreter> compile(const Program& program, const cmd::CommandIndex& cmdIndex);
+
+    // Loads a module, e.g. one read back from disk. Returns nullptr if a
+    // command the module calls isn't available or the code is invalid, which
+    // includes passing a string where something else is expected or vice
+    // versa. The JIT needs the program's IR, so functions are never compiled.
+    static std::unique_ptr<Interpreter> load(const BytecodeModule& module, const cmd::CommandIndex& cmdIndex);
+
+    // Number of function entries plus loop back-edges after which a function
+    // is compiled. 0 disables compiling entirely.
+    void setTierUpThreshold(int threshold);
+    void setOptimizationLevel(OptimizationLevel optimizationLevel);
+
+    // Runs the main function. Returns 0 on success and 1 if execution was
+    // aborted by a runtime error.
+    int run();
+
+    std::uint64_t entryCount(const FunctionDefinition& function) const;
+    std::uint64_t backEdgeCount(const FunctionDefinition& function) const;
+    bool isCompiled(const FunctionDefinition& function) const;
+
+private:
+    explicit Interpreter(std::unique_ptr<InterpreterData> data);
+
+    std::unique_ptr<InterpreterData> data_;
+};
+} // namespace odb::ir
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/ir/Codegen.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+namespace odb::ir {
+struct JITProgramData;
+
+// A program compiled in memory for the host with an LLVM ORC LLJIT, which lets
+// it run without writing an object file and invoking a linker. Only the ODB
+// SDK is supported, since the DBPro engine only exists as 32-bit Windows DLLs.
+class ODBCOMPILER_PUBLIC_API JITProgram
+{
+public:
+    // Entry point of a single user function. The arguments are passed as an
+    // array of ArgumentSlotSize byte slots, each holding the argument's value
+    // in its first bytes.
+    using FunctionEntryPoint = void (*)(const void* arguments);
+    static constexpr std::size_t ArgumentSlotSize = 8;
+
+    ~JITProgram();
+
+    // Generates and compiles the program. Plugin commands are resolved against
+    // the library each command was loaded from. Returns nullptr on failure.
+    static std::unique_ptr<JITProgram> compile(const Program& program, const cmd::CommandIndex& cmdIndex,
+                                               OptimizationLevel optimizationLevel = OptimizationLevel::O0);
+
+    // Runs the program's entry point and returns its exit code.
+    int run();
+
+    // Looks up the compiled code of a user function, so it can be called
+    // directly instead of through the program's entry point. Returns nullptr
+    // for unknown functions and for functions that return a value.
+    FunctionEntryPoint lookupFunction(const std::string& name);
+
+private:
+    explicit JITProgram(std::unique_ptr<JITProgramData> data);
+
+    std::unique_ptr<JITProgramData> data_;
+};
+} // namespace odb::ir
@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "odb-compiler/ast/Atom.hpp"
 #include "odb-compiler/ast/Block.hpp"
 #include "odb-compiler/ast/Datatypes.hpp"
 #include "odb-compiler/ast/Operators.hpp"
@@ -44,8 +45,41 @@ enum class BuiltinType
 #undef X
 };
 
+// Concrete class of an expression or statement, so passes can switch over a
+// node instead of trying one dynamic_cast after the other.
+enum class ExpressionKind
+{
+    Cast,
+    Unary,
+    Binary,
+    VarRef,
+#define X(dbname, cppname) dbname##Literal,
+    ODB_DATATYPE_LIST
+#undef X
+    FunctionCall
+};
+
+enum class StatementKind
+{
+    VarAssignment,
+    Conditional,
+    Select,
+    ForLoop,
+    WhileLoop,
+    UntilLoop,
+    InfiniteLoop,
+    Label,
+    Goto,
+    Gosub,
+    FunctionCall,
+    SubReturn,
+    Exit,
+    ExitFunction
+};
+
 ODBCOMPILER_PUBLIC_API bool isIntegralType(BuiltinType type);
 ODBCOMPILER_PUBLIC_API bool isFloatingPointType(BuiltinType type);
+ODBCOMPILER_PUBLIC_API bool isUnsignedType(BuiltinType type);
 ODBCOMPILER_PUBLIC_API const char* convertBuiltinTypeToString(BuiltinType type);
 
 // Type trait that maps a C++ type to the corresponding BuiltinType enum.
@@ -56,6 +90,7 @@ template <typename T> struct LiteralType
     template <> struct LiteralType<cppname>                                                                            \
     {                                                                                                                  \
         static constexpr BuiltinType type = BuiltinType::dbname;                                                       \
+        static constexpr ExpressionKind kind = ExpressionKind::dbname##Literal;                                        \
     };
 ODB_DATATYPE_LIST
 #undef X
@@ -107,7 +142,9 @@ private:
     Reference<SourceLocation> location_;
 };
 
-class ODBCOMPILER_PUBLIC_API Variable : public Node, public RefCounted
+// RefCounted has to be the first base, because Reference<T> reinterpret_casts
+// to it.
+class ODBCOMPILER_PUBLIC_API Variable : public RefCounted, public Node
 {
 public:
     enum class Annotation : int
@@ -118,12 +155,15 @@ public:
     };
 
     Variable(SourceLocation* location, std::string name, Annotation annotation, Type type);
+    Variable(SourceLocation* location, ast::Atom atom, std::string name, Annotation annotation, Type type);
 
     const std::string& name() const;
+    ast::Atom atom() const;
     Annotation annotation() const;
     const Type& type() const;
 
 private:
+    ast::Atom atom_;
     std::string name_;
     Annotation annotation_;
     Type type_;
@@ -134,8 +174,13 @@ private:
 class ODBCOMPILER_PUBLIC_API Expression : public Node
 {
 public:
-    Expression(SourceLocation* location);
+    Expression(SourceLocation* location, ExpressionKind kind);
     virtual Type getType() const = 0;
+
+    ExpressionKind kind() const { return kind_; }
+
+private:
+    ExpressionKind kind_;
 };
 
 class ODBCOMPILER_PUBLIC_API CastExpression : public Expression
@@ -148,6 +193,9 @@ public:
     Expression* expression() const;
     const Type& targetType() const;
 
+    void setExpression(Ptr<Expression> expression);
+    void setTargetType(Type targetType);
+
 private:
     Ptr<Expression> expression_;
     Type targetType_;
@@ -163,6 +211,8 @@ public:
     UnaryOp op() const;
     Expression* expression() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     UnaryOp op_;
     Ptr<Expression> expr_;
@@ -179,6 +229,9 @@ public:
     Expression* left() const;
     Expression* right() const;
 
+    void setLeft(Ptr<Expression> left);
+    void setRight(Ptr<Expression> right);
+
 private:
     BinaryOp op_;
     Ptr<Expression> left_;
@@ -202,7 +255,7 @@ private:
 class ODBCOMPILER_PUBLIC_API Literal : public Expression
 {
 public:
-    Literal(SourceLocation* location);
+    Literal(SourceLocation* location, ExpressionKind kind);
     virtual Type literalType() const = 0;
 
     Type getType() const override { return literalType(); }
@@ -211,7 +264,10 @@ public:
 template <typename T> class LiteralTemplate : public Literal
 {
 public:
-    LiteralTemplate(SourceLocation* location, const T& value) : Literal(location), value_(value) {}
+    LiteralTemplate(SourceLocation* location, const T& value)
+        : Literal(location, LiteralType<T>::kind), value_(value)
+    {
+    }
     const T& value() const { return value_; }
     Type literalType() const override { return Type{LiteralType<T>::type}; }
 
@@ -245,6 +301,10 @@ public:
     const PtrVector<Expression>& arguments() const;
     Type returnType() const;
 
+    void setArgument(std::size_t index, Ptr<Expression> argument);
+    void setCommand(const cmd::Command* command, Type returnType);
+    void setUserFunction(FunctionDefinition* userFunction, Type returnType);
+
 private:
     const cmd::Command* command_;
     FunctionDefinition* userFunction_;
@@ -257,12 +317,16 @@ private:
 class ODBCOMPILER_PUBLIC_API Statement : public Node
 {
 public:
-    Statement(SourceLocation* location, FunctionDefinition* containingFunction);
+    Statement(SourceLocation* location, FunctionDefinition* containingFunction, StatementKind kind);
 
     FunctionDefinition* containingFunction() const;
+    StatementKind kind() const { return kind_; }
 
 protected:
     FunctionDefinition* containingFunction_;
+
+private:
+    StatementKind kind_;
 };
 
 using StatementBlock = PtrVector<Statement>;
@@ -280,6 +344,8 @@ public:
     const Variable* variable() const;
     Expression* expression() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     Reference<Variable> variable_;
     Ptr<Expression> expression_;
@@ -299,6 +365,8 @@ public:
     const StatementBlock& trueBranch() const;
     const StatementBlock& falseBranch() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     Ptr<Expression> expression_;
     StatementBlock trueBranch_;
@@ -308,6 +376,8 @@ private:
 class ODBCOMPILER_PUBLIC_API Select : public Statement
 {
 public:
+    // The case runs if the condition equals the expression. The condition of
+    // the default case is null.
     struct Case
     {
         Ptr<Expression> condition;
@@ -324,6 +394,8 @@ public:
     Expression* expression() const;
     const std::vector<Case>& cases() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     Ptr<Expression> expression_;
     std::vector<Case> cases_;
@@ -343,7 +415,7 @@ public:
 
 protected:
     // Protected constructor to avoid instantiation.
-    Loop(SourceLocation* location, FunctionDefinition* containingFunction, StatementBlock block);
+    Loop(SourceLocation* location, FunctionDefinition* containingFunction, StatementKind kind, StatementBlock block);
 
 private:
     StatementBlock statements_;
@@ -360,9 +432,13 @@ public:
     ForLoop& operator=(const ForLoop&) = delete;
 
     const VarAssignment& assignment() const;
+    VarAssignment& assignment();
     Expression* endValue() const;
     Expression* stepValue() const;
 
+    void setEndValue(Ptr<Expression> endValue);
+    void setStepValue(Ptr<Expression> stepValue);
+
 private:
     VarAssignment assignment_;
     Ptr<Expression> endValue_;
@@ -381,6 +457,8 @@ public:
 
     Expression* expression() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     Ptr<Expression> expression_;
 };
@@ -397,6 +475,8 @@ public:
 
     Expression* expression() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     Ptr<Expression> expression_;
 };
@@ -458,6 +538,7 @@ public:
     FunctionCall& operator=(const FunctionCall&) = delete;
 
     const FunctionCallExpression& expression() const;
+    FunctionCallExpression& expression();
 
 private:
     FunctionCallExpression expression_;
@@ -493,6 +574,8 @@ public:
 
     Expression* expression() const;
 
+    void setExpression(Ptr<Expression> expression);
+
 private:
     Ptr<Expression> expression_;
 };
@@ -512,12 +595,14 @@ public:
     {
     public:
         void add(Reference<Variable> variable);
-        Reference<Variable> lookup(const std::string& name, Variable::Annotation annotation) const;
+        Reference<Variable> lookup(ast::Atom name, Variable::Annotation annotation) const;
 
         const std::vector<Variable*>& list() const;
 
     private:
-        std::unordered_map<std::string, std::array<Reference<Variable>, 3>> variables_;
+        // Keyed on the interned name, so lookups neither hash nor compare
+        // strings, and ignore case the same way DBP does
+        std::unordered_map<ast::Atom, std::array<Reference<Variable>, 3>> variables_;
         std::vector<Variable*> variables_as_list_;
     };
 
@@ -539,6 +624,10 @@ public:
     VariableScope& variables();
     const VariableScope& variables() const;
 
+    // Returns the variable the argument at index is bound to, or nullptr if
+    // the function body never refers to the argument.
+    const Variable* argumentVariable(std::size_t index) const;
+
 private:
     std::string name_;
     std::vector<Argument> arguments_;
@@ -568,6 +657,7 @@ public:
     Program& operator=(const Program&) = delete;
 
     const FunctionDefinition& mainFunction() const;
+    FunctionDefinition& mainFunction();
     const PtrVector<FunctionDefinition>& functions() const;
 
 private:
@@ -3,7 +3,44 @@
 #include "odb-compiler/config.hpp"
 #include "odb-compiler/ir/Node.hpp"
 #include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
 
 namespace odb::ir {
 ODBCOMPILER_PUBLIC_API Ptr<Program> runSemanticChecks(const ast::Block* ast, const cmd::CommandIndex& cmdIndex);
-}  // namespace odb::ir
\ No newline at end of file
+
+struct SemanticCheckPipelineData;
+
+/*!
+ * Runs the semantic checks while the program is still being parsed. Set it as
+ * the statement consumer of a driver, and each top-level statement is
+ * converted to IR on a separate thread while parsing continues, after which
+ * its AST is freed. If more than one file is parsed, they are treated as if
+ * they had been merged in the order they were parsed.
+ *
+ * The resulting program is identical to the one returned by
+ * runSemanticChecks() for the merged AST.
+ */
+class ODBCOMPILER_PUBLIC_API SemanticCheckPipeline : public db::StatementConsumer
+{
+public:
+    explicit SemanticCheckPipeline(const cmd::CommandIndex& cmdIndex);
+
+    /*!
+     * Stops converting and discards all statements that weren't converted
+     * yet, unless finish() was already called. Use this if parsing failed.
+     */
+    ~SemanticCheckPipeline();
+
+    void consumeStatement(ast::Statement* statement) override;
+
+    /*!
+     * Waits for all statements to be converted and returns the program, or
+     * nullptr if a semantic error occurred. Must only be called once, after
+     * all files were parsed successfully.
+     */
+    Ptr<Program> finish();
+
+private:
+    std::unique_ptr<SemanticCheckPipelineData> data_;
+};
+}  // namespace odb::ir
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "odb-compiler/irpost/Process.hpp"
+
+namespace odb::irpost {
+
+// Replaces unary, binary and cast expressions of scalar literals with their
+// result, and references to variables with the literal last assigned to them
+// where that value is known. Results are computed with the same operators as
+// the interpreter. Expressions that would fail at runtime, such as integer
+// division by zero, are left alone.
+class ODBCOMPILER_PUBLIC_API FoldConstants : public Process
+{
+public:
+    bool execute(ir::Program* program) override final;
+};
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include <vector>
+#include <memory>
+
+namespace odb {
+namespace ir {
+    class Program;
+}
+namespace irpost {
+
+// A pass over the IR of a whole program, run after the semantic checks and
+// before code generation. Processes may change the program, but it has to
+// mean the same thing afterwards.
+class ODBCOMPILER_PUBLIC_API Process
+{
+public:
+    virtual ~Process() = default;
+    virtual bool execute(ir::Program* program) = 0;
+};
+
+class ODBCOMPILER_PUBLIC_API ProcessGroup
+{
+public:
+    ProcessGroup() = default;
+    ProcessGroup(const ProcessGroup&) = delete;
+    ProcessGroup(ProcessGroup&&) = default;
+    ProcessGroup& operator=(const ProcessGroup&) = delete;
+    ProcessGroup& operator=(ProcessGroup&&) = default;
+
+    void addProcess(std::unique_ptr<Process> process);
+    bool execute(ir::Program* program);
+
+private:
+    std::vector<std::unique_ptr<Process>> processes_;
+};
+
+// The processes every program goes through before code generation.
+ODBCOMPILER_PUBLIC_API ProcessGroup createDefaultProcessGroup();
+
+}
+}
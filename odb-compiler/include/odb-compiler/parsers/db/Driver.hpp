@@ -1,6 +1,7 @@
 #pragma once
 
 #include "odb-compiler/config.hpp"
+#include "odb-compiler/ast/SourceFileTable.hpp"
 #include "odb-compiler/parsers/db/Scanner.hpp"
 #include "odb-sdk/Reference.hpp"
 #include <string>
@@ -8,6 +9,8 @@
 
 namespace odb {
 
+class MappedFile;
+
 namespace ast {
     class ArrayRef;
     class Assignment;
@@ -15,6 +18,7 @@ namespace ast {
     class Expression;
     class Literal;
     class SourceLocation;
+    class Statement;
     class UDTFieldOuter;
     class VarRef;
 }
@@ -25,6 +29,27 @@ namespace cmd {
 
 namespace db {
 
+class FastScanner;
+
+/*!
+ * @brief Receives the top-level statements of a program while it is being
+ * parsed, see Driver::setStatementConsumer().
+ */
+class ODBCOMPILER_PUBLIC_API StatementConsumer
+{
+public:
+    virtual ~StatementConsumer() = default;
+
+    /*!
+     * Called on the parsing thread as soon as the parser has reduced a
+     * statement at the top level of the source, i.e. a statement of main or
+     * a function declaration. Statements are passed on in source order.
+     * Ownership is shared using Reference<> as usual, but the parser doesn't
+     * keep a reference of its own.
+     */
+    virtual void consumeStatement(ast::Statement* statement) = 0;
+};
+
 class ODBCOMPILER_PUBLIC_API Driver
 {
 public:
@@ -34,6 +59,34 @@ public:
         DEC = -1
     };
 
+    /*!
+     * @brief If enabled, all AST nodes and source locations created during a
+     * single call to parse() are bump-allocated from one odb::Arena instead
+     * of being individually allocated on the heap. The returned AST can be
+     * used with Reference<> as usual. The arena's memory is freed in bulk
+     * once the last node created by that parse is destroyed.
+     */
+    void setUseArena(bool enable);
+
+    /*!
+     * @brief If enabled, tokens are scanned by the hand written FastScanner
+     * instead of the FLEX generated scanner. Both produce the same tokens and
+     * locations.
+     */
+    void setUseFastScanner(bool enable);
+
+    /*!
+     * @brief If set, top-level statements are handed to the consumer as soon
+     * as they are parsed instead of being collected into the block returned
+     * by parse(). On success, parse() then returns an empty block. The
+     * consumer is free to process statements on another thread, so the
+     * nodes are always heap allocated, even if setUseArena() is enabled.
+     *
+     * If parsing fails, the statements passed on before the error are not
+     * taken back.
+     */
+    void setStatementConsumer(StatementConsumer* consumer);
+
     // ------------------------------------------------------------------------
     // Functions below are used by BISON only
     // ------------------------------------------------------------------------
@@ -44,6 +97,12 @@ public:
      */
     ODBCOMPILER_PRIVATE_API void giveProgram(ast::Block* program);
 
+    /*!
+     * Appends a statement to the top-level block of the program, or passes
+     * it on to the statement consumer, if there is one.
+     */
+    ODBCOMPILER_PRIVATE_API void giveTopLevelStatement(ast::Block* program, ast::Statement* statement);
+
     /*!
      * Attempts to create the smallest possible literal type based on the value
      * of the literal.
@@ -70,45 +129,84 @@ public:
 
     /*!
      * Factory method for converting a BISON location into a SourceLocation.
-     * Depending on whether a file is being parsed or a string is being parsed,
-     * this will return a different instance (handled by derived Driver classes)
+     * The location refers to the source currently being parsed, which derived
+     * Driver classes register with the SourceFileTable before parsing.
      */
-    ODBCOMPILER_PRIVATE_API virtual ast::SourceLocation* newLocation(const DBLTYPE* loc) const = 0;
+    ODBCOMPILER_PRIVATE_API ast::SourceLocation* newLocation(const DBLTYPE* loc) const;
 
     // ------------------------------------------------------------------------
     // Functions above used by BISON only
     // ------------------------------------------------------------------------
 
+    /*!
+     * Called by FLEX for every match so the driver can record where each line
+     * starts. The resulting line index is handed to the SourceFileTable, which
+     * makes rendering diagnostics an O(1) seek.
+     */
+    ODBCOMPILER_PRIVATE_API void addScannedText(const char* text, int length);
+
+    // ------------------------------------------------------------------------
+    // Functions above used by FLEX only
+    // ------------------------------------------------------------------------
+
 protected:
-    ast::Block* doParse(dbscan_t scanner, dbpstate* parser, const cmd::CommandMatcher& commandMatcher);
+    /*!
+     * Tokens are read from fastScanner if it isn't null, otherwise from the
+     * FLEX scanner. The FLEX scanner must exist in either case, because the
+     * parser uses it to get back to the driver.
+     */
+    ast::Block* doParse(dbscan_t scanner, FastScanner* fastScanner, dbpstate* parser, const cmd::CommandMatcher& commandMatcher);
+
+    /*!
+     * Sets the source that subsequent locations refer to and starts a new
+     * line index. endSource() passes the index on to the SourceFileTable if
+     * the entire source was scanned, and releases the reference on the source
+     * that was returned along with its ID.
+     */
+    void beginSource(ast::SourceFileId id, size_t length);
+    void endSource();
+
+    ast::SourceFileId sourceFileId_ = 0;
+    bool useFastScanner_ = false;
 
 private:
     odb::Reference<ast::Block> program_;
+    std::vector<uint32_t> lineStarts_;
+    size_t sourceLength_ = 0;
+    size_t scanOffset_ = 0;
+    bool useArena_ = false;
+    StatementConsumer* statementConsumer_ = nullptr;
 };
 
 class ODBCOMPILER_PUBLIC_API FileParserDriver : public Driver
 {
 public:
+    /*!
+     * @brief If enabled, the file is memory mapped and scanned in place
+     * instead of being read into a string first. The mapping is kept alive by
+     * the SourceFileTable for as long as locations refer to it. The FLEX
+     * scanner writes into the buffer it scans, so it scans a second private
+     * mapping of the file. Files that can't be mapped are read normally.
+     */
+    void setUseMemoryMap(bool enable);
+
     ast::Block* parse(const std::string& fileName, const cmd::CommandMatcher& commandMatcher);
 
-protected:
-    virtual ast::SourceLocation* newLocation(const DBLTYPE* loc) const override;
+    /*!
+     * @brief Parses a file that the caller already mapped, for example to
+     * look it up in a cache first. The mapping is registered with the
+     * SourceFileTable the same way setUseMemoryMap() does.
+     */
+    ast::Block* parse(MappedFile* file, const cmd::CommandMatcher& commandMatcher);
 
 private:
-    const std::string* fileName_;
+    bool useMemoryMap_ = false;
 };
 
 class ODBCOMPILER_PUBLIC_API StringParserDriver : public Driver
 {
 public:
     ast::Block* parse(const std::string& sourceName, const std::string& str, const cmd::CommandMatcher& commandMatcher);
-
-protected:
-    virtual ast::SourceLocation* newLocation(const DBLTYPE* loc) const override;
-
-private:
-    const std::string* sourceName_;
-    const std::string* code_;
 };
 
 }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "odb-compiler/config.hpp"
+#include "odb-compiler/parsers/db/Scanner.hpp"
+#include <string_view>
+
+namespace odb {
+namespace db {
+
+/*!
+ * @brief Hand written alternative to the FLEX scanner in Scanner.lex. It
+ * returns the same tokens, values and locations as dblex(), but skips
+ * whitespace, remarks and the bodies of strings in bulk using SSE2/AVX2 where
+ * available, and parses numeric literals in a single pass.
+ *
+ * The scanner reads the buffer in place and never modifies it. The buffer
+ * does not need to be NUL terminated, but must outlive the scanner.
+ */
+class ODBCOMPILER_PUBLIC_API FastScanner
+{
+public:
+    /*!
+     * @param[in] driver Every scanned character is reported to the driver
+     * through Driver::addScannedText(), same as with FLEX. May be null.
+     */
+    FastScanner(Driver* driver, const char* data, size_t length);
+
+    /*!
+     * Scans the next token. Same as dblex(), this returns TOK_END (0) once
+     * the end of the buffer is reached, and advances the location passed in
+     * from where the previous token ended.
+     */
+    int lex(DBSTYPE* value, DBLTYPE* loc);
+
+    /*!
+     * Text of the token returned by the last call to lex(). It points into
+     * the scanned buffer, so unlike with FLEX it stays valid for as long as
+     * the buffer does.
+     */
+    std::string_view text() const;
+
+private:
+    int scan(DBSTYPE* value, DBLTYPE* loc);
+    int scanNumber(DBSTYPE* value, DBLTYPE* loc);
+    void skipComment(const char* begin, const char* bodyBegin, const char* terminator, size_t terminatorLength, DBLTYPE* loc);
+    int token(int kind, const char* end, DBLTYPE* loc);
+
+    Driver* driver_;
+    const char* pos_;
+    const char* end_;
+    std::string_view text_;
+};
+
+}
+}
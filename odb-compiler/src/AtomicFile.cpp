@@ -0,0 +1,42 @@
+#include "AtomicFile.hpp"
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace odb {
+
+// ----------------------------------------------------------------------------
+bool writeFileAtomically(const std::filesystem::path& fileName, const void* data, size_t size)
+{
+    std::filesystem::path tmpPath = fileName;
+    tmpPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+             + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())
+             + ".tmp";
+
+    std::error_code ec;
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        if (!out.is_open())
+            return false;
+        out.write(static_cast<const char*>(data), (std::streamsize)size);
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, fileName, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace odb {
+
+/*!
+ * Replaces the file with the data in a way that readers never see a
+ * partially written file. The data is written to a temporary file unique to
+ * the calling thread, which is then renamed into place. Returns false if
+ * anything failed, in which case the temporary file is removed again and the
+ * original file is left untouched.
+ */
+bool writeFileAtomically(const std::filesystem::path& fileName, const void* data, size_t size);
+
+}
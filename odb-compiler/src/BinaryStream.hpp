@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace odb {
+
+/*!
+ * Appends values to a byte buffer in the format shared by the AST cache and
+ * bytecode files. Values are written in the host's byte order, counts and
+ * sizes as LEB128 varints.
+ */
+class BinaryWriter
+{
+public:
+    explicit BinaryWriter(std::vector<uint8_t>* out) : out_(out) {}
+
+    void writeBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        out_->insert(out_->end(), bytes, bytes + size);
+    }
+
+    void writeU8(uint8_t value) { out_->push_back(value); }
+
+    void writeVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out_->push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out_->push_back((uint8_t)value);
+    }
+
+    void writeString(std::string_view str)
+    {
+        writeVarint(str.size());
+        writeBytes(str.data(), str.size());
+    }
+
+    template <typename T>
+    void writeValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "");
+        writeBytes(&value, sizeof(T));
+    }
+    void writeValue(bool value) { writeU8(value ? 1 : 0); }
+    void writeValue(const std::string& value) { writeString(value); }
+
+private:
+    std::vector<uint8_t>* out_;
+};
+
+/*!
+ * Reads values written by BinaryWriter. Every function returns false instead
+ * of reading past the end of the data or accepting malformed values.
+ */
+class BinaryReader
+{
+public:
+    BinaryReader(const uint8_t* data, size_t size) : ptr_(data), end_(data + size) {}
+
+    bool readBytes(void* data, size_t size)
+    {
+        if ((size_t)(end_ - ptr_) < size)
+            return false;
+        memcpy(data, ptr_, size);
+        ptr_ += size;
+        return true;
+    }
+
+    bool readU8(uint8_t* value)
+    {
+        return readBytes(value, 1);
+    }
+
+    bool readVarint(uint64_t* value)
+    {
+        *value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (ptr_ == end_)
+                return false;
+            uint8_t byte = *ptr_++;
+            *value |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool readCount(size_t* count)
+    {
+        // Every element takes up at least one byte, which gives a cheap
+        // sanity check against absurd counts in corrupt data
+        uint64_t value;
+        if (!readVarint(&value) || value > (uint64_t)(end_ - ptr_))
+            return false;
+        *count = (size_t)value;
+        return true;
+    }
+
+    bool readString(std::string* str)
+    {
+        size_t size;
+        if (!readCount(&size))
+            return false;
+        str->assign(reinterpret_cast<const char*>(ptr_), size);
+        ptr_ += size;
+        return true;
+    }
+
+    template <typename T>
+    bool readValue(T* value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "");
+        return readBytes(value, sizeof(T));
+    }
+    bool readValue(bool* value)
+    {
+        uint8_t byte;
+        if (!readU8(&byte) || byte > 1)
+            return false;
+        *value = byte != 0;
+        return true;
+    }
+    bool readValue(std::string* value) { return readString(value); }
+
+    bool atEnd() const { return ptr_ == end_; }
+
+private:
+    const uint8_t* ptr_;
+    const uint8_t* end_;
+};
+
+}
@@ -0,0 +1,225 @@
+#include "odb-compiler/Stats.hpp"
+#include <atomic>
+#include <cassert>
+#include <ctime>
+#include <mutex>
+
+#if defined(ODBCOMPILER_PLATFORM_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+// Version 2 maps GetProcessMemoryInfo() to kernel32, so psapi.lib isn't needed
+#   define PSAPI_VERSION 2
+#   include <windows.h>
+#   include <psapi.h>
+#else
+#   include <sys/resource.h>
+#endif
+
+namespace odb {
+
+namespace {
+
+struct State
+{
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> counters[Stats::COUNTER_COUNT] = {};
+
+    std::mutex timingsMutex;
+    std::vector<Stats::Timing> timings;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+static State& state()
+{
+    static State state;
+    return state;
+}
+
+#if defined(ODBCOMPILER_PLATFORM_WIN32)
+// ----------------------------------------------------------------------------
+static double fileTimeToSeconds(const FILETIME& time)
+{
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return value.QuadPart * 1e-7;
+}
+#else
+// ----------------------------------------------------------------------------
+static double clockSeconds(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+void Stats::setEnabled(bool enable)
+{
+    state().enabled.store(enable, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+bool Stats::enabled()
+{
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+void Stats::add(Counter counter, uint64_t amount)
+{
+    assert(counter < COUNTER_COUNT);
+    State& s = state();
+    if (s.enabled.load(std::memory_order_relaxed))
+        s.counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+uint64_t Stats::get(Counter counter)
+{
+    assert(counter < COUNTER_COUNT);
+    return state().counters[counter].load(std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+const char* Stats::key(Counter counter)
+{
+    static const char* keys[] = {
+#define X(name, key, description) key,
+        ODB_STATS_COUNTER_LIST
+#undef X
+    };
+    assert(counter < COUNTER_COUNT);
+    return keys[counter];
+}
+
+// ----------------------------------------------------------------------------
+const char* Stats::description(Counter counter)
+{
+    static const char* descriptions[] = {
+#define X(name, key, description) description,
+        ODB_STATS_COUNTER_LIST
+#undef X
+    };
+    assert(counter < COUNTER_COUNT);
+    return descriptions[counter];
+}
+
+// ----------------------------------------------------------------------------
+std::vector<Stats::Timing> Stats::timings()
+{
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.timingsMutex);
+    return s.timings;
+}
+
+// ----------------------------------------------------------------------------
+void Stats::addTiming(Timing timing)
+{
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.timingsMutex);
+    s.timings.push_back(std::move(timing));
+}
+
+// ----------------------------------------------------------------------------
+uint64_t Stats::peakResidentSetSize()
+{
+#if defined(ODBCOMPILER_PLATFORM_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#   if defined(ODBCOMPILER_PLATFORM_MACOS)
+    return (uint64_t)usage.ru_maxrss;
+#   else
+    // Linux reports kilobytes
+    return (uint64_t)usage.ru_maxrss * 1024;
+#   endif
+#endif
+}
+
+// ----------------------------------------------------------------------------
+double Stats::processCPUTime()
+{
+#if defined(ODBCOMPILER_PLATFORM_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    return fileTimeToSeconds(kernel) + fileTimeToSeconds(user);
+#else
+    return clockSeconds(CLOCK_PROCESS_CPUTIME_ID);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+double Stats::threadCPUTime()
+{
+#if defined(ODBCOMPILER_PLATFORM_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    return fileTimeToSeconds(kernel) + fileTimeToSeconds(user);
+#else
+    return clockSeconds(CLOCK_THREAD_CPUTIME_ID);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+void Stats::reset()
+{
+    State& s = state();
+    for (auto& counter : s.counters)
+        counter.store(0, std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(s.timingsMutex);
+    s.timings.clear();
+}
+
+// ----------------------------------------------------------------------------
+PhaseTimer::PhaseTimer(const char* phase) :
+    phase_(phase),
+    threadCPU_(false),
+    enabled_(Stats::enabled()),
+    trace_("phase", phase)
+{
+    if (enabled_)
+    {
+        startWall_ = std::chrono::steady_clock::now();
+        startCPU_ = Stats::processCPUTime();
+    }
+}
+
+// ----------------------------------------------------------------------------
+PhaseTimer::PhaseTimer(const char* phase, const std::string& file) :
+    phase_(phase),
+    threadCPU_(true),
+    enabled_(Stats::enabled()),
+    trace_("phase", phase, file)
+{
+    if (enabled_)
+    {
+        file_ = file;
+        startWall_ = std::chrono::steady_clock::now();
+        startCPU_ = Stats::threadCPUTime();
+    }
+}
+
+// ----------------------------------------------------------------------------
+PhaseTimer::~PhaseTimer()
+{
+    if (!enabled_)
+        return;
+
+    double cpu = threadCPU_ ? Stats::threadCPUTime() : Stats::processCPUTime();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - startWall_;
+    Stats::addTiming({phase_, file_, wall.count(), cpu - startCPU_});
+}
+
+}
@@ -0,0 +1,106 @@
+#include "odb-compiler/Trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace odb {
+
+namespace {
+
+struct State
+{
+    std::atomic<bool> enabled{false};
+    std::atomic<uint32_t> nextThreadId{1};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::mutex eventsMutex;
+    std::vector<Trace::Event> events;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+static State& state()
+{
+    static State state;
+    return state;
+}
+
+// ----------------------------------------------------------------------------
+void Trace::setEnabled(bool enable)
+{
+    state().enabled.store(enable, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+bool Trace::enabled()
+{
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+int64_t Trace::now()
+{
+    auto elapsed = std::chrono::steady_clock::now() - state().epoch;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+// ----------------------------------------------------------------------------
+uint32_t Trace::threadId()
+{
+    thread_local uint32_t id = state().nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// ----------------------------------------------------------------------------
+void Trace::addEvent(Event event)
+{
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.eventsMutex);
+    s.events.push_back(std::move(event));
+}
+
+// ----------------------------------------------------------------------------
+std::vector<Trace::Event> Trace::events()
+{
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.eventsMutex);
+    return s.events;
+}
+
+// ----------------------------------------------------------------------------
+void Trace::reset()
+{
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.eventsMutex);
+    s.events.clear();
+}
+
+// ----------------------------------------------------------------------------
+TraceScope::TraceScope(const char* category, const char* name, std::string_view detail) :
+    category_(category),
+    enabled_(Trace::enabled())
+{
+    if (!enabled_)
+        return;
+
+    name_ = name;
+    if (!detail.empty())
+    {
+        name_ += " ";
+        name_ += detail;
+    }
+    threadId_ = Trace::threadId();
+    start_ = Trace::now();
+}
+
+// ----------------------------------------------------------------------------
+TraceScope::~TraceScope()
+{
+    if (!enabled_)
+        return;
+
+    Trace::addEvent({category_, std::move(name_), start_, Trace::now() - start_, threadId_});
+}
+
+}
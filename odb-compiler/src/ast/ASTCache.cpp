@@ -0,0 +1,134 @@
+#include "odb-compiler/ast/ASTCache.hpp"
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/ast/Serialization.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-sdk/Log.hpp"
+#include "../AtomicFile.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace odb::ast {
+
+namespace {
+
+struct EntryHeader
+{
+    char magic[8];
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t commandIndexHash;
+};
+
+}
+
+static constexpr char entryMagic[8] = {'O', 'D', 'B', 'C', 'A', 'C', 'H', 'E'};
+
+// ----------------------------------------------------------------------------
+// 64-bit FNV-1a. Not cryptographic, but the key also includes the source size
+// and the file name, and a stale entry can only ever come from a local file.
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i != size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// ----------------------------------------------------------------------------
+ASTCache::ASTCache(const std::filesystem::path& directory, const cmd::CommandIndex& commandIndex) :
+    directory_(directory),
+    commandIndexHash_(hashCommandIndex(commandIndex))
+{
+}
+
+// ----------------------------------------------------------------------------
+uint64_t ASTCache::hashCommandIndex(const cmd::CommandIndex& commandIndex)
+{
+    // Only the command names affect how a source file is parsed. The NUL
+    // terminator is included so "a b" + "c" and "a" + "b c" differ
+    uint64_t hash = hashBytes(nullptr, 0);
+    for (const auto& name : commandIndex.commandNamesAsList())
+        hash = hashBytes(name.c_str(), name.size() + 1, hash);
+    return hash;
+}
+
+// ----------------------------------------------------------------------------
+std::filesystem::path ASTCache::entryPath(const std::string& fileName, uint64_t sourceHash) const
+{
+    uint64_t key = hashBytes(fileName.c_str(), fileName.size() + 1);
+    key = hashBytes(&sourceHash, sizeof(sourceHash), key);
+    key = hashBytes(&commandIndexHash_, sizeof(commandIndexHash_), key);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ast", (unsigned long long)key);
+    return directory_ / name;
+}
+
+// ----------------------------------------------------------------------------
+Block* ASTCache::load(const std::string& fileName, std::string_view source) const
+{
+    uint64_t sourceHash = hashBytes(source.data(), source.size());
+    std::ifstream in(entryPath(fileName, sourceHash), std::ios::binary);
+    if (!in.is_open())
+        return nullptr;
+
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(EntryHeader))
+        return nullptr;
+
+    EntryHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, entryMagic, sizeof(entryMagic)) != 0 ||
+        header.sourceHash != sourceHash ||
+        header.sourceSize != source.size() ||
+        header.commandIndexHash != commandIndexHash_)
+    {
+        return nullptr;
+    }
+
+    Node* node = deserialize(data.data() + sizeof(header), data.size() - sizeof(header));
+    Block* block = dynamic_cast<Block*>(node);
+    if (block == nullptr)
+    {
+        Log::ast(Log::WARNING, "Ignoring corrupt AST cache entry for `%s`\n", fileName.c_str());
+        Reference<Node> discard = node;
+        return nullptr;
+    }
+
+    return block;
+}
+
+// ----------------------------------------------------------------------------
+bool ASTCache::store(const std::string& fileName, std::string_view source, const Block* block) const
+{
+    EntryHeader header;
+    memcpy(header.magic, entryMagic, sizeof(entryMagic));
+    header.sourceHash = hashBytes(source.data(), source.size());
+    header.sourceSize = source.size();
+    header.commandIndexHash = commandIndexHash_;
+
+    std::vector<uint8_t> data(sizeof(header));
+    memcpy(data.data(), &header, sizeof(header));
+    serialize(&data, block);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+
+    // Readers must never see a partially written entry
+    std::filesystem::path path = entryPath(fileName, header.sourceHash);
+    if (!writeFileAtomically(path, data.data(), data.size()))
+    {
+        Log::ast(Log::WARNING, "Failed to write AST cache entry `%s`\n", path.string().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -5,7 +5,14 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 AnnotatedSymbol::AnnotatedSymbol(Annotation annotation, const std::string& name, SourceLocation* location) :
-    Symbol(name, location),
+    Symbol(NodeKind::AnnotatedSymbol, name, location),
+    annotation_(annotation)
+{
+}
+
+// ----------------------------------------------------------------------------
+AnnotatedSymbol::AnnotatedSymbol(Annotation annotation, Atom atom, const std::string& name, SourceLocation* location) :
+    Symbol(NodeKind::AnnotatedSymbol, atom, name, location),
     annotation_(annotation)
 {
 }
@@ -41,7 +48,7 @@ void AnnotatedSymbol::swapChild(const Node* oldNode, Node* newNode)
 // ----------------------------------------------------------------------------
 Node* AnnotatedSymbol::duplicateImpl() const
 {
-    return new AnnotatedSymbol(annotation_, name_, location());
+    return new AnnotatedSymbol(annotation_, atom_, name_, location());
 }
 
 }
@@ -7,13 +7,13 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 ArgList::ArgList(SourceLocation* location) :
-    Node(location)
+    Node(NodeKind::ArgList, location)
 {
 }
 
 // ----------------------------------------------------------------------------
 ArgList::ArgList(Expression* expr, SourceLocation* location) :
-    Node(location)
+    Node(NodeKind::ArgList, location)
 {
     appendExpression(expr);
 }
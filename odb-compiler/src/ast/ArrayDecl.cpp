@@ -9,8 +9,8 @@
 namespace odb::ast {
 
 // ----------------------------------------------------------------------------
-ArrayDecl::ArrayDecl(ScopedAnnotatedSymbol* symbol, ArgList* dims, SourceLocation* location)
-    : Statement(location)
+ArrayDecl::ArrayDecl(NodeKind kind, ScopedAnnotatedSymbol* symbol, ArgList* dims, SourceLocation* location)
+    : Statement(kind, location)
     , symbol_(symbol)
     , dims_(dims)
 {
@@ -35,7 +35,7 @@ ArgList* ArrayDecl::dims() const
     dbname##ArrayDecl::dbname##ArrayDecl(ScopedAnnotatedSymbol* symbol,       \
                                                   ArgList* dims,              \
                                                   SourceLocation* location)   \
-        : ArrayDecl(symbol, dims, location)                                   \
+        : ArrayDecl(NodeKind::dbname##ArrayDecl, symbol, dims, location)      \
     {                                                                         \
     }                                                                         \
                                                                               \
@@ -85,7 +85,7 @@ ODB_DATATYPE_LIST
 
 // ----------------------------------------------------------------------------
 UDTArrayDecl::UDTArrayDecl(ScopedAnnotatedSymbol* symbol, ArgList* dims, UDTRef* udt, SourceLocation* location)
-    : ArrayDecl(symbol, dims, location)
+    : ArrayDecl(NodeKind::UDTArrayDecl, symbol, dims, location)
     , udt_(udt)
 {
     udt->setParent(this);
@@ -9,7 +9,7 @@ namespace ast {
 
 // ----------------------------------------------------------------------------
 ArrayRef::ArrayRef(AnnotatedSymbol* symbol, ArgList* args, SourceLocation* location) :
-    LValue(location),
+    LValue(NodeKind::ArrayRef, location),
     symbol_(symbol),
     args_(args)
 {
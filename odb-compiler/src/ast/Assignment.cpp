@@ -10,8 +10,8 @@
 namespace odb::ast {
 
 // ----------------------------------------------------------------------------
-Assignment::Assignment(LValue* lvalue, Expression* expr, SourceLocation* location)
-    : Statement(location)
+Assignment::Assignment(NodeKind kind, LValue* lvalue, Expression* expr, SourceLocation* location)
+    : Statement(kind, location)
     , lvalue_(lvalue)
     , expr_(expr)
 {
@@ -33,7 +33,7 @@ Expression* Assignment::expression() const
 
 // ----------------------------------------------------------------------------
 VarAssignment::VarAssignment(VarRef* var, Expression* expr, SourceLocation* location)
-    : Assignment(var, expr, location)
+    : Assignment(NodeKind::VarAssignment, var, expr, location)
 {
 }
 
@@ -90,7 +90,7 @@ Node* VarAssignment::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 ArrayAssignment::ArrayAssignment(ArrayRef* var, Expression* expr, SourceLocation* location)
-    : Assignment(var, expr, location)
+    : Assignment(NodeKind::ArrayAssignment, var, expr, location)
 {
 }
 
@@ -147,7 +147,7 @@ Node* ArrayAssignment::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 UDTFieldAssignment::UDTFieldAssignment(UDTFieldOuter* field, Expression* expr, SourceLocation* location)
-    : Assignment(field, expr, location)
+    : Assignment(NodeKind::UDTFieldAssignment, field, expr, location)
 {
 }
 
@@ -0,0 +1,175 @@
+#include "odb-compiler/ast/Atom.hpp"
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace odb::ast {
+
+namespace {
+
+char toLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Names are hashed and compared ignoring case, so they can be looked up the
+// way they are spelled in the source without folding them into a new string
+struct CaseInsensitiveHash
+{
+    size_t operator()(std::string_view name) const
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : name)
+        {
+            hash ^= (unsigned char)toLower(c);
+            hash *= 1099511628211ull;
+        }
+        return (size_t)hash;
+    }
+};
+
+struct CaseInsensitiveEqual
+{
+    bool operator()(std::string_view a, std::string_view b) const
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i != a.size(); ++i)
+            if (toLower(a[i]) != toLower(b[i]))
+                return false;
+        return true;
+    }
+};
+
+using NameMap = std::unordered_map<std::string_view, uint32_t, CaseInsensitiveHash, CaseInsensitiveEqual>;
+
+struct Table
+{
+    std::shared_mutex mutex;
+
+    // deque so the keys of byName, which point into it, remain stable as the
+    // table grows
+    std::deque<std::string> names;
+    NameMap byName;
+    int scopes = 0;
+
+    // Incremented every time the table is cleared, so each thread knows when
+    // its cache has to start over
+    std::atomic<uint32_t> generation{0};
+};
+
+// The atoms the thread interned before. Most identifiers are seen many times,
+// and looking them up here means threads don't contend on the table's lock.
+// The keys point into the table's names.
+struct ThreadCache
+{
+    uint32_t generation = 0;
+    NameMap byName;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+static Table& table()
+{
+    static Table table;
+    return table;
+}
+
+// ----------------------------------------------------------------------------
+static ThreadCache& threadCache()
+{
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+// ----------------------------------------------------------------------------
+static void clearLocked(Table& t)
+{
+    t.byName.clear();
+    t.names.clear();
+    t.generation.fetch_add(1, std::memory_order_release);
+}
+
+// ----------------------------------------------------------------------------
+AtomTable::Scope::Scope()
+{
+    Table& t = table();
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    t.scopes++;
+}
+
+// ----------------------------------------------------------------------------
+AtomTable::Scope::~Scope()
+{
+    Table& t = table();
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    if (--t.scopes == 0)
+        clearLocked(t);
+}
+
+// ----------------------------------------------------------------------------
+Atom AtomTable::intern(std::string_view name)
+{
+    Table& t = table();
+    ThreadCache& cache = threadCache();
+    uint32_t generation = t.generation.load(std::memory_order_acquire);
+    if (cache.generation != generation)
+    {
+        cache.byName.clear();
+        cache.generation = generation;
+    }
+
+    auto cached = cache.byName.find(name);
+    if (cached != cache.byName.end())
+        return Atom(cached->second);
+
+    {
+        std::shared_lock<std::shared_mutex> lock(t.mutex);
+        auto it = t.byName.find(name);
+        if (it != t.byName.end())
+        {
+            cache.byName.emplace(it->first, it->second);
+            return Atom(it->second);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    auto it = t.byName.find(name);
+    if (it == t.byName.end())
+    {
+        std::string folded(name);
+        for (char& c : folded)
+            c = toLower(c);
+
+        uint32_t id = (uint32_t)t.names.size();
+        t.names.push_back(std::move(folded));
+        it = t.byName.emplace(t.names.back(), id).first;
+    }
+    cache.byName.emplace(it->first, it->second);
+    return Atom(it->second);
+}
+
+// ----------------------------------------------------------------------------
+std::string_view AtomTable::name(Atom atom)
+{
+    Table& t = table();
+    std::shared_lock<std::shared_mutex> lock(t.mutex);
+    assert(atom.id() < t.names.size());
+    return t.names[atom.id()];
+}
+
+// ----------------------------------------------------------------------------
+void AtomTable::clear()
+{
+    Table& t = table();
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    clearLocked(t);
+}
+
+}
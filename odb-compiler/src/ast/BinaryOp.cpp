@@ -6,7 +6,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 BinaryOp::BinaryOp(BinaryOpType op, Expression* lhs, Expression* rhs, SourceLocation* location)
-    : Expression(location)
+    : Expression(NodeKind::BinaryOp, location)
     , lhs_(lhs)
     , rhs_(rhs)
     , op_(op)
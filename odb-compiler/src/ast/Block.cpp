@@ -8,13 +8,13 @@ namespace ast {
 
 // ----------------------------------------------------------------------------
 Block::Block(SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::Block, location)
 {
 }
 
 // ----------------------------------------------------------------------------
 Block::Block(Statement* stmnt, SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::Block, location)
 {
     appendStatement(stmnt);
 }
@@ -8,7 +8,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 CommandExpr::CommandExpr(const std::string& command, ArgList* args, SourceLocation* location) :
-    Expression(location),
+    Expression(NodeKind::CommandExpr, location),
     args_(args),
     command_(command)
 {
@@ -17,7 +17,7 @@ CommandExpr::CommandExpr(const std::string& command, ArgList* args, SourceLocati
 
 // ----------------------------------------------------------------------------
 CommandExpr::CommandExpr(const std::string& command, SourceLocation* location) :
-    Expression(location),
+    Expression(NodeKind::CommandExpr, location),
     command_(command)
 {
 }
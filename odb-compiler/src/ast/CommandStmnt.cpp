@@ -8,7 +8,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 CommandStmnt::CommandStmnt(const std::string& command, ArgList* args, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::CommandStmnt, location),
     args_(args),
     command_(command)
 {
@@ -17,7 +17,7 @@ CommandStmnt::CommandStmnt(const std::string& command, ArgList* args, SourceLoca
 
 // ----------------------------------------------------------------------------
 CommandStmnt::CommandStmnt(const std::string& command, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::CommandStmnt, location),
     command_(command)
 {
 }
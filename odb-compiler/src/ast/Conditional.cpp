@@ -8,7 +8,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 Conditional::Conditional(Expression* condition, Block* trueBranch, Block* falseBranch, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::Conditional, location),
     cond_(condition),
     true_(trueBranch),
     false_(falseBranch)
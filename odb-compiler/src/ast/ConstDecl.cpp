@@ -8,7 +8,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 ConstDeclExpr::ConstDeclExpr(AnnotatedSymbol* symbol, Expression* expr, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::ConstDeclExpr, location),
     symbol_(symbol),
     expr_(expr)
 {
@@ -75,7 +75,7 @@ Node* ConstDeclExpr::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 ConstDecl::ConstDecl(AnnotatedSymbol* symbol, Literal* literal, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::ConstDecl, location),
     symbol_(symbol),
     literal_(literal)
 {
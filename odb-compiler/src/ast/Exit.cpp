@@ -6,7 +6,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 Exit::Exit(SourceLocation* location) :
-    Statement(location)
+    Statement(NodeKind::Exit, location)
 {
 }
 
@@ -5,8 +5,8 @@ namespace odb {
 namespace ast {
 
 // ----------------------------------------------------------------------------
-Expression::Expression(SourceLocation* location) :
-    Node(location)
+Expression::Expression(NodeKind kind, SourceLocation* location) :
+    Node(kind, location)
 {
 }
 
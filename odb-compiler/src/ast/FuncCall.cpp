@@ -9,7 +9,7 @@ namespace ast {
 
 // ----------------------------------------------------------------------------
 FuncCallExpr::FuncCallExpr(AnnotatedSymbol* symbol, ArgList* args, SourceLocation* location) :
-    Expression(location),
+    Expression(NodeKind::FuncCallExpr, location),
     symbol_(symbol),
     args_(args)
 {
@@ -19,7 +19,7 @@ FuncCallExpr::FuncCallExpr(AnnotatedSymbol* symbol, ArgList* args, SourceLocatio
 
 // ----------------------------------------------------------------------------
 FuncCallExpr::FuncCallExpr(AnnotatedSymbol* symbol, SourceLocation* location) :
-    Expression(location),
+    Expression(NodeKind::FuncCallExpr, location),
     symbol_(symbol)
 {
     symbol->setParent(this);
@@ -86,7 +86,7 @@ Node* FuncCallExpr::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 FuncCallExprOrArrayRef::FuncCallExprOrArrayRef(AnnotatedSymbol* symbol, ArgList* args, SourceLocation* location) :
-    Expression(location),
+    Expression(NodeKind::FuncCallExprOrArrayRef, location),
     symbol_(symbol),
     args_(args)
 {
@@ -155,7 +155,7 @@ Node* FuncCallExprOrArrayRef::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 FuncCallStmnt::FuncCallStmnt(AnnotatedSymbol* symbol, ArgList* args, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncCallStmnt, location),
     symbol_(symbol),
     args_(args)
 {
@@ -165,7 +165,7 @@ FuncCallStmnt::FuncCallStmnt(AnnotatedSymbol* symbol, ArgList* args, SourceLocat
 
 // ----------------------------------------------------------------------------
 FuncCallStmnt::FuncCallStmnt(AnnotatedSymbol* symbol, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncCallStmnt, location),
     symbol_(symbol)
 {
     symbol->setParent(this);
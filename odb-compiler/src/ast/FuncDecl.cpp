@@ -11,7 +11,7 @@ namespace ast {
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, Block* body, Expression* returnValue, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     args_(args),
     body_(body),
@@ -25,7 +25,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, Block* body, Expressi
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, Expression* returnValue, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     args_(args),
     returnValue_(returnValue)
@@ -37,7 +37,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, Expression* returnVal
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, Block* body, Expression* returnValue, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     body_(body),
     returnValue_(returnValue)
@@ -49,7 +49,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, Block* body, Expression* returnValue
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, Expression* returnValue, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     returnValue_(returnValue)
 {
@@ -59,7 +59,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, Expression* returnValue, SourceLocat
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, Block* body, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     args_(args),
     body_(body)
@@ -71,7 +71,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, Block* body, SourceLo
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     args_(args)
 {
@@ -81,7 +81,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, ArgList* args, SourceLocation* locat
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, Block* body, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol),
     body_(body)
 {
@@ -91,7 +91,7 @@ FuncDecl::FuncDecl(AnnotatedSymbol* symbol, Block* body, SourceLocation* locatio
 
 // ----------------------------------------------------------------------------
 FuncDecl::FuncDecl(AnnotatedSymbol* symbol, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncDecl, location),
     symbol_(symbol)
 {
     symbol->setParent(this);
@@ -182,7 +182,7 @@ Node* FuncDecl::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 FuncExit::FuncExit(Expression* returnValue, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::FuncExit, location),
     returnValue_(returnValue)
 {
     returnValue->setParent(this);
@@ -190,7 +190,7 @@ FuncExit::FuncExit(Expression* returnValue, SourceLocation* location) :
 
 // ----------------------------------------------------------------------------
 FuncExit::FuncExit(SourceLocation* location) :
-    Statement(location)
+    Statement(NodeKind::FuncExit, location)
 {
 }
 
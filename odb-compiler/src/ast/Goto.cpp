@@ -8,7 +8,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 Goto::Goto(Symbol* label, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::Goto, location),
     label_(label)
 {
     label->setParent(this);
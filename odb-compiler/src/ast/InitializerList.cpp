@@ -7,13 +7,13 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 InitializerList::InitializerList(SourceLocation* location) :
-    Expression(location)
+    Expression(NodeKind::InitializerList, location)
 {
 }
 
 // ----------------------------------------------------------------------------
 InitializerList::InitializerList(Expression* expr, SourceLocation* location) :
-    Expression(location)
+    Expression(NodeKind::InitializerList, location)
 {
     appendExpression(expr);
 }
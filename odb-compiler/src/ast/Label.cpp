@@ -8,7 +8,7 @@ namespace ast {
 
 // ----------------------------------------------------------------------------
 Label::Label(Symbol* symbol, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::Label, location),
     symbol_(symbol)
 {
     symbol->setParent(this);
@@ -49,15 +49,15 @@
 namespace odb::ast {
 
 // ----------------------------------------------------------------------------
-Literal::Literal(SourceLocation* location) :
-    Expression(location)
+Literal::Literal(NodeKind kind, SourceLocation* location) :
+    Expression(kind, location)
 {
 }
 
 // ----------------------------------------------------------------------------
 #define X(dbname, cppname)                                                    \
     dbname##Literal::dbname##Literal(const cppname& value, SourceLocation* location) \
-        : Literal(location)                                                   \
+        : Literal(NodeKind::dbname##Literal, location)                        \
         , value_(value)                                                       \
     {}                                                                        \
                                                                               \
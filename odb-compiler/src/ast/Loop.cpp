@@ -11,8 +11,8 @@ namespace odb {
 namespace ast {
 
 // ----------------------------------------------------------------------------
-Loop::Loop(SourceLocation* location) :
-    Statement(location)
+Loop::Loop(NodeKind kind, SourceLocation* location) :
+    Statement(kind, location)
 {
 }
 
@@ -21,7 +21,7 @@ Loop::Loop(SourceLocation* location) :
 
 // ----------------------------------------------------------------------------
 InfiniteLoop::InfiniteLoop(Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::InfiniteLoop, location),
     body_(body)
 {
     body->setParent(this);
@@ -29,7 +29,7 @@ InfiniteLoop::InfiniteLoop(Block* body, SourceLocation* location) :
 
 // ----------------------------------------------------------------------------
 InfiniteLoop::InfiniteLoop(SourceLocation* location) :
-    Loop(location)
+    Loop(NodeKind::InfiniteLoop, location)
 {
 }
 
@@ -83,7 +83,7 @@ Node* InfiniteLoop::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 WhileLoop::WhileLoop(Expression* continueCondition, Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::WhileLoop, location),
     continueCondition_(continueCondition),
     body_(body)
 {
@@ -93,7 +93,7 @@ WhileLoop::WhileLoop(Expression* continueCondition, Block* body, SourceLocation*
 
 // ----------------------------------------------------------------------------
 WhileLoop::WhileLoop(Expression* continueCondition, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::WhileLoop, location),
     continueCondition_(continueCondition)
 {
     continueCondition->setParent(this);
@@ -160,7 +160,7 @@ Node* WhileLoop::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 UntilLoop::UntilLoop(Expression* exitCondition, Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::UntilLoop, location),
     exitCondition_(exitCondition),
     body_(body)
 {
@@ -170,7 +170,7 @@ UntilLoop::UntilLoop(Expression* exitCondition, Block* body, SourceLocation* loc
 
 // ----------------------------------------------------------------------------
 UntilLoop::UntilLoop(Expression* exitCondition, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::UntilLoop, location),
     exitCondition_(exitCondition)
 {
     exitCondition->setParent(this);
@@ -237,7 +237,7 @@ Node* UntilLoop::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValue, AnnotatedSymbol* nextSymbol, Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     stepValue_(stepValue),
@@ -253,7 +253,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValu
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValue, AnnotatedSymbol* nextSymbol, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     stepValue_(stepValue),
@@ -267,7 +267,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValu
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValue, Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     stepValue_(stepValue),
@@ -281,7 +281,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValu
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValue, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     stepValue_(stepValue)
@@ -293,7 +293,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, Expression* stepValu
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, AnnotatedSymbol* nextSymbol, Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     nextSymbol_(nextSymbol),
@@ -307,7 +307,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, AnnotatedSymbol* nex
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, AnnotatedSymbol* nextSymbol, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     nextSymbol_(nextSymbol)
@@ -319,7 +319,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, AnnotatedSymbol* nex
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, Block* body, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue),
     body_(body)
@@ -331,7 +331,7 @@ ForLoop::ForLoop(Assignment* counter, Expression* endValue, Block* body, SourceL
 
 // ----------------------------------------------------------------------------
 ForLoop::ForLoop(Assignment* counter, Expression* endValue, SourceLocation* location) :
-    Loop(location),
+    Loop(NodeKind::ForLoop, location),
     counter_(counter),
     endValue_(endValue)
 {
@@ -3,16 +3,37 @@
 #include "odb-compiler/ast/SourceLocation.hpp"
 #include "odb-compiler/commands/Command.hpp"
 #include "odb-compiler/parsers/db/Parser.y.hpp"
+#include "odb-compiler/Stats.hpp"
+#include "odb-sdk/Arena.hpp"
 
 namespace odb {
 namespace ast {
 
 // ----------------------------------------------------------------------------
-Node::Node(SourceLocation* location) :
-    location_(location)
+Node::Node(NodeKind kind, SourceLocation* location) :
+    location_(location),
+    kind_(kind)
 {
 }
 
+// ----------------------------------------------------------------------------
+void* Node::operator new(size_t size)
+{
+    if (Stats::enabled())
+    {
+        Stats::add(Stats::ASTNodes, 1);
+        Stats::add(Stats::ASTAllocations, 1);
+        Stats::add(Stats::ASTBytes, size);
+    }
+    return Arena::allocate(size);
+}
+
+// ----------------------------------------------------------------------------
+void Node::operator delete(void* ptr)
+{
+    Arena::deallocate(ptr);
+}
+
 // ----------------------------------------------------------------------------
 void Node::setParent(Node* node)
 {
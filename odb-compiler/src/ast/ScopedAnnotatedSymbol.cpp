@@ -5,7 +5,15 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 ScopedAnnotatedSymbol::ScopedAnnotatedSymbol(Scope scope, Annotation annotation, const std::string& name, SourceLocation* location) :
-    Symbol(name, location),
+    Symbol(NodeKind::ScopedAnnotatedSymbol, name, location),
+    scope_(scope),
+    annotation_(annotation)
+{
+}
+
+// ----------------------------------------------------------------------------
+ScopedAnnotatedSymbol::ScopedAnnotatedSymbol(Scope scope, Annotation annotation, Atom atom, const std::string& name, SourceLocation* location) :
+    Symbol(NodeKind::ScopedAnnotatedSymbol, atom, name, location),
     scope_(scope),
     annotation_(annotation)
 {
@@ -57,7 +65,7 @@ void ScopedAnnotatedSymbol::swapChild(const Node* oldNode, Node* newNode)
 // ----------------------------------------------------------------------------
 Node* ScopedAnnotatedSymbol::duplicateImpl() const
 {
-    return new ScopedAnnotatedSymbol(scope_, annotation_, name_, location());
+    return new ScopedAnnotatedSymbol(scope_, annotation_, atom_, name_, location());
 }
 
 }
@@ -8,7 +8,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 Select::Select(Expression* expr, CaseList* cases, SourceLocation* location, SourceLocation* beginSelect, SourceLocation* endSelect)
-    : Statement(location)
+    : Statement(NodeKind::Select, location)
     , expr_(expr)
     , cases_(cases)
     , beginLoc_(beginSelect)
@@ -20,7 +20,7 @@ Select::Select(Expression* expr, CaseList* cases, SourceLocation* location, Sour
 
 // ----------------------------------------------------------------------------
 Select::Select(Expression* expr, SourceLocation* location, SourceLocation* beginSelect, SourceLocation* endSelect)
-    : Statement(location)
+    : Statement(NodeKind::Select, location)
     , expr_(expr)
     , beginLoc_(beginSelect)
     , endLoc_(endSelect)
@@ -103,21 +103,21 @@ Node* Select::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 CaseList::CaseList(Case* case_, SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::CaseList, location)
 {
     appendCase(case_);
 }
 
 // ----------------------------------------------------------------------------
 CaseList::CaseList(DefaultCase* case_, SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::CaseList, location)
 {
     appendDefaultCase(case_);
 }
 
 // ----------------------------------------------------------------------------
 CaseList::CaseList(SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::CaseList, location)
 {
 }
 
@@ -218,7 +218,7 @@ Node* CaseList::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 Case::Case(Expression* expr, Block* body, SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::Case, location)
     , expr_(expr)
     , body_(body)
 {
@@ -228,7 +228,7 @@ Case::Case(Expression* expr, Block* body, SourceLocation* location)
 
 // ----------------------------------------------------------------------------
 Case::Case(Expression* expr, SourceLocation* location)
-    : Node(location)
+    : Node(NodeKind::Case, location)
     , expr_(expr)
 {
     expr->setParent(this);
@@ -295,7 +295,7 @@ Node* Case::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 DefaultCase::DefaultCase(Block* body, SourceLocation* location, SourceLocation* beginCaseLoc, SourceLocation* endCaseLoc)
-    : Node(location)
+    : Node(NodeKind::DefaultCase, location)
     , body_(body)
     , beginLoc_(beginCaseLoc)
     , endLoc_(endCaseLoc)
@@ -305,7 +305,7 @@ DefaultCase::DefaultCase(Block* body, SourceLocation* location, SourceLocation*
 
 // ----------------------------------------------------------------------------
 DefaultCase::DefaultCase(SourceLocation* location, SourceLocation* beginCaseLoc, SourceLocation* endCaseLoc)
-    : Node(location)
+    : Node(NodeKind::DefaultCase, location)
     , beginLoc_(beginCaseLoc)
     , endLoc_(endCaseLoc)
 {
@@ -0,0 +1,1079 @@
+#include "odb-compiler/ast/Serialization.hpp"
+#include "odb-compiler/ast/AnnotatedSymbol.hpp"
+#include "odb-compiler/ast/ArgList.hpp"
+#include "odb-compiler/ast/ArrayDecl.hpp"
+#include "odb-compiler/ast/ArrayRef.hpp"
+#include "odb-compiler/ast/Assignment.hpp"
+#include "odb-compiler/ast/BinaryOp.hpp"
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/ast/CommandExpr.hpp"
+#include "odb-compiler/ast/CommandStmnt.hpp"
+#include "odb-compiler/ast/Conditional.hpp"
+#include "odb-compiler/ast/ConstDecl.hpp"
+#include "odb-compiler/ast/Exit.hpp"
+#include "odb-compiler/ast/FuncCall.hpp"
+#include "odb-compiler/ast/FuncDecl.hpp"
+#include "odb-compiler/ast/Goto.hpp"
+#include "odb-compiler/ast/InitializerList.hpp"
+#include "odb-compiler/ast/Label.hpp"
+#include "odb-compiler/ast/Literal.hpp"
+#include "odb-compiler/ast/Loop.hpp"
+#include "odb-compiler/ast/ScopedAnnotatedSymbol.hpp"
+#include "odb-compiler/ast/SelectCase.hpp"
+#include "odb-compiler/ast/SourceFileTable.hpp"
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-compiler/ast/Subroutine.hpp"
+#include "odb-compiler/ast/Symbol.hpp"
+#include "odb-compiler/ast/UDTDecl.hpp"
+#include "odb-compiler/ast/UDTField.hpp"
+#include "odb-compiler/ast/UDTRef.hpp"
+#include "odb-compiler/ast/UnaryOp.hpp"
+#include "odb-compiler/ast/VarDecl.hpp"
+#include "odb-compiler/ast/VarRef.hpp"
+#include "odb-compiler/ast/Visitor.hpp"
+#include "../BinaryStream.hpp"
+#include <unordered_map>
+
+namespace odb::ast {
+
+// Bump this whenever the layout of any node changes, so stale caches are
+// rejected instead of being misinterpreted
+static constexpr uint16_t formatVersion = 1;
+static constexpr char magic[6] = {'O', 'D', 'B', 'A', 'S', 'T'};
+static constexpr uint16_t byteOrderMark = 0x0102;
+
+namespace {
+
+// Nodes are tagged with their NodeKind, so its numbering is part of the
+// format. These catch kinds being added, removed or reordered. Bump
+// formatVersion when updating them.
+static_assert((int)NodeKind::WhileLoop == 42, "NodeKind changed, bump formatVersion");
+static_assert((int)NodeKind::Vec4ArrayDecl == 111, "NodeKind changed, bump formatVersion");
+
+// Optional children are announced by a bit in the node's flags, so the reader
+// knows which constructor overload to call
+enum Flags : uint8_t
+{
+    HAS_ARGS = 0x01,
+    HAS_BODY = 0x02,
+    HAS_RETURN_VALUE = 0x04,
+    HAS_STEP = 0x08,
+    HAS_NEXT_SYMBOL = 0x10,
+    HAS_TRUE_BRANCH = 0x20,
+    HAS_FALSE_BRANCH = 0x40,
+    HAS_INITIALIZER = 0x80,
+    HAS_CASES = HAS_ARGS
+};
+
+// ----------------------------------------------------------------------------
+// Hands ownership of a node that was built up through a reference over to the
+// caller, the same way the parser returns nodes with a refcount of zero
+template <typename T>
+T* release(Reference<T>* ref)
+{
+    T* ptr = ref->get();
+    ref->detach();
+    return ptr;
+}
+
+// ----------------------------------------------------------------------------
+// The nodes are written in the same pre-order that accept() visits them in.
+// Each visit writes the node's type, location, its own data and flags for
+// optional children. accept() then takes care of writing the children.
+class Writer : public ConstVisitor, public BinaryWriter
+{
+public:
+    explicit Writer(std::vector<uint8_t>* out) : BinaryWriter(out) {}
+
+    void writeFile(SourceFileId id)
+    {
+        auto it = files_.find(id);
+        if (it != files_.end())
+        {
+            writeVarint(it->second + 1);
+            return;
+        }
+
+        // Files are written by name and loaded lazily. Sources that didn't
+        // come from a file can't be reloaded, so their text is stored too
+        files_.emplace(id, files_.size());
+        writeVarint(0);
+        bool isFile = SourceFileTable::isFile(id);
+        writeU8(isFile ? 1 : 0);
+        writeString(SourceFileTable::name(id));
+        if (!isFile)
+        {
+            std::string_view text;
+            if (!SourceFileTable::text(id, &text))
+                text = std::string_view();
+            writeString(text);
+        }
+    }
+
+    void writeLocation(const SourceLocation* location)
+    {
+        if (location == nullptr)
+        {
+            writeVarint(0);
+            return;
+        }
+
+        auto it = locations_.find(location);
+        if (it != locations_.end())
+        {
+            writeVarint(it->second + 2);
+            return;
+        }
+
+        locations_.emplace(location, locations_.size());
+        writeVarint(1);
+        writeFile(location->fileId());
+        writeVarint((uint32_t)location->firstLine());
+        writeVarint((uint32_t)location->lastLine());
+        writeVarint((uint32_t)location->firstColumn());
+        writeVarint((uint32_t)location->lastColumn());
+        writeU8((uint8_t)location->color());
+    }
+
+    void beginNode(NodeKind kind, const Node* node)
+    {
+        writeU8((uint8_t)kind);
+        writeLocation(node->location());
+    }
+
+    void visitAnnotatedSymbol(const AnnotatedSymbol* node) override
+    {
+        beginNode(NodeKind::AnnotatedSymbol, node);
+        writeU8((uint8_t)node->annotation());
+        writeString(node->name());
+    }
+    void visitArgList(const ArgList* node) override
+    {
+        beginNode(NodeKind::ArgList, node);
+        writeVarint(node->expressions().size());
+    }
+    void visitArrayAssignment(const ArrayAssignment* node) override
+    {
+        beginNode(NodeKind::ArrayAssignment, node);
+    }
+    void visitArrayRef(const ArrayRef* node) override
+    {
+        beginNode(NodeKind::ArrayRef, node);
+    }
+    void visitBinaryOp(const BinaryOp* node) override
+    {
+        beginNode(NodeKind::BinaryOp, node);
+        writeU8((uint8_t)node->op());
+    }
+    void visitBlock(const Block* node) override
+    {
+        beginNode(NodeKind::Block, node);
+        writeVarint(node->statements().size());
+    }
+    void visitCase(const Case* node) override
+    {
+        beginNode(NodeKind::Case, node);
+        writeU8(node->body().notNull() ? HAS_BODY : 0);
+    }
+    void visitCaseList(const CaseList* node) override
+    {
+        beginNode(NodeKind::CaseList, node);
+        writeVarint(node->cases().size());
+        writeVarint(node->defaultCases().size());
+    }
+    void visitCommandExpr(const CommandExpr* node) override
+    {
+        beginNode(NodeKind::CommandExpr, node);
+        writeString(node->command());
+        writeU8(node->args().notNull() ? HAS_ARGS : 0);
+    }
+    void visitCommandStmnt(const CommandStmnt* node) override
+    {
+        beginNode(NodeKind::CommandStmnt, node);
+        writeString(node->command());
+        writeU8(node->args().notNull() ? HAS_ARGS : 0);
+    }
+    void visitConditional(const Conditional* node) override
+    {
+        beginNode(NodeKind::Conditional, node);
+        writeU8((node->trueBranch().notNull() ? HAS_TRUE_BRANCH : 0) |
+                (node->falseBranch().notNull() ? HAS_FALSE_BRANCH : 0));
+    }
+    void visitConstDecl(const ConstDecl* node) override
+    {
+        beginNode(NodeKind::ConstDecl, node);
+    }
+    void visitConstDeclExpr(const ConstDeclExpr* node) override
+    {
+        beginNode(NodeKind::ConstDeclExpr, node);
+    }
+    void visitDefaultCase(const DefaultCase* node) override
+    {
+        beginNode(NodeKind::DefaultCase, node);
+        writeLocation(node->beginCaseLocation());
+        writeLocation(node->endCaseLocation());
+        writeU8(node->body().notNull() ? HAS_BODY : 0);
+    }
+    void visitExit(const Exit* node) override
+    {
+        beginNode(NodeKind::Exit, node);
+    }
+    void visitForLoop(const ForLoop* node) override
+    {
+        beginNode(NodeKind::ForLoop, node);
+        writeU8((node->stepValue().notNull() ? HAS_STEP : 0) |
+                (node->nextSymbol().notNull() ? HAS_NEXT_SYMBOL : 0) |
+                (node->body().notNull() ? HAS_BODY : 0));
+    }
+    void visitFuncCallExpr(const FuncCallExpr* node) override
+    {
+        beginNode(NodeKind::FuncCallExpr, node);
+        writeU8(node->args().notNull() ? HAS_ARGS : 0);
+    }
+    void visitFuncCallExprOrArrayRef(const FuncCallExprOrArrayRef* node) override
+    {
+        beginNode(NodeKind::FuncCallExprOrArrayRef, node);
+        writeU8(node->args().notNull() ? HAS_ARGS : 0);
+    }
+    void visitFuncCallStmnt(const FuncCallStmnt* node) override
+    {
+        beginNode(NodeKind::FuncCallStmnt, node);
+        writeU8(node->args().notNull() ? HAS_ARGS : 0);
+    }
+    void visitFuncDecl(const FuncDecl* node) override
+    {
+        beginNode(NodeKind::FuncDecl, node);
+        writeU8((node->args().notNull() ? HAS_ARGS : 0) |
+                (node->body().notNull() ? HAS_BODY : 0) |
+                (node->returnValue().notNull() ? HAS_RETURN_VALUE : 0));
+    }
+    void visitFuncExit(const FuncExit* node) override
+    {
+        beginNode(NodeKind::FuncExit, node);
+        writeU8(node->returnValue().notNull() ? HAS_RETURN_VALUE : 0);
+    }
+    void visitGoto(const Goto* node) override
+    {
+        beginNode(NodeKind::Goto, node);
+    }
+    void visitInfiniteLoop(const InfiniteLoop* node) override
+    {
+        beginNode(NodeKind::InfiniteLoop, node);
+        writeU8(node->body().notNull() ? HAS_BODY : 0);
+    }
+    void visitInitializerList(const InitializerList* node) override
+    {
+        beginNode(NodeKind::InitializerList, node);
+        writeVarint(node->expressions().size());
+    }
+    void visitLabel(const Label* node) override
+    {
+        beginNode(NodeKind::Label, node);
+    }
+    void visitScopedAnnotatedSymbol(const ScopedAnnotatedSymbol* node) override
+    {
+        beginNode(NodeKind::ScopedAnnotatedSymbol, node);
+        writeU8((uint8_t)node->scope());
+        writeU8((uint8_t)node->annotation());
+        writeString(node->name());
+    }
+    void visitSelect(const Select* node) override
+    {
+        beginNode(NodeKind::Select, node);
+        writeLocation(node->beginSelectLocation());
+        writeLocation(node->endSelectLocation());
+        writeU8(node->cases().notNull() ? HAS_CASES : 0);
+    }
+    void visitSubCall(const SubCall* node) override
+    {
+        beginNode(NodeKind::SubCall, node);
+    }
+    void visitSubReturn(const SubReturn* node) override
+    {
+        beginNode(NodeKind::SubReturn, node);
+    }
+    void visitSymbol(const Symbol* node) override
+    {
+        beginNode(NodeKind::Symbol, node);
+        writeString(node->name());
+    }
+    void visitUDTArrayDecl(const UDTArrayDecl* node) override
+    {
+        beginNode(NodeKind::UDTArrayDecl, node);
+    }
+    void visitUDTDecl(const UDTDecl* node) override
+    {
+        beginNode(NodeKind::UDTDecl, node);
+    }
+    void visitUDTDeclBody(const UDTDeclBody* node) override
+    {
+        beginNode(NodeKind::UDTDeclBody, node);
+        writeVarint(node->varDeclarations().size());
+        writeVarint(node->arrayDeclarations().size());
+    }
+    void visitUDTFieldAssignment(const UDTFieldAssignment* node) override
+    {
+        beginNode(NodeKind::UDTFieldAssignment, node);
+    }
+    void visitUDTFieldOuter(const UDTFieldOuter* node) override
+    {
+        beginNode(NodeKind::UDTFieldOuter, node);
+    }
+    void visitUDTFieldInner(const UDTFieldInner* node) override
+    {
+        beginNode(NodeKind::UDTFieldInner, node);
+    }
+    void visitUDTRef(const UDTRef* node) override
+    {
+        beginNode(NodeKind::UDTRef, node);
+        writeString(node->name());
+    }
+    void visitUDTVarDecl(const UDTVarDecl* node) override
+    {
+        beginNode(NodeKind::UDTVarDecl, node);
+        writeU8(node->initializer().notNull() ? HAS_INITIALIZER : 0);
+    }
+    void visitUnaryOp(const UnaryOp* node) override
+    {
+        beginNode(NodeKind::UnaryOp, node);
+        writeU8((uint8_t)node->op());
+    }
+    void visitUntilLoop(const UntilLoop* node) override
+    {
+        beginNode(NodeKind::UntilLoop, node);
+        writeU8(node->body().notNull() ? HAS_BODY : 0);
+    }
+    void visitVarAssignment(const VarAssignment* node) override
+    {
+        beginNode(NodeKind::VarAssignment, node);
+    }
+    void visitVarRef(const VarRef* node) override
+    {
+        beginNode(NodeKind::VarRef, node);
+    }
+    void visitWhileLoop(const WhileLoop* node) override
+    {
+        beginNode(NodeKind::WhileLoop, node);
+        writeU8(node->body().notNull() ? HAS_BODY : 0);
+    }
+
+#define X(dbname, cppname)                                                    \
+    void visit##dbname##Literal(const dbname##Literal* node) override         \
+    {                                                                         \
+        beginNode(NodeKind::dbname##Literal, node);                           \
+        writeValue(node->value());                                            \
+    }                                                                         \
+    void visit##dbname##VarDecl(const dbname##VarDecl* node) override         \
+    {                                                                         \
+        beginNode(NodeKind::dbname##VarDecl, node);                           \
+    }                                                                         \
+    void visit##dbname##ArrayDecl(const dbname##ArrayDecl* node) override     \
+    {                                                                         \
+        beginNode(NodeKind::dbname##ArrayDecl, node);                         \
+    }
+    ODB_DATATYPE_LIST
+#undef X
+
+private:
+    std::unordered_map<const SourceLocation*, uint64_t> locations_;
+    std::unordered_map<SourceFileId, uint64_t> files_;
+};
+
+// ----------------------------------------------------------------------------
+// Mirrors the writer. Every read function returns false as soon as the data
+// turns out to be truncated or inconsistent, in which case everything that
+// was constructed so far is released by the references holding it.
+class Reader : public BinaryReader
+{
+public:
+    Reader(const uint8_t* data, size_t size) : BinaryReader(data, size) {}
+
+    ~Reader()
+    {
+        // The locations that were read hold their own references
+        for (SourceFileId id : files_)
+            SourceFileTable::release(id);
+    }
+
+    bool readFile(SourceFileId* id)
+    {
+        uint64_t ref;
+        if (!readVarint(&ref))
+            return false;
+        if (ref > 0)
+        {
+            if (ref > files_.size())
+                return false;
+            *id = files_[ref - 1];
+            return true;
+        }
+
+        uint8_t isFile;
+        std::string name;
+        if (!readU8(&isFile) || !readString(&name))
+            return false;
+        if (isFile)
+            *id = SourceFileTable::addFile(name);
+        else
+        {
+            std::string text;
+            if (!readString(&text))
+                return false;
+            *id = SourceFileTable::addString(name, text);
+        }
+
+        files_.push_back(*id);
+        return true;
+    }
+
+    bool readLocation(Reference<SourceLocation>* location)
+    {
+        uint64_t ref;
+        if (!readVarint(&ref))
+            return false;
+        if (ref == 0)
+        {
+            *location = nullptr;
+            return true;
+        }
+        if (ref > 1)
+        {
+            if (ref - 2 >= locations_.size())
+                return false;
+            *location = locations_[ref - 2];
+            return true;
+        }
+
+        SourceFileId fileId;
+        uint64_t firstLine, lastLine, firstColumn, lastColumn;
+        uint8_t color;
+        if (!readFile(&fileId) ||
+            !readVarint(&firstLine) || !readVarint(&lastLine) ||
+            !readVarint(&firstColumn) || !readVarint(&lastColumn) ||
+            !readU8(&color))
+        {
+            return false;
+        }
+
+        *location = new SourceLocation(fileId,
+            (int)firstLine, (int)lastLine, (int)firstColumn, (int)lastColumn,
+            (Log::Color)color);
+        locations_.push_back(*location);
+        return true;
+    }
+
+    template <typename T>
+    bool readChild(Reference<T>* child)
+    {
+        Reference<Node> node = readNode();
+        if (node.isNull())
+            return false;
+        T* typed = dynamic_cast<T*>(node.get());
+        if (typed == nullptr)
+            return false;
+        *child = typed;
+        return true;
+    }
+
+    bool readFlags(uint8_t* flags, uint8_t allowed)
+    {
+        return readU8(flags) && (*flags & ~allowed) == 0;
+    }
+
+    bool readAnnotation(Annotation* annotation)
+    {
+        static const uint8_t count = 1
+#define X(enum_, chr, str, dbname) + 1
+            ODB_TYPE_ANNOTATION_LIST
+#undef X
+            ;
+        uint8_t value;
+        if (!readU8(&value) || value >= count)
+            return false;
+        *annotation = (Annotation)value;
+        return true;
+    }
+
+    bool readScope(Scope* scope)
+    {
+        uint8_t value;
+        if (!readU8(&value) || value > (uint8_t)Scope::GLOBAL)
+            return false;
+        *scope = (Scope)value;
+        return true;
+    }
+
+    Node* readNode();
+
+private:
+    std::vector<Reference<SourceLocation>> locations_;
+    std::vector<SourceFileId> files_;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+Node* Reader::readNode()
+{
+    uint8_t type;
+    Reference<SourceLocation> location;
+    if (!readU8(&type) || !readLocation(&location))
+        return nullptr;
+
+    switch ((NodeKind)type)
+    {
+        case NodeKind::AnnotatedSymbol: {
+            Annotation annotation;
+            std::string name;
+            if (!readAnnotation(&annotation) || !readString(&name))
+                return nullptr;
+            return new AnnotatedSymbol(annotation, name, location);
+        }
+
+        case NodeKind::ArgList: {
+            size_t count;
+            if (!readCount(&count))
+                return nullptr;
+            Reference<ArgList> args = new ArgList(location);
+            for (size_t i = 0; i != count; ++i)
+            {
+                Reference<Expression> expr;
+                if (!readChild(&expr))
+                    return nullptr;
+                args->appendExpression(expr);
+            }
+            return release(&args);
+        }
+
+        case NodeKind::ArrayAssignment: {
+            Reference<ArrayRef> array;
+            Reference<Expression> expr;
+            if (!readChild(&array) || !readChild(&expr))
+                return nullptr;
+            return new ArrayAssignment(array, expr, location);
+        }
+
+        case NodeKind::ArrayRef: {
+            Reference<AnnotatedSymbol> symbol;
+            Reference<ArgList> args;
+            if (!readChild(&symbol) || !readChild(&args))
+                return nullptr;
+            return new ArrayRef(symbol, args, location);
+        }
+
+        case NodeKind::BinaryOp: {
+            uint8_t op;
+            Reference<Expression> lhs, rhs;
+            if (!readU8(&op) || op > (uint8_t)BinaryOpType::LOGICAL_XOR)
+                return nullptr;
+            if (!readChild(&lhs) || !readChild(&rhs))
+                return nullptr;
+            return new BinaryOp((BinaryOpType)op, lhs, rhs, location);
+        }
+
+        case NodeKind::Block: {
+            size_t count;
+            if (!readCount(&count))
+                return nullptr;
+            Reference<Block> block = new Block(location);
+            for (size_t i = 0; i != count; ++i)
+            {
+                Reference<Statement> stmnt;
+                if (!readChild(&stmnt))
+                    return nullptr;
+                block->appendStatement(stmnt);
+            }
+            return release(&block);
+        }
+
+        case NodeKind::Case: {
+            uint8_t flags;
+            Reference<Expression> expr;
+            Reference<Block> body;
+            if (!readFlags(&flags, HAS_BODY) || !readChild(&expr))
+                return nullptr;
+            if (flags & HAS_BODY)
+            {
+                if (!readChild(&body))
+                    return nullptr;
+                return new Case(expr, body, location);
+            }
+            return new Case(expr, location);
+        }
+
+        case NodeKind::CaseList: {
+            size_t caseCount, defaultCount;
+            if (!readCount(&caseCount) || !readCount(&defaultCount))
+                return nullptr;
+            Reference<CaseList> cases = new CaseList(location);
+            for (size_t i = 0; i != caseCount; ++i)
+            {
+                Reference<Case> case_;
+                if (!readChild(&case_))
+                    return nullptr;
+                cases->appendCase(case_);
+            }
+            for (size_t i = 0; i != defaultCount; ++i)
+            {
+                Reference<DefaultCase> case_;
+                if (!readChild(&case_))
+                    return nullptr;
+                cases->appendDefaultCase(case_);
+            }
+            return release(&cases);
+        }
+
+        case NodeKind::CommandExpr:
+        case NodeKind::CommandStmnt: {
+            std::string command;
+            uint8_t flags;
+            Reference<ArgList> args;
+            if (!readString(&command) || !readFlags(&flags, HAS_ARGS))
+                return nullptr;
+            if ((flags & HAS_ARGS) && !readChild(&args))
+                return nullptr;
+            if ((NodeKind)type == NodeKind::CommandExpr)
+                return args ? new CommandExpr(command, args, location)
+                            : new CommandExpr(command, location);
+            return args ? new CommandStmnt(command, args, location)
+                        : new CommandStmnt(command, location);
+        }
+
+        case NodeKind::Conditional: {
+            uint8_t flags;
+            Reference<Expression> cond;
+            Reference<Block> trueBranch, falseBranch;
+            if (!readFlags(&flags, HAS_TRUE_BRANCH | HAS_FALSE_BRANCH) || !readChild(&cond))
+                return nullptr;
+            if ((flags & HAS_TRUE_BRANCH) && !readChild(&trueBranch))
+                return nullptr;
+            if ((flags & HAS_FALSE_BRANCH) && !readChild(&falseBranch))
+                return nullptr;
+            return new Conditional(cond, trueBranch, falseBranch, location);
+        }
+
+        case NodeKind::ConstDecl: {
+            Reference<AnnotatedSymbol> symbol;
+            Reference<Literal> literal;
+            if (!readChild(&symbol) || !readChild(&literal))
+                return nullptr;
+            return new ConstDecl(symbol, literal, location);
+        }
+
+        case NodeKind::ConstDeclExpr: {
+            Reference<AnnotatedSymbol> symbol;
+            Reference<Expression> expr;
+            if (!readChild(&symbol) || !readChild(&expr))
+                return nullptr;
+            return new ConstDeclExpr(symbol, expr, location);
+        }
+
+        case NodeKind::DefaultCase: {
+            Reference<SourceLocation> beginLoc, endLoc;
+            uint8_t flags;
+            Reference<Block> body;
+            if (!readLocation(&beginLoc) || !readLocation(&endLoc) || !readFlags(&flags, HAS_BODY))
+                return nullptr;
+            if (flags & HAS_BODY)
+            {
+                if (!readChild(&body))
+                    return nullptr;
+                return new DefaultCase(body, location, beginLoc, endLoc);
+            }
+            return new DefaultCase(location, beginLoc, endLoc);
+        }
+
+        case NodeKind::Exit:
+            return new Exit(location);
+
+        case NodeKind::ForLoop: {
+            uint8_t flags;
+            Reference<Assignment> counter;
+            Reference<Expression> endValue, stepValue;
+            Reference<AnnotatedSymbol> nextSymbol;
+            Reference<Block> body;
+            if (!readFlags(&flags, HAS_STEP | HAS_NEXT_SYMBOL | HAS_BODY))
+                return nullptr;
+            if (!readChild(&counter) || !readChild(&endValue))
+                return nullptr;
+            if ((flags & HAS_STEP) && !readChild(&stepValue))
+                return nullptr;
+            if ((flags & HAS_NEXT_SYMBOL) && !readChild(&nextSymbol))
+                return nullptr;
+            if ((flags & HAS_BODY) && !readChild(&body))
+                return nullptr;
+
+            switch (flags)
+            {
+                case HAS_STEP | HAS_NEXT_SYMBOL | HAS_BODY:
+                    return new ForLoop(counter, endValue, stepValue, nextSymbol, body, location);
+                case HAS_STEP | HAS_NEXT_SYMBOL:
+                    return new ForLoop(counter, endValue, stepValue, nextSymbol, location);
+                case HAS_STEP | HAS_BODY:
+                    return new ForLoop(counter, endValue, stepValue, body, location);
+                case HAS_STEP:
+                    return new ForLoop(counter, endValue, stepValue, location);
+                case HAS_NEXT_SYMBOL | HAS_BODY:
+                    return new ForLoop(counter, endValue, nextSymbol, body, location);
+                case HAS_NEXT_SYMBOL:
+                    return new ForLoop(counter, endValue, nextSymbol, location);
+                case HAS_BODY:
+                    return new ForLoop(counter, endValue, body, location);
+                default:
+                    return new ForLoop(counter, endValue, location);
+            }
+        }
+
+        case NodeKind::FuncCallExpr:
+        case NodeKind::FuncCallExprOrArrayRef:
+        case NodeKind::FuncCallStmnt: {
+            uint8_t flags;
+            Reference<AnnotatedSymbol> symbol;
+            Reference<ArgList> args;
+            if (!readFlags(&flags, HAS_ARGS) || !readChild(&symbol))
+                return nullptr;
+            if ((flags & HAS_ARGS) && !readChild(&args))
+                return nullptr;
+
+            switch ((NodeKind)type)
+            {
+                case NodeKind::FuncCallExpr:
+                    return args ? new FuncCallExpr(symbol, args, location)
+                                : new FuncCallExpr(symbol, location);
+                case NodeKind::FuncCallStmnt:
+                    return args ? new FuncCallStmnt(symbol, args, location)
+                                : new FuncCallStmnt(symbol, location);
+                default:
+                    // There is no constructor without arguments
+                    if (args.isNull())
+                        return nullptr;
+                    return new FuncCallExprOrArrayRef(symbol, args, location);
+            }
+        }
+
+        case NodeKind::FuncDecl: {
+            uint8_t flags;
+            Reference<AnnotatedSymbol> symbol;
+            Reference<ArgList> args;
+            Reference<Block> body;
+            Reference<Expression> returnValue;
+            if (!readFlags(&flags, HAS_ARGS | HAS_BODY | HAS_RETURN_VALUE) || !readChild(&symbol))
+                return nullptr;
+            if ((flags & HAS_ARGS) && !readChild(&args))
+                return nullptr;
+            if ((flags & HAS_BODY) && !readChild(&body))
+                return nullptr;
+            if ((flags & HAS_RETURN_VALUE) && !readChild(&returnValue))
+                return nullptr;
+
+            switch (flags)
+            {
+                case HAS_ARGS | HAS_BODY | HAS_RETURN_VALUE:
+                    return new FuncDecl(symbol, args, body, returnValue, location);
+                case HAS_ARGS | HAS_RETURN_VALUE:
+                    return new FuncDecl(symbol, args, returnValue, location);
+                case HAS_BODY | HAS_RETURN_VALUE:
+                    return new FuncDecl(symbol, body, returnValue, location);
+                case HAS_RETURN_VALUE:
+                    return new FuncDecl(symbol, returnValue, location);
+                case HAS_ARGS | HAS_BODY:
+                    return new FuncDecl(symbol, args, body, location);
+                case HAS_ARGS:
+                    return new FuncDecl(symbol, args, location);
+                case HAS_BODY:
+                    return new FuncDecl(symbol, body, location);
+                default:
+                    return new FuncDecl(symbol, location);
+            }
+        }
+
+        case NodeKind::FuncExit: {
+            uint8_t flags;
+            Reference<Expression> returnValue;
+            if (!readFlags(&flags, HAS_RETURN_VALUE))
+                return nullptr;
+            if (flags & HAS_RETURN_VALUE)
+            {
+                if (!readChild(&returnValue))
+                    return nullptr;
+                return new FuncExit(returnValue, location);
+            }
+            return new FuncExit(location);
+        }
+
+        case NodeKind::Goto: {
+            Reference<Symbol> label;
+            if (!readChild(&label))
+                return nullptr;
+            return new Goto(label, location);
+        }
+
+        case NodeKind::InfiniteLoop: {
+            uint8_t flags;
+            Reference<Block> body;
+            if (!readFlags(&flags, HAS_BODY))
+                return nullptr;
+            if (flags & HAS_BODY)
+            {
+                if (!readChild(&body))
+                    return nullptr;
+                return new InfiniteLoop(body, location);
+            }
+            return new InfiniteLoop(location);
+        }
+
+        case NodeKind::InitializerList: {
+            size_t count;
+            if (!readCount(&count))
+                return nullptr;
+            Reference<InitializerList> list = new InitializerList(location);
+            for (size_t i = 0; i != count; ++i)
+            {
+                Reference<Expression> expr;
+                if (!readChild(&expr))
+                    return nullptr;
+                list->appendExpression(expr);
+            }
+            return release(&list);
+        }
+
+        case NodeKind::Label: {
+            Reference<Symbol> symbol;
+            if (!readChild(&symbol))
+                return nullptr;
+            return new Label(symbol, location);
+        }
+
+        case NodeKind::ScopedAnnotatedSymbol: {
+            Scope scope;
+            Annotation annotation;
+            std::string name;
+            if (!readScope(&scope) || !readAnnotation(&annotation) || !readString(&name))
+                return nullptr;
+            return new ScopedAnnotatedSymbol(scope, annotation, name, location);
+        }
+
+        case NodeKind::Select: {
+            Reference<SourceLocation> beginLoc, endLoc;
+            uint8_t flags;
+            Reference<Expression> expr;
+            Reference<CaseList> cases;
+            if (!readLocation(&beginLoc) || !readLocation(&endLoc) || !readFlags(&flags, HAS_CASES))
+                return nullptr;
+            if (!readChild(&expr))
+                return nullptr;
+            if (flags & HAS_CASES)
+            {
+                if (!readChild(&cases))
+                    return nullptr;
+                return new Select(expr, cases, location, beginLoc, endLoc);
+            }
+            return new Select(expr, location, beginLoc, endLoc);
+        }
+
+        case NodeKind::SubCall: {
+            Reference<Symbol> label;
+            if (!readChild(&label))
+                return nullptr;
+            return new SubCall(label, location);
+        }
+
+        case NodeKind::SubReturn:
+            return new SubReturn(location);
+
+        case NodeKind::Symbol: {
+            std::string name;
+            if (!readString(&name))
+                return nullptr;
+            return new Symbol(name, location);
+        }
+
+        case NodeKind::UDTArrayDecl: {
+            Reference<ScopedAnnotatedSymbol> symbol;
+            Reference<ArgList> dims;
+            Reference<UDTRef> udt;
+            if (!readChild(&symbol) || !readChild(&dims) || !readChild(&udt))
+                return nullptr;
+            return new UDTArrayDecl(symbol, dims, udt, location);
+        }
+
+        case NodeKind::UDTDecl: {
+            Reference<Symbol> typeName;
+            Reference<UDTDeclBody> body;
+            if (!readChild(&typeName) || !readChild(&body))
+                return nullptr;
+            return new UDTDecl(typeName, body, location);
+        }
+
+        case NodeKind::UDTDeclBody: {
+            size_t varCount, arrayCount;
+            if (!readCount(&varCount) || !readCount(&arrayCount))
+                return nullptr;
+            Reference<UDTDeclBody> body = new UDTDeclBody(location);
+            for (size_t i = 0; i != varCount; ++i)
+            {
+                Reference<VarDecl> varDecl;
+                if (!readChild(&varDecl))
+                    return nullptr;
+                body->appendVarDecl(varDecl);
+            }
+            for (size_t i = 0; i != arrayCount; ++i)
+            {
+                Reference<ArrayDecl> arrayDecl;
+                if (!readChild(&arrayDecl))
+                    return nullptr;
+                body->appendArrayDecl(arrayDecl);
+            }
+            return release(&body);
+        }
+
+        case NodeKind::UDTFieldAssignment: {
+            Reference<UDTFieldOuter> field;
+            Reference<Expression> expr;
+            if (!readChild(&field) || !readChild(&expr))
+                return nullptr;
+            return new UDTFieldAssignment(field, expr, location);
+        }
+
+        case NodeKind::UDTFieldOuter: {
+            Reference<Expression> left;
+            Reference<LValue> right;
+            if (!readChild(&left) || !readChild(&right))
+                return nullptr;
+            return new UDTFieldOuter(left, right, location);
+        }
+
+        case NodeKind::UDTFieldInner: {
+            Reference<LValue> left, right;
+            if (!readChild(&left) || !readChild(&right))
+                return nullptr;
+            return new UDTFieldInner(left, right, location);
+        }
+
+        case NodeKind::UDTRef: {
+            std::string name;
+            if (!readString(&name))
+                return nullptr;
+            return new UDTRef(name, location);
+        }
+
+        case NodeKind::UDTVarDecl: {
+            uint8_t flags;
+            Reference<ScopedAnnotatedSymbol> symbol;
+            Reference<UDTRef> udt;
+            Reference<InitializerList> initializer;
+            if (!readFlags(&flags, HAS_INITIALIZER) || !readChild(&symbol) || !readChild(&udt))
+                return nullptr;
+            if (flags & HAS_INITIALIZER)
+            {
+                if (!readChild(&initializer))
+                    return nullptr;
+                return new UDTVarDecl(symbol, udt, initializer, location);
+            }
+            return new UDTVarDecl(symbol, udt, location);
+        }
+
+        case NodeKind::UnaryOp: {
+            uint8_t op;
+            Reference<Expression> expr;
+            if (!readU8(&op) || op > (uint8_t)UnaryOpType::BITWISE_NOT)
+                return nullptr;
+            if (!readChild(&expr))
+                return nullptr;
+            return new UnaryOp((UnaryOpType)op, expr, location);
+        }
+
+        case NodeKind::UntilLoop:
+        case NodeKind::WhileLoop: {
+            uint8_t flags;
+            Reference<Expression> condition;
+            Reference<Block> body;
+            if (!readFlags(&flags, HAS_BODY) || !readChild(&condition))
+                return nullptr;
+            if ((flags & HAS_BODY) && !readChild(&body))
+                return nullptr;
+            if ((NodeKind)type == NodeKind::UntilLoop)
+                return body ? new UntilLoop(condition, body, location)
+                            : new UntilLoop(condition, location);
+            return body ? new WhileLoop(condition, body, location)
+                        : new WhileLoop(condition, location);
+        }
+
+        case NodeKind::VarAssignment: {
+            Reference<VarRef> var;
+            Reference<Expression> expr;
+            if (!readChild(&var) || !readChild(&expr))
+                return nullptr;
+            return new VarAssignment(var, expr, location);
+        }
+
+        case NodeKind::VarRef: {
+            Reference<AnnotatedSymbol> symbol;
+            if (!readChild(&symbol))
+                return nullptr;
+            return new VarRef(symbol, location);
+        }
+
+#define X(dbname, cppname)                                                    \
+        case NodeKind::dbname##Literal: {                                     \
+            cppname value;                                                    \
+            if (!readValue(&value))                                           \
+                return nullptr;                                               \
+            return new dbname##Literal(value, location);                      \
+        }                                                                     \
+                                                                              \
+        case NodeKind::dbname##VarDecl: {                                     \
+            Reference<ScopedAnnotatedSymbol> symbol;                          \
+            Reference<InitializerList> initializer;                           \
+            if (!readChild(&symbol) || !readChild(&initializer))              \
+                return nullptr;                                               \
+            return new dbname##VarDecl(symbol, initializer, location);        \
+        }                                                                     \
+                                                                              \
+        case NodeKind::dbname##ArrayDecl: {                                   \
+            Reference<ScopedAnnotatedSymbol> symbol;                          \
+            Reference<ArgList> dims;                                          \
+            if (!readChild(&symbol) || !readChild(&dims))                     \
+                return nullptr;                                               \
+            return new dbname##ArrayDecl(symbol, dims, location);             \
+        }
+        ODB_DATATYPE_LIST
+#undef X
+    }
+
+    // Unknown node type
+    return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+void serialize(std::vector<uint8_t>* out, const Node* root)
+{
+    Writer writer(out);
+    writer.writeBytes(magic, sizeof(magic));
+    writer.writeValue(formatVersion);
+    writer.writeValue(byteOrderMark);
+    root->accept(&writer);
+}
+
+// ----------------------------------------------------------------------------
+Node* deserialize(const void* data, size_t size)
+{
+    Reader reader(static_cast<const uint8_t*>(data), size);
+
+    char header[sizeof(magic)];
+    uint16_t version, bom;
+    if (!reader.readBytes(header, sizeof(header)) || memcmp(header, magic, sizeof(magic)) != 0)
+        return nullptr;
+    if (!reader.readValue(&version) || version != formatVersion)
+        return nullptr;
+    if (!reader.readValue(&bom) || bom != byteOrderMark)
+        return nullptr;
+
+    Reference<Node> root = reader.readNode();
+    if (root.isNull() || !reader.atEnd())
+        return nullptr;
+
+    return release(&root);
+}
+
+}
@@ -0,0 +1,295 @@
+#include "odb-compiler/ast/SourceFileTable.hpp"
+#include "odb-sdk/MappedFile.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace odb::ast {
+
+namespace {
+
+struct SourceFile
+{
+    std::string_view text() const
+    {
+        if (mappedFile)
+            return std::string_view(mappedFile->data(), mappedFile->size());
+        return ownedText;
+    }
+
+    std::string name;
+    std::string ownedText;
+    Reference<MappedFile> mappedFile;
+    std::vector<uint32_t> lineStarts;
+    std::atomic<int> refs{0};
+    bool isFile = false;
+    bool isLoaded = false;
+    bool loadFailed = false;
+    bool isFree = true;
+};
+
+struct Table
+{
+    // Entries are allocated in chunks that never move, so addRef() and
+    // release() can find an entry without locking
+    static constexpr SourceFileId ChunkSize = 256;
+    static constexpr SourceFileId MaxChunks = 4096;
+
+    SourceFile& operator[](SourceFileId id)
+    {
+        assert(id / ChunkSize < MaxChunks && chunks[id / ChunkSize]);
+        return chunks[id / ChunkSize][id % ChunkSize];
+    }
+
+    std::mutex mutex;
+    std::unique_ptr<SourceFile[]> chunks[MaxChunks];
+    SourceFileId size = 0;
+    std::vector<SourceFileId> freeIds;
+    std::unordered_multimap<std::string, SourceFileId> byName;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+static Table& table()
+{
+    static Table table;
+    return table;
+}
+
+// ----------------------------------------------------------------------------
+static SourceFileId allocateId(Table& t)
+{
+    if (!t.freeIds.empty())
+    {
+        SourceFileId id = t.freeIds.back();
+        t.freeIds.pop_back();
+        return id;
+    }
+
+    assert(t.size < Table::ChunkSize * Table::MaxChunks);
+    if (t.size % Table::ChunkSize == 0)
+        t.chunks[t.size / Table::ChunkSize].reset(new SourceFile[Table::ChunkSize]);
+    return t.size++;
+}
+
+// ----------------------------------------------------------------------------
+static SourceFileId addSource(std::string name, std::string text, MappedFile* mappedFile, bool isFile, bool isLoaded)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    std::string_view newText = mappedFile ?
+            std::string_view(mappedFile->data(), mappedFile->size()) : std::string_view(text);
+
+    auto range = t.byName.equal_range(name);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        SourceFile& file = t[it->second];
+        if (file.isFile != isFile || file.loadFailed)
+            continue;
+
+        // Registering a file without its contents can reuse any existing
+        // entry for that file. Nobody has seen the contents of an unloaded
+        // entry yet, so it can adopt the text, since that's what it would
+        // have loaded anyway
+        bool reuse = !isLoaded || !file.isLoaded || file.text() == newText;
+        if (!reuse)
+            continue;
+
+        if (isLoaded && !file.isLoaded)
+        {
+            file.ownedText = std::move(text);
+            file.mappedFile = mappedFile;
+            file.isLoaded = true;
+        }
+
+        // The entry may have just lost its last reference. release() checks
+        // the count again under the lock, so it won't remove the entry.
+        file.refs.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+
+    SourceFileId id = allocateId(t);
+    SourceFile& file = t[id];
+    file.name = name;
+    file.ownedText = std::move(text);
+    file.mappedFile = mappedFile;
+    file.isFile = isFile;
+    file.isLoaded = isLoaded;
+    file.loadFailed = false;
+    file.isFree = false;
+    file.refs.store(1, std::memory_order_relaxed);
+    t.byName.emplace(std::move(name), id);
+    return id;
+}
+
+// ----------------------------------------------------------------------------
+SourceFileId SourceFileTable::addFile(const std::string& fileName)
+{
+    return addSource(fileName, "", nullptr, true, false);
+}
+
+// ----------------------------------------------------------------------------
+SourceFileId SourceFileTable::addFile(const std::string& fileName, std::string text)
+{
+    return addSource(fileName, std::move(text), nullptr, true, true);
+}
+
+// ----------------------------------------------------------------------------
+SourceFileId SourceFileTable::addFile(const std::string& fileName, MappedFile* file)
+{
+    return addSource(fileName, "", file, true, true);
+}
+
+// ----------------------------------------------------------------------------
+SourceFileId SourceFileTable::addString(const std::string& sourceName, const std::string& code)
+{
+    return addSource(sourceName, code, nullptr, false, true);
+}
+
+// ----------------------------------------------------------------------------
+void SourceFileTable::addRef(SourceFileId id)
+{
+    // The caller holds a reference, so the entry can't be removed or reused
+    // while this runs
+    Table& t = table();
+    t[id].refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+void SourceFileTable::release(SourceFileId id)
+{
+    Table& t = table();
+    if (t[id].refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    // Another thread may have added the same source again, or removed the
+    // entry already, before the lock was taken
+    std::lock_guard<std::mutex> lock(t.mutex);
+    SourceFile& file = t[id];
+    if (file.isFree || file.refs.load(std::memory_order_acquire) != 0)
+        return;
+
+    auto range = t.byName.equal_range(file.name);
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second == id)
+        {
+            t.byName.erase(it);
+            break;
+        }
+
+    file.name.clear();
+    std::string().swap(file.ownedText);
+    std::vector<uint32_t>().swap(file.lineStarts);
+    file.mappedFile.reset();
+    file.isFree = true;
+    t.freeIds.push_back(id);
+}
+
+// ----------------------------------------------------------------------------
+int SourceFileTable::count()
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return (int)(t.size - t.freeIds.size());
+}
+
+// ----------------------------------------------------------------------------
+const std::string& SourceFileTable::name(SourceFileId id)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return t[id].name;
+}
+
+// ----------------------------------------------------------------------------
+bool SourceFileTable::isFile(SourceFileId id)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return t[id].isFile;
+}
+
+// ----------------------------------------------------------------------------
+static bool loadText(SourceFile& file)
+{
+    if (!file.isLoaded)
+    {
+        std::ifstream in(file.name, std::ios::binary);
+        if (in.is_open())
+            file.ownedText.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        else
+            file.loadFailed = true;
+        file.isLoaded = true;
+    }
+
+    return !file.loadFailed;
+}
+
+// ----------------------------------------------------------------------------
+bool SourceFileTable::text(SourceFileId id, std::string_view* text)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    SourceFile& file = t[id];
+
+    if (!loadText(file))
+        return false;
+
+    *text = file.text();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void SourceFileTable::setLineIndex(SourceFileId id, std::vector<uint32_t> lineStarts)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    assert(lineStarts.size() > 0 && lineStarts[0] == 0);
+    SourceFile& file = t[id];
+
+    if (file.lineStarts.empty())
+        file.lineStarts = std::move(lineStarts);
+}
+
+// ----------------------------------------------------------------------------
+bool SourceFileTable::line(SourceFileId id, int lineNumber, std::string_view* line)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    SourceFile& file = t[id];
+
+    if (!loadText(file))
+        return false;
+
+    // Sources that were never lexed (e.g. locations created by hand) don't
+    // have an index yet
+    if (file.lineStarts.empty())
+    {
+        file.lineStarts.push_back(0);
+        std::string_view text = file.text();
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        for (const char* p = begin; (p = (const char*)memchr(p, '\n', end - p)) != nullptr; )
+            file.lineStarts.push_back((uint32_t)(++p - begin));
+    }
+
+    // The text after the last newline counts as a line, even if it's empty
+    if (lineNumber < 1 || lineNumber > (int)file.lineStarts.size())
+        return false;
+
+    size_t start = file.lineStarts[lineNumber - 1];
+    size_t end = lineNumber < (int)file.lineStarts.size() ?
+            file.lineStarts[lineNumber] - 1 : file.text().size();
+    *line = file.text().substr(start, end - start);
+    return true;
+}
+
+}
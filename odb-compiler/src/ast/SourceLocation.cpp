@@ -1,21 +1,59 @@
 #include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-compiler/Stats.hpp"
+#include "odb-sdk/Arena.hpp"
 #include "odb-sdk/Str.hpp"
-#include <fstream>
+#include <algorithm>
 #include <vector>
-#include <sstream>
 #include <cassert>
 
 namespace odb {
 namespace ast {
 
 // ----------------------------------------------------------------------------
-SourceLocation::SourceLocation(int firstLine, int lastLine, int firstColumn, int lastColumn, Log::Color color) :
+static uint16_t packColumn(int column)
+{
+    return (uint16_t)std::clamp(column, 0, 0xFFFF);
+}
+
+// ----------------------------------------------------------------------------
+SourceLocation::SourceLocation(SourceFileId fileId, int firstLine, int lastLine, int firstColumn, int lastColumn, Log::Color color) :
+    fileId_(fileId),
     firstLine_(firstLine),
     lastLine_(lastLine),
-    firstColumn_(firstColumn),
-    lastColumn_(lastColumn),
-    color_(color)
+    firstColumn_(packColumn(firstColumn)),
+    lastColumn_(packColumn(lastColumn)),
+    color_((uint8_t)color)
+{
+    SourceFileTable::addRef(fileId_);
+}
+
+// ----------------------------------------------------------------------------
+SourceLocation::~SourceLocation()
 {
+    SourceFileTable::release(fileId_);
+}
+
+// ----------------------------------------------------------------------------
+void* SourceLocation::operator new(size_t size)
+{
+    if (Stats::enabled())
+    {
+        Stats::add(Stats::ASTAllocations, 1);
+        Stats::add(Stats::ASTBytes, size);
+    }
+    return Arena::allocate(size);
+}
+
+// ----------------------------------------------------------------------------
+void SourceLocation::operator delete(void* ptr)
+{
+    Arena::deallocate(ptr);
+}
+
+// ----------------------------------------------------------------------------
+SourceFileId SourceLocation::fileId() const
+{
+    return fileId_;
 }
 
 // ----------------------------------------------------------------------------
@@ -45,23 +83,23 @@ int SourceLocation::lastColumn() const
 // ----------------------------------------------------------------------------
 Log::Color SourceLocation::color() const
 {
-    return color_;
+    return (Log::Color)color_;
 }
 
 // ----------------------------------------------------------------------------
 void SourceLocation::unionize(const SourceLocation* other)
 {
     if (firstLine_ > other->firstLine())
-        firstColumn_ = other->firstColumn();
+        firstColumn_ = packColumn(other->firstColumn());
     else if (firstLine_ == other->firstLine())
         if (firstColumn_ > other->firstColumn())
             firstColumn_ = other->firstColumn_;
 
     if (lastLine_ < other->lastLine())
-        lastColumn_ = other->lastColumn();
+        lastColumn_ = packColumn(other->lastColumn());
     else if (lastLine_ == other->lastLine())
         if (lastColumn_ < other->lastColumn())
-            lastColumn_ = other->lastColumn();
+            lastColumn_ = packColumn(other->lastColumn());
 
     if (firstLine_ > other->firstLine())
         firstLine_ = other->firstLine();
@@ -70,45 +108,24 @@ void SourceLocation::unionize(const SourceLocation* other)
 }
 
 // ----------------------------------------------------------------------------
-std::vector<std::string> SourceLocation::getUnderlinedSection(std::istream& code) const
+std::vector<std::string> SourceLocation::invalidLocation() const
 {
-    auto retError = [this]() -> std::vector<std::string> {
-        return {"(Invalid location " + std::to_string(firstLine_) + ","
-                                     + std::to_string(lastLine_) + ","
-                                     + std::to_string(firstColumn_) + ","
-                                     + std::to_string(lastColumn_) + ")",
-                ""};
-    };
-    // Seek to first line
-    int currentLine = 0;
-    std::string line;
-    while (currentLine < firstLine_)
-    {
-        if (code.eof())
-            return retError();
-        std::getline(code, line);
-        currentLine++;
-    }
-
-    std::vector<std::string> lines;
-    lines.push_back(line);
-
-    // Section might span more than one line
-    while (currentLine < lastLine_)
-    {
-        if (code.eof())
-            return retError();
-        std::getline(code, line);
-        lines.push_back(line);
-        currentLine++;
-    }
+    return {"(Invalid location " + std::to_string(firstLine_) + ","
+                                 + std::to_string(lastLine_) + ","
+                                 + std::to_string(firstColumn_) + ","
+                                 + std::to_string(lastColumn_) + ")",
+            ""};
+}
 
+// ----------------------------------------------------------------------------
+std::vector<std::string> SourceLocation::getUnderlinedSection(std::vector<std::string> lines) const
+{
     std::vector<std::string> squiggles;
     squiggles.emplace_back();
     for (int i = 1; i < firstColumn_; ++i)
     {
         if (i >= (int)lines[0].length())
-            return retError();
+            return invalidLocation();
         squiggles.back() += " ";
         if (lines[0][i-1] == '\t')
             squiggles.back() += "   ";
@@ -151,7 +168,7 @@ std::vector<std::string> SourceLocation::getUnderlinedSection(std::istream& code
         for (int i = (int)pos; i < lastColumn_-1; ++i)
         {
             if (i >= (int)lines.back().length())
-                return retError();
+                return invalidLocation();
             squiggles.back() += "~";
             if (lines.back()[i] == '\t')
                 squiggles.back() += "~~~";
@@ -162,7 +179,7 @@ std::vector<std::string> SourceLocation::getUnderlinedSection(std::istream& code
         for (int i = firstColumn_; i < lastColumn_-1; ++i)
         {
             if (i >= (int)lines[0].length())
-                return retError();
+                return invalidLocation();
             squiggles.back() += "~";
             if (i > 0 && lines[0][i-1] == '\t')
                 squiggles.back() += "~~~";
@@ -213,71 +230,60 @@ std::string SourceLocation::getLineColumnExtents() const
 }
 
 // ----------------------------------------------------------------------------
-FileSourceLocation::FileSourceLocation(const std::string& fileName,
-        int firstLine, int lastLine, int firstColumn, int lastColumn) :
-    SourceLocation(firstLine, lastLine, firstColumn, lastColumn),
-    fileName_(fileName)
+std::string SourceLocation::getFileLineColumn() const
 {
+    return SourceFileTable::name(fileId_) + ":" + std::to_string(firstLine_) + ":" + std::to_string(firstColumn_);
 }
 
 // ----------------------------------------------------------------------------
-std::string FileSourceLocation::getFileLineColumn() const
+std::vector<std::string> SourceLocation::getUnderlinedSection() const
 {
-    return fileName_ + ":" + std::to_string(firstLine_) + ":" + std::to_string(firstColumn_);
-}
-
-// ----------------------------------------------------------------------------
-std::vector<std::string> FileSourceLocation::getUnderlinedSection() const
-{
-    std::ifstream code(fileName_);
-    if (!code.is_open())
+    std::string_view code;
+    if (!SourceFileTable::text(fileId_, &code))
         return {"(source file was removed)"};
-    return SourceLocation::getUnderlinedSection(code);
+
+    // Each line is an O(1) lookup in the source's line index, so rendering
+    // doesn't depend on how far into the file the location is. Line 0 is
+    // used by generated locations and is treated as an empty line.
+    std::vector<std::string> lines;
+    for (int l = firstLine_; l <= std::max(firstLine_, lastLine_); ++l)
+    {
+        std::string_view line;
+        if (l != 0 && !SourceFileTable::line(fileId_, l, &line))
+            return invalidLocation();
+        lines.emplace_back(line);
+    }
+
+    return getUnderlinedSection(std::move(lines));
 }
 
 // ----------------------------------------------------------------------------
-SourceLocation* FileSourceLocation::duplicate() const
+SourceLocation* SourceLocation::duplicate() const
 {
-    return new FileSourceLocation(
-        fileName_,
+    return new SourceLocation(
+        fileId_,
         firstLine_,
         lastLine_,
         firstColumn_,
-        lastColumn_);
+        lastColumn_,
+        color());
 }
 
 // ----------------------------------------------------------------------------
-InlineSourceLocation::InlineSourceLocation(const std::string& sourceName, const std::string& code,
+FileSourceLocation::FileSourceLocation(const std::string& fileName,
         int firstLine, int lastLine, int firstColumn, int lastColumn) :
-    SourceLocation(firstLine, lastLine, firstColumn, lastColumn),
-    sourceName_(sourceName),
-    code_(code)
-{
-}
-
-// ----------------------------------------------------------------------------
-std::string InlineSourceLocation::getFileLineColumn() const
-{
-    return sourceName_ + ":" + std::to_string(firstLine_) + ":" + std::to_string(firstColumn_);
-}
-
-// ----------------------------------------------------------------------------
-std::vector<std::string> InlineSourceLocation::getUnderlinedSection() const
+    SourceLocation(SourceFileTable::addFile(fileName), firstLine, lastLine, firstColumn, lastColumn)
 {
-    std::stringstream ss(code_);
-    return SourceLocation::getUnderlinedSection(ss);
+    // The location holds its own reference now
+    SourceFileTable::release(fileId_);
 }
 
 // ----------------------------------------------------------------------------
-SourceLocation* InlineSourceLocation::duplicate() const
+InlineSourceLocation::InlineSourceLocation(const std::string& sourceName, const std::string& code,
+        int firstLine, int lastLine, int firstColumn, int lastColumn) :
+    SourceLocation(SourceFileTable::addString(sourceName, code), firstLine, lastLine, firstColumn, lastColumn)
 {
-    return new InlineSourceLocation(
-        sourceName_,
-        code_,
-        firstLine_,
-        lastLine_,
-        firstColumn_,
-        lastColumn_);
+    SourceFileTable::release(fileId_);
 }
 
 }
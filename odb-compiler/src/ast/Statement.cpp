@@ -4,8 +4,8 @@
 namespace odb::ast {
 
 // ----------------------------------------------------------------------------
-Statement::Statement(SourceLocation* location) :
-    Node(location)
+Statement::Statement(NodeKind kind, SourceLocation* location) :
+    Node(kind, location)
 {
 }
 
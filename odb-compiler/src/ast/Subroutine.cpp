@@ -9,7 +9,7 @@ namespace ast {
 
 // ----------------------------------------------------------------------------
 SubCall::SubCall(Symbol* label, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::SubCall, location),
     label_(label)
 {
     label->setParent(this);
@@ -63,7 +63,7 @@ Node* SubCall::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 SubReturn::SubReturn(SourceLocation* location) :
-    Statement(location)
+    Statement(NodeKind::SubReturn, location)
 {
 }
 
@@ -6,8 +6,27 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 Symbol::Symbol(const std::string& name, SourceLocation* location) :
-    Node(location),
-    name_(name)
+    Symbol(NodeKind::Symbol, name, location)
+{
+}
+
+// ----------------------------------------------------------------------------
+Symbol::Symbol(Atom atom, const std::string& name, SourceLocation* location) :
+    Symbol(NodeKind::Symbol, atom, name, location)
+{
+}
+
+// ----------------------------------------------------------------------------
+Symbol::Symbol(NodeKind kind, const std::string& name, SourceLocation* location) :
+    Symbol(kind, AtomTable::intern(name), name, location)
+{
+}
+
+// ----------------------------------------------------------------------------
+Symbol::Symbol(NodeKind kind, Atom atom, const std::string& name, SourceLocation* location) :
+    Node(kind, location),
+    name_(name),
+    atom_(atom)
 {
 }
 
@@ -17,6 +36,12 @@ const std::string& Symbol::name() const
     return name_;
 }
 
+// ----------------------------------------------------------------------------
+Atom Symbol::atom() const
+{
+    return atom_;
+}
+
 // ----------------------------------------------------------------------------
 std::string Symbol::toString() const
 {
@@ -42,7 +67,7 @@ void Symbol::swapChild(const Node* oldNode, Node* newNode)
 // ----------------------------------------------------------------------------
 Node* Symbol::duplicateImpl() const
 {
-    return new Symbol(name_, location());
+    return new Symbol(atom_, name_, location());
 }
 
 }
@@ -13,7 +13,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 UDTDecl::UDTDecl(Symbol* typeName, UDTDeclBody* udtBody, SourceLocation* location) :
-    Statement(location),
+    Statement(NodeKind::UDTDecl, location),
     typeName_(typeName),
     body_(udtBody)
 {
@@ -80,20 +80,20 @@ Node* UDTDecl::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 UDTDeclBody::UDTDeclBody(SourceLocation* location) :
-    Node(location)
+    Node(NodeKind::UDTDeclBody, location)
 {
 }
 
 // ----------------------------------------------------------------------------
 UDTDeclBody::UDTDeclBody(VarDecl* varDecl, SourceLocation* location) :
-    Node(location)
+    Node(NodeKind::UDTDeclBody, location)
 {
     appendVarDecl(varDecl);
 }
 
 // ----------------------------------------------------------------------------
 UDTDeclBody::UDTDeclBody(ArrayDecl* arrayDecl, SourceLocation* location) :
-    Node(location)
+    Node(NodeKind::UDTDeclBody, location)
 {
     appendArrayDecl(arrayDecl);
 }
@@ -5,7 +5,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 UDTFieldOuter::UDTFieldOuter(Expression* left, LValue* right, SourceLocation* location)
-    : LValue(location)
+    : LValue(NodeKind::UDTFieldOuter, location)
     , left_(left)
     , right_(right)
 {
@@ -72,7 +72,7 @@ Node* UDTFieldOuter::duplicateImpl() const
 
 // ----------------------------------------------------------------------------
 UDTFieldInner::UDTFieldInner(LValue* left, LValue* right, SourceLocation* location)
-    : LValue(location)
+    : LValue(NodeKind::UDTFieldInner, location)
     , left_(left)
     , right_(right)
 {
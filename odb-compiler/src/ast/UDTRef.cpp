@@ -6,7 +6,13 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 UDTRef::UDTRef(const std::string& name, SourceLocation* location)
-    : Symbol(name, location)
+    : Symbol(NodeKind::UDTRef, name, location)
+{
+}
+
+// ----------------------------------------------------------------------------
+UDTRef::UDTRef(Atom atom, const std::string& name, SourceLocation* location)
+    : Symbol(NodeKind::UDTRef, atom, name, location)
 {
 }
 
@@ -29,7 +35,7 @@ void UDTRef::accept(ConstVisitor* visitor) const
 // ----------------------------------------------------------------------------
 Node* UDTRef::duplicateImpl() const
 {
-    return new UDTRef(name_, location());
+    return new UDTRef(atom_, name_, location());
 }
 
 }
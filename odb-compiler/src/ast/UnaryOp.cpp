@@ -6,7 +6,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 UnaryOp::UnaryOp(UnaryOpType op, Expression* expr, SourceLocation* location) :
-    Expression(location),
+    Expression(NodeKind::UnaryOp, location),
     expr_(expr),
     op_(op)
 {
@@ -9,8 +9,8 @@
 namespace odb::ast {
 
 // ----------------------------------------------------------------------------
-VarDecl::VarDecl(ScopedAnnotatedSymbol* symbol, InitializerList* initializer, SourceLocation* location) :
-    Statement(location),
+VarDecl::VarDecl(NodeKind kind, ScopedAnnotatedSymbol* symbol, InitializerList* initializer, SourceLocation* location) :
+    Statement(kind, location),
     symbol_(symbol),
     initializer_(initializer)
 {
@@ -19,8 +19,8 @@ VarDecl::VarDecl(ScopedAnnotatedSymbol* symbol, InitializerList* initializer, So
 }
 
 // ----------------------------------------------------------------------------
-VarDecl::VarDecl(ScopedAnnotatedSymbol* symbol, SourceLocation* location) :
-    Statement(location),
+VarDecl::VarDecl(NodeKind kind, ScopedAnnotatedSymbol* symbol, SourceLocation* location) :
+    Statement(kind, location),
     symbol_(symbol)
 {
     symbol->setParent(this);
@@ -53,13 +53,13 @@ void VarDecl::setInitializer(InitializerList* initializer)
     dbname##VarDecl::dbname##VarDecl(ScopedAnnotatedSymbol* symbol,           \
                                      InitializerList* initial,                \
                                      SourceLocation* location)                \
-        : VarDecl(symbol, initial, location)                                  \
+        : VarDecl(NodeKind::dbname##VarDecl, symbol, initial, location)       \
     {                                                                         \
     }                                                                         \
                                                                               \
     dbname##VarDecl::dbname##VarDecl(ScopedAnnotatedSymbol* symbol,           \
                                      SourceLocation* location)                \
-        : VarDecl(symbol,                                                     \
+        : VarDecl(NodeKind::dbname##VarDecl, symbol,                          \
             new InitializerList(                                              \
                 new dbname##Literal(cppname(), location),                     \
                 location),                                                    \
@@ -113,7 +113,7 @@ ODB_DATATYPE_LIST
 
 // ----------------------------------------------------------------------------
 UDTVarDecl::UDTVarDecl(ScopedAnnotatedSymbol* symbol, UDTRef* udt, InitializerList* initializer, SourceLocation* location)
-    : VarDecl(symbol, initializer, location)
+    : VarDecl(NodeKind::UDTVarDecl, symbol, initializer, location)
     , udt_(udt)
 {
     udt->setParent(this);
@@ -121,7 +121,7 @@ UDTVarDecl::UDTVarDecl(ScopedAnnotatedSymbol* symbol, UDTRef* udt, InitializerLi
 
 // ----------------------------------------------------------------------------
 UDTVarDecl::UDTVarDecl(ScopedAnnotatedSymbol* symbol, UDTRef* udt, SourceLocation* location)
-    : VarDecl(symbol, location)
+    : VarDecl(NodeKind::UDTVarDecl, symbol, location)
     , udt_(udt)
 {
     udt->setParent(this);
@@ -7,7 +7,7 @@ namespace odb::ast {
 
 // ----------------------------------------------------------------------------
 VarRef::VarRef(AnnotatedSymbol* symbol, SourceLocation* location) :
-    LValue(location),
+    LValue(NodeKind::VarRef, location),
     symbol_(symbol)
 {
     symbol->setParent(this);
@@ -0,0 +1,488 @@
+#include "odb-compiler/commands/CommandCache.hpp"
+#include "odb-compiler/commands/Command.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-sdk/DynamicLibrary.hpp"
+#include "odb-sdk/Log.hpp"
+#include "odb-sdk/MappedFile.hpp"
+#include "odb-sdk/Str.hpp"
+#include "../AtomicFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace odb {
+namespace cmd {
+
+// All offsets are relative to the start of the image. String references are
+// offsets into the string table, which holds NUL terminated strings.
+struct CommandCache::Header
+{
+    char magic[8];
+    uint16_t version;
+    uint16_t byteOrderMark;
+    uint32_t pluginCount;
+    uint32_t commandCount;
+    uint32_t argCount;
+    uint32_t nameCount;
+    uint32_t pluginsOffset;
+    uint32_t commandsOffset;
+    uint32_t argsOffset;
+    uint32_t namesOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t reserved;
+};
+
+struct CommandCache::PluginRecord
+{
+    uint32_t path;
+    uint32_t firstCommand;
+    uint32_t commandCount;
+    uint32_t reserved;
+    int64_t modificationTime;
+    uint64_t size;
+};
+
+struct CommandCache::CommandRecord
+{
+    uint32_t dbSymbol;
+    uint32_t cppSymbol;
+    uint32_t helpFile;
+    uint32_t firstArg;
+    uint32_t argCount;
+    char returnType;
+    char reserved[3];
+};
+
+struct CommandCache::ArgRecord
+{
+    uint32_t symName;
+    uint32_t description;
+    char type;
+    char reserved[3];
+};
+
+static constexpr char magic[8] = {'O', 'D', 'B', 'C', 'M', 'D', 'D', 'B'};
+static constexpr uint16_t version = 1;
+static constexpr uint16_t byteOrderMark = 0x0102;
+
+// Every table starts on this boundary so records can be accessed in place
+static constexpr size_t tableAlignment = 8;
+
+// ----------------------------------------------------------------------------
+static bool typeExists(char c)
+{
+    using T = Command::Type;
+    switch (static_cast<T>(c))
+    {
+        case T::Integer:
+        case T::Float:
+        case T::String:
+        case T::Double:
+        case T::Long:
+        case T::Dword:
+        case T::Void:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Plugins are looked up by their normalized absolute path, so the same plugin
+// maps to the same entry regardless of how the SDK root was specified
+static std::string pluginKey(const fs::path& plugin)
+{
+    std::error_code ec;
+    fs::path absolute = fs::absolute(plugin, ec);
+    if (ec)
+        return plugin.lexically_normal().string();
+    return absolute.lexically_normal().string();
+}
+
+// ----------------------------------------------------------------------------
+static bool statPlugin(const fs::path& plugin, int64_t* modificationTime, uint64_t* size)
+{
+    std::error_code ec;
+    auto time = fs::last_write_time(plugin, ec);
+    if (ec)
+        return false;
+    uintmax_t fileSize = fs::file_size(plugin, ec);
+    if (ec)
+        return false;
+
+    *modificationTime = (int64_t)time.time_since_epoch().count();
+    *size = (uint64_t)fileSize;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static bool tableInBounds(uint32_t offset, uint32_t count, size_t recordSize, size_t imageSize)
+{
+    if (offset % tableAlignment != 0)
+        return false;
+    return (uint64_t)offset + (uint64_t)count * recordSize <= imageSize;
+}
+
+// ----------------------------------------------------------------------------
+CommandCache::CommandCache(MappedFile* file) :
+    file_(file)
+{
+}
+
+// ----------------------------------------------------------------------------
+CommandCache::~CommandCache() = default;
+
+// ----------------------------------------------------------------------------
+CommandCache* CommandCache::open(const fs::path& fileName)
+{
+    Reference<MappedFile> file = MappedFile::open(fileName.string().c_str());
+    if (file == nullptr)
+        return nullptr;
+
+    auto corrupt = [&fileName]() -> CommandCache* {
+        Log::cmd(Log::WARNING, "Ignoring corrupt command cache `%s`\n", fileName.string().c_str());
+        return nullptr;
+    };
+
+    // Validate everything up front so the accessors can trust the image
+    const char* data = file->data();
+    size_t size = file->size();
+    if (size < sizeof(Header))
+        return corrupt();
+
+    const Header* h = reinterpret_cast<const Header*>(data);
+    if (memcmp(h->magic, magic, sizeof(magic)) != 0)
+        return corrupt();
+    if (h->byteOrderMark != byteOrderMark || h->version != version)
+    {
+        Log::cmd(Log::INFO, "Command cache `%s` was written by a different version and will be rebuilt\n", fileName.string().c_str());
+        return nullptr;
+    }
+
+    if (!tableInBounds(h->pluginsOffset, h->pluginCount, sizeof(PluginRecord), size) ||
+        !tableInBounds(h->commandsOffset, h->commandCount, sizeof(CommandRecord), size) ||
+        !tableInBounds(h->argsOffset, h->argCount, sizeof(ArgRecord), size) ||
+        !tableInBounds(h->namesOffset, h->nameCount, sizeof(uint32_t), size))
+    {
+        return corrupt();
+    }
+
+    if (h->stringsSize == 0 || (uint64_t)h->stringsOffset + h->stringsSize > size)
+        return corrupt();
+    const char* strings = data + h->stringsOffset;
+    if (strings[h->stringsSize - 1] != '\0')
+        return corrupt();
+
+    auto validString = [h](uint32_t offset) { return offset < h->stringsSize; };
+
+    const PluginRecord* plugins = reinterpret_cast<const PluginRecord*>(data + h->pluginsOffset);
+    for (uint32_t i = 0; i != h->pluginCount; ++i)
+    {
+        const PluginRecord& p = plugins[i];
+        if (!validString(p.path) || (uint64_t)p.firstCommand + p.commandCount > h->commandCount)
+            return corrupt();
+        // Plugins are looked up with a binary search
+        if (i > 0 && strcmp(strings + plugins[i - 1].path, strings + p.path) >= 0)
+            return corrupt();
+    }
+
+    const CommandRecord* commands = reinterpret_cast<const CommandRecord*>(data + h->commandsOffset);
+    for (uint32_t i = 0; i != h->commandCount; ++i)
+    {
+        const CommandRecord& c = commands[i];
+        if (!validString(c.dbSymbol) || !validString(c.cppSymbol) || !validString(c.helpFile))
+            return corrupt();
+        if ((uint64_t)c.firstArg + c.argCount > h->argCount || !typeExists(c.returnType))
+            return corrupt();
+    }
+
+    const ArgRecord* args = reinterpret_cast<const ArgRecord*>(data + h->argsOffset);
+    for (uint32_t i = 0; i != h->argCount; ++i)
+        if (!validString(args[i].symName) || !validString(args[i].description) || !typeExists(args[i].type))
+            return corrupt();
+
+    const uint32_t* names = reinterpret_cast<const uint32_t*>(data + h->namesOffset);
+    for (uint32_t i = 0; i != h->nameCount; ++i)
+    {
+        if (!validString(names[i]))
+            return corrupt();
+        if (i > 0 && std::string_view(strings + names[i - 1]) >= std::string_view(strings + names[i]))
+            return corrupt();
+    }
+
+    return new CommandCache(file);
+}
+
+// ----------------------------------------------------------------------------
+bool CommandCache::write(const fs::path& fileName, const CommandIndex& index,
+                         const std::vector<fs::path>& scannedPlugins)
+{
+    // Group commands by plugin. Sorting by key is required for lookups, and
+    // keeping the index order within a plugin keeps overloads in the order
+    // the plugin exported them
+    struct Plugin
+    {
+        int64_t modificationTime;
+        uint64_t size;
+        std::vector<const Command*> commands;
+    };
+    std::map<std::string, Plugin> pluginsByKey;
+    std::unordered_map<const DynamicLibrary*, Plugin*> pluginsByLibrary;
+
+    // Plugins that failed to load or export no commands still get an entry,
+    // otherwise they would be opened again on every run
+    for (const auto& plugin : scannedPlugins)
+    {
+        Plugin entry;
+        if (statPlugin(plugin, &entry.modificationTime, &entry.size))
+            pluginsByKey.emplace(pluginKey(plugin), std::move(entry));
+    }
+    for (const auto& command : index.commands())
+    {
+        const DynamicLibrary* library = command->library();
+        if (library == nullptr)
+            continue;
+
+        auto it = pluginsByLibrary.find(library);
+        if (it == pluginsByLibrary.end())
+        {
+            std::string key = pluginKey(library->getFilename());
+            auto scanned = pluginsByKey.find(key);
+            if (scanned == pluginsByKey.end())
+            {
+                Plugin plugin;
+                if (!statPlugin(library->getFilename(), &plugin.modificationTime, &plugin.size))
+                {
+                    // Leaving the plugin out means it is loaded normally next time
+                    pluginsByLibrary.emplace(library, nullptr);
+                    continue;
+                }
+                scanned = pluginsByKey.emplace(std::move(key), std::move(plugin)).first;
+            }
+            it = pluginsByLibrary.emplace(library, &scanned->second).first;
+        }
+        if (it->second)
+            it->second->commands.push_back(command);
+    }
+
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> stringOffsets;
+    auto addString = [&strings, &stringOffsets](const std::string& str) -> uint32_t {
+        auto it = stringOffsets.find(str);
+        if (it != stringOffsets.end())
+            return it->second;
+        uint32_t offset = (uint32_t)strings.size();
+        strings.append(str.c_str(), str.size() + 1);
+        stringOffsets.emplace(str, offset);
+        return offset;
+    };
+
+    std::vector<PluginRecord> pluginRecords;
+    std::vector<CommandRecord> commandRecords;
+    std::vector<ArgRecord> argRecords;
+    std::vector<std::string> names;
+    for (const auto& [key, plugin] : pluginsByKey)
+    {
+        PluginRecord& p = pluginRecords.emplace_back();
+        memset(&p, 0, sizeof(p));
+        p.path = addString(key);
+        p.firstCommand = (uint32_t)commandRecords.size();
+        p.commandCount = (uint32_t)plugin.commands.size();
+        p.modificationTime = plugin.modificationTime;
+        p.size = plugin.size;
+
+        for (const Command* command : plugin.commands)
+        {
+            CommandRecord& c = commandRecords.emplace_back();
+            memset(&c, 0, sizeof(c));
+            c.dbSymbol = addString(command->dbSymbol());
+            c.cppSymbol = addString(command->cppSymbol());
+            c.helpFile = addString(command->helpFile());
+            c.firstArg = (uint32_t)argRecords.size();
+            c.argCount = (uint32_t)command->args().size();
+            c.returnType = static_cast<char>(command->returnType());
+
+            for (const auto& arg : command->args())
+            {
+                ArgRecord& a = argRecords.emplace_back();
+                memset(&a, 0, sizeof(a));
+                a.symName = addString(arg.symName);
+                a.description = addString(arg.description);
+                a.type = static_cast<char>(arg.type);
+            }
+
+            names.push_back(str::toLower(command->dbSymbol()));
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    std::vector<uint32_t> nameRecords;
+    nameRecords.reserve(names.size());
+    for (const auto& name : names)
+        nameRecords.push_back(addString(name));
+
+    // The string table must not be empty, so an empty image still validates
+    if (strings.empty())
+        strings.push_back('\0');
+
+    std::vector<char> image(sizeof(Header));
+    auto appendTable = [&image](const void* records, size_t bytes) -> uint32_t {
+        image.resize((image.size() + tableAlignment - 1) & ~(tableAlignment - 1));
+        uint32_t offset = (uint32_t)image.size();
+        const char* begin = static_cast<const char*>(records);
+        image.insert(image.end(), begin, begin + bytes);
+        return offset;
+    };
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.byteOrderMark = byteOrderMark;
+    h.pluginCount = (uint32_t)pluginRecords.size();
+    h.commandCount = (uint32_t)commandRecords.size();
+    h.argCount = (uint32_t)argRecords.size();
+    h.nameCount = (uint32_t)nameRecords.size();
+    h.pluginsOffset = appendTable(pluginRecords.data(), pluginRecords.size() * sizeof(PluginRecord));
+    h.commandsOffset = appendTable(commandRecords.data(), commandRecords.size() * sizeof(CommandRecord));
+    h.argsOffset = appendTable(argRecords.data(), argRecords.size() * sizeof(ArgRecord));
+    h.namesOffset = appendTable(nameRecords.data(), nameRecords.size() * sizeof(uint32_t));
+    h.stringsOffset = appendTable(strings.data(), strings.size());
+    h.stringsSize = (uint32_t)strings.size();
+    memcpy(image.data(), &h, sizeof(h));
+
+    // Another compiler instance may be reading the cache
+    if (!writeFileAtomically(fileName, image.data(), image.size()))
+    {
+        Log::cmd(Log::WARNING, "Failed to write command cache `%s`\n", fileName.string().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+const CommandCache::Header* CommandCache::header() const
+{
+    return reinterpret_cast<const Header*>(file_->data());
+}
+
+// ----------------------------------------------------------------------------
+const CommandCache::PluginRecord* CommandCache::plugins() const
+{
+    return reinterpret_cast<const PluginRecord*>(file_->data() + header()->pluginsOffset);
+}
+
+// ----------------------------------------------------------------------------
+const CommandCache::CommandRecord* CommandCache::commands() const
+{
+    return reinterpret_cast<const CommandRecord*>(file_->data() + header()->commandsOffset);
+}
+
+// ----------------------------------------------------------------------------
+const CommandCache::ArgRecord* CommandCache::args() const
+{
+    return reinterpret_cast<const ArgRecord*>(file_->data() + header()->argsOffset);
+}
+
+// ----------------------------------------------------------------------------
+const char* CommandCache::string(uint32_t offset) const
+{
+    return file_->data() + header()->stringsOffset + offset;
+}
+
+// ----------------------------------------------------------------------------
+int CommandCache::pluginCount() const
+{
+    return (int)header()->pluginCount;
+}
+
+// ----------------------------------------------------------------------------
+const CommandCache::PluginRecord* CommandCache::findPlugin(const fs::path& plugin) const
+{
+    std::string key = pluginKey(plugin);
+    const PluginRecord* first = plugins();
+    const PluginRecord* last = first + header()->pluginCount;
+    const PluginRecord* it = std::lower_bound(first, last, key,
+            [this](const PluginRecord& p, const std::string& key) { return strcmp(string(p.path), key.c_str()) < 0; });
+    if (it == last || key != string(it->path))
+        return nullptr;
+    return it;
+}
+
+// ----------------------------------------------------------------------------
+bool CommandCache::isUpToDate(const fs::path& plugin) const
+{
+    const PluginRecord* p = findPlugin(plugin);
+    if (p == nullptr)
+        return false;
+
+    int64_t modificationTime;
+    uint64_t size;
+    if (!statPlugin(plugin, &modificationTime, &size))
+        return false;
+
+    return p->modificationTime == modificationTime && p->size == size;
+}
+
+// ----------------------------------------------------------------------------
+void CommandCache::addPluginCommands(CommandIndex* index, const PluginRecord* plugin) const
+{
+    // All commands of a plugin share the same handle, and it's only loaded
+    // if something actually needs its symbols
+    Reference<DynamicLibrary> library = DynamicLibrary::openDeferred(string(plugin->path));
+
+    const CommandRecord* c = commands() + plugin->firstCommand;
+    for (uint32_t i = 0; i != plugin->commandCount; ++i, ++c)
+    {
+        std::vector<Command::Arg> cmdArgs;
+        cmdArgs.reserve(c->argCount);
+        const ArgRecord* a = args() + c->firstArg;
+        for (uint32_t j = 0; j != c->argCount; ++j, ++a)
+            cmdArgs.push_back({static_cast<Command::Type>(a->type), string(a->symName), string(a->description)});
+
+        index->addCommand(new Command(library, string(c->dbSymbol), string(c->cppSymbol),
+                                      static_cast<Command::Type>(c->returnType), cmdArgs, string(c->helpFile)));
+    }
+}
+
+// ----------------------------------------------------------------------------
+bool CommandCache::populateIndexFromPlugin(CommandIndex* index, const fs::path& plugin) const
+{
+    const PluginRecord* p = findPlugin(plugin);
+    if (p == nullptr)
+        return false;
+
+    addPluginCommands(index, p);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void CommandCache::populateIndex(CommandIndex* index) const
+{
+    const PluginRecord* p = plugins();
+    for (uint32_t i = 0; i != header()->pluginCount; ++i)
+        addPluginCommands(index, p + i);
+}
+
+// ----------------------------------------------------------------------------
+int CommandCache::commandNameCount() const
+{
+    return (int)header()->nameCount;
+}
+
+// ----------------------------------------------------------------------------
+std::string_view CommandCache::commandNameAt(int idx) const
+{
+    const uint32_t* names = reinterpret_cast<const uint32_t*>(file_->data() + header()->namesOffset);
+    return string(names[idx]);
+}
+
+}
+}
@@ -1,4 +1,5 @@
 #include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandCache.hpp"
 #include "odb-sdk/DynamicLibrary.hpp"
 #include "odb-sdk/Log.hpp"
 #include "odb-sdk/Str.hpp"
@@ -12,6 +13,12 @@
 namespace odb {
 namespace cmd {
 
+// ----------------------------------------------------------------------------
+CommandIndex::CommandIndex(const CommandCache& cache)
+{
+    cache.populateIndex(this);
+}
+
 // ----------------------------------------------------------------------------
 void CommandIndex::addCommand(Command* command)
 {
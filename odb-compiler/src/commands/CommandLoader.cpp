@@ -1,4 +1,15 @@
 #include "odb-compiler/commands/CommandLoader.hpp"
+#include "odb-compiler/commands/CommandCache.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/Trace.hpp"
+#include "odb-sdk/DynamicLibrary.hpp"
+#include "odb-sdk/Log.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace fs = std::filesystem;
 
 namespace odb {
 namespace cmd {
@@ -11,5 +22,98 @@ CommandLoader::CommandLoader(const std::filesystem::path& sdkRoot,
 {
 }
 
+// ----------------------------------------------------------------------------
+void CommandLoader::setCommandCacheFile(const fs::path& cacheFile)
+{
+    commandCacheFile_ = cacheFile;
+}
+
+// ----------------------------------------------------------------------------
+void CommandLoader::setJobs(int jobs)
+{
+    jobs_ = jobs;
+}
+
+// ----------------------------------------------------------------------------
+bool CommandLoader::populateIndexFromPlugins(CommandIndex* index, const std::vector<fs::path>& pluginPaths)
+{
+    // Directory iteration order is unspecified. Sorting makes the order of
+    // the commands, and with it the conflicts that get reported, the same on
+    // every run
+    std::vector<fs::path> plugins = pluginPaths;
+    std::sort(plugins.begin(), plugins.end());
+
+    Reference<CommandCache> cache;
+    if (!commandCacheFile_.empty())
+        cache = CommandCache::open(commandCacheFile_);
+
+    // Each plugin's commands are collected into a separate index and merged
+    // afterwards in plugin order, so the result does not depend on which
+    // thread finishes first
+    std::vector<CommandIndex> results(plugins.size());
+    std::vector<size_t> pluginsToOpen;
+    int pluginsFromCache = 0;
+    for (size_t i = 0; i != plugins.size(); ++i)
+    {
+        if (cache && cache->isUpToDate(plugins[i]) && cache->populateIndexFromPlugin(&results[i], plugins[i]))
+            pluginsFromCache++;
+        else
+            pluginsToOpen.push_back(i);
+    }
+
+    // Opening a plugin and walking its symbol table is independent of all
+    // other plugins
+    std::atomic<size_t> nextPlugin(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        for (size_t i = nextPlugin++; i < pluginsToOpen.size() && !failed; i = nextPlugin++)
+        {
+            size_t slot = pluginsToOpen[i];
+            TraceScope trace("plugin", "load plugin", plugins[slot].filename().string());
+            Reference<DynamicLibrary> lib = DynamicLibrary::open(plugins[slot].string().c_str());
+            if (lib == nullptr)
+                continue;
+
+            if (!populateIndexFromLibrary(&results[slot], lib))
+                failed = true;
+        }
+    };
+
+    int jobs = jobs_ > 0 ? jobs_ : (int)std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min(jobs, (int)pluginsToOpen.size());
+    if (jobs <= 1)
+        worker();
+    else
+    {
+        std::vector<std::thread> threads;
+        for (int i = 0; i != jobs; ++i)
+            threads.emplace_back(worker);
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    if (failed)
+        return false;
+
+    for (const auto& result : results)
+        for (const auto& command : result.commands())
+            index->addCommand(command);
+
+    if (commandCacheFile_.empty())
+        return true;
+
+    // Entries of plugins that were removed also make the image stale
+    if (!pluginsToOpen.empty() || cache == nullptr || cache->pluginCount() != pluginsFromCache)
+    {
+        // The mapping must be gone before the file can be replaced on Windows
+        cache.reset();
+        CommandCache::write(commandCacheFile_, *index, plugins);
+    }
+    else
+        Log::cmd(Log::INFO, "Loaded commands of %d plugins from cache `%s`\n", pluginsFromCache, commandCacheFile_.string().c_str());
+
+    return true;
+}
+
 }
 }
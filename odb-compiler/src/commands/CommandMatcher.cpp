@@ -1,9 +1,9 @@
 #include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/commands/CommandCache.hpp"
 #include "odb-compiler/commands/CommandIndex.hpp"
 #include "odb-sdk/Str.hpp"
 #include <algorithm>
-#include <iostream>
-#include <cstring>
+#include <cctype>
 
 namespace odb {
 namespace cmd {
@@ -22,73 +22,190 @@ static bool charIsSymbolToken(char c)
     return false;
 }
 
+// ----------------------------------------------------------------------------
+static char toLower(char c)
+{
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
 // ----------------------------------------------------------------------------
 void CommandMatcher::updateFromIndex(const CommandIndex* db)
 {
-    longestCommandLength_ = 0;
-    longestCommandWordCount_ = 0;
-    commands_ = db->commandNamesAsList();
+    std::vector<std::string> names = db->commandNamesAsList();
 
     // Commands are case insensitive, so transform all to lower case
-    for (auto& s : commands_)
+    for (auto& s : names)
         str::toLowerInplace(s);
 
-    // Lexicographic sort so we can binary search later
-    std::sort(commands_.begin(), commands_.end(), [](const std::string& a,const  std::string& b) { return a < b; });
-
-    // Find the longest command so the lexicographic comparison is faster during
-    // binary search
-    auto longestCommand = std::max_element(commands_.begin(), commands_.end(),
-            [](const std::string& a, const std::string& b) { return a.size() < b.size(); });
-    if (longestCommand != commands_.end())
-        longestCommandLength_ = (int)longestCommand->size();
-
-    // Find the maximum number of words that appear in a command. This is not
-    // necessarily the longest command. Counting the number of spaces should
-    // work in all cases.
-    auto wordCount = [](const std::string& str) {
-        return std::count(str.begin(), str.end(), ' ') + 1;
-    };
-    auto longestCommandWordCount = std::max_element(commands_.begin(), commands_.end(),
-            [&wordCount](const std::string& a, const std::string& b) {
-                return wordCount(a) < wordCount(b);
-            });
-    if (longestCommandWordCount != commands_.end())
-        longestCommandWordCount_ = (int)wordCount(*longestCommandWordCount);
+    // Lexicographic sort groups commands sharing a prefix together. Overloaded
+    // commands share the same name, so remove duplicates
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    buildTrie(std::vector<std::string_view>(names.begin(), names.end()));
 }
 
 // ----------------------------------------------------------------------------
-CommandMatcher::MatchResult CommandMatcher::findLongestCommandMatching(const std::string& str) const
+void CommandMatcher::updateFromCache(const CommandCache* cache)
 {
-    auto first = commands_.begin();
-    auto last = commands_.end();
-    std::vector<std::vector<std::string>::const_iterator> commandStack;
-    commandStack.reserve(longestCommandWordCount());
-    int matchedLen = 0;
-    while (str[matchedLen])
+    // The cache already stores the names case-folded, sorted and unique
+    std::vector<std::string_view> names;
+    names.reserve(cache->commandNameCount());
+    for (int i = 0; i != cache->commandNameCount(); ++i)
+        names.push_back(cache->commandNameAt(i));
+
+    buildTrie(names);
+}
+
+// ----------------------------------------------------------------------------
+void CommandMatcher::buildTrie(const std::vector<std::string_view>& commands)
+{
+    longestCommandLength_ = 0;
+    longestCommandWordCount_ = 0;
+
+    for (const auto& command : commands)
     {
-        auto compare = [&](const std::string& a, const std::string& b) {
-            return std::tolower(a[matchedLen]) < std::tolower(b[matchedLen]);
-        };
-        first = std::lower_bound(first, last, str, compare);
-        last = std::upper_bound(first, last, str, compare);
-        if (first == last)
-            break;
-
-        ++matchedLen;
-        if (!charIsSymbolToken(str[matchedLen]))
-            commandStack.push_back(first);
+        // Find the maximum number of words that appear in a command. This is
+        // not necessarily the longest command. Counting the number of spaces
+        // should work in all cases.
+        int wordCount = (int)std::count(command.begin(), command.end(), ' ') + 1;
+        longestCommandLength_ = std::max(longestCommandLength_, (int)command.size());
+        longestCommandWordCount_ = std::max(longestCommandWordCount_, wordCount);
     }
 
-    while (commandStack.size())
+    // Build the trie breadth first. Each pending entry is a node together with
+    // the range of (sorted) commands that share the node's prefix. Because the
+    // range is sorted, the children of a node are created in sorted order and
+    // end up contiguous in nodes_.
+    struct Pending
     {
-        auto command = commandStack.back();
-        if (command != commands_.end() && str::strncicmp(str.c_str(), command->c_str(), command->length()) == 0)
-            return { (int)command->length(), true };
-        commandStack.pop_back();
+        int node;
+        int depth;
+        size_t first, last;
+    };
+    std::vector<Pending> queue;
+
+    nodes_.clear();
+    nodes_.push_back({0, 0, '\0', false});
+    if (commands.empty())
+        return;
+    queue.push_back({0, 0, 0, commands.size()});
+
+    for (size_t q = 0; q != queue.size(); ++q)
+    {
+        Pending p = queue[q];
+
+        // The shortest command of the range sorts first. If it ends at this
+        // depth then this node terminates a command
+        if (commands[p.first].size() == (size_t)p.depth)
+        {
+            nodes_[p.node].isCommand = true;
+            p.first++;
+        }
+
+        nodes_[p.node].firstChild = (int)nodes_.size();
+        nodes_[p.node].childCount = 0;
+        while (p.first != p.last)
+        {
+            char c = commands[p.first][p.depth];
+            size_t groupEnd = p.first + 1;
+            while (groupEnd != p.last && commands[groupEnd][p.depth] == c)
+                groupEnd++;
+
+            nodes_[p.node].childCount++;
+            queue.push_back({(int)nodes_.size(), p.depth + 1, p.first, groupEnd});
+            nodes_.push_back({0, 0, c, false});
+            p.first = groupEnd;
+        }
     }
+}
 
-    return { matchedLen, false };
+// ----------------------------------------------------------------------------
+int CommandMatcher::findChild(int node, char c) const
+{
+    const TrieNode& parent = nodes_[node];
+    auto first = nodes_.begin() + parent.firstChild;
+    auto last = first + parent.childCount;
+    auto it = std::lower_bound(first, last, c,
+            [](const TrieNode& n, char c) { return n.c < c; });
+    if (it == last || it->c != c)
+        return -1;
+    return (int)(it - nodes_.begin());
+}
+
+// ----------------------------------------------------------------------------
+CommandMatcher::MatchResult CommandMatcher::findLongestCommandMatching(std::string_view str) const
+{
+    // Walk down the trie one character at a time. A command is only accepted
+    // if it is not immediately followed by another symbol character, i.e.
+    // "decal" must not match the command "dec"
+    Cursor it = cursor();
+    int commandLen = -1;
+    while (it.matchedLength() < (int)str.size() && it.advance(str[it.matchedLength()]))
+    {
+        int len = it.matchedLength();
+        if (it.isCommand() && (len == (int)str.size() || !charIsSymbolToken(str[len])))
+            commandLen = len;
+    }
+
+    if (commandLen >= 0)
+        return { commandLen, true };
+    return { it.matchedLength(), false };
+}
+
+// ----------------------------------------------------------------------------
+CommandMatcher::Cursor CommandMatcher::cursor() const
+{
+    return Cursor(this);
+}
+
+// ----------------------------------------------------------------------------
+CommandMatcher::Cursor::Cursor(const CommandMatcher* matcher) :
+    matcher_(matcher),
+    node_(matcher->nodes_.empty() ? -1 : 0),
+    matchedLength_(0)
+{
+}
+
+// ----------------------------------------------------------------------------
+bool CommandMatcher::Cursor::advance(char c)
+{
+    if (node_ < 0)
+        return false;
+
+    node_ = matcher_->findChild(node_, toLower(c));
+    if (node_ < 0)
+        return false;
+
+    matchedLength_++;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool CommandMatcher::Cursor::advance(std::string_view str)
+{
+    for (char c : str)
+        if (!advance(c))
+            return false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool CommandMatcher::Cursor::isCommand() const
+{
+    return node_ > 0 && matcher_->nodes_[node_].isCommand;
+}
+
+// ----------------------------------------------------------------------------
+bool CommandMatcher::Cursor::isValid() const
+{
+    return node_ >= 0;
+}
+
+// ----------------------------------------------------------------------------
+int CommandMatcher::Cursor::matchedLength() const
+{
+    return matchedLength_;
 }
 
 // ----------------------------------------------------------------------------
@@ -53,17 +53,7 @@ bool DBPCommandLoader::populateIndex(CommandIndex* index)
                 pluginsToLoad.emplace_back(p.path());
     }
 
-    for (const auto& path : pluginsToLoad)
-    {
-        Reference<DynamicLibrary> lib = DynamicLibrary::open(path.string().c_str());
-        if (lib == nullptr)
-            continue;
-
-        if (!populateIndexFromLibrary(index, lib))
-            return false;
-    }
-
-    return true;
+    return populateIndexFromPlugins(index, pluginsToLoad);
 #else
     // Not implemented on other platforms... yet.
     Log::sdk(Log::ERROR, "DBP command loading not implemented on this platform\n");
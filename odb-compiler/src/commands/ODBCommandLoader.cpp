@@ -6,6 +6,8 @@
 #include "odb-sdk/FileSystem.hpp"
 #include "odb-sdk/Reference.hpp"
 #include <filesystem>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace fs = std::filesystem;
@@ -53,7 +55,7 @@ static bool parseTypeinfoString(Command::Type* retType, std::vector<Command::Arg
     args->clear();
     for (t++; *t && *t != ')'; t++)
     {
-        args->emplace({});
+        args->emplace_back();
         args->back().type = static_cast<Command::Type>(*t);
         if (!typeExists(args->back().type))
         {
@@ -110,34 +112,39 @@ bool ODBCommandLoader::populateIndex(CommandIndex* index)
             continue;
         }
 
-        for (const auto& p : fs::recursive_directory_iterator(sdkPluginsDir))
+        for (const auto& p : fs::recursive_directory_iterator(path))
             if (FileSystem::isDynamicLib(p.path()))
                 pluginsToLoad.emplace_back(p.path());
     }
 
-    for (const auto& path : pluginsToLoad)
-    {
-        Reference<DynamicLibrary> lib = DynamicLibrary::open(path.string().c_str());
-        if (lib == nullptr)
-            continue;
-
-        if (!populateIndexFromLibrary(index, lib))
-            return false;
-    }
-
-    return true;
+    return populateIndexFromPlugins(index, pluginsToLoad);
 }
 
 // ----------------------------------------------------------------------------
 bool ODBCommandLoader::populateIndexFromLibrary(CommandIndex* index, DynamicLibrary* library)
 {
-    auto lookupString = [&library](std::string sym) -> std::string {
-        const char** addr = reinterpret_cast<const char**>(
-            library->lookupSymbolAddress(sym.c_str()));
-        return addr ? *addr : "";
+    // Index all defined symbols by name in a single pass over the symbol
+    // table. Each lookup below is then a hash map probe instead of a dlsym()
+    // round trip through the dynamic linker
+    const int symbolCount = library->getSymbolCount();
+    std::unordered_map<std::string_view, const void*> symbols;
+    symbols.reserve(symbolCount);
+    for (int i = 0; i != symbolCount; ++i)
+    {
+        const void* addr = library->getSymbolAddressAt(i);
+        if (addr)
+            symbols.emplace(library->getSymbolAt(i), addr);
+    }
+
+    auto lookupString = [&symbols](const std::string& sym) -> std::string {
+        auto it = symbols.find(sym);
+        if (it == symbols.end())
+            return "";
+        const char* str = *static_cast<const char* const*>(it->second);
+        return str ? str : "";
     };
 
-    for (int i = 0; i != library->getSymbolCount(); ++i)
+    for (int i = 0; i != symbolCount; ++i)
     {
         std::string cppSymbol = library->getSymbolAt(i);
 
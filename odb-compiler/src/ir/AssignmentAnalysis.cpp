@@ -0,0 +1,52 @@
+#include "odb-compiler/ir/AssignmentAnalysis.hpp"
+
+namespace odb::ir {
+bool collectAssignedVariables(const StatementBlock& statements, std::unordered_set<const Variable*>& variables)
+{
+    for (const auto& s : statements)
+    {
+        switch (s->kind())
+        {
+        case StatementKind::VarAssignment:
+            variables.insert(static_cast<const VarAssignment*>(s.get())->variable());
+            break;
+        case StatementKind::Conditional:
+        {
+            auto* conditional = static_cast<const Conditional*>(s.get());
+            if (!collectAssignedVariables(conditional->trueBranch(), variables) ||
+                !collectAssignedVariables(conditional->falseBranch(), variables))
+            {
+                return false;
+            }
+            break;
+        }
+        case StatementKind::Select:
+            for (const auto& selectCase : static_cast<const Select*>(s.get())->cases())
+            {
+                if (!collectAssignedVariables(selectCase.statements, variables))
+                {
+                    return false;
+                }
+            }
+            break;
+        case StatementKind::ForLoop:
+            variables.insert(static_cast<const ForLoop*>(s.get())->assignment().variable());
+            [[fallthrough]];
+        case StatementKind::WhileLoop:
+        case StatementKind::UntilLoop:
+        case StatementKind::InfiniteLoop:
+            if (!collectAssignedVariables(static_cast<const Loop*>(s.get())->statements(), variables))
+            {
+                return false;
+            }
+            break;
+        case StatementKind::Label:
+        case StatementKind::Gosub:
+            return false;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+} // namespace odb::ir
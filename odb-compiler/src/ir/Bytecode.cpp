@@ -0,0 +1,334 @@
+#include "odb-compiler/ir/Bytecode.hpp"
+
+#include "../BinaryStream.hpp"
+#include "codegen/BytecodeGenerator.hpp"
+
+#include <cstring>
+
+namespace odb::ir {
+namespace {
+// Bump this whenever the layout of the module or the meaning of an opcode
+// changes, so stale caches are rejected instead of being misinterpreted.
+constexpr std::uint16_t formatVersion = 2;
+constexpr char magic[6] = {'O', 'D', 'B', 'B', 'Y', 'C'};
+constexpr std::uint16_t byteOrderMark = 0x0102;
+
+constexpr std::uint8_t opCount = 0
+#define X(name) +1
+    ODB_BYTECODE_OP_LIST
+#undef X
+    ;
+
+constexpr std::uint8_t builtinTypeCount = 0
+#define X(dbname, cppname) +1
+    ODB_DATATYPE_LIST
+#undef X
+    ;
+
+class Writer : public BinaryWriter
+{
+public:
+    using BinaryWriter::BinaryWriter;
+
+    void writeRegisters(const std::vector<std::int32_t>& registers)
+    {
+        writeVarint(registers.size());
+        for (std::int32_t reg : registers)
+        {
+            writeValue(reg);
+        }
+    }
+};
+
+class Reader : public BinaryReader
+{
+public:
+    using BinaryReader::BinaryReader;
+
+    bool readOp(BytecodeOp* op)
+    {
+        std::uint8_t value;
+        if (!readValue(&value) || value >= opCount)
+        {
+            return false;
+        }
+        *op = BytecodeOp(value);
+        return true;
+    }
+
+    bool readBuiltinType(BuiltinType* type)
+    {
+        std::uint8_t value;
+        if (!readValue(&value) || value >= builtinTypeCount)
+        {
+            return false;
+        }
+        *type = BuiltinType(value);
+        return true;
+    }
+
+    bool readCommandType(cmd::Command::Type* type)
+    {
+        char value;
+        if (!readValue(&value))
+        {
+            return false;
+        }
+        switch (cmd::Command::Type(value))
+        {
+        case cmd::Command::Type::Integer:
+        case cmd::Command::Type::Float:
+        case cmd::Command::Type::String:
+        case cmd::Command::Type::Double:
+        case cmd::Command::Type::Long:
+        case cmd::Command::Type::Dword:
+        case cmd::Command::Type::Void:
+            *type = cmd::Command::Type(value);
+            return true;
+        }
+        return false;
+    }
+
+    bool readRegisters(std::vector<std::int32_t>* registers)
+    {
+        std::size_t count;
+        if (!readCount(&count))
+        {
+            return false;
+        }
+        registers->resize(count);
+        for (std::int32_t& reg : *registers)
+        {
+            if (!readValue(&reg))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void writeFunction(Writer& writer, const BytecodeFunction& function)
+{
+    writer.writeString(function.name);
+    writer.writeValue(function.registerCount);
+    writer.writeValue(function.returnsString);
+    writer.writeRegisters(function.argumentRegisters);
+    writer.writeRegisters(function.stringRegisters);
+
+    writer.writeVarint(function.code.size());
+    for (const BytecodeInstruction& instruction : function.code)
+    {
+        writer.writeValue(std::uint8_t(instruction.op));
+        writer.writeValue(std::uint8_t(instruction.type));
+        writer.writeValue(std::uint8_t(instruction.sourceType));
+        writer.writeValue(instruction.dst);
+        writer.writeValue(instruction.a);
+        writer.writeValue(instruction.b);
+        writer.writeValue(instruction.target);
+        writer.writeValue(instruction.constant);
+    }
+
+    writer.writeVarint(function.callSites.size());
+    for (const BytecodeCallSite& site : function.callSites)
+    {
+        writer.writeValue(site.callee);
+        writer.writeRegisters(site.argumentRegisters);
+    }
+}
+
+bool readFunction(Reader& reader, BytecodeFunction* function)
+{
+    if (!reader.readString(&function->name) || !reader.readValue(&function->registerCount) ||
+        !reader.readValue(&function->returnsString) || !reader.readRegisters(&function->argumentRegisters) ||
+        !reader.readRegisters(&function->stringRegisters))
+    {
+        return false;
+    }
+
+    std::size_t count;
+    if (!reader.readCount(&count))
+    {
+        return false;
+    }
+    function->code.resize(count);
+    for (BytecodeInstruction& instruction : function->code)
+    {
+        if (!reader.readOp(&instruction.op) || !reader.readBuiltinType(&instruction.type) ||
+            !reader.readBuiltinType(&instruction.sourceType) || !reader.readValue(&instruction.dst) ||
+            !reader.readValue(&instruction.a) || !reader.readValue(&instruction.b) ||
+            !reader.readValue(&instruction.target) || !reader.readValue(&instruction.constant))
+        {
+            return false;
+        }
+    }
+
+    if (!reader.readCount(&count))
+    {
+        return false;
+    }
+    function->callSites.resize(count);
+    for (BytecodeCallSite& site : function->callSites)
+    {
+        if (!reader.readValue(&site.callee) || !reader.readRegisters(&site.argumentRegisters))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+} // namespace
+
+const char* convertBytecodeOpToString(BytecodeOp op)
+{
+    switch (op)
+    {
+#define X(name)                                                                                                        \
+    case BytecodeOp::name:                                                                                             \
+        return #name;
+        ODB_BYTECODE_OP_LIST
+#undef X
+    default:
+        return "";
+    }
+}
+
+std::unique_ptr<BytecodeModule> generateBytecode(const Program& program)
+{
+    auto flat = flattenProgram(program);
+    if (!flat)
+    {
+        return nullptr;
+    }
+    return generateBytecode(*flat);
+}
+
+std::unique_ptr<BytecodeModule> generateBytecode(const FlatProgram& program)
+{
+    auto module = std::make_unique<BytecodeModule>();
+    BytecodeGenerator generator(*module);
+    if (!generator.generateModule(program))
+    {
+        return nullptr;
+    }
+    return module;
+}
+
+void serializeBytecode(std::vector<std::uint8_t>* out, const BytecodeModule& module)
+{
+    Writer writer(out);
+    writer.writeBytes(magic, sizeof(magic));
+    writer.writeValue(formatVersion);
+    writer.writeValue(byteOrderMark);
+    writer.writeValue(module.canCompile);
+
+    writer.writeVarint(module.strings.size());
+    for (const std::string& string : module.strings)
+    {
+        writer.writeString(string);
+    }
+
+    writer.writeVarint(module.commands.size());
+    for (const BytecodeCommand& command : module.commands)
+    {
+        writer.writeString(command.dbSymbol);
+        writer.writeString(command.cppSymbol);
+        writer.writeValue(command.returnType);
+        writer.writeVarint(command.argumentTypes.size());
+        for (cmd::Command::Type type : command.argumentTypes)
+        {
+            writer.writeValue(type);
+        }
+    }
+
+    writer.writeVarint(module.functions.size());
+    for (const BytecodeFunction& function : module.functions)
+    {
+        writeFunction(writer, function);
+    }
+}
+
+std::unique_ptr<BytecodeModule> deserializeBytecode(const void* data, std::size_t size)
+{
+    Reader reader(static_cast<const std::uint8_t*>(data), size);
+
+    char header[sizeof(magic)];
+    std::uint16_t version, bom;
+    if (!reader.readBytes(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0)
+    {
+        return nullptr;
+    }
+    if (!reader.readValue(&version) || version != formatVersion)
+    {
+        return nullptr;
+    }
+    if (!reader.readValue(&bom) || bom != byteOrderMark)
+    {
+        return nullptr;
+    }
+
+    auto module = std::make_unique<BytecodeModule>();
+    if (!reader.readValue(&module->canCompile))
+    {
+        return nullptr;
+    }
+
+    std::size_t count;
+    if (!reader.readCount(&count))
+    {
+        return nullptr;
+    }
+    module->strings.resize(count);
+    for (std::string& string : module->strings)
+    {
+        if (!reader.readString(&string))
+        {
+            return nullptr;
+        }
+    }
+
+    if (!reader.readCount(&count))
+    {
+        return nullptr;
+    }
+    module->commands.resize(count);
+    for (BytecodeCommand& command : module->commands)
+    {
+        std::size_t argumentCount;
+        if (!reader.readString(&command.dbSymbol) || !reader.readString(&command.cppSymbol) ||
+            !reader.readCommandType(&command.returnType) || !reader.readCount(&argumentCount))
+        {
+            return nullptr;
+        }
+        command.argumentTypes.resize(argumentCount);
+        for (cmd::Command::Type& type : command.argumentTypes)
+        {
+            if (!reader.readCommandType(&type))
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    // A module without a main function can't be run.
+    if (!reader.readCount(&count) || count == 0)
+    {
+        return nullptr;
+    }
+    module->functions.resize(count);
+    for (BytecodeFunction& function : module->functions)
+    {
+        if (!readFunction(reader, &function))
+        {
+            return nullptr;
+        }
+    }
+
+    if (!reader.atEnd())
+    {
+        return nullptr;
+    }
+    return module;
+}
+} // namespace odb::ir
@@ -1,21 +1,83 @@
 #include "odb-compiler/ir/Codegen.hpp"
+#include "odb-compiler/Stats.hpp"
 
 #include "codegen/CodeGenerator.hpp"
 #include "codegen/LLVM.hpp"
 #include "codegen/ODBEngineInterface.hpp"
+#include "codegen/Optimizer.hpp"
 #include "codegen/TGCEngineInterface.hpp"
 
 #include <iostream>
 
 namespace odb::ir {
+// ----------------------------------------------------------------------------
+static std::string getHostCPUFeatures()
+{
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> hostFeatures;
+    if (llvm::sys::getHostCPUFeatures(hostFeatures))
+    {
+        for (const auto& feature : hostFeatures)
+        {
+            features.AddFeature(feature.first(), feature.second);
+        }
+    }
+    return features.getString();
+}
+
+// ----------------------------------------------------------------------------
 bool generateCode(SDKType sdk_type, OutputType outputType, TargetTriple targetTriple, std::ostream& os,
-                  const std::string& moduleName, Program& program, const cmd::CommandIndex& cmdIndex)
+                  const std::string& moduleName, Program& program, const cmd::CommandIndex& cmdIndex,
+                  const CodegenOptions& options)
 {
     llvm::LLVMContext context;
     llvm::Module module(moduleName, context);
 
-    // Generate the module.
+    LLVMInitializeX86TargetInfo();
+    LLVMInitializeX86Target();
+    LLVMInitializeX86TargetMC();
+    LLVMInitializeX86AsmPrinter();
+
+    // Lookup target machine.
+    std::string llvmTargetTriple = targetTriple.getLLVMTargetTriple();
+    bool emitsMachineCode = outputType == OutputType::ObjectFile || outputType == OutputType::Executable;
+    if (sdk_type == SDKType::DarkBASIC && emitsMachineCode)
+    {
+        // Only the i386-pc-windows-msvc target triple is supported.
+        if (targetTriple.arch != TargetTriple::Arch::i386 || targetTriple.platform != TargetTriple::Platform::Windows)
+        {
+            Log::info.print(
+                "Unsupported platform and arch. Only i386 on Windows is supported when working with the DBP SDK type.");
+            return false;
+        }
+    }
+
+    // The optimization pipeline queries the target machine for cost models,
+    // so it's created before optimizing. LLVM IR and bitcode can still be
+    // emitted (target independently optimized) if the target isn't available.
+    std::unique_ptr<llvm::TargetMachine> targetMachine;
+    std::string error;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(llvmTargetTriple, error);
+    if (target)
     {
+        std::string cpu = options.cpu == "native" ? llvm::sys::getHostCPUName().str() : options.cpu;
+        std::string features = options.features == "native" ? getHostCPUFeatures() : options.features;
+        llvm::TargetOptions opt;
+        targetMachine.reset(target->createTargetMachine(llvmTargetTriple, cpu, features, opt, {}, {},
+                                                        getCodeGenOptLevel(options.optimizationLevel)));
+        module.setDataLayout(targetMachine->createDataLayout());
+        module.setTargetTriple(llvmTargetTriple);
+    }
+    else if (emitsMachineCode)
+    {
+        Log::info.print("Unknown target triple: %s", error.c_str());
+        return false;
+    }
+
+    // Generate the module. The data layout is set first, because the generated
+    // code depends on the size of pointers.
+    {
+        PhaseTimer timer("generate module");
         std::unique_ptr<EngineInterface> engineInterface;
         switch (sdk_type)
         {
@@ -36,6 +98,23 @@ bool generateCode(SDKType sdk_type, OutputType outputType, TargetTriple targetTr
         }
     }
 
+    if (Stats::enabled())
+    {
+        Stats::add(Stats::LLVMInstructionsGenerated, module.getInstructionCount());
+    }
+
+    {
+        PhaseTimer timer("optimize module");
+        optimizeModule(module, targetMachine.get(), options.optimizationLevel);
+    }
+
+    if (Stats::enabled())
+    {
+        Stats::add(Stats::LLVMInstructionsOptimized, module.getInstructionCount());
+    }
+
+    PhaseTimer emitTimer("emit");
+
     // If we are emitting LLVM IR or Bitcode, return early.
     if (outputType == OutputType::LLVMIR)
     {
@@ -50,38 +129,6 @@ bool generateCode(SDKType sdk_type, OutputType outputType, TargetTriple targetTr
         return true;
     }
 
-    LLVMInitializeX86TargetInfo();
-    LLVMInitializeX86Target();
-    LLVMInitializeX86TargetMC();
-    LLVMInitializeX86AsmPrinter();
-
-    // Lookup target machine.
-    std::string llvmTargetTriple = targetTriple.getLLVMTargetTriple();
-    if (sdk_type == SDKType::DarkBASIC)
-    {
-        // Only the i386-pc-windows-msvc target triple is supported.
-        if (targetTriple.arch != TargetTriple::Arch::i386 || targetTriple.platform != TargetTriple::Platform::Windows)
-        {
-            Log::info.print(
-                "Unsupported platform and arch. Only i386 on Windows is supported when working with the DBP SDK type.");
-            return false;
-        }
-    }
-    std::string error;
-    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(llvmTargetTriple, error);
-    if (!target)
-    {
-        Log::info.print("Unknown target triple: %s", error.c_str());
-        return false;
-    }
-
-    auto cpu = "generic";
-    auto features = "";
-    llvm::TargetOptions opt;
-    llvm::TargetMachine* targetMachine = target->createTargetMachine(llvmTargetTriple, cpu, features, opt, {});
-    module.setDataLayout(targetMachine->createDataLayout());
-    module.setTargetTriple(llvmTargetTriple);
-
     llvm::SmallVector<char, 0> outputFileBuffer;
 
     if (outputType == OutputType::ObjectFile)
@@ -0,0 +1,479 @@
+#include "odb-compiler/ir/FlatIR.hpp"
+
+#include "odb-sdk/Log.hpp"
+
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace odb::ir {
+namespace {
+// Tables shared by all functions of the program while it's being flattened.
+struct FlattenContext
+{
+    std::unordered_map<const FunctionDefinition*, FlatIndex> functionIndices;
+    std::unordered_map<const cmd::Command*, FlatIndex> commandIndices;
+    std::unordered_map<std::string, FlatIndex> stringIndices;
+    std::unordered_map<const SourceLocation*, FlatIndex> locationIndices;
+};
+
+class Flattener
+{
+public:
+    Flattener(FlatProgram& program, FlattenContext& context, const FunctionDefinition& definition,
+              FlatFunction& function)
+        : program_(program), context_(context), definition_(definition), function_(function)
+    {
+    }
+
+    bool flatten()
+    {
+        function_.name = definition_.name();
+        function_.location = addLocation(definition_.location());
+
+        for (Variable* variable : definition_.variables().list())
+        {
+            if (variable->type().isUDT())
+            {
+                return error(variable, "UDT variables");
+            }
+            variableIndices_.emplace(variable, FlatIndex(function_.variableTypes.size()));
+            function_.variableTypes.push_back(variable->type());
+            function_.variableLocations.push_back(addLocation(variable->location()));
+        }
+        for (std::size_t i = 0; i < definition_.arguments().size(); ++i)
+        {
+            const FunctionDefinition::Argument& argument = definition_.arguments()[i];
+            if (argument.type.isUDT())
+            {
+                return error(&definition_, "UDT arguments");
+            }
+            const Variable* variable = definition_.argumentVariable(i);
+            function_.argumentTypes.push_back(argument.type);
+            function_.argumentVariables.push_back(variable ? variableIndices_.at(variable) : noFlatIndex);
+        }
+
+        if (!flattenBlock(definition_.statements(), &function_.body))
+        {
+            return false;
+        }
+        if (definition_.returnExpression() &&
+            !flattenExpression(definition_.returnExpression().get(), &function_.returnExpression))
+        {
+            return false;
+        }
+
+        for (const auto& [statement, label] : labelFixups_)
+        {
+            if (label == nullptr)
+            {
+                continue;
+            }
+            auto it = labels_.find(label);
+            if (it == labels_.end())
+            {
+                return error(label, "jumps to a label of a different function");
+            }
+            function_.statements.a[statement] = it->second;
+        }
+
+        return true;
+    }
+
+private:
+    bool error(const Node* node, const char* what)
+    {
+        SourceLocation* location = node->location();
+        Log::codegen(Log::NOTICE, "%s: The flat IR doesn't support %s\n",
+                     location ? location->getFileLineColumn().c_str() : definition_.name().c_str(), what);
+        return false;
+    }
+
+    FlatIndex addLocation(SourceLocation* location)
+    {
+        if (location == nullptr)
+        {
+            return noFlatIndex;
+        }
+        auto [it, inserted] = context_.locationIndices.emplace(location, FlatIndex(program_.locations.size()));
+        if (inserted)
+        {
+            program_.locations.push_back(location->getFileLineColumn());
+        }
+        return it->second;
+    }
+
+    FlatIndex addString(const std::string& string)
+    {
+        auto [it, inserted] = context_.stringIndices.emplace(string, FlatIndex(program_.strings.size()));
+        if (inserted)
+        {
+            program_.strings.push_back(string);
+        }
+        return it->second;
+    }
+
+    FlatIndex addCommand(const cmd::Command* command)
+    {
+        auto [it, inserted] = context_.commandIndices.emplace(command, FlatIndex(program_.commands.size()));
+        if (inserted)
+        {
+            FlatCommand& entry = program_.commands.emplace_back();
+            entry.dbSymbol = command->dbSymbol();
+            entry.cppSymbol = command->cppSymbol();
+            entry.returnType = command->returnType();
+            for (const auto& arg : command->args())
+            {
+                entry.argumentTypes.push_back(arg.type);
+            }
+        }
+        return it->second;
+    }
+
+    FlatIndex addList(const std::vector<FlatIndex>& entries)
+    {
+        FlatIndex list = FlatIndex(function_.lists.size());
+        function_.lists.push_back(FlatIndex(entries.size()));
+        function_.lists.insert(function_.lists.end(), entries.begin(), entries.end());
+        return list;
+    }
+
+    template <typename T> FlatIndex addLiteralData(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "");
+        FlatIndex offset = FlatIndex(function_.literalData.size());
+        function_.literalData.resize(offset + sizeof(T));
+        std::memcpy(function_.literalData.data() + offset, &value, sizeof(T));
+        return offset;
+    }
+
+    template <typename T> FlatIndex addLiteral(const LiteralTemplate<T>* literal)
+    {
+        if constexpr (std::is_same_v<T, std::string>)
+        {
+            return addString(literal->value());
+        }
+        else
+        {
+            return addLiteralData(literal->value());
+        }
+    }
+
+    FlatIndex addExpression(const Expression* e)
+    {
+        FlatExpressionPool& pool = function_.expressions;
+        pool.kinds.push_back(e->kind());
+        pool.types.push_back(e->getType());
+        pool.ops.push_back(0);
+        pool.a.push_back(noFlatIndex);
+        pool.b.push_back(noFlatIndex);
+        pool.locations.push_back(addLocation(e->location()));
+        return pool.size() - 1;
+    }
+
+    FlatIndex addStatement(const Statement* s)
+    {
+        FlatStatementPool& pool = function_.statements;
+        pool.kinds.push_back(s->kind());
+        pool.a.push_back(noFlatIndex);
+        pool.b.push_back(noFlatIndex);
+        pool.c.push_back(noFlatIndex);
+        pool.d.push_back(noFlatIndex);
+        pool.locations.push_back(addLocation(s->location()));
+        return pool.size() - 1;
+    }
+
+    bool flattenExpression(const Expression* e, FlatIndex* index)
+    {
+        if (e->getType().isUDT())
+        {
+            return error(e, "UDT expressions");
+        }
+
+        // Children are flattened before the slot of the parent is filled in,
+        // since they can grow the pools.
+        FlatIndex a = noFlatIndex, b = noFlatIndex;
+        std::uint8_t op = 0;
+        switch (e->kind())
+        {
+        case ExpressionKind::Cast: {
+            if (!flattenExpression(static_cast<const CastExpression*>(e)->expression(), &a))
+            {
+                return false;
+            }
+            break;
+        }
+        case ExpressionKind::Unary: {
+            auto* unary = static_cast<const UnaryExpression*>(e);
+            op = std::uint8_t(unary->op());
+            if (!flattenExpression(unary->expression(), &a))
+            {
+                return false;
+            }
+            break;
+        }
+        case ExpressionKind::Binary: {
+            auto* binary = static_cast<const BinaryExpression*>(e);
+            op = std::uint8_t(binary->op());
+            if (!flattenExpression(binary->left(), &a) || !flattenExpression(binary->right(), &b))
+            {
+                return false;
+            }
+            break;
+        }
+        case ExpressionKind::VarRef: {
+            auto variable = variableIndices_.find(static_cast<const VarRefExpression*>(e)->variable());
+            if (variable == variableIndices_.end())
+            {
+                return error(e, "referencing a variable of a different function");
+            }
+            a = variable->second;
+            break;
+        }
+#define X(dbname, cppname)                                                                                             \
+    case ExpressionKind::dbname##Literal:                                                                              \
+        a = addLiteral(static_cast<const dbname##Literal*>(e));                                                        \
+        break;
+            ODB_DATATYPE_LIST
+#undef X
+        case ExpressionKind::FunctionCall: {
+            auto* call = static_cast<const FunctionCallExpression*>(e);
+            std::vector<FlatIndex> arguments;
+            for (const auto& argument : call->arguments())
+            {
+                if (!flattenExpression(argument.get(), &arguments.emplace_back()))
+                {
+                    return false;
+                }
+            }
+            if (call->isUserFunction())
+            {
+                a = context_.functionIndices.at(call->userFunction());
+            }
+            else
+            {
+                op = 1;
+                a = addCommand(call->command());
+            }
+            b = addList(arguments);
+            break;
+        }
+        }
+
+        *index = addExpression(e);
+        function_.expressions.ops[*index] = op;
+        function_.expressions.a[*index] = a;
+        function_.expressions.b[*index] = b;
+        return true;
+    }
+
+    bool flattenBlock(const StatementBlock& block, FlatIndex* list)
+    {
+        std::vector<FlatIndex> statements;
+        for (const auto& statement : block)
+        {
+            if (!flattenStatement(statement.get(), &statements.emplace_back()))
+            {
+                return false;
+            }
+        }
+        *list = addList(statements);
+        return true;
+    }
+
+    bool flattenAssignment(const VarAssignment* assignment, FlatIndex* index)
+    {
+        auto variable = variableIndices_.find(assignment->variable());
+        if (variable == variableIndices_.end())
+        {
+            return error(assignment, "assigning a variable of a different function");
+        }
+        FlatIndex expression;
+        if (!flattenExpression(assignment->expression(), &expression))
+        {
+            return false;
+        }
+        *index = addStatement(assignment);
+        function_.statements.a[*index] = variable->second;
+        function_.statements.b[*index] = expression;
+        return true;
+    }
+
+    bool flattenStatement(const Statement* s, FlatIndex* index)
+    {
+        FlatStatementPool& pool = function_.statements;
+        switch (s->kind())
+        {
+        case StatementKind::VarAssignment:
+            return flattenAssignment(static_cast<const VarAssignment*>(s), index);
+        case StatementKind::Conditional: {
+            auto* conditional = static_cast<const Conditional*>(s);
+            FlatIndex condition, trueBranch, falseBranch;
+            if (!flattenExpression(conditional->expression(), &condition) ||
+                !flattenBlock(conditional->trueBranch(), &trueBranch) ||
+                !flattenBlock(conditional->falseBranch(), &falseBranch))
+            {
+                return false;
+            }
+            *index = addStatement(s);
+            pool.a[*index] = condition;
+            pool.b[*index] = trueBranch;
+            pool.c[*index] = falseBranch;
+            return true;
+        }
+        case StatementKind::Select: {
+            auto* select = static_cast<const Select*>(s);
+            FlatIndex expression;
+            if (!flattenExpression(select->expression(), &expression))
+            {
+                return false;
+            }
+            std::vector<FlatIndex> cases;
+            for (const Select::Case& selectCase : select->cases())
+            {
+                FlatIndex condition = noFlatIndex, block;
+                if (selectCase.condition && !flattenExpression(selectCase.condition.get(), &condition))
+                {
+                    return false;
+                }
+                if (!flattenBlock(selectCase.statements, &block))
+                {
+                    return false;
+                }
+                cases.push_back(condition);
+                cases.push_back(block);
+            }
+            *index = addStatement(s);
+            pool.a[*index] = expression;
+            pool.b[*index] = addList(cases);
+            return true;
+        }
+        case StatementKind::ForLoop: {
+            auto* forLoop = static_cast<const ForLoop*>(s);
+            // The loop gets its slot before the body, so exits can refer to it.
+            *index = addStatement(s);
+            loops_.emplace(forLoop, *index);
+            FlatIndex assignment, endValue, stepValue, body;
+            if (!flattenAssignment(&forLoop->assignment(), &assignment) ||
+                !flattenExpression(forLoop->endValue(), &endValue) ||
+                !flattenExpression(forLoop->stepValue(), &stepValue) || !flattenBlock(forLoop->statements(), &body))
+            {
+                return false;
+            }
+            pool.a[*index] = assignment;
+            pool.b[*index] = endValue;
+            pool.c[*index] = stepValue;
+            pool.d[*index] = body;
+            return true;
+        }
+        case StatementKind::WhileLoop:
+        case StatementKind::UntilLoop:
+        case StatementKind::InfiniteLoop: {
+            auto* loop = static_cast<const Loop*>(s);
+            *index = addStatement(s);
+            loops_.emplace(loop, *index);
+            FlatIndex condition = noFlatIndex, body;
+            Expression* expression = s->kind() == StatementKind::WhileLoop
+                                         ? static_cast<const WhileLoop*>(s)->expression()
+                                     : s->kind() == StatementKind::UntilLoop
+                                         ? static_cast<const UntilLoop*>(s)->expression()
+                                         : nullptr;
+            if ((expression && !flattenExpression(expression, &condition)) || !flattenBlock(loop->statements(), &body))
+            {
+                return false;
+            }
+            pool.a[*index] = condition;
+            pool.d[*index] = body;
+            return true;
+        }
+        case StatementKind::Label: {
+            auto* label = static_cast<const Label*>(s);
+            *index = addStatement(s);
+            labels_.emplace(label, *index);
+            return true;
+        }
+        case StatementKind::Goto:
+            *index = addStatement(s);
+            labelFixups_.emplace_back(*index, static_cast<const Goto*>(s)->label());
+            return true;
+        case StatementKind::Gosub:
+            *index = addStatement(s);
+            labelFixups_.emplace_back(*index, static_cast<const Gosub*>(s)->label());
+            return true;
+        case StatementKind::FunctionCall: {
+            FlatIndex call;
+            if (!flattenExpression(&static_cast<const FunctionCall*>(s)->expression(), &call))
+            {
+                return false;
+            }
+            *index = addStatement(s);
+            pool.a[*index] = call;
+            return true;
+        }
+        case StatementKind::SubReturn:
+            *index = addStatement(s);
+            return true;
+        case StatementKind::Exit: {
+            auto loop = loops_.find(static_cast<const Exit*>(s)->loopToBreak());
+            if (loop == loops_.end())
+            {
+                return error(s, "exiting a loop that doesn't contain the exit");
+            }
+            *index = addStatement(s);
+            pool.a[*index] = loop->second;
+            return true;
+        }
+        case StatementKind::ExitFunction: {
+            FlatIndex expression = noFlatIndex;
+            Expression* returned = static_cast<const ExitFunction*>(s)->expression();
+            if (returned && !flattenExpression(returned, &expression))
+            {
+                return false;
+            }
+            *index = addStatement(s);
+            pool.a[*index] = expression;
+            return true;
+        }
+        }
+        return error(s, "this statement");
+    }
+
+    FlatProgram& program_;
+    FlattenContext& context_;
+    const FunctionDefinition& definition_;
+    FlatFunction& function_;
+
+    std::unordered_map<const Variable*, FlatIndex> variableIndices_;
+    std::unordered_map<const Loop*, FlatIndex> loops_;
+    std::unordered_map<const Label*, FlatIndex> labels_;
+    std::vector<std::pair<FlatIndex, const Label*>> labelFixups_;
+};
+} // namespace
+
+std::unique_ptr<FlatProgram> flattenProgram(const Program& program)
+{
+    std::vector<const FunctionDefinition*> definitions;
+    definitions.push_back(&program.mainFunction());
+    for (const auto& function : program.functions())
+    {
+        definitions.push_back(function.get());
+    }
+    FlattenContext context;
+    for (const FunctionDefinition* definition : definitions)
+    {
+        context.functionIndices.emplace(definition, FlatIndex(context.functionIndices.size()));
+    }
+
+    auto flat = std::make_unique<FlatProgram>();
+    flat->functions.resize(definitions.size());
+    for (std::size_t i = 0; i < definitions.size(); ++i)
+    {
+        if (!Flattener(*flat, context, *definitions[i], flat->functions[i]).flatten())
+        {
+            return nullptr;
+        }
+    }
+    return flat;
+}
+
+} // namespace odb::ir
@@ -0,0 +1,171 @@
+#include "odb-compiler/ir/GosubAnalysis.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace odb::ir {
+namespace {
+// Calls f for the statement and every statement nested in it.
+template <typename F> void forEachStatement(const Statement* s, F& f)
+{
+    f(s);
+    switch (s->kind())
+    {
+    case StatementKind::Conditional:
+    {
+        auto* conditional = static_cast<const Conditional*>(s);
+        for (const auto& nested : conditional->trueBranch())
+        {
+            forEachStatement(nested.get(), f);
+        }
+        for (const auto& nested : conditional->falseBranch())
+        {
+            forEachStatement(nested.get(), f);
+        }
+        break;
+    }
+    case StatementKind::Select:
+        for (const auto& selectCase : static_cast<const Select*>(s)->cases())
+        {
+            for (const auto& nested : selectCase.statements)
+            {
+                forEachStatement(nested.get(), f);
+            }
+        }
+        break;
+    case StatementKind::ForLoop:
+    case StatementKind::WhileLoop:
+    case StatementKind::UntilLoop:
+    case StatementKind::InfiniteLoop:
+        for (const auto& nested : static_cast<const Loop*>(s)->statements())
+        {
+            forEachStatement(nested.get(), f);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+class DepthAnalysis
+{
+public:
+    explicit DepthAnalysis(const StatementBlock& statements) : statements_(statements)
+    {
+        for (std::size_t i = 0; i != statements.size(); ++i)
+        {
+            if (statements[i]->kind() == StatementKind::Label)
+            {
+                labelIndices_[static_cast<const Label*>(statements[i].get())] = i;
+            }
+        }
+    }
+
+    // Returns how many return addresses the subroutine at the label can push
+    // on top of its own, or nullopt if there is no bound.
+    std::optional<std::uint32_t> depthBelow(const Label* label)
+    {
+        // Only labels at the top level are followed by the whole subroutine
+        auto labelIndex = labelIndices_.find(label);
+        if (labelIndex == labelIndices_.end())
+        {
+            return std::nullopt;
+        }
+
+        State& state = states_[label];
+        if (state.isDone)
+        {
+            return state.depth;
+        }
+        if (state.isVisiting)
+        {
+            // Recursion
+            return std::nullopt;
+        }
+        state.isVisiting = true;
+
+        std::optional<std::uint32_t> depth = 0;
+        auto visit = [this, &depth](const Statement* s) {
+            if (depth && s->kind() == StatementKind::Goto)
+            {
+                // Could jump to a gosub outside of the subroutine
+                depth = std::nullopt;
+            }
+            if (!depth || s->kind() != StatementKind::Gosub)
+            {
+                return;
+            }
+            auto nestedDepth = depthBelow(static_cast<const Gosub*>(s)->label());
+            depth = nestedDepth ? std::optional(std::max(*depth, *nestedDepth + 1)) : std::nullopt;
+        };
+        for (std::size_t i = labelIndex->second + 1;
+             i != statements_.size() && statements_[i]->kind() != StatementKind::SubReturn; ++i)
+        {
+            forEachStatement(statements_[i].get(), visit);
+        }
+
+        // Elements of an unordered_map don't move when others are added
+        state.isVisiting = false;
+        state.isDone = true;
+        state.depth = depth;
+        return depth;
+    }
+
+private:
+    struct State
+    {
+        bool isVisiting = false;
+        bool isDone = false;
+        std::optional<std::uint32_t> depth;
+    };
+
+    const StatementBlock& statements_;
+    std::unordered_map<const Label*, std::size_t> labelIndices_;
+    std::unordered_map<const Label*, State> states_;
+};
+} // namespace
+
+GosubUsage analyzeGosubUsage(const FunctionDefinition& function)
+{
+    GosubUsage usage;
+    std::vector<const Gosub*> gosubs;
+    auto visit = [&](const Statement* s) {
+        switch (s->kind())
+        {
+        case StatementKind::Gosub:
+            gosubs.push_back(static_cast<const Gosub*>(s));
+            usage.usesGosub = true;
+            break;
+        case StatementKind::SubReturn:
+            usage.usesGosub = true;
+            break;
+        default:
+            break;
+        }
+    };
+    for (const auto& s : function.statements())
+    {
+        forEachStatement(s.get(), visit);
+    }
+
+    if (gosubs.empty())
+    {
+        usage.maxDepth = 0;
+        return usage;
+    }
+    DepthAnalysis analysis(function.statements());
+    std::uint32_t maxDepth = 0;
+    for (const Gosub* gosub : gosubs)
+    {
+        auto depth = analysis.depthBelow(gosub->label());
+        if (!depth)
+        {
+            return usage;
+        }
+        maxDepth = std::max(maxDepth, *depth + 1);
+    }
+    usage.maxDepth = maxDepth;
+    return usage;
+}
+} // namespace odb::ir
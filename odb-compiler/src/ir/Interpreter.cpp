@@ -0,0 +1,1002 @@
+#include "odb-compiler/ir/Interpreter.hpp"
+#include "odb-compiler/ir/JIT.hpp"
+
+#include "interpreter/CommandCall.hpp"
+#include "interpreter/Operators.hpp"
+
+#include "odb-sdk/DynamicLibrary.hpp"
+#include "odb-sdk/Log.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace odb::ir {
+static_assert(sizeof(Value) == JITProgram::ArgumentSlotSize, "Arguments are passed to compiled code as values");
+
+namespace {
+// Number of value slots available to all active frames together.
+constexpr std::size_t StackSize = 1 << 18;
+// Calls recurse on the native stack, so the call depth is limited as well.
+// Functions without variables don't take up any slots at all.
+constexpr std::size_t MaxCallDepth = 1 << 12;
+constexpr std::size_t MaxGosubDepth = 1 << 16;
+
+struct Frame;
+struct Instruction;
+struct FunctionCode;
+
+using Handler = const Instruction* (*)(Frame& frame, const Instruction* ip);
+
+// The bytecode is turned into these when it's loaded. Each instruction holds
+// the handler for its opcode and type, so dispatching is a single indirect
+// call instead of a switch over both.
+struct Instruction
+{
+    Handler handler;
+    // Operand slots, not every handler uses all of them.
+    std::int32_t dst;
+    std::int32_t a;
+    std::int32_t b;
+    // Index of the instruction to jump to.
+    std::int32_t target;
+    Value constant;
+    void* data;
+};
+
+// Entry of the FFI table the commands of a module are bound to.
+struct BoundCommand
+{
+    const void* address = nullptr;
+    CommandInvoker invoke = nullptr;
+};
+
+struct CallSite
+{
+    FunctionCode* function = nullptr;
+    const void* command = nullptr;
+    CommandInvoker invoke = nullptr;
+    std::vector<std::int32_t> argumentSlots;
+    // The arguments are gathered here before the call, because neither plugin
+    // functions nor compiled functions know about frames.
+    std::vector<Value> arguments;
+};
+
+struct FunctionCode
+{
+    std::string name;
+    std::vector<Instruction> instructions;
+    // Never resized after loading, because instructions point to their call
+    // site.
+    std::vector<CallSite> callSites;
+    // Slot of the variable each argument is bound to, or -1.
+    std::vector<std::int32_t> argumentSlots;
+    // Slots of string variables, which start out as "" instead of null.
+    std::vector<std::int32_t> stringSlots;
+    std::int32_t slotCount = 0;
+
+    std::uint64_t entryCount = 0;
+    std::uint64_t backEdgeCount = 0;
+    bool canCompile = false;
+    JITProgram::FunctionEntryPoint compiled = nullptr;
+};
+} // namespace
+
+struct InterpreterData
+{
+    explicit InterpreterData(const cmd::CommandIndex& cmdIndex) : cmdIndex(cmdIndex) {}
+
+    // Only set if the interpreter was created from the IR, the JIT needs it to
+    // compile hot functions.
+    const Program* program = nullptr;
+    const cmd::CommandIndex& cmdIndex;
+
+    // The first entry is the main function.
+    std::vector<std::unique_ptr<FunctionCode>> functions;
+    std::unordered_map<std::string, FunctionCode*> functionMap;
+    std::vector<BoundCommand> commands;
+    // String literals are loaded as pointers into these.
+    std::vector<std::string> strings;
+
+    std::unique_ptr<Value[]> stack;
+    std::size_t stackTop = 0;
+    std::size_t callDepth = 0;
+    std::vector<const Instruction*> gosubStack;
+    bool aborted = false;
+
+    int tierUpThreshold = 1000;
+    OptimizationLevel optimizationLevel = OptimizationLevel::O0;
+    std::unique_ptr<JITProgram> jit;
+};
+
+namespace {
+struct Frame
+{
+    InterpreterData* interpreter;
+    FunctionCode* function;
+    const Instruction* code;
+    Value* slots;
+    Value* result;
+    std::size_t gosubBase;
+};
+
+bool callFunction(InterpreterData& interpreter, FunctionCode& function, const Value* arguments, Value* result);
+void countTowardsTierUp(InterpreterData& interpreter, FunctionCode& function);
+
+const Instruction* runtimeError(Frame& frame, const char* message)
+{
+    Log::codegen(Log::ERROR, "Runtime error in function `%s`: %s\n", frame.function->name.c_str(), message);
+    frame.interpreter->aborted = true;
+    return nullptr;
+}
+
+// Handlers. Each one executes a single instruction and returns the next
+// instruction to execute, or nullptr to return from the function.
+const Instruction* loadConstant(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst] = ip->constant;
+    return ip + 1;
+}
+
+const Instruction* move(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst] = frame.slots[ip->a];
+    return ip + 1;
+}
+
+template <typename From, typename To> const Instruction* cast(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst].set<To>(static_cast<To>(frame.slots[ip->a].get<From>()));
+    return ip + 1;
+}
+
+template <typename T> const Instruction* negate(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst].set<T>(Sub::apply(T(0), frame.slots[ip->a].get<T>()));
+    return ip + 1;
+}
+
+template <typename T> const Instruction* bitwiseNot(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst].set<T>(T(~frame.slots[ip->a].get<T>()));
+    return ip + 1;
+}
+
+const Instruction* logicalNot(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst].set<bool>(!frame.slots[ip->a].get<bool>());
+    return ip + 1;
+}
+
+template <typename T, typename Op> const Instruction* binary(Frame& frame, const Instruction* ip)
+{
+    frame.slots[ip->dst].set(Op::apply(frame.slots[ip->a].get<T>(), frame.slots[ip->b].get<T>()));
+    return ip + 1;
+}
+
+template <typename T, bool IsModulo> const Instruction* integerDivide(Frame& frame, const Instruction* ip)
+{
+    T left = frame.slots[ip->a].get<T>();
+    T right = frame.slots[ip->b].get<T>();
+    if (right == T(0))
+    {
+        return runtimeError(frame, "Division by zero");
+    }
+    frame.slots[ip->dst].set<T>(IntegerDivide<IsModulo>::apply(left, right));
+    return ip + 1;
+}
+
+const Instruction* jump(Frame& frame, const Instruction* ip)
+{
+    return frame.code + ip->target;
+}
+
+const Instruction* jumpIfFalse(Frame& frame, const Instruction* ip)
+{
+    return frame.slots[ip->a].get<bool>() ? ip + 1 : frame.code + ip->target;
+}
+
+// Hot loops also count towards compiling the function. The current call
+// keeps running in the interpreter, the compiled code is used from the next
+// call on.
+const Instruction* backEdge(Frame& frame, const Instruction* ip)
+{
+    ++frame.function->backEdgeCount;
+    countTowardsTierUp(*frame.interpreter, *frame.function);
+    return frame.code + ip->target;
+}
+
+const Instruction* backEdgeIfFalse(Frame& frame, const Instruction* ip)
+{
+    if (frame.slots[ip->a].get<bool>())
+    {
+        return ip + 1;
+    }
+    ++frame.function->backEdgeCount;
+    countTowardsTierUp(*frame.interpreter, *frame.function);
+    return frame.code + ip->target;
+}
+
+// dst is the loop variable, a the end value and b the step. Same as the code
+// CodeGenerator emits, a step of 0 ends the loop.
+template <typename T> const Instruction* forLoopCondition(Frame& frame, const Instruction* ip)
+{
+    T value = frame.slots[ip->dst].get<T>();
+    T endValue = frame.slots[ip->a].get<T>();
+    T step = frame.slots[ip->b].get<T>();
+    bool continueLoop = step > T(0) ? value <= endValue : (step < T(0) && value >= endValue);
+    return continueLoop ? ip + 1 : frame.code + ip->target;
+}
+
+const Instruction* gosub(Frame& frame, const Instruction* ip)
+{
+    auto& gosubStack = frame.interpreter->gosubStack;
+    if (gosubStack.size() >= MaxGosubDepth)
+    {
+        return runtimeError(frame, "Gosub stack overflow");
+    }
+    gosubStack.push_back(ip + 1);
+    return frame.code + ip->target;
+}
+
+const Instruction* subReturn(Frame& frame, const Instruction* ip)
+{
+    auto& gosubStack = frame.interpreter->gosubStack;
+    if (gosubStack.size() <= frame.gosubBase)
+    {
+        return runtimeError(frame, "Return without gosub");
+    }
+    const Instruction* returnAddress = gosubStack.back();
+    gosubStack.pop_back();
+    return returnAddress;
+}
+
+const Instruction* returnVoid(Frame& frame, const Instruction* ip)
+{
+    return nullptr;
+}
+
+const Instruction* returnValue(Frame& frame, const Instruction* ip)
+{
+    if (frame.result)
+    {
+        *frame.result = frame.slots[ip->a];
+    }
+    return nullptr;
+}
+
+const Instruction* callCommand(Frame& frame, const Instruction* ip)
+{
+    auto* site = static_cast<CallSite*>(ip->data);
+    for (std::size_t i = 0; i < site->argumentSlots.size(); ++i)
+    {
+        site->arguments[i] = frame.slots[site->argumentSlots[i]];
+    }
+    site->invoke(site->command, site->arguments.data(), &frame.slots[ip->dst]);
+    return ip + 1;
+}
+
+const Instruction* callUserFunction(Frame& frame, const Instruction* ip)
+{
+    auto* site = static_cast<CallSite*>(ip->data);
+    for (std::size_t i = 0; i < site->argumentSlots.size(); ++i)
+    {
+        site->arguments[i] = frame.slots[site->argumentSlots[i]];
+    }
+    if (!callFunction(*frame.interpreter, *site->function, site->arguments.data(), &frame.slots[ip->dst]))
+    {
+        return nullptr;
+    }
+    return ip + 1;
+}
+
+bool execute(InterpreterData& interpreter, FunctionCode& function, const Value* arguments, Value* result)
+{
+    if (interpreter.callDepth == MaxCallDepth || interpreter.stackTop + function.slotCount > StackSize)
+    {
+        Log::codegen(Log::ERROR, "Runtime error in function `%s`: Stack overflow\n", function.name.c_str());
+        interpreter.aborted = true;
+        return false;
+    }
+
+    Frame frame;
+    frame.interpreter = &interpreter;
+    frame.function = &function;
+    frame.code = function.instructions.data();
+    frame.slots = &interpreter.stack[interpreter.stackTop];
+    frame.result = result;
+    frame.gosubBase = interpreter.gosubStack.size();
+    interpreter.stackTop += function.slotCount;
+    ++interpreter.callDepth;
+
+    std::fill_n(frame.slots, function.slotCount, Value{});
+    for (std::int32_t slot : function.stringSlots)
+    {
+        frame.slots[slot].set<const char*>("");
+    }
+    for (std::size_t i = 0; i < function.argumentSlots.size(); ++i)
+    {
+        if (function.argumentSlots[i] >= 0)
+        {
+            frame.slots[function.argumentSlots[i]] = arguments[i];
+        }
+    }
+    if (result)
+    {
+        *result = Value{};
+    }
+
+    const Instruction* ip = frame.code;
+    while (ip)
+    {
+        ip = ip->handler(frame, ip);
+    }
+
+    interpreter.gosubStack.resize(frame.gosubBase);
+    interpreter.stackTop -= function.slotCount;
+    --interpreter.callDepth;
+    return !interpreter.aborted;
+}
+
+void compileFunction(InterpreterData& interpreter, FunctionCode& function)
+{
+    // Only attempted once, whether it works or not.
+    function.canCompile = false;
+
+    if (!interpreter.jit)
+    {
+        interpreter.jit = JITProgram::compile(*interpreter.program, interpreter.cmdIndex, interpreter.optimizationLevel);
+        if (!interpreter.jit)
+        {
+            Log::codegen(Log::WARNING, "Failed to compile the program, continuing in the interpreter\n");
+            for (auto& code : interpreter.functions)
+            {
+                code->canCompile = false;
+            }
+            return;
+        }
+    }
+
+    function.compiled = interpreter.jit->lookupFunction(function.name);
+}
+
+void countTowardsTierUp(InterpreterData& interpreter, FunctionCode& function)
+{
+    if (function.canCompile && interpreter.tierUpThreshold > 0 &&
+        function.entryCount + function.backEdgeCount >= std::uint64_t(interpreter.tierUpThreshold))
+    {
+        compileFunction(interpreter, function);
+    }
+}
+
+bool callFunction(InterpreterData& interpreter, FunctionCode& function, const Value* arguments, Value* result)
+{
+    ++function.entryCount;
+    countTowardsTierUp(interpreter, function);
+
+    if (function.compiled)
+    {
+        function.compiled(arguments);
+        return true;
+    }
+    return execute(interpreter, function, arguments, result);
+}
+
+template <typename Op> Handler numericBinary(BuiltinType type)
+{
+    return forNumericType(type, [](auto t) -> Handler { return &binary<decltype(t), Op>; });
+}
+
+template <typename Op> Handler integralBinary(BuiltinType type)
+{
+    return forIntegralType(type, [](auto t) -> Handler { return &binary<decltype(t), Op>; });
+}
+
+template <typename Op> Handler scalarBinary(BuiltinType type)
+{
+    return forScalarType(type, [](auto t) -> Handler { return &binary<decltype(t), Op>; });
+}
+
+
+template <typename Op> Handler divisionBinary(BuiltinType type)
+{
+    return forNumericType(type, [](auto t) -> Handler {
+        using T = decltype(t);
+        if constexpr (std::is_integral_v<T>)
+            return &integerDivide<T, std::is_same_v<Op, Modulo>>;
+        else
+            return &binary<T, Op>;
+    });
+}
+
+// Returns the handler implementing the instruction's opcode for its type, or
+// nullptr if there is none.
+Handler selectHandler(const BytecodeInstruction& instruction)
+{
+    BuiltinType type = instruction.type;
+    switch (instruction.op)
+    {
+    case BytecodeOp::LoadConstant:
+    case BytecodeOp::LoadString:
+        return loadConstant;
+    case BytecodeOp::Move:
+        return move;
+    case BytecodeOp::Cast:
+        return forScalarType(instruction.sourceType, [type](auto from) -> Handler {
+            using From = decltype(from);
+            return forScalarType(type, [](auto to) -> Handler { return &cast<From, decltype(to)>; });
+        });
+    case BytecodeOp::Negate:
+        return forNumericType(type, [](auto t) -> Handler { return &negate<decltype(t)>; });
+    case BytecodeOp::BitwiseNot:
+        return forIntegralType(type, [](auto t) -> Handler { return &bitwiseNot<decltype(t)>; });
+    case BytecodeOp::LogicalNot:
+        return type == BuiltinType::Boolean ? &logicalNot : nullptr;
+    case BytecodeOp::Add:
+        return numericBinary<Add>(type);
+    case BytecodeOp::Sub:
+        return numericBinary<Sub>(type);
+    case BytecodeOp::Mul:
+        return numericBinary<Mul>(type);
+    case BytecodeOp::Div:
+        return divisionBinary<Divide>(type);
+    case BytecodeOp::Mod:
+        return divisionBinary<Modulo>(type);
+    case BytecodeOp::Pow:
+        return numericBinary<Power>(type);
+    case BytecodeOp::ShiftLeft:
+        return integralBinary<ShiftLeft>(type);
+    case BytecodeOp::ShiftRight:
+        return integralBinary<ShiftRight>(type);
+    case BytecodeOp::BitwiseOr:
+        return integralBinary<BitwiseOr>(type);
+    case BytecodeOp::BitwiseAnd:
+        return integralBinary<BitwiseAnd>(type);
+    case BytecodeOp::BitwiseXor:
+        return integralBinary<BitwiseXor>(type);
+    case BytecodeOp::Less:
+        return scalarBinary<Less>(type);
+    case BytecodeOp::LessEqual:
+        return scalarBinary<LessEqual>(type);
+    case BytecodeOp::Greater:
+        return scalarBinary<Greater>(type);
+    case BytecodeOp::GreaterEqual:
+        return scalarBinary<GreaterEqual>(type);
+    case BytecodeOp::Equal:
+        return scalarBinary<Equal>(type);
+    case BytecodeOp::NotEqual:
+        return scalarBinary<NotEqual>(type);
+    case BytecodeOp::LogicalOr:
+        return scalarBinary<LogicalOr>(type);
+    case BytecodeOp::LogicalAnd:
+        return scalarBinary<LogicalAnd>(type);
+    case BytecodeOp::LogicalXor:
+        return scalarBinary<LogicalXor>(type);
+    case BytecodeOp::Jump:
+        return jump;
+    case BytecodeOp::JumpIfFalse:
+        return jumpIfFalse;
+    case BytecodeOp::BackEdge:
+        return backEdge;
+    case BytecodeOp::BackEdgeIfFalse:
+        return backEdgeIfFalse;
+    case BytecodeOp::ForLoopCondition:
+        return forNumericType(type, [](auto t) -> Handler { return &forLoopCondition<decltype(t)>; });
+    case BytecodeOp::Gosub:
+        return gosub;
+    case BytecodeOp::SubReturn:
+        return subReturn;
+    case BytecodeOp::Return:
+        return returnVoid;
+    case BytecodeOp::ReturnValue:
+        return returnValue;
+    case BytecodeOp::CallCommand:
+        return callCommand;
+    case BytecodeOp::CallFunction:
+        return callUserFunction;
+    }
+    return nullptr;
+}
+
+// Checks that every register and jump target the instruction uses is inside
+// of the function, so the handlers don't have to.
+bool hasValidOperands(const BytecodeInstruction& instruction, const BytecodeFunction& function)
+{
+    auto isRegister = [&function](std::int32_t reg) { return reg >= 0 && reg < function.registerCount; };
+    auto isTarget = [&function](std::int32_t target) {
+        return target >= 0 && std::size_t(target) < function.code.size();
+    };
+
+    switch (instruction.op)
+    {
+    case BytecodeOp::LoadConstant:
+    case BytecodeOp::LoadString:
+        return isRegister(instruction.dst);
+    case BytecodeOp::Move:
+    case BytecodeOp::Cast:
+    case BytecodeOp::Negate:
+    case BytecodeOp::BitwiseNot:
+    case BytecodeOp::LogicalNot:
+        return isRegister(instruction.dst) && isRegister(instruction.a);
+    case BytecodeOp::Jump:
+    case BytecodeOp::BackEdge:
+    case BytecodeOp::Gosub:
+        return isTarget(instruction.target);
+    case BytecodeOp::JumpIfFalse:
+    case BytecodeOp::BackEdgeIfFalse:
+        return isRegister(instruction.a) && isTarget(instruction.target);
+    case BytecodeOp::ForLoopCondition:
+        return isRegister(instruction.dst) && isRegister(instruction.a) && isRegister(instruction.b) &&
+               isTarget(instruction.target);
+    case BytecodeOp::SubReturn:
+    case BytecodeOp::Return:
+        return true;
+    case BytecodeOp::ReturnValue:
+        return isRegister(instruction.a);
+    case BytecodeOp::CallCommand:
+    case BytecodeOp::CallFunction:
+        return isRegister(instruction.dst) && instruction.target >= 0 &&
+               std::size_t(instruction.target) < function.callSites.size();
+    default:
+        // Binary operators
+        return isRegister(instruction.dst) && isRegister(instruction.a) && isRegister(instruction.b);
+    }
+}
+
+bool invalidBytecode(const BytecodeFunction& function, const char* message)
+{
+    Log::codegen(Log::ERROR, "Invalid bytecode in function `%s`: %s\n", function.name.c_str(), message);
+    return false;
+}
+
+// Builds the FFI table of the module. Every command is looked up by its C++
+// symbol and must have the same signature it had when the module was
+// generated.
+bool bindCommands(InterpreterData& interpreter, const BytecodeModule& module)
+{
+    std::unordered_multimap<std::string, const cmd::Command*> commandsBySymbol;
+    for (const auto& command : interpreter.cmdIndex.commands())
+    {
+        commandsBySymbol.emplace(command->cppSymbol(), command.get());
+    }
+
+    for (const BytecodeCommand& entry : module.commands)
+    {
+        const cmd::Command* command = nullptr;
+        auto [begin, end] = commandsBySymbol.equal_range(entry.cppSymbol);
+        for (auto it = begin; it != end && !command; ++it)
+        {
+            const auto& args = it->second->args();
+            bool signatureMatches = it->second->returnType() == entry.returnType &&
+                                    std::equal(args.begin(), args.end(), entry.argumentTypes.begin(),
+                                               entry.argumentTypes.end(),
+                                               [](const auto& arg, cmd::Command::Type type) { return arg.type == type; });
+            if (signatureMatches)
+            {
+                command = it->second;
+            }
+        }
+
+        BoundCommand& bound = interpreter.commands.emplace_back();
+        if (command)
+        {
+            DynamicLibrary* library = command->library();
+            bound.address = library ? library->lookupSymbolAddress(command->cppSymbol().c_str()) : nullptr;
+            bound.invoke = getCommandInvoker(entry.returnType, entry.argumentTypes);
+        }
+        if (!bound.address || !bound.invoke)
+        {
+            Log::codegen(Log::ERROR, "Command `%s` (%s) isn't available from any loaded plugin\n",
+                         entry.dbSymbol.c_str(), entry.cppSymbol.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// What a register holds at some point in the function. Strings are pointers,
+// so they must never be mixed up with other values.
+enum class RegisterKind : std::uint8_t
+{
+    Unreached,
+    Scalar,
+    String,
+    // Different paths leave different kinds of values in the register.
+    Mixed
+};
+
+RegisterKind joinKinds(RegisterKind a, RegisterKind b)
+{
+    if (a == RegisterKind::Unreached || a == b)
+    {
+        return b;
+    }
+    return b == RegisterKind::Unreached ? a : RegisterKind::Mixed;
+}
+
+bool isStringRegister(const BytecodeFunction& function, std::int32_t reg)
+{
+    return std::find(function.stringRegisters.begin(), function.stringRegisters.end(), reg) !=
+           function.stringRegisters.end();
+}
+
+// Follows the kind of value in each register through all paths of the
+// function, and checks that strings are only passed to commands and
+// functions that expect strings and vice versa. Everything else only
+// reinterprets the bits of a value, which gives garbage results but is
+// harmless. Expects the operands and call sites to be validated.
+bool hasValidRegisterKinds(const BytecodeModule& module, const BytecodeFunction& function)
+{
+    const std::size_t registerCount = std::size_t(function.registerCount);
+    // Kinds of all registers before each instruction.
+    std::vector<RegisterKind> states(function.code.size() * registerCount, RegisterKind::Unreached);
+    auto stateAt = [&](std::size_t instruction) { return states.data() + instruction * registerCount; };
+
+    // Registers start out as zero, except for string variables, which start
+    // out as "". Arguments are bound to variables, so the same goes for them.
+    std::vector<RegisterKind> state(registerCount, RegisterKind::Scalar);
+    for (std::int32_t reg : function.stringRegisters)
+    {
+        state[reg] = RegisterKind::String;
+    }
+
+    std::vector<std::size_t> gosubReturns;
+    for (std::size_t i = 0; i < function.code.size(); ++i)
+    {
+        if (function.code[i].op == BytecodeOp::Gosub && i + 1 < function.code.size())
+        {
+            gosubReturns.push_back(i + 1);
+        }
+    }
+
+    std::vector<bool> reached(function.code.size(), false);
+    std::vector<std::size_t> worklist;
+    auto flowInto = [&](std::size_t instruction) {
+        if (instruction >= function.code.size())
+        {
+            return;
+        }
+        RegisterKind* target = stateAt(instruction);
+        bool changed = false;
+        for (std::size_t reg = 0; reg < registerCount; ++reg)
+        {
+            RegisterKind joined = joinKinds(target[reg], state[reg]);
+            changed |= joined != target[reg];
+            target[reg] = joined;
+        }
+        if (changed || !reached[instruction])
+        {
+            reached[instruction] = true;
+            worklist.push_back(instruction);
+        }
+    };
+
+    flowInto(0);
+    while (!worklist.empty())
+    {
+        std::size_t i = worklist.back();
+        worklist.pop_back();
+
+        const BytecodeInstruction& instruction = function.code[i];
+        state.assign(stateAt(i), stateAt(i) + registerCount);
+        switch (instruction.op)
+        {
+        case BytecodeOp::LoadString:
+            state[instruction.dst] = RegisterKind::String;
+            break;
+        case BytecodeOp::Move:
+            state[instruction.dst] = state[instruction.a];
+            break;
+        case BytecodeOp::Jump:
+        case BytecodeOp::BackEdge:
+        case BytecodeOp::Gosub:
+            flowInto(std::size_t(instruction.target));
+            continue;
+        case BytecodeOp::JumpIfFalse:
+        case BytecodeOp::BackEdgeIfFalse:
+            flowInto(std::size_t(instruction.target));
+            break;
+        case BytecodeOp::ForLoopCondition:
+            state[instruction.dst] = RegisterKind::Scalar;
+            flowInto(std::size_t(instruction.target));
+            break;
+        case BytecodeOp::SubReturn:
+            for (std::size_t returnAddress : gosubReturns)
+            {
+                flowInto(returnAddress);
+            }
+            continue;
+        case BytecodeOp::Return:
+        case BytecodeOp::ReturnValue:
+            continue;
+        case BytecodeOp::CallCommand: {
+            const BytecodeCallSite& site = function.callSites[instruction.target];
+            cmd::Command::Type returnType = module.commands[site.callee].returnType;
+            // Commands that don't return anything leave the register alone.
+            if (returnType != cmd::Command::Type::Void)
+            {
+                state[instruction.dst] =
+                    returnType == cmd::Command::Type::String ? RegisterKind::String : RegisterKind::Scalar;
+            }
+            break;
+        }
+        case BytecodeOp::CallFunction: {
+            const BytecodeFunction& callee = module.functions[function.callSites[instruction.target].callee];
+            // The result is cleared unless the callee was compiled, in which
+            // case it's left alone. Compiled functions never return values.
+            state[instruction.dst] = callee.returnsString
+                                         ? RegisterKind::String
+                                         : joinKinds(state[instruction.dst], RegisterKind::Scalar);
+            break;
+        }
+        default:
+            // Everything else produces a number or a boolean.
+            state[instruction.dst] = RegisterKind::Scalar;
+            break;
+        }
+        flowInto(i + 1);
+    }
+
+    auto expect = [&](const RegisterKind* kinds, std::int32_t reg, bool isString) {
+        return kinds[reg] == (isString ? RegisterKind::String : RegisterKind::Scalar);
+    };
+    for (std::size_t i = 0; i < function.code.size(); ++i)
+    {
+        if (!reached[i])
+        {
+            continue;
+        }
+
+        const BytecodeInstruction& instruction = function.code[i];
+        const RegisterKind* kinds = stateAt(i);
+        if (instruction.op == BytecodeOp::ReturnValue && !expect(kinds, instruction.a, function.returnsString))
+        {
+            return false;
+        }
+        if (instruction.op != BytecodeOp::CallCommand && instruction.op != BytecodeOp::CallFunction)
+        {
+            continue;
+        }
+
+        const BytecodeCallSite& site = function.callSites[instruction.target];
+        for (std::size_t arg = 0; arg < site.argumentRegisters.size(); ++arg)
+        {
+            std::int32_t reg = site.argumentRegisters[arg];
+            if (instruction.op == BytecodeOp::CallCommand)
+            {
+                if (!expect(kinds, reg, module.commands[site.callee].argumentTypes[arg] == cmd::Command::Type::String))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                // Arguments the callee never uses can be anything.
+                const BytecodeFunction& callee = module.functions[site.callee];
+                std::int32_t parameter = callee.argumentRegisters[arg];
+                if (parameter >= 0 && !expect(kinds, reg, isStringRegister(callee, parameter)))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool loadFunction(InterpreterData& interpreter, const BytecodeModule& module, const BytecodeFunction& function,
+                  FunctionCode& code)
+{
+    auto isRegister = [&function](std::int32_t reg) { return reg >= 0 && reg < function.registerCount; };
+
+    if (function.registerCount < 0)
+    {
+        return invalidBytecode(function, "Negative register count");
+    }
+    for (std::int32_t reg : function.argumentRegisters)
+    {
+        if (reg != -1 && !isRegister(reg))
+        {
+            return invalidBytecode(function, "Argument register out of range");
+        }
+    }
+    if (!std::all_of(function.stringRegisters.begin(), function.stringRegisters.end(), isRegister))
+    {
+        return invalidBytecode(function, "String register out of range");
+    }
+    // Execution must not run past the last instruction.
+    if (function.code.empty() || (function.code.back().op != BytecodeOp::Return &&
+                                  function.code.back().op != BytecodeOp::ReturnValue &&
+                                  function.code.back().op != BytecodeOp::Jump &&
+                                  function.code.back().op != BytecodeOp::BackEdge))
+    {
+        return invalidBytecode(function, "Missing return at the end of the function");
+    }
+
+    code.argumentSlots = function.argumentRegisters;
+    code.stringSlots = function.stringRegisters;
+    code.slotCount = function.registerCount;
+
+    code.callSites.resize(function.callSites.size());
+    code.instructions.reserve(function.code.size());
+    for (const BytecodeInstruction& instruction : function.code)
+    {
+        Handler handler = selectHandler(instruction);
+        if (!handler)
+        {
+            return invalidBytecode(function, "Opcode used with an unsupported type");
+        }
+        if (!hasValidOperands(instruction, function))
+        {
+            return invalidBytecode(function, "Operand out of range");
+        }
+
+        Instruction& loaded = code.instructions.emplace_back(
+            Instruction{handler, instruction.dst, instruction.a, instruction.b, instruction.target, Value{}, nullptr});
+        loaded.constant.bits = instruction.constant;
+
+        if (instruction.op == BytecodeOp::LoadString)
+        {
+            if (instruction.constant >= interpreter.strings.size())
+            {
+                return invalidBytecode(function, "String index out of range");
+            }
+            loaded.constant.set<const char*>(interpreter.strings[instruction.constant].c_str());
+        }
+        else if (instruction.op == BytecodeOp::CallCommand || instruction.op == BytecodeOp::CallFunction)
+        {
+            const BytecodeCallSite& site = function.callSites[instruction.target];
+            CallSite& callSite = code.callSites[instruction.target];
+            std::size_t argumentCount = 0;
+            if (instruction.op == BytecodeOp::CallCommand)
+            {
+                if (site.callee < 0 || std::size_t(site.callee) >= interpreter.commands.size())
+                {
+                    return invalidBytecode(function, "Command index out of range");
+                }
+                callSite.command = interpreter.commands[site.callee].address;
+                callSite.invoke = interpreter.commands[site.callee].invoke;
+                argumentCount = module.commands[site.callee].argumentTypes.size();
+            }
+            else
+            {
+                if (site.callee < 0 || std::size_t(site.callee) >= interpreter.functions.size())
+                {
+                    return invalidBytecode(function, "Function index out of range");
+                }
+                callSite.function = interpreter.functions[site.callee].get();
+                argumentCount = module.functions[site.callee].argumentRegisters.size();
+            }
+            if (site.argumentRegisters.size() != argumentCount ||
+                !std::all_of(site.argumentRegisters.begin(), site.argumentRegisters.end(), isRegister))
+            {
+                return invalidBytecode(function, "Call arguments don't match the callee");
+            }
+            callSite.argumentSlots = site.argumentRegisters;
+            callSite.arguments.resize(site.argumentRegisters.size());
+            loaded.data = &callSite;
+        }
+    }
+
+    if (!hasValidRegisterKinds(module, function))
+    {
+        return invalidBytecode(function, "String and non-string values are mixed up");
+    }
+
+    return true;
+}
+
+std::unique_ptr<InterpreterData> loadModule(const BytecodeModule& module, const cmd::CommandIndex& cmdIndex)
+{
+    auto data = std::make_unique<InterpreterData>(cmdIndex);
+    data->strings = module.strings;
+    if (module.functions.empty() || !bindCommands(*data, module))
+    {
+        return nullptr;
+    }
+
+    for (const BytecodeFunction& function : module.functions)
+    {
+        auto code = std::make_unique<FunctionCode>();
+        code->name = function.name;
+        data->functionMap.emplace(function.name, code.get());
+        data->functions.emplace_back(std::move(code));
+    }
+    for (std::size_t i = 0; i < module.functions.size(); ++i)
+    {
+        if (!loadFunction(*data, module, module.functions[i], *data->functions[i]))
+        {
+            return nullptr;
+        }
+    }
+
+    return data;
+}
+} // namespace
+
+Interpreter::Interpreter(std::unique_ptr<InterpreterData> data) : data_(std::move(data))
+{
+}
+
+Interpreter::~Interpreter() = default;
+
+std::unique_ptr<Interpreter> Interpreter::compile(const Program& program, const cmd::CommandIndex& cmdIndex)
+{
+    auto module = generateBytecode(program);
+    if (!module)
+    {
+        return nullptr;
+    }
+
+    auto data = loadModule(*module, cmdIndex);
+    if (!data)
+    {
+        return nullptr;
+    }
+    data->program = &program;
+
+    // CodeGenerator only generates whole programs, so a single construct it
+    // can't lower yet keeps every function in the interpreter. The main
+    // function is only entered once, so compiling it would never pay off.
+    // Compiled functions have no way to hand back a return value, so
+    // functions that return one stay in the interpreter as well.
+    for (const auto& function : program.functions())
+    {
+        data->functionMap.at(function->name())->canCompile =
+            module->canCompile && function->returnExpression() == nullptr;
+    }
+
+    return std::unique_ptr<Interpreter>(new Interpreter(std::move(data)));
+}
+
+std::unique_ptr<Interpreter> Interpreter::load(const BytecodeModule& module, const cmd::CommandIndex& cmdIndex)
+{
+    auto data = loadModule(module, cmdIndex);
+    if (!data)
+    {
+        return nullptr;
+    }
+    return std::unique_ptr<Interpreter>(new Interpreter(std::move(data)));
+}
+
+void Interpreter::setTierUpThreshold(int threshold)
+{
+    data_->tierUpThreshold = threshold;
+}
+
+void Interpreter::setOptimizationLevel(OptimizationLevel optimizationLevel)
+{
+    data_->optimizationLevel = optimizationLevel;
+}
+
+int Interpreter::run()
+{
+    if (!data_->stack)
+    {
+        data_->stack = std::make_unique<Value[]>(StackSize);
+    }
+    data_->aborted = false;
+
+    FunctionCode& mainFunction = *data_->functions.front();
+    ++mainFunction.entryCount;
+    return execute(*data_, mainFunction, nullptr, nullptr) ? 0 : 1;
+}
+
+std::uint64_t Interpreter::entryCount(const FunctionDefinition& function) const
+{
+    return data_->functionMap.at(function.name())->entryCount;
+}
+
+std::uint64_t Interpreter::backEdgeCount(const FunctionDefinition& function) const
+{
+    return data_->functionMap.at(function.name())->backEdgeCount;
+}
+
+bool Interpreter::isCompiled(const FunctionDefinition& function) const
+{
+    return data_->functionMap.at(function.name())->compiled != nullptr;
+}
+} // namespace odb::ir
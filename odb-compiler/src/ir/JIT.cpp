@@ -0,0 +1,212 @@
+#include "odb-compiler/ir/JIT.hpp"
+
+#include "codegen/CodeGenerator.hpp"
+#include "codegen/LLVM.hpp"
+#include "codegen/ODBEngineInterface.hpp"
+#include "codegen/Optimizer.hpp"
+
+#include "odb-sdk/DynamicLibrary.hpp"
+#include "odb-sdk/Log.hpp"
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+
+namespace odb::ir {
+struct JITProgramData
+{
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    int (*entryPoint)();
+};
+
+// ----------------------------------------------------------------------------
+static std::string getEntryPointName(const std::string& functionName)
+{
+    // '.' can't appear in a DBA identifier, so this never clashes with a user
+    // function
+    return "__DB" + functionName + ".entry";
+}
+
+// ----------------------------------------------------------------------------
+// Generates an externally visible wrapper that unpacks the arguments of a
+// user function from an array of slots (see JITProgram::FunctionEntryPoint)
+// and calls it. User functions themselves have internal linkage, so this also
+// keeps them from being removed by the optimizer.
+static void generateEntryPoint(llvm::Module& module, llvm::Function* function, const std::string& name)
+{
+    llvm::LLVMContext& ctx = module.getContext();
+    auto* entryPointType =
+        llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {llvm::Type::getInt8PtrTy(ctx)}, false);
+    auto* entryPoint = llvm::Function::Create(entryPointType, llvm::Function::ExternalLinkage, name, module);
+
+    llvm::IRBuilder<> builder(ctx);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(ctx, "", entryPoint));
+
+    std::vector<llvm::Value*> args;
+    for (llvm::Argument& arg : function->args())
+    {
+        llvm::Value* slot = builder.CreateConstInBoundsGEP1_64(builder.getInt8Ty(), entryPoint->getArg(0),
+                                                               arg.getArgNo() * JITProgram::ArgumentSlotSize);
+        slot = builder.CreateBitCast(slot, arg.getType()->getPointerTo());
+        args.emplace_back(builder.CreateLoad(arg.getType(), slot));
+    }
+    builder.CreateCall(function, args);
+    builder.CreateRetVoid();
+}
+
+// ----------------------------------------------------------------------------
+JITProgram::JITProgram(std::unique_ptr<JITProgramData> data) : data_(std::move(data))
+{
+}
+
+// ----------------------------------------------------------------------------
+JITProgram::~JITProgram() = default;
+
+// ----------------------------------------------------------------------------
+std::unique_ptr<JITProgram> JITProgram::compile(const Program& program, const cmd::CommandIndex& cmdIndex,
+                                                OptimizationLevel optimizationLevel)
+{
+    auto logError = [](const char* what, llvm::Error error) {
+        Log::codegen(Log::ERROR, "%s: %s\n", what, llvm::toString(std::move(error)).c_str());
+    };
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto jitTargetMachineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jitTargetMachineBuilder)
+    {
+        logError("Failed to detect host target", jitTargetMachineBuilder.takeError());
+        return nullptr;
+    }
+    jitTargetMachineBuilder->setCodeGenOptLevel(getCodeGenOptLevel(optimizationLevel));
+
+    auto targetMachine = jitTargetMachineBuilder->createTargetMachine();
+    if (!targetMachine)
+    {
+        logError("Failed to create target machine", targetMachine.takeError());
+        return nullptr;
+    }
+
+    auto jit = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(*jitTargetMachineBuilder).create();
+    if (!jit)
+    {
+        logError("Failed to create JIT", jit.takeError());
+        return nullptr;
+    }
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module = std::make_unique<llvm::Module>("jit", *context);
+    module->setDataLayout((*jit)->getDataLayout());
+    module->setTargetTriple((*targetMachine)->getTargetTriple().str());
+
+    ODBEngineInterface engineInterface(*module);
+    {
+        CodeGenerator gen(*module, engineInterface);
+        if (!gen.generateModule(program, cmdIndex.librariesAsList()))
+        {
+            return nullptr;
+        }
+    }
+
+    // Functions returning a value can't be called through an entry point yet,
+    // since CodeGenerator doesn't lower return values
+    for (const auto& function : program.functions())
+    {
+        if (function->returnExpression() == nullptr)
+        {
+            generateEntryPoint(*module, module->getFunction("__DB" + function->name()),
+                               getEntryPointName(function->name()));
+        }
+    }
+
+    // The optimizer deletes declarations that ended up unused, so remember the
+    // names before running it
+    std::vector<std::pair<std::string, const cmd::Command*>> commandFunctions;
+    for (const auto& [function, command] : engineInterface.commandFunctions())
+    {
+        commandFunctions.emplace_back(function->getName().str(), command);
+    }
+
+    optimizeModule(*module, targetMachine->get(), optimizationLevel);
+
+    // The plugins are already loaded (the command index holds references to
+    // them), so command calls go straight to the plugin's function.
+    llvm::orc::SymbolMap commandSymbols;
+    for (const auto& [name, command] : commandFunctions)
+    {
+        if (module->getFunction(name) == nullptr)
+        {
+            continue;
+        }
+
+        DynamicLibrary* library = command->library();
+        void* address = library ? library->lookupSymbolAddress(command->cppSymbol().c_str()) : nullptr;
+        if (!address)
+        {
+            Log::codegen(Log::ERROR, "Failed to resolve command `%s`: symbol `%s` not found in `%s`\n",
+                         command->dbSymbol().c_str(), command->cppSymbol().c_str(),
+                         library ? library->getFilename() : "(no library)");
+            return nullptr;
+        }
+
+        commandSymbols[(*jit)->mangleAndIntern(name)] =
+            llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(address),
+                                     llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    }
+
+    llvm::orc::JITDylib& mainDylib = (*jit)->getMainJITDylib();
+    if (auto error = mainDylib.define(llvm::orc::absoluteSymbols(std::move(commandSymbols))))
+    {
+        logError("Failed to define command symbols", std::move(error));
+        return nullptr;
+    }
+
+    // Everything else (e.g. puts) comes from the C runtime this process links
+    auto processSymbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+    if (!processSymbols)
+    {
+        logError("Failed to search process symbols", processSymbols.takeError());
+        return nullptr;
+    }
+    mainDylib.addGenerator(std::move(*processSymbols));
+
+    if (auto error = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context))))
+    {
+        logError("Failed to add module to JIT", std::move(error));
+        return nullptr;
+    }
+
+    // Looking up the entry point compiles the module, so the program can start
+    // executing immediately once run() is called.
+    auto entryPoint = (*jit)->lookup("main");
+    if (!entryPoint)
+    {
+        logError("Failed to compile program", entryPoint.takeError());
+        return nullptr;
+    }
+
+    auto data = std::make_unique<JITProgramData>();
+    data->jit = std::move(*jit);
+    data->entryPoint = llvm::jitTargetAddressToFunction<int (*)()>(entryPoint->getAddress());
+    return std::unique_ptr<JITProgram>(new JITProgram(std::move(data)));
+}
+
+// ----------------------------------------------------------------------------
+int JITProgram::run()
+{
+    return data_->entryPoint();
+}
+
+// ----------------------------------------------------------------------------
+JITProgram::FunctionEntryPoint JITProgram::lookupFunction(const std::string& name)
+{
+    auto address = data_->jit->lookup(getEntryPointName(name));
+    if (!address)
+    {
+        llvm::consumeError(address.takeError());
+        return nullptr;
+    }
+    return llvm::jitTargetAddressToFunction<FunctionEntryPoint>(address->getAddress());
+}
+} // namespace odb::ir
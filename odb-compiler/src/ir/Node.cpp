@@ -1,4 +1,5 @@
 #include "odb-compiler/ir/Node.hpp"
+#include "odb-compiler/Stats.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -28,6 +29,12 @@ bool isFloatingPointType(BuiltinType type)
     return type == BuiltinType::DoubleFloat || type == BuiltinType::Float;
 }
 
+bool isUnsignedType(BuiltinType type)
+{
+    return type == BuiltinType::Dword || type == BuiltinType::Word || type == BuiltinType::Byte ||
+           type == BuiltinType::Boolean;
+}
+
 const char* convertBuiltinTypeToString(BuiltinType type)
 {
     switch (type)
@@ -123,6 +130,7 @@ std::string Type::toString() const
 
 Node::Node(SourceLocation* location) : location_(location)
 {
+    Stats::add(Stats::IRNodes, 1);
 }
 
 SourceLocation* Node::location() const
@@ -131,7 +139,12 @@ SourceLocation* Node::location() const
 }
 
 Variable::Variable(SourceLocation* location, std::string name, Annotation annotation, Type type)
-    : Node(location), name_(std::move(name)), annotation_(annotation), type_(type)
+    : Node(location), atom_(ast::AtomTable::intern(name)), name_(std::move(name)), annotation_(annotation), type_(type)
+{
+}
+
+Variable::Variable(SourceLocation* location, ast::Atom atom, std::string name, Annotation annotation, Type type)
+    : Node(location), atom_(atom), name_(std::move(name)), annotation_(annotation), type_(type)
 {
 }
 
@@ -140,6 +153,11 @@ const std::string& Variable::name() const
     return name_;
 }
 
+ast::Atom Variable::atom() const
+{
+    return atom_;
+}
+
 Variable::Annotation Variable::annotation() const
 {
     return annotation_;
@@ -150,12 +168,12 @@ const Type& Variable::type() const
     return type_;
 }
 
-Expression::Expression(SourceLocation* location) : Node(location)
+Expression::Expression(SourceLocation* location, ExpressionKind kind) : Node(location), kind_(kind)
 {
 }
 
 CastExpression::CastExpression(SourceLocation* location, Ptr<Expression> expression, Type targetType)
-    : Expression(location), expression_(std::move(expression)), targetType_(targetType)
+    : Expression(location, ExpressionKind::Cast), expression_(std::move(expression)), targetType_(targetType)
 {
 }
 
@@ -169,8 +187,18 @@ const Type& CastExpression::targetType() const
     return targetType_;
 }
 
+void CastExpression::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
+void CastExpression::setTargetType(Type targetType)
+{
+    targetType_ = targetType;
+}
+
 UnaryExpression::UnaryExpression(SourceLocation* location, UnaryOp op, Ptr<Expression> expr)
-    : Expression(location), op_(op), expr_(std::move(expr))
+    : Expression(location, ExpressionKind::Unary), op_(op), expr_(std::move(expr))
 {
 }
 
@@ -189,8 +217,13 @@ Expression* UnaryExpression::expression() const
     return expr_.get();
 }
 
+void UnaryExpression::setExpression(Ptr<Expression> expression)
+{
+    expr_ = std::move(expression);
+}
+
 BinaryExpression::BinaryExpression(SourceLocation* location, BinaryOp op, Ptr<Expression> left, Ptr<Expression> right)
-    : Expression(location), op_(op), left_(std::move(left)), right_(std::move(right))
+    : Expression(location, ExpressionKind::Binary), op_(op), left_(std::move(left)), right_(std::move(right))
 {
 }
 
@@ -219,6 +252,7 @@ Type BinaryExpression::getType() const
     case BinaryOp::NOT_EQUAL:
     case BinaryOp::LOGICAL_OR:
     case BinaryOp::LOGICAL_AND:
+    case BinaryOp::LOGICAL_XOR:
         return Type{BuiltinType::Boolean};
     default:
         fatalError("Unhandled binary expression.");
@@ -240,8 +274,18 @@ Expression* BinaryExpression::right() const
     return right_.get();
 }
 
+void BinaryExpression::setLeft(Ptr<Expression> left)
+{
+    left_ = std::move(left);
+}
+
+void BinaryExpression::setRight(Ptr<Expression> right)
+{
+    right_ = std::move(right);
+}
+
 VarRefExpression::VarRefExpression(SourceLocation* location, Reference<Variable> variable)
-    : Expression(location), variable_(std::move(variable))
+    : Expression(location, ExpressionKind::VarRef), variable_(std::move(variable))
 {
 }
 
@@ -255,13 +299,13 @@ const Variable* VarRefExpression::variable() const
     return variable_;
 }
 
-Literal::Literal(SourceLocation* location) : Expression(location)
+Literal::Literal(SourceLocation* location, ExpressionKind kind) : Expression(location, kind)
 {
 }
 
 FunctionCallExpression::FunctionCallExpression(SourceLocation* location, const cmd::Command* command,
                                                PtrVector<Expression> arguments, Type returnType)
-    : Expression(location)
+    : Expression(location, ExpressionKind::FunctionCall)
     , command_(command)
     , userFunction_(nullptr)
     , arguments_(std::move(arguments))
@@ -271,7 +315,7 @@ FunctionCallExpression::FunctionCallExpression(SourceLocation* location, const c
 
 FunctionCallExpression::FunctionCallExpression(SourceLocation* location, FunctionDefinition* userFunction,
                                                PtrVector<Expression> arguments, Type returnType)
-    : Expression(location)
+    : Expression(location, ExpressionKind::FunctionCall)
     , command_(nullptr)
     , userFunction_(userFunction)
     , arguments_(std::move(arguments))
@@ -309,8 +353,27 @@ Type FunctionCallExpression::returnType() const
     return returnType_;
 }
 
-Statement::Statement(SourceLocation* location, FunctionDefinition* containingFunction)
-    : Node(location), containingFunction_(containingFunction)
+void FunctionCallExpression::setArgument(std::size_t index, Ptr<Expression> argument)
+{
+    arguments_[index] = std::move(argument);
+}
+
+void FunctionCallExpression::setCommand(const cmd::Command* command, Type returnType)
+{
+    command_ = command;
+    userFunction_ = nullptr;
+    returnType_ = returnType;
+}
+
+void FunctionCallExpression::setUserFunction(FunctionDefinition* userFunction, Type returnType)
+{
+    command_ = nullptr;
+    userFunction_ = userFunction;
+    returnType_ = returnType;
+}
+
+Statement::Statement(SourceLocation* location, FunctionDefinition* containingFunction, StatementKind kind)
+    : Node(location), containingFunction_(containingFunction), kind_(kind)
 {
 }
 
@@ -321,7 +384,7 @@ FunctionDefinition* Statement::containingFunction() const
 
 Conditional::Conditional(SourceLocation* location, FunctionDefinition* containingFunction, Ptr<Expression> expression,
                          StatementBlock trueBranch, StatementBlock falseBranch)
-    : Statement(location, containingFunction)
+    : Statement(location, containingFunction, StatementKind::Conditional)
     , expression_(std::move(expression))
     , trueBranch_(std::move(trueBranch))
     , falseBranch_(std::move(falseBranch))
@@ -343,9 +406,14 @@ const StatementBlock& Conditional::falseBranch() const
     return falseBranch_;
 }
 
+void Conditional::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
 Select::Select(SourceLocation* location, FunctionDefinition* containingFunction, Ptr<Expression> expression,
                std::vector<Case> cases)
-    : Statement(location, containingFunction), expression_(std::move(expression)), cases_(std::move(cases))
+    : Statement(location, containingFunction, StatementKind::Select), expression_(std::move(expression)), cases_(std::move(cases))
 {
 }
 
@@ -359,6 +427,11 @@ const std::vector<Select::Case>& Select::cases() const
     return cases_;
 }
 
+void Select::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
 void Loop::appendStatements(StatementBlock block)
 {
     std::move(block.begin(), block.end(), std::back_inserter(statements_));
@@ -369,13 +442,14 @@ const StatementBlock& Loop::statements() const
     return statements_;
 }
 
-Loop::Loop(SourceLocation* location, FunctionDefinition* containingFunction, StatementBlock block) : Statement(location, containingFunction), statements_(std::move(block))
+Loop::Loop(SourceLocation* location, FunctionDefinition* containingFunction, StatementKind kind, StatementBlock block)
+    : Statement(location, containingFunction, kind), statements_(std::move(block))
 {
 }
 
 ForLoop::ForLoop(SourceLocation* location, FunctionDefinition* containingFunction, VarAssignment assignment, Ptr<Expression> endValue, Ptr<Expression> stepValue,
                  StatementBlock statements)
-    : Loop(location, containingFunction, std::move(statements)), assignment_(std::move(assignment)), endValue_(std::move(endValue)), stepValue_(std::move(stepValue))
+    : Loop(location, containingFunction, StatementKind::ForLoop, std::move(statements)), assignment_(std::move(assignment)), endValue_(std::move(endValue)), stepValue_(std::move(stepValue))
 {
 }
 
@@ -384,6 +458,11 @@ const VarAssignment& ForLoop::assignment() const
     return assignment_;
 }
 
+VarAssignment& ForLoop::assignment()
+{
+    return assignment_;
+}
+
 Expression* ForLoop::endValue() const
 {
     return endValue_.get();
@@ -394,9 +473,19 @@ Expression* ForLoop::stepValue() const
     return stepValue_.get();
 }
 
+void ForLoop::setEndValue(Ptr<Expression> endValue)
+{
+    endValue_ = std::move(endValue);
+}
+
+void ForLoop::setStepValue(Ptr<Expression> stepValue)
+{
+    stepValue_ = std::move(stepValue);
+}
+
 WhileLoop::WhileLoop(SourceLocation* location, FunctionDefinition* containingFunction, Ptr<Expression> expression,
                      StatementBlock statements)
-    : Loop(location, containingFunction, std::move(statements)), expression_(std::move(expression))
+    : Loop(location, containingFunction, StatementKind::WhileLoop, std::move(statements)), expression_(std::move(expression))
 {
 }
 
@@ -405,9 +494,14 @@ Expression* WhileLoop::expression() const
     return expression_.get();
 }
 
+void WhileLoop::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
 UntilLoop::UntilLoop(SourceLocation* location, FunctionDefinition* containingFunction, Ptr<Expression> expression,
                      StatementBlock statements)
-    : Loop(location, containingFunction, std::move(statements)), expression_(std::move(expression))
+    : Loop(location, containingFunction, StatementKind::UntilLoop, std::move(statements)), expression_(std::move(expression))
 {
 }
 
@@ -416,14 +510,19 @@ Expression* UntilLoop::expression() const
     return expression_.get();
 }
 
+void UntilLoop::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
 InfiniteLoop::InfiniteLoop(SourceLocation* location, FunctionDefinition* containingFunction, StatementBlock statements)
-    : Loop(location, containingFunction, std::move(statements))
+    : Loop(location, containingFunction, StatementKind::InfiniteLoop, std::move(statements))
 {
 }
 
 VarAssignment::VarAssignment(SourceLocation* location, FunctionDefinition* containingFunction,
                              Reference<Variable> variable, Ptr<Expression> expression)
-    : Statement(location, containingFunction), variable_(std::move(variable)), expression_(std::move(expression))
+    : Statement(location, containingFunction, StatementKind::VarAssignment), variable_(std::move(variable)), expression_(std::move(expression))
 {
 }
 
@@ -437,8 +536,13 @@ Expression* VarAssignment::expression() const
     return expression_.get();
 }
 
+void VarAssignment::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
 Label::Label(SourceLocation* location, FunctionDefinition* containingFunction, std::string name)
-    : Statement(location, containingFunction), name_(std::move(name))
+    : Statement(location, containingFunction, StatementKind::Label), name_(std::move(name))
 {
 }
 
@@ -448,7 +552,7 @@ const std::string& Label::name() const
 }
 
 Goto::Goto(SourceLocation* location, FunctionDefinition* containingFunction, Label* label)
-    : Statement(location, containingFunction), label_(label)
+    : Statement(location, containingFunction, StatementKind::Goto), label_(label)
 {
 }
 
@@ -463,7 +567,7 @@ void Goto::setLabel(Label* label)
 }
 
 Gosub::Gosub(SourceLocation* location, FunctionDefinition* containingFunction, Label* label)
-    : Statement(location, containingFunction), label_(label)
+    : Statement(location, containingFunction, StatementKind::Gosub), label_(label)
 {
 }
 
@@ -479,7 +583,7 @@ void Gosub::setLabel(Label* label)
 
 FunctionCall::FunctionCall(SourceLocation* location, FunctionDefinition* containingFunction,
                            FunctionCallExpression call)
-    : Statement(location, containingFunction), expression_(std::move(call))
+    : Statement(location, containingFunction, StatementKind::FunctionCall), expression_(std::move(call))
 {
 }
 
@@ -488,12 +592,17 @@ const FunctionCallExpression& FunctionCall::expression() const
     return expression_;
 }
 
+FunctionCallExpression& FunctionCall::expression()
+{
+    return expression_;
+}
+
 SubReturn::SubReturn(SourceLocation* location, FunctionDefinition* containingFunction)
-    : Statement(location, containingFunction)
+    : Statement(location, containingFunction, StatementKind::SubReturn)
 {
 }
 
-Exit::Exit(SourceLocation* location, FunctionDefinition* containingFunction, Loop* loopToBreak) : Statement(location, containingFunction), loopToBreak_(loopToBreak)
+Exit::Exit(SourceLocation* location, FunctionDefinition* containingFunction, Loop* loopToBreak) : Statement(location, containingFunction, StatementKind::Exit), loopToBreak_(loopToBreak)
 {
 }
 
@@ -503,7 +612,7 @@ Loop* Exit::loopToBreak() const
 }
 
 ExitFunction::ExitFunction(SourceLocation* location, FunctionDefinition* containingFunction, Ptr<Expression> expression)
-    : Statement(location, containingFunction), expression_(std::move(expression))
+    : Statement(location, containingFunction, StatementKind::ExitFunction), expression_(std::move(expression))
 {
 }
 
@@ -512,13 +621,19 @@ Expression* ExitFunction::expression() const
     return expression_.get();
 }
 
+void ExitFunction::setExpression(Ptr<Expression> expression)
+{
+    expression_ = std::move(expression);
+}
+
 void FunctionDefinition::VariableScope::add(Reference<Variable> variable)
 {
     variables_as_list_.emplace_back(variable.get());
-    variables_[variable->name()][int(variable->annotation())] = std::move(variable);
+    ast::Atom name = variable->atom();
+    variables_[name][int(variable->annotation())] = std::move(variable);
 }
 
-Reference<Variable> FunctionDefinition::VariableScope::lookup(const std::string& name,
+Reference<Variable> FunctionDefinition::VariableScope::lookup(ast::Atom name,
                                                               Variable::Annotation annotation) const
 {
     auto it = variables_.find(name);
@@ -584,6 +699,19 @@ const FunctionDefinition::VariableScope& FunctionDefinition::variables() const
     return variables_;
 }
 
+const Variable* FunctionDefinition::argumentVariable(std::size_t index) const
+{
+    const Argument& argument = arguments_[index];
+    for (const Variable* variable : variables_.list())
+    {
+        if (variable->name() == argument.name && variable->type() == argument.type)
+        {
+            return variable;
+        }
+    }
+    return nullptr;
+}
+
 UDTDefinition::UDTDefinition(SourceLocation* location) : Node(location)
 {
 }
@@ -598,6 +726,11 @@ const FunctionDefinition& Program::mainFunction() const
     return mainFunction_;
 }
 
+FunctionDefinition& Program::mainFunction()
+{
+    return mainFunction_;
+}
+
 const PtrVector<FunctionDefinition>& Program::functions() const
 {
     return functions_;
@@ -1,8 +1,93 @@
 #include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/ast/Statement.hpp"
 #include "semantic/ASTConverter.hpp"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace odb::ir {
 Ptr<Program> runSemanticChecks(const ast::Block* ast, const cmd::CommandIndex& cmdIndex) {
     return ASTConverter(cmdIndex).generateProgram(ast);
 }
+
+struct SemanticCheckPipelineData
+{
+    explicit SemanticCheckPipelineData(const cmd::CommandIndex& cmdIndex) : converter(cmdIndex) {}
+
+    // Only ever used by the converting thread
+    ASTConverter converter;
+
+    std::mutex mutex;
+    std::condition_variable statementsAvailable;
+    std::deque<Reference<ast::Statement>> statements;
+    bool endOfInput = false;
+    bool cancelled = false;
+
+    std::thread thread;
+};
+
+static void convertStatements(SemanticCheckPipelineData* data)
+{
+    std::unique_lock<std::mutex> lock(data->mutex);
+    while (true)
+    {
+        data->statementsAvailable.wait(
+            lock, [data] { return data->cancelled || data->endOfInput || !data->statements.empty(); });
+        if (data->cancelled || data->statements.empty())
+        {
+            return;
+        }
+
+        // Nothing else refers to the statement, so it's freed as soon as the
+        // converter is done with it
+        Reference<ast::Statement> statement = std::move(data->statements.front());
+        data->statements.pop_front();
+        lock.unlock();
+        data->converter.addStatement(statement);
+        statement.reset();
+        lock.lock();
+    }
+}
+
+SemanticCheckPipeline::SemanticCheckPipeline(const cmd::CommandIndex& cmdIndex)
+    : data_(std::make_unique<SemanticCheckPipelineData>(cmdIndex))
+{
+    data_->thread = std::thread(convertStatements, data_.get());
+}
+
+SemanticCheckPipeline::~SemanticCheckPipeline()
+{
+    if (data_->thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(data_->mutex);
+            data_->cancelled = true;
+        }
+        data_->statementsAvailable.notify_one();
+        data_->thread.join();
+    }
+}
+
+void SemanticCheckPipeline::consumeStatement(ast::Statement* statement)
+{
+    {
+        std::lock_guard<std::mutex> lock(data_->mutex);
+        data_->statements.emplace_back(statement);
+    }
+    data_->statementsAvailable.notify_one();
+}
+
+Ptr<Program> SemanticCheckPipeline::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(data_->mutex);
+        data_->endOfInput = true;
+    }
+    data_->statementsAvailable.notify_one();
+    data_->thread.join();
+
+    return data_->converter.finishProgram();
+}
 }
@@ -0,0 +1,754 @@
+#include "BytecodeGenerator.hpp"
+
+#include "../interpreter/CommandCall.hpp"
+
+#include "odb-sdk/Log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace odb::ir {
+namespace {
+bool isScalarOrString(const Type& type)
+{
+    if (!type.isBuiltinType())
+    {
+        return false;
+    }
+    BuiltinType builtin = *type.getBuiltinType();
+    return isIntegralType(builtin) || isFloatingPointType(builtin) || builtin == BuiltinType::String;
+}
+
+bool isNumericType(BuiltinType type)
+{
+    return type != BuiltinType::Boolean && (isIntegralType(type) || isFloatingPointType(type));
+}
+
+// Whether the VM implements a typed opcode for the given type.
+bool isSupportedOperandType(BytecodeOp op, BuiltinType type)
+{
+    switch (op)
+    {
+    case BytecodeOp::Negate:
+    case BytecodeOp::Add:
+    case BytecodeOp::Sub:
+    case BytecodeOp::Mul:
+    case BytecodeOp::Div:
+    case BytecodeOp::Mod:
+    case BytecodeOp::Pow:
+    case BytecodeOp::ForLoopCondition:
+        return isNumericType(type);
+    case BytecodeOp::BitwiseNot:
+    case BytecodeOp::ShiftLeft:
+    case BytecodeOp::ShiftRight:
+    case BytecodeOp::BitwiseOr:
+    case BytecodeOp::BitwiseAnd:
+    case BytecodeOp::BitwiseXor:
+        return type != BuiltinType::Boolean && isIntegralType(type);
+    case BytecodeOp::LogicalNot:
+        return type == BuiltinType::Boolean;
+    case BytecodeOp::Cast:
+    case BytecodeOp::Less:
+    case BytecodeOp::LessEqual:
+    case BytecodeOp::Greater:
+    case BytecodeOp::GreaterEqual:
+    case BytecodeOp::Equal:
+    case BytecodeOp::NotEqual:
+    case BytecodeOp::LogicalOr:
+    case BytecodeOp::LogicalAnd:
+    case BytecodeOp::LogicalXor:
+        return isIntegralType(type) || isFloatingPointType(type);
+    default:
+        return true;
+    }
+}
+
+BytecodeOp convertBinaryOp(BinaryOp op)
+{
+    switch (op)
+    {
+    case BinaryOp::ADD:
+        return BytecodeOp::Add;
+    case BinaryOp::SUB:
+        return BytecodeOp::Sub;
+    case BinaryOp::MUL:
+        return BytecodeOp::Mul;
+    case BinaryOp::DIV:
+        return BytecodeOp::Div;
+    case BinaryOp::MOD:
+        return BytecodeOp::Mod;
+    case BinaryOp::POW:
+        return BytecodeOp::Pow;
+    case BinaryOp::SHIFT_LEFT:
+        return BytecodeOp::ShiftLeft;
+    case BinaryOp::SHIFT_RIGHT:
+        return BytecodeOp::ShiftRight;
+    case BinaryOp::BITWISE_OR:
+        return BytecodeOp::BitwiseOr;
+    case BinaryOp::BITWISE_AND:
+        return BytecodeOp::BitwiseAnd;
+    case BinaryOp::BITWISE_XOR:
+        return BytecodeOp::BitwiseXor;
+    case BinaryOp::BITWISE_NOT:
+        return BytecodeOp::BitwiseNot;
+    case BinaryOp::LESS_THAN:
+        return BytecodeOp::Less;
+    case BinaryOp::LESS_EQUAL:
+        return BytecodeOp::LessEqual;
+    case BinaryOp::GREATER_THAN:
+        return BytecodeOp::Greater;
+    case BinaryOp::GREATER_EQUAL:
+        return BytecodeOp::GreaterEqual;
+    case BinaryOp::EQUAL:
+        return BytecodeOp::Equal;
+    case BinaryOp::NOT_EQUAL:
+        return BytecodeOp::NotEqual;
+    case BinaryOp::LOGICAL_OR:
+        return BytecodeOp::LogicalOr;
+    case BinaryOp::LOGICAL_AND:
+        return BytecodeOp::LogicalAnd;
+    case BinaryOp::LOGICAL_XOR:
+        return BytecodeOp::LogicalXor;
+    }
+    return BytecodeOp::Return;
+}
+
+// Constants are stored in the first bytes of the 64-bit field, which is the
+// same layout the VM uses for its registers.
+template <typename T> std::uint64_t constantBits(T value)
+{
+    static_assert(sizeof(T) <= sizeof(std::uint64_t));
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+} // namespace
+
+class BytecodeGenerator::FunctionTranslator
+{
+public:
+    FunctionTranslator(BytecodeGenerator& generator, FlatIndex functionIndex, BytecodeFunction& function)
+        : generator_(generator), functionIndex_(functionIndex),
+          definition_(generator.program_->functions[functionIndex]), function_(function),
+          expressions_(definition_.expressions), statements_(definition_.statements),
+          labels_(statements_.size(), -1)
+    {
+    }
+
+    bool translate()
+    {
+        function_.name = definition_.name;
+        // Every variable is bound to the register with the same index.
+        for (FlatIndex variable = 0; variable < definition_.variableTypes.size(); ++variable)
+        {
+            const Type& type = definition_.variableTypes[variable];
+            if (!isScalarOrString(type))
+            {
+                return unsupported(definition_.variableLocations[variable], "a variable of this type");
+            }
+            if (*type.getBuiltinType() == BuiltinType::String)
+            {
+                function_.stringRegisters.push_back(std::int32_t(variable));
+            }
+        }
+        for (std::size_t i = 0; i < definition_.argumentTypes.size(); ++i)
+        {
+            if (!isScalarOrString(definition_.argumentTypes[i]))
+            {
+                return unsupported(definition_.location, "an argument of this type");
+            }
+            FlatIndex variable = definition_.argumentVariables[i];
+            function_.argumentRegisters.push_back(variable == noFlatIndex ? -1 : std::int32_t(variable));
+        }
+        if (definition_.returnExpression != noFlatIndex)
+        {
+            const Type& returnType = expressions_.types[definition_.returnExpression];
+            function_.returnsString =
+                returnType.isBuiltinType() && *returnType.getBuiltinType() == BuiltinType::String;
+        }
+        firstTemporary_ = std::int32_t(definition_.variableTypes.size());
+        function_.registerCount = firstTemporary_;
+
+        if (!translateBlock(definition_.body))
+        {
+            return false;
+        }
+
+        nextTemporary_ = firstTemporary_;
+        if (definition_.returnExpression != noFlatIndex)
+        {
+            // CodeGenerator declares every function as returning void.
+            generator_.module_.canCompile = false;
+
+            std::int32_t result = translateExpression(definition_.returnExpression);
+            if (result < 0)
+            {
+                return false;
+            }
+            emit(BytecodeOp::ReturnValue, 0, result);
+        }
+        else
+        {
+            emit(BytecodeOp::Return);
+        }
+
+        for (const auto& [instruction, statement] : labelFixups_)
+        {
+            FlatIndex label = statements_.a[statement];
+            if (label == noFlatIndex || labels_[label] < 0)
+            {
+                return unsupported(statements_.locations[statement], "a jump to a label in a different function");
+            }
+            function_.code[instruction].target = labels_[label];
+        }
+
+        return true;
+    }
+
+private:
+    std::int32_t here() const { return std::int32_t(function_.code.size()); }
+
+    std::int32_t emit(BytecodeOp op, std::int32_t dst = 0, std::int32_t a = 0, std::int32_t b = 0)
+    {
+        BytecodeInstruction& instruction = function_.code.emplace_back();
+        instruction.op = op;
+        instruction.dst = dst;
+        instruction.a = a;
+        instruction.b = b;
+        return here() - 1;
+    }
+
+    // Returns -1 if the VM doesn't implement the opcode for this type.
+    std::int32_t emitTyped(BytecodeOp op, BuiltinType type, std::int32_t dst, std::int32_t a = 0, std::int32_t b = 0)
+    {
+        if (!isSupportedOperandType(op, type))
+        {
+            return -1;
+        }
+        std::int32_t instruction = emit(op, dst, a, b);
+        function_.code[instruction].type = type;
+        return instruction;
+    }
+
+    std::int32_t allocateTemporary()
+    {
+        std::int32_t reg = nextTemporary_++;
+        function_.registerCount = std::max(function_.registerCount, nextTemporary_);
+        return reg;
+    }
+
+    bool unsupported(FlatIndex location, const char* what)
+    {
+        Log::codegen(Log::NOTICE, "%s: The bytecode doesn't support %s\n",
+                     location != noFlatIndex
+                         ? generator_.program_->locations[location].c_str()
+                         : definition_.name.c_str(),
+                     what);
+        return false;
+    }
+
+    bool isMainFunction() const { return functionIndex_ == 0; }
+
+    bool translateBlock(FlatIndex block)
+    {
+        for (const FlatIndex* it = definition_.listBegin(block); it != definition_.listEnd(block); ++it)
+        {
+            if (!translateStatement(*it))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void patchLoopExits(FlatIndex loop)
+    {
+        for (std::int32_t instruction : loopExitFixups_[loop])
+        {
+            function_.code[instruction].target = here();
+        }
+    }
+
+    BuiltinType builtinTypeOf(FlatIndex e) const { return *expressions_.types[e].getBuiltinType(); }
+
+    bool translateStatement(FlatIndex s)
+    {
+        // Temporaries never outlive the statement they were allocated for.
+        nextTemporary_ = firstTemporary_;
+
+        switch (statements_.kinds[s])
+        {
+        case StatementKind::Label: {
+            labels_[s] = here();
+            break;
+        }
+        case StatementKind::Goto: {
+            labelFixups_.emplace_back(emit(BytecodeOp::Jump), s);
+            break;
+        }
+        case StatementKind::Gosub: {
+            labelFixups_.emplace_back(emit(BytecodeOp::Gosub), s);
+            break;
+        }
+        case StatementKind::SubReturn: {
+            emit(BytecodeOp::SubReturn);
+            break;
+        }
+        case StatementKind::Conditional: {
+            std::int32_t condition = translateExpression(statements_.a[s]);
+            if (condition < 0)
+            {
+                return false;
+            }
+            std::int32_t jumpToElse = emit(BytecodeOp::JumpIfFalse, 0, condition);
+            if (!translateBlock(statements_.b[s]))
+            {
+                return false;
+            }
+            std::int32_t jumpToEnd = emit(BytecodeOp::Jump);
+            function_.code[jumpToElse].target = here();
+            if (!translateBlock(statements_.c[s]))
+            {
+                return false;
+            }
+            function_.code[jumpToEnd].target = here();
+            break;
+        }
+        case StatementKind::Select: {
+            FlatIndex expression = statements_.a[s];
+            if (!expressions_.types[expression].isBuiltinType() ||
+                !isSupportedOperandType(BytecodeOp::NotEqual, builtinTypeOf(expression)))
+            {
+                return unsupported(statements_.locations[s], "a select on a value of this type");
+            }
+            std::int32_t value = translateExpression(expression);
+            if (value < 0)
+            {
+                return false;
+            }
+
+            // Compare with every case first, then lay out the default case and
+            // the other cases after it.
+            std::int32_t firstCaseTemporary = nextTemporary_;
+            std::vector<std::pair<std::int32_t, FlatIndex>> caseJumps;
+            FlatIndex defaultBlock = noFlatIndex;
+            FlatIndex cases = statements_.b[s];
+            for (const FlatIndex* it = definition_.listBegin(cases); it != definition_.listEnd(cases); it += 2)
+            {
+                if (it[0] == noFlatIndex)
+                {
+                    defaultBlock = defaultBlock == noFlatIndex ? it[1] : defaultBlock;
+                    continue;
+                }
+                nextTemporary_ = firstCaseTemporary;
+                std::int32_t condition = translateExpression(it[0]);
+                if (condition < 0)
+                {
+                    return false;
+                }
+                std::int32_t differs = allocateTemporary();
+                emitTyped(BytecodeOp::NotEqual, builtinTypeOf(expression), differs, value, condition);
+                caseJumps.emplace_back(emit(BytecodeOp::JumpIfFalse, 0, differs), it[1]);
+            }
+
+            std::vector<std::int32_t> jumpsToEnd;
+            if (defaultBlock != noFlatIndex && !translateBlock(defaultBlock))
+            {
+                return false;
+            }
+            jumpsToEnd.push_back(emit(BytecodeOp::Jump));
+            for (const auto& [jump, block] : caseJumps)
+            {
+                function_.code[jump].target = here();
+                if (!translateBlock(block))
+                {
+                    return false;
+                }
+                jumpsToEnd.push_back(emit(BytecodeOp::Jump));
+            }
+            for (std::int32_t jump : jumpsToEnd)
+            {
+                function_.code[jump].target = here();
+            }
+            break;
+        }
+        case StatementKind::Exit: {
+            loopExitFixups_[statements_.a[s]].push_back(emit(BytecodeOp::Jump));
+            break;
+        }
+        case StatementKind::InfiniteLoop: {
+            std::int32_t loopStart = here();
+            if (!translateBlock(statements_.d[s]))
+            {
+                return false;
+            }
+            function_.code[emit(BytecodeOp::BackEdge)].target = loopStart;
+            patchLoopExits(s);
+            break;
+        }
+        case StatementKind::WhileLoop: {
+            std::int32_t loopStart = here();
+            std::int32_t condition = translateExpression(statements_.a[s]);
+            if (condition < 0)
+            {
+                return false;
+            }
+            loopExitFixups_[s].push_back(emit(BytecodeOp::JumpIfFalse, 0, condition));
+            if (!translateBlock(statements_.d[s]))
+            {
+                return false;
+            }
+            function_.code[emit(BytecodeOp::BackEdge)].target = loopStart;
+            patchLoopExits(s);
+            break;
+        }
+        case StatementKind::UntilLoop: {
+            std::int32_t loopStart = here();
+            if (!translateBlock(statements_.d[s]))
+            {
+                return false;
+            }
+            nextTemporary_ = firstTemporary_;
+            std::int32_t condition = translateExpression(statements_.a[s]);
+            if (condition < 0)
+            {
+                return false;
+            }
+            function_.code[emit(BytecodeOp::BackEdgeIfFalse, 0, condition)].target = loopStart;
+            patchLoopExits(s);
+            break;
+        }
+        case StatementKind::ForLoop: {
+            FlatIndex assignment = statements_.a[s];
+            std::int32_t variable = std::int32_t(statements_.a[assignment]);
+            if (translateExpression(statements_.b[assignment], variable) < 0)
+            {
+                return false;
+            }
+
+            BuiltinType type = *definition_.variableTypes[variable].getBuiltinType();
+            if (!isSupportedOperandType(BytecodeOp::ForLoopCondition, type))
+            {
+                return unsupported(statements_.locations[s], "a loop variable of this type");
+            }
+
+            std::int32_t loopStart = here();
+            nextTemporary_ = firstTemporary_;
+            std::int32_t endValue = translateExpression(statements_.b[s]);
+            std::int32_t stepValue = translateExpression(statements_.c[s]);
+            if (endValue < 0 || stepValue < 0)
+            {
+                return false;
+            }
+            loopExitFixups_[s].push_back(emitTyped(BytecodeOp::ForLoopCondition, type, variable, endValue, stepValue));
+
+            if (!translateBlock(statements_.d[s]))
+            {
+                return false;
+            }
+
+            nextTemporary_ = firstTemporary_;
+            stepValue = translateExpression(statements_.c[s]);
+            if (stepValue < 0)
+            {
+                return false;
+            }
+            emitTyped(BytecodeOp::Add, type, variable, variable, stepValue);
+            function_.code[emit(BytecodeOp::BackEdge)].target = loopStart;
+            patchLoopExits(s);
+            break;
+        }
+        case StatementKind::VarAssignment:
+            return translateExpression(statements_.b[s], std::int32_t(statements_.a[s])) >= 0;
+        case StatementKind::FunctionCall: {
+            FlatIndex call = statements_.a[s];
+            if (expressions_.ops[call] == 1 && isMainFunction() &&
+                generator_.program_->commands[expressions_.a[call]].dbSymbol == "end")
+            {
+                emit(BytecodeOp::Return);
+            }
+            else
+            {
+                return translateExpression(call) >= 0;
+            }
+            break;
+        }
+        case StatementKind::ExitFunction: {
+            // CodeGenerator can't return values yet.
+            generator_.module_.canCompile = false;
+
+            if (statements_.a[s] != noFlatIndex)
+            {
+                std::int32_t result = translateExpression(statements_.a[s]);
+                if (result < 0)
+                {
+                    return false;
+                }
+                emit(BytecodeOp::ReturnValue, 0, result);
+            }
+            else
+            {
+                emit(BytecodeOp::Return);
+            }
+            break;
+        }
+        default:
+            return unsupported(statements_.locations[s], "this statement");
+        }
+
+        return true;
+    }
+
+    // Returns the register holding the value of the expression, or -1 on
+    // error. If dst isn't -1, the value is written to dst.
+    std::int32_t translateExpression(FlatIndex e, std::int32_t dst = -1)
+    {
+        auto destination = [&] { return dst >= 0 ? dst : allocateTemporary(); };
+        auto fail = [&](const char* what) {
+            unsupported(expressions_.locations[e], what);
+            return -1;
+        };
+        auto loadValue = [&](auto value) {
+            std::memcpy(&value, definition_.literalData.data() + expressions_.a[e], sizeof(value));
+            std::int32_t reg = destination();
+            function_.code[emit(BytecodeOp::LoadConstant, reg)].constant = constantBits(value);
+            return reg;
+        };
+
+        switch (expressions_.kinds[e])
+        {
+        case ExpressionKind::VarRef: {
+            std::int32_t variable = std::int32_t(expressions_.a[e]);
+            if (dst < 0 || dst == variable)
+            {
+                return variable;
+            }
+            emit(BytecodeOp::Move, dst, variable);
+            return dst;
+        }
+        case ExpressionKind::DoubleIntegerLiteral:
+            return loadValue(std::int64_t());
+        case ExpressionKind::IntegerLiteral:
+            return loadValue(std::int32_t());
+        case ExpressionKind::DwordLiteral:
+            return loadValue(std::uint32_t());
+        case ExpressionKind::WordLiteral:
+            return loadValue(std::uint16_t());
+        case ExpressionKind::ByteLiteral:
+            return loadValue(std::uint8_t());
+        case ExpressionKind::BooleanLiteral:
+            return loadValue(bool());
+        case ExpressionKind::DoubleFloatLiteral:
+            return loadValue(double());
+        case ExpressionKind::FloatLiteral:
+            return loadValue(float());
+        case ExpressionKind::StringLiteral: {
+            std::int32_t reg = destination();
+            function_.code[emit(BytecodeOp::LoadString, reg)].constant =
+                std::uint64_t(generator_.getOrAddString(expressions_.a[e]));
+            return reg;
+        }
+        case ExpressionKind::FunctionCall:
+            return translateCall(e, dst);
+        case ExpressionKind::Cast: {
+            const Type& type = expressions_.types[e];
+            if (!type.isBuiltinType())
+            {
+                return fail("an expression of this type");
+            }
+            FlatIndex operand = expressions_.a[e];
+            const Type& sourceType = expressions_.types[operand];
+            std::int32_t source = translateExpression(operand);
+            if (source < 0 || !sourceType.isBuiltinType())
+            {
+                return -1;
+            }
+            if (sourceType == type)
+            {
+                if (dst < 0 || dst == source)
+                {
+                    return source;
+                }
+                emit(BytecodeOp::Move, dst, source);
+                return dst;
+            }
+
+            if (!isSupportedOperandType(BytecodeOp::Cast, *sourceType.getBuiltinType()))
+            {
+                return fail("this cast");
+            }
+            std::int32_t result = destination();
+            std::int32_t instruction = emitTyped(BytecodeOp::Cast, *type.getBuiltinType(), result, source);
+            if (instruction < 0)
+            {
+                return fail("this cast");
+            }
+            function_.code[instruction].sourceType = *sourceType.getBuiltinType();
+            return result;
+        }
+        case ExpressionKind::Unary: {
+            if (!expressions_.types[e].isBuiltinType())
+            {
+                return fail("an expression of this type");
+            }
+            std::int32_t operand = translateExpression(expressions_.a[e]);
+            if (operand < 0)
+            {
+                return -1;
+            }
+
+            BytecodeOp op = BytecodeOp::Negate;
+            switch (UnaryOp(expressions_.ops[e]))
+            {
+            case UnaryOp::NEGATE:
+                op = BytecodeOp::Negate;
+                break;
+            case UnaryOp::BITWISE_NOT:
+                generator_.module_.canCompile = false;
+                op = BytecodeOp::BitwiseNot;
+                break;
+            case UnaryOp::LOGICAL_NOT:
+                generator_.module_.canCompile = false;
+                op = BytecodeOp::LogicalNot;
+                break;
+            }
+            std::int32_t result = destination();
+            if (emitTyped(op, builtinTypeOf(e), result, operand) < 0)
+            {
+                return fail("this unary operator");
+            }
+            return result;
+        }
+        case ExpressionKind::Binary: {
+            if (!expressions_.types[e].isBuiltinType())
+            {
+                return fail("an expression of this type");
+            }
+            std::int32_t left = translateExpression(expressions_.a[e]);
+            std::int32_t right = translateExpression(expressions_.b[e]);
+            if (left < 0 || right < 0 || !expressions_.types[expressions_.a[e]].isBuiltinType())
+            {
+                return -1;
+            }
+
+            BuiltinType builtin = builtinTypeOf(expressions_.a[e]);
+            BytecodeOp op = convertBinaryOp(BinaryOp(expressions_.ops[e]));
+
+            // CodeGenerator only lowers floating point operators other than
+            // addition for 32-bit floats, and logical operators for integers.
+            bool isLogical = op == BytecodeOp::LogicalOr || op == BytecodeOp::LogicalAnd || op == BytecodeOp::LogicalXor;
+            if (op == BytecodeOp::Pow || (builtin == BuiltinType::DoubleFloat && op != BytecodeOp::Add) ||
+                (isLogical && isFloatingPointType(builtin)))
+            {
+                generator_.module_.canCompile = false;
+            }
+
+            std::int32_t result = destination();
+            if (emitTyped(op, builtin, result, left, right) < 0)
+            {
+                return fail("this binary operator with operands of this type");
+            }
+            return result;
+        }
+        default:
+            break;
+        }
+
+        return fail("this expression");
+    }
+
+    std::int32_t translateCall(FlatIndex call, std::int32_t dst)
+    {
+        BytecodeCallSite site;
+        BytecodeOp op = BytecodeOp::CallFunction;
+        if (expressions_.ops[call] == 0)
+        {
+            site.callee = std::int32_t(expressions_.a[call]);
+        }
+        else
+        {
+            const FlatCommand& command = generator_.program_->commands[expressions_.a[call]];
+            if (!getCommandInvoker(command.returnType, command.argumentTypes))
+            {
+                unsupported(expressions_.locations[call], "calling this command");
+                return -1;
+            }
+            site.callee = generator_.getOrAddCommand(expressions_.a[call]);
+            op = BytecodeOp::CallCommand;
+        }
+
+        FlatIndex arguments = expressions_.b[call];
+        for (const FlatIndex* it = definition_.listBegin(arguments); it != definition_.listEnd(arguments); ++it)
+        {
+            std::int32_t reg = translateExpression(*it);
+            if (reg < 0)
+            {
+                return -1;
+            }
+            site.argumentRegisters.push_back(reg);
+        }
+
+        std::int32_t result = dst >= 0 ? dst : allocateTemporary();
+        function_.code[emit(op, result)].target = std::int32_t(function_.callSites.size());
+        function_.callSites.push_back(std::move(site));
+        return result;
+    }
+
+    BytecodeGenerator& generator_;
+    FlatIndex functionIndex_;
+    const FlatFunction& definition_;
+    BytecodeFunction& function_;
+    const FlatExpressionPool& expressions_;
+    const FlatStatementPool& statements_;
+
+    std::int32_t firstTemporary_ = 0;
+    std::int32_t nextTemporary_ = 0;
+
+    // Instruction each label statement starts at, or -1.
+    std::vector<std::int32_t> labels_;
+    std::vector<std::pair<std::int32_t, FlatIndex>> labelFixups_;
+    std::unordered_map<FlatIndex, std::vector<std::int32_t>> loopExitFixups_;
+};
+
+bool BytecodeGenerator::generateModule(const FlatProgram& program)
+{
+    program_ = &program;
+    module_.canCompile = true;
+    commandIndices_.assign(program.commands.size(), -1);
+    stringIndices_.assign(program.strings.size(), -1);
+
+    module_.functions.resize(program.functions.size());
+    for (std::size_t i = 0; i < program.functions.size(); ++i)
+    {
+        if (!FunctionTranslator(*this, FlatIndex(i), module_.functions[i]).translate())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::int32_t BytecodeGenerator::getOrAddCommand(FlatIndex command)
+{
+    if (commandIndices_[command] >= 0)
+    {
+        return commandIndices_[command];
+    }
+
+    module_.commands.push_back(program_->commands[command]);
+    commandIndices_[command] = std::int32_t(module_.commands.size() - 1);
+    return commandIndices_[command];
+}
+
+std::int32_t BytecodeGenerator::getOrAddString(FlatIndex string)
+{
+    if (stringIndices_[string] < 0)
+    {
+        stringIndices_[string] = std::int32_t(module_.strings.size());
+        module_.strings.push_back(program_->strings[string]);
+    }
+    return stringIndices_[string];
+}
+} // namespace odb::ir
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "odb-compiler/ir/Bytecode.hpp"
+#include "odb-compiler/ir/FlatIR.hpp"
+
+#include <vector>
+
+namespace odb::ir {
+class BytecodeGenerator
+{
+public:
+    explicit BytecodeGenerator(BytecodeModule& module) : module_(module) {}
+
+    bool generateModule(const FlatProgram& program);
+
+private:
+    class FunctionTranslator;
+
+    std::int32_t getOrAddCommand(FlatIndex command);
+    std::int32_t getOrAddString(FlatIndex string);
+
+    BytecodeModule& module_;
+    const FlatProgram* program_ = nullptr;
+
+    // Module index of each command and string of the program, or -1 if it
+    // isn't used by the module yet.
+    std::vector<std::int32_t> commandIndices_;
+    std::vector<std::int32_t> stringIndices_;
+};
+} // namespace odb::ir
@@ -1,7 +1,106 @@
 #include "CodeGenerator.hpp"
 
+#include "odb-compiler/ir/AssignmentAnalysis.hpp"
+#include "odb-compiler/ir/GosubAnalysis.hpp"
+#include "odb-compiler/Trace.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
 namespace odb::ir {
 namespace {
+// Gosub stacks that may need more entries are allocated on the heap, so they
+// don't bloat the stack frame.
+constexpr std::uint32_t MaxStaticGosubDepth = 64;
+
+// Whether the expression evaluates to the same value as long as none of the
+// variables change. Function calls may have side effects, so they never are.
+bool isInvariant(const Expression* e, const std::unordered_set<const Variable*>& assignedVariables)
+{
+    switch (e->kind())
+    {
+    case ExpressionKind::Cast:
+        return isInvariant(static_cast<const CastExpression*>(e)->expression(), assignedVariables);
+    case ExpressionKind::Unary:
+        return isInvariant(static_cast<const UnaryExpression*>(e)->expression(), assignedVariables);
+    case ExpressionKind::Binary:
+    {
+        auto* binary = static_cast<const BinaryExpression*>(e);
+        return isInvariant(binary->left(), assignedVariables) && isInvariant(binary->right(), assignedVariables);
+    }
+    case ExpressionKind::VarRef:
+        return assignedVariables.count(static_cast<const VarRefExpression*>(e)->variable()) == 0;
+    case ExpressionKind::FunctionCall:
+        return false;
+    default:
+        // Literals
+        return true;
+    }
+}
+
+// Whether the expression is made of literals only, so it generates a constant.
+bool isConstantExpression(const Expression* e)
+{
+    switch (e->kind())
+    {
+    case ExpressionKind::Cast:
+        return isConstantExpression(static_cast<const CastExpression*>(e)->expression());
+    case ExpressionKind::Unary:
+        return isConstantExpression(static_cast<const UnaryExpression*>(e)->expression());
+    case ExpressionKind::Binary:
+    {
+        auto* binary = static_cast<const BinaryExpression*>(e);
+        return isConstantExpression(binary->left()) && isConstantExpression(binary->right());
+    }
+    case ExpressionKind::VarRef:
+    case ExpressionKind::FunctionCall:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// 32-bit FNV-1a, the same hash the function from getOrCreateStringHashFunction()
+// computes at runtime.
+std::uint32_t hashString(const std::string& str)
+{
+    std::uint32_t hash = 2166136261u;
+    for (char c : str)
+    {
+        hash ^= std::uint8_t(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Returns the predicate that compares values of the type like the interpreter
+// does: unsigned for unsigned types, and ordered for floating point types, so a
+// NaN step or end value ends the loop.
+llvm::CmpInst::Predicate getComparePredicate(BuiltinType type, llvm::CmpInst::Predicate signedPredicate)
+{
+    if (isFloatingPointType(type))
+    {
+        switch (signedPredicate)
+        {
+        case llvm::CmpInst::Predicate::ICMP_SGT:
+            return llvm::CmpInst::Predicate::FCMP_OGT;
+        case llvm::CmpInst::Predicate::ICMP_SGE:
+            return llvm::CmpInst::Predicate::FCMP_OGE;
+        case llvm::CmpInst::Predicate::ICMP_SLT:
+            return llvm::CmpInst::Predicate::FCMP_OLT;
+        case llvm::CmpInst::Predicate::ICMP_SLE:
+            return llvm::CmpInst::Predicate::FCMP_OLE;
+        default:
+            return llvm::CmpInst::Predicate::FCMP_FALSE;
+        }
+    }
+    if (isUnsignedType(type))
+    {
+        return llvm::ICmpInst::getUnsignedPredicate(signedPredicate);
+    }
+    return signedPredicate;
+}
+
 llvm::Type* getLLVMType(llvm::LLVMContext& ctx, cmd::Command::Type type)
 {
     switch (type)
@@ -198,8 +297,11 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
 
 llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuilder<>& builder, const Expression* e)
 {
-    if (auto* cast = dynamic_cast<const CastExpression*>(e))
+    switch (e->kind())
     {
+    case ExpressionKind::Cast:
+    {
+        auto* cast = static_cast<const CastExpression*>(e);
         llvm::Type* expressionType = getLLVMType(ctx, cast->expression()->getType());
         llvm::Type* targetType = getLLVMType(ctx, cast->targetType());
 
@@ -210,10 +312,30 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
             return innerExpression;
         }
 
+        // Casts convert values the same way the interpreter does, so unsigned
+        // types are zero extended and anything that isn't zero becomes true.
+        auto sourceBuiltinType = cast->expression()->getType().getBuiltinType();
+        auto targetBuiltinType = cast->targetType().getBuiltinType();
+        bool sourceIsUnsigned = sourceBuiltinType && isUnsignedType(*sourceBuiltinType);
+        bool targetIsUnsigned = targetBuiltinType && isUnsignedType(*targetBuiltinType);
+
+        // -> bool casts.
+        if (targetBuiltinType == BuiltinType::Boolean)
+        {
+            if (expressionType->isIntegerTy())
+            {
+                return builder.CreateICmpNE(innerExpression, llvm::Constant::getNullValue(expressionType));
+            }
+            if (expressionType->isFloatingPointTy())
+            {
+                return builder.CreateFCmpUNE(innerExpression, llvm::Constant::getNullValue(expressionType));
+            }
+        }
+
         // int -> int casts.
         if (expressionType->isIntegerTy() && targetType->isIntegerTy())
         {
-            return builder.CreateIntCast(innerExpression, targetType, true);
+            return builder.CreateIntCast(innerExpression, targetType, !sourceIsUnsigned);
         }
 
         // fp -> fp casts.
@@ -225,12 +347,20 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
         // int -> fp casts.
         if (expressionType->isIntegerTy() && targetType->isFloatingPointTy())
         {
+            if (sourceIsUnsigned)
+            {
+                return builder.CreateUIToFP(innerExpression, targetType);
+            }
             return builder.CreateSIToFP(innerExpression, targetType);
         }
 
         // fp -> int casts.
         if (expressionType->isFloatingPointTy() && targetType->isIntegerTy())
         {
+            if (targetIsUnsigned)
+            {
+                return builder.CreateFPToUI(innerExpression, targetType);
+            }
             return builder.CreateFPToSI(innerExpression, targetType);
         }
 
@@ -245,8 +375,9 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
                      targetTypeStr.c_str());
         return nullptr;
     }
-    else if (auto* unary = dynamic_cast<const UnaryExpression*>(e))
+    case ExpressionKind::Unary:
     {
+        auto* unary = static_cast<const UnaryExpression*>(e);
         llvm::Value* inner = generateExpression(symtab, builder, unary->expression());
         switch (unary->op())
         {
@@ -269,13 +400,19 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
             return nullptr;
         }
     }
-    else if (auto* binary = dynamic_cast<const BinaryExpression*>(e))
+    case ExpressionKind::Binary:
     {
+        auto* binary = static_cast<const BinaryExpression*>(e);
         llvm::Value* left = generateExpression(symtab, builder, binary->left());
         llvm::Value* right = generateExpression(symtab, builder, binary->right());
         assert(binary->left()->getType() == binary->right()->getType() &&
                "Binary expression should have matching types.");
 
+        // Dword, Word and Byte are unsigned, like in the interpreter and when
+        // folding constants.
+        auto builtinType = binary->left()->getType().getBuiltinType();
+        bool isUnsigned = builtinType && isUnsignedType(*builtinType);
+
         switch (binary->op())
         {
         case BinaryOp::ADD:
@@ -303,7 +440,7 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
             {
                 return builder.CreateSub(left, right);
             }
-            else if (left->getType()->isFloatTy())
+            else if (left->getType()->isFloatingPointTy())
             {
                 return builder.CreateFSub(left, right);
             }
@@ -317,7 +454,7 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
             {
                 return builder.CreateMul(left, right);
             }
-            else if (left->getType()->isFloatTy())
+            else if (left->getType()->isFloatingPointTy())
             {
                 return builder.CreateFMul(left, right);
             }
@@ -329,9 +466,13 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
         case BinaryOp::DIV:
             if (left->getType()->isIntegerTy())
             {
+                if (isUnsigned)
+                {
+                    return builder.CreateUDiv(left, right);
+                }
                 return builder.CreateSDiv(left, right);
             }
-            else if (left->getType()->isFloatTy())
+            else if (left->getType()->isFloatingPointTy())
             {
                 return builder.CreateFDiv(left, right);
             }
@@ -343,9 +484,13 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
         case BinaryOp::MOD:
             if (left->getType()->isIntegerTy())
             {
+                if (isUnsigned)
+                {
+                    return builder.CreateURem(left, right);
+                }
                 return builder.CreateSRem(left, right);
             }
-            else if (left->getType()->isFloatTy())
+            else if (left->getType()->isFloatingPointTy())
             {
                 return builder.CreateFRem(left, right);
             }
@@ -355,19 +500,49 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
                 return nullptr;
             }
         case BinaryOp::POW:
-            // TODO: implement
-            Log::codegen(Log::Severity::FATAL, "Pow binary op unimplemented.");
-            return nullptr;
+            if (left->getType()->isIntegerTy())
+            {
+                // Integers are raised to the power in double precision, like
+                // in the interpreter.
+                llvm::Type* doubleTy = builder.getDoubleTy();
+                auto toDouble = [&](llvm::Value* value) {
+                    return isUnsigned ? builder.CreateUIToFP(value, doubleTy) : builder.CreateSIToFP(value, doubleTy);
+                };
+                llvm::Value* result =
+                    builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, toDouble(left), toDouble(right));
+                if (isUnsigned)
+                {
+                    return builder.CreateFPToUI(result, left->getType());
+                }
+                return builder.CreateFPToSI(result, left->getType());
+            }
+            else if (left->getType()->isFloatingPointTy())
+            {
+                return builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, left, right);
+            }
+            else
+            {
+                Log::codegen(Log::Severity::FATAL, "Unknown type in pow binary op.");
+                return nullptr;
+            }
         case BinaryOp::SHIFT_LEFT:
-            assert(left->getType()->isIntegerTy());
-            assert(right->getType()->isIntegerTy());
-            return builder.CreateShl(left, right);
         case BinaryOp::SHIFT_RIGHT:
-            // TODO: Arithmetic shift right (sign extension), or logical shift right (zero
-            // bits)?
+        {
             assert(left->getType()->isIntegerTy());
             assert(right->getType()->isIntegerTy());
-            return builder.CreateAShr(left, right);
+            // The shift amount wraps around at the width of the type, like in
+            // the interpreter, instead of producing a poison value.
+            llvm::Value* amount = builder.CreateAnd(right, left->getType()->getIntegerBitWidth() - 1);
+            if (binary->op() == BinaryOp::SHIFT_LEFT)
+            {
+                return builder.CreateShl(left, amount);
+            }
+            if (isUnsigned)
+            {
+                return builder.CreateLShr(left, amount);
+            }
+            return builder.CreateAShr(left, amount);
+        }
         case BinaryOp::BITWISE_OR:
             assert(left->getType()->isIntegerTy());
             assert(right->getType()->isIntegerTy());
@@ -417,9 +592,13 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
                     Log::codegen(Log::Severity::FATAL, "Unknown binary op.");
                     return nullptr;
                 }
+                if (isUnsigned)
+                {
+                    cmpPredicate = llvm::ICmpInst::getUnsignedPredicate(cmpPredicate);
+                }
                 return builder.CreateICmp(cmpPredicate, left, right);
             }
-            else if (left->getType()->isFloatTy())
+            else if (left->getType()->isFloatingPointTy())
             {
                 llvm::CmpInst::Predicate cmpPredicate;
                 switch (binary->op())
@@ -468,49 +647,60 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
             return nullptr;
         }
     }
-    else if (auto* varRef = dynamic_cast<const VarRefExpression*>(e))
+    case ExpressionKind::VarRef:
     {
+        auto* varRef = static_cast<const VarRefExpression*>(e);
         llvm::Value* variableInst = symtab.getVar(varRef->variable());
         return builder.CreateLoad(variableInst, "");
     }
-    else if (auto* doubleIntegerLiteral = dynamic_cast<const DoubleIntegerLiteral*>(e))
+    case ExpressionKind::DoubleIntegerLiteral:
     {
+        auto* doubleIntegerLiteral = static_cast<const DoubleIntegerLiteral*>(e);
         return llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), std::uint64_t(doubleIntegerLiteral->value()));
     }
-    else if (auto* integerLiteral = dynamic_cast<const IntegerLiteral*>(e))
+    case ExpressionKind::IntegerLiteral:
     {
+        auto* integerLiteral = static_cast<const IntegerLiteral*>(e);
         return llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), std::uint64_t(integerLiteral->value()));
     }
-    else if (auto* dwordLiteral = dynamic_cast<const DwordLiteral*>(e))
+    case ExpressionKind::DwordLiteral:
     {
+        auto* dwordLiteral = static_cast<const DwordLiteral*>(e);
         return llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), std::uint64_t(dwordLiteral->value()));
     }
-    else if (auto* wordLiteral = dynamic_cast<const WordLiteral*>(e))
+    case ExpressionKind::WordLiteral:
     {
+        auto* wordLiteral = static_cast<const WordLiteral*>(e);
         return llvm::ConstantInt::get(llvm::Type::getInt16Ty(ctx), std::uint64_t(wordLiteral->value()));
     }
-    else if (auto* byteLiteral = dynamic_cast<const ByteLiteral*>(e))
+    case ExpressionKind::ByteLiteral:
     {
+        auto* byteLiteral = static_cast<const ByteLiteral*>(e);
         return llvm::ConstantInt::get(llvm::Type::getInt8Ty(ctx), std::uint64_t(byteLiteral->value()));
     }
-    else if (auto* booleanLiteral = dynamic_cast<const BooleanLiteral*>(e))
+    case ExpressionKind::BooleanLiteral:
     {
+        auto* booleanLiteral = static_cast<const BooleanLiteral*>(e);
         return llvm::ConstantInt::get(llvm::Type::getInt1Ty(ctx), booleanLiteral->value() ? 1 : 0);
     }
-    else if (auto* doubleFloatLiteral = dynamic_cast<const DoubleFloatLiteral*>(e))
+    case ExpressionKind::DoubleFloatLiteral:
     {
+        auto* doubleFloatLiteral = static_cast<const DoubleFloatLiteral*>(e);
         return llvm::ConstantFP::get(llvm::Type::getDoubleTy(ctx), llvm::APFloat(doubleFloatLiteral->value()));
     }
-    else if (auto* floatLiteral = dynamic_cast<const FloatLiteral*>(e))
+    case ExpressionKind::FloatLiteral:
     {
+        auto* floatLiteral = static_cast<const FloatLiteral*>(e);
         return llvm::ConstantFP::get(llvm::Type::getFloatTy(ctx), llvm::APFloat(floatLiteral->value()));
     }
-    else if (auto* stringLiteral = dynamic_cast<const StringLiteral*>(e))
+    case ExpressionKind::StringLiteral:
     {
+        auto* stringLiteral = static_cast<const StringLiteral*>(e);
         return builder.CreateBitCast(symtab.getOrAddStrLiteral(stringLiteral->value()), llvm::Type::getInt8PtrTy(ctx));
     }
-    else if (auto* call = dynamic_cast<const FunctionCallExpression*>(e))
+    case ExpressionKind::FunctionCall:
     {
+        auto* call = static_cast<const FunctionCallExpression*>(e);
         llvm::Function* func = nullptr;
         if (call->isUserFunction())
         {
@@ -528,11 +718,12 @@ llvm::Value* CodeGenerator::generateExpression(SymbolTable& symtab, llvm::IRBuil
         }
         return builder.CreateCall(func, args);
     }
-    else
-    {
-        Log::codegen(Log::Severity::FATAL, "Unimplemented expression type.");
-        return nullptr;
+    default:
+        break;
     }
+
+    Log::codegen(Log::Severity::FATAL, "Unimplemented expression type.");
+    return nullptr;
 }
 
 llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicBlock* initialBlock,
@@ -547,8 +738,11 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
     for (const auto& statementPtr : statements)
     {
         Statement* s = statementPtr.get();
-        if (auto* label = dynamic_cast<const Label*>(s))
+        switch (s->kind())
+        {
+        case StatementKind::Label:
         {
+            auto* label = static_cast<const Label*>(s);
             auto* labelBlock = symtab.getOrAddLabelBlock(label);
 
             // Insert the label block into the function.
@@ -557,28 +751,43 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
             // Create a branch, then continue in the label block.
             builder.CreateBr(labelBlock);
             builder.SetInsertPoint(labelBlock);
+            break;
         }
-        else if (auto* goto_ = dynamic_cast<const Goto*>(s))
+        case StatementKind::Goto:
         {
+            auto* goto_ = static_cast<const Goto*>(s);
             printString(builder, builder.CreateGlobalStringPtr("Jumping to " + goto_->label()->name()));
             builder.CreateBr(symtab.getOrAddLabelBlock(goto_->label()));
             builder.SetInsertPoint(llvm::BasicBlock::Create(ctx, "deadStatementsAfterGoto", parent));
+            break;
         }
-        else if (auto* gosub_ = dynamic_cast<const Gosub*>(s))
+        case StatementKind::Gosub:
         {
+            auto* gosub_ = static_cast<const Gosub*>(s);
             auto* labelBlock = symtab.getOrAddLabelBlock(gosub_->label());
             auto* continuationBlock = llvm::BasicBlock::Create(ctx, "return_gosub_" + gosub_->label()->name(), parent);
 
             symtab.addGosubReturnPoint(continuationBlock);
-            builder.CreateCall(gosubPushAddress, {symtab.gosubStack, symtab.gosubStackPointer,
-                                                  llvm::BlockAddress::get(continuationBlock)});
+            if (symtab.gosubStackCapacity)
+            {
+                builder.CreateCall(gosubPushAddressGrowable,
+                                   {symtab.gosubStack, symtab.gosubStackCapacity, symtab.gosubStackPointer,
+                                    llvm::BlockAddress::get(continuationBlock)});
+            }
+            else
+            {
+                builder.CreateCall(gosubPushAddress, {symtab.gosubStack, symtab.gosubStackPointer,
+                                                      llvm::BlockAddress::get(continuationBlock)});
+            }
             printString(builder,
                         builder.CreateGlobalStringPtr("Pushed address. Jumping to " + gosub_->label()->name()));
             builder.CreateBr(labelBlock);
             builder.SetInsertPoint(continuationBlock);
+            break;
         }
-        else if (auto* branch = dynamic_cast<const Conditional*>(s))
+        case StatementKind::Conditional:
         {
+            auto* branch = static_cast<const Conditional*>(s);
             // Generate true and false branches.
             llvm::BasicBlock* trueBlock = llvm::BasicBlock::Create(ctx, "if", parent);
             llvm::BasicBlock* trueBlockEnd = generateBlock(symtab, trueBlock, branch->trueBranch());
@@ -597,12 +806,11 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
 
             // Set continue branch as the insertion point for future instructions.
             builder.SetInsertPoint(continueBlock);
+            break;
         }
-        //        else if (auto* select = dynamic_cast<const Select*>(s))
-        //        {
-        //        }
-        else if (auto* exit = dynamic_cast<const Exit*>(s))
+        case StatementKind::Exit:
         {
+            auto* exit = static_cast<const Exit*>(s);
             auto loopExitBlockIt = symtab.loopExitBlocks.find(exit->loopToBreak());
             if (loopExitBlockIt == symtab.loopExitBlocks.end())
             {
@@ -614,9 +822,11 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
             builder.CreateBr(loopExitBlockIt->second);
             // Add a dead block for any statements inserted after this point in this block.
             builder.SetInsertPoint(llvm::BasicBlock::Create(ctx, "deadStatementsAfterEnd", parent));
+            break;
         }
-        else if (auto* infiniteLoop = dynamic_cast<const InfiniteLoop*>(s))
+        case StatementKind::InfiniteLoop:
         {
+            auto* infiniteLoop = static_cast<const InfiniteLoop*>(s);
             // Create blocks.
             llvm::BasicBlock* loopBlock = llvm::BasicBlock::Create(ctx, "loop", parent);
             llvm::BasicBlock* endBlock = llvm::BasicBlock::Create(ctx, "loopBreak", parent);
@@ -635,69 +845,67 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
 
             // Set loop end block as the insertion point for future instructions.
             builder.SetInsertPoint(endBlock);
+            break;
         }
-        else if (auto* forLoop = dynamic_cast<const ForLoop*>(s))
+        case StatementKind::WhileLoop:
         {
-            // Generate initialisation.
-            llvm::Value* variableStorage = symtab.getVar(forLoop->assignment().variable());
-            builder.CreateStore(generateExpression(symtab, builder, forLoop->assignment().expression()),
-                                variableStorage);
-
+            auto* whileLoop = static_cast<const WhileLoop*>(s);
             // Create blocks.
-            llvm::BasicBlock* conditionBlock = llvm::BasicBlock::Create(ctx, "forLoopCond", parent);
-            llvm::BasicBlock* conditionPositiveStepBlock = llvm::BasicBlock::Create(ctx, "forLoopCondPosStep", parent);
-            llvm::BasicBlock* conditionCheckNegativeStepBlock =
-                llvm::BasicBlock::Create(ctx, "forLoopCondCheckNegStep", parent);
-            llvm::BasicBlock* conditionNegativeStepBlock = llvm::BasicBlock::Create(ctx, "forLoopCondNegStep", parent);
-            llvm::BasicBlock* loopBlock = llvm::BasicBlock::Create(ctx, "forLoopBody", parent);
-            llvm::BasicBlock* endBlock = llvm::BasicBlock::Create(ctx, "forLoopEnd", parent);
-            symtab.loopExitBlocks[forLoop] = endBlock;
-
-            // Generate condition block.
+            llvm::BasicBlock* conditionBlock = llvm::BasicBlock::Create(ctx, "whileLoopCond", parent);
+            llvm::BasicBlock* loopBlock = llvm::BasicBlock::Create(ctx, "whileLoopBody", parent);
+            llvm::BasicBlock* endBlock = llvm::BasicBlock::Create(ctx, "whileLoopEnd", parent);
+            symtab.loopExitBlocks[whileLoop] = endBlock;
+
+            // Check the condition before every iteration, including the first.
             builder.CreateBr(conditionBlock);
             builder.SetInsertPoint(conditionBlock);
-            llvm::Value* valueOnCondition = builder.CreateLoad(variableStorage);
-            llvm::Value* endValueOnCondition = generateExpression(symtab, builder, forLoop->endValue());
-            llvm::Value* stepValueOnCondition = generateExpression(symtab, builder, forLoop->stepValue());
-            llvm::Value* stepValueConstantZero = llvm::ConstantInt::get(stepValueOnCondition->getType(), 0);
-            // if step > 0
-            builder.CreateCondBr(builder.CreateICmpSGT(stepValueOnCondition, stepValueConstantZero),
-                                 conditionPositiveStepBlock, conditionCheckNegativeStepBlock);
-            // if step < 0
-            builder.SetInsertPoint(conditionCheckNegativeStepBlock);
-            builder.CreateCondBr(builder.CreateICmpSLT(stepValueOnCondition, stepValueConstantZero),
-                                 conditionNegativeStepBlock, endBlock);
-            // Generate condition if step is positive.
-            builder.SetInsertPoint(conditionPositiveStepBlock);
-            builder.CreateCondBr(builder.CreateICmpSLE(valueOnCondition, endValueOnCondition), loopBlock, endBlock);
-            // Generate condition if step is negative.
-            builder.SetInsertPoint(conditionNegativeStepBlock);
-            builder.CreateCondBr(builder.CreateICmpSGE(valueOnCondition, endValueOnCondition), loopBlock, endBlock);
+            builder.CreateCondBr(generateExpression(symtab, builder, whileLoop->expression()), loopBlock, endBlock);
 
-            // Generate loop body.
-            llvm::BasicBlock* loopEndBlock = generateBlock(symtab, loopBlock, forLoop->statements());
-            builder.SetInsertPoint(loopEndBlock);
-
-            // Generate increment block.
-            llvm::BasicBlock* incrementBlock = llvm::BasicBlock::Create(ctx, "forLoopIncrement", parent);
-            builder.CreateBr(incrementBlock); // branch from end of loop body to increment block.
-            builder.SetInsertPoint(incrementBlock);
-            builder.CreateStore(builder.CreateAdd(builder.CreateLoad(variableStorage),
-                                                  generateExpression(symtab, builder, forLoop->stepValue())),
-                                variableStorage);
-            builder.CreateBr(conditionBlock); // jump back to condition block after increment.
-
-            // Set end block as the insertion point for future instructions.
+            // Generate loop body and branch back to the condition.
+            llvm::BasicBlock* statementsEndBlock = generateBlock(symtab, loopBlock, whileLoop->statements());
+            endBlock->moveAfter(statementsEndBlock);
+            builder.SetInsertPoint(statementsEndBlock);
+            builder.CreateBr(conditionBlock);
+
+            // Set loop end block as the insertion point for future instructions.
             builder.SetInsertPoint(endBlock);
+            break;
         }
-        else if (auto* assignment = dynamic_cast<const VarAssignment*>(s))
+        case StatementKind::UntilLoop:
         {
+            auto* untilLoop = static_cast<const UntilLoop*>(s);
+            // Create blocks.
+            llvm::BasicBlock* loopBlock = llvm::BasicBlock::Create(ctx, "repeatLoopBody", parent);
+            llvm::BasicBlock* endBlock = llvm::BasicBlock::Create(ctx, "repeatLoopEnd", parent);
+            symtab.loopExitBlocks[untilLoop] = endBlock;
+
+            // The body always runs at least once.
+            builder.CreateBr(loopBlock);
+            llvm::BasicBlock* statementsEndBlock = generateBlock(symtab, loopBlock, untilLoop->statements());
+            endBlock->moveAfter(statementsEndBlock);
+
+            // Check the condition after every iteration and leave the loop once it holds.
+            builder.SetInsertPoint(statementsEndBlock);
+            builder.CreateCondBr(generateExpression(symtab, builder, untilLoop->expression()), endBlock, loopBlock);
+
+            // Set loop end block as the insertion point for future instructions.
+            builder.SetInsertPoint(endBlock);
+            break;
+        }
+        case StatementKind::ForLoop:
+            generateForLoop(symtab, builder, static_cast<const ForLoop*>(s));
+            break;
+        case StatementKind::VarAssignment:
+        {
+            auto* assignment = static_cast<const VarAssignment*>(s);
             llvm::Value* expression = generateExpression(symtab, builder, assignment->expression());
             llvm::Value* storeTarget = symtab.getVar(assignment->variable());
             builder.CreateStore(expression, storeTarget);
+            break;
         }
-        else if (auto* call = dynamic_cast<const FunctionCall*>(s))
+        case StatementKind::FunctionCall:
         {
+            auto* call = static_cast<const FunctionCall*>(s);
             if (!call->expression().isUserFunction() && call->expression().command()->dbSymbol() == "end" &&
                 parent->getName() == "__DBmain")
             {
@@ -709,21 +917,31 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
                 // Generate the expression, but discard the result.
                 generateExpression(symtab, builder, &call->expression());
             }
+            break;
         }
-        else if (auto* endfunction = dynamic_cast<const ExitFunction*>(s))
+        case StatementKind::ExitFunction:
         {
+            auto* endfunction = static_cast<const ExitFunction*>(s);
             builder.CreateRet(generateExpression(symtab, builder, endfunction->expression()));
+            break;
         }
-        else if (auto* subReturn = dynamic_cast<const SubReturn*>(s))
+        case StatementKind::SubReturn:
         {
-            (void)subReturn; // SubReturn has no useful data members.
-            auto* returnAddr = builder.CreateCall(gosubPopAddress, {symtab.gosubStack, symtab.gosubStackPointer});
+            llvm::Value* stack = symtab.gosubStack;
+            if (symtab.gosubStackCapacity)
+            {
+                stack = builder.CreateLoad(llvm::Type::getInt8PtrTy(ctx)->getPointerTo(), stack, "gosubStack");
+            }
+            auto* returnAddr = builder.CreateCall(gosubPopAddress, {stack, symtab.gosubStackPointer});
             printString(builder, builder.CreateGlobalStringPtr("Popped address. Jumping back to call site."));
             symtab.addGosubIndirectBr(builder.CreateIndirectBr(returnAddr));
             builder.SetInsertPoint(llvm::BasicBlock::Create(ctx, "deadStatementsAfterReturn", parent));
+            break;
         }
-        else
-        {
+        case StatementKind::Select:
+            generateSelect(symtab, builder, static_cast<const Select*>(s));
+            break;
+        default:
             Log::codegen(Log::Severity::FATAL, "Unhandled statement.");
             return nullptr;
         }
@@ -732,6 +950,319 @@ llvm::BasicBlock* CodeGenerator::generateBlock(SymbolTable& symtab, llvm::BasicB
     return builder.GetInsertBlock();
 }
 
+void CodeGenerator::generateForLoop(SymbolTable& symtab, llvm::IRBuilder<>& builder, const ForLoop* forLoop)
+{
+    llvm::Function* parent = builder.GetInsertBlock()->getParent();
+    const Variable* variable = forLoop->assignment().variable();
+    BuiltinType type = *variable->type().getBuiltinType();
+    bool isFloatingPoint = isFloatingPointType(type);
+
+    // Generate initialisation.
+    llvm::Value* variableStorage = symtab.getVar(variable);
+    llvm::Type* variableType = getLLVMType(ctx, variable->type());
+    builder.CreateStore(generateExpression(symtab, builder, forLoop->assignment().expression()), variableStorage);
+
+    // The end and step values are evaluated once before the loop if nothing in
+    // the loop can change them, and on every iteration otherwise.
+    std::unordered_set<const Variable*> assignedVariables{variable};
+    bool canHoist = collectAssignedVariables(forLoop->statements(), assignedVariables);
+    llvm::Value* endValue = nullptr;
+    if (canHoist && isInvariant(forLoop->endValue(), assignedVariables))
+    {
+        endValue = generateExpression(symtab, builder, forLoop->endValue());
+    }
+    llvm::Value* stepValue = nullptr;
+    if (canHoist && isInvariant(forLoop->stepValue(), assignedVariables))
+    {
+        stepValue = generateExpression(symtab, builder, forLoop->stepValue());
+    }
+
+    // The loop counts up for a positive step, down for a negative step, and
+    // doesn't run at all for a zero step.
+    llvm::Value* stepIsPositive = nullptr;
+    llvm::Value* stepIsNegative = nullptr;
+    auto generateStepSign = [&](llvm::Value* step) {
+        llvm::Value* zero = llvm::Constant::getNullValue(variableType);
+        stepIsPositive =
+            builder.CreateCmp(getComparePredicate(type, llvm::CmpInst::Predicate::ICMP_SGT), step, zero, "stepIsPositive");
+        stepIsNegative =
+            builder.CreateCmp(getComparePredicate(type, llvm::CmpInst::Predicate::ICMP_SLT), step, zero, "stepIsNegative");
+    };
+    if (stepValue)
+    {
+        generateStepSign(stepValue);
+    }
+
+    // Create blocks.
+    llvm::BasicBlock* conditionBlock = llvm::BasicBlock::Create(ctx, "forLoopCond", parent);
+    llvm::BasicBlock* loopBlock = llvm::BasicBlock::Create(ctx, "forLoopBody", parent);
+    llvm::BasicBlock* endBlock = llvm::BasicBlock::Create(ctx, "forLoopEnd", parent);
+    symtab.loopExitBlocks[forLoop] = endBlock;
+
+    // Generate condition block.
+    builder.CreateBr(conditionBlock);
+    builder.SetInsertPoint(conditionBlock);
+    llvm::Value* value = builder.CreateLoad(variableType, variableStorage);
+    llvm::Value* endValueOnCondition = endValue ? endValue : generateExpression(symtab, builder, forLoop->endValue());
+    if (!stepValue)
+    {
+        generateStepSign(generateExpression(symtab, builder, forLoop->stepValue()));
+    }
+    auto generateCompare = [&](llvm::CmpInst::Predicate predicate) {
+        return builder.CreateCmp(getComparePredicate(type, predicate), value, endValueOnCondition);
+    };
+    llvm::Value* condition;
+    auto* constantIsPositive = llvm::dyn_cast<llvm::ConstantInt>(stepIsPositive);
+    auto* constantIsNegative = llvm::dyn_cast<llvm::ConstantInt>(stepIsNegative);
+    if (constantIsPositive && constantIsNegative)
+    {
+        // The step is a constant, so a single compare decides.
+        if (constantIsPositive->isOne())
+        {
+            condition = generateCompare(llvm::CmpInst::Predicate::ICMP_SLE);
+        }
+        else if (constantIsNegative->isOne())
+        {
+            condition = generateCompare(llvm::CmpInst::Predicate::ICMP_SGE);
+        }
+        else
+        {
+            condition = builder.getFalse();
+        }
+    }
+    else
+    {
+        // Selects instead of branches, so the optimizer can unswitch the loop
+        // on a step that doesn't change.
+        condition = builder.CreateSelect(
+            stepIsPositive, generateCompare(llvm::CmpInst::Predicate::ICMP_SLE),
+            builder.CreateSelect(stepIsNegative, generateCompare(llvm::CmpInst::Predicate::ICMP_SGE),
+                                 builder.getFalse()));
+    }
+    builder.CreateCondBr(condition, loopBlock, endBlock);
+
+    // Generate loop body.
+    llvm::BasicBlock* loopEndBlock = generateBlock(symtab, loopBlock, forLoop->statements());
+    builder.SetInsertPoint(loopEndBlock);
+
+    // Generate increment block.
+    llvm::BasicBlock* incrementBlock = llvm::BasicBlock::Create(ctx, "forLoopIncrement", parent);
+    builder.CreateBr(incrementBlock); // branch from end of loop body to increment block.
+    builder.SetInsertPoint(incrementBlock);
+    llvm::Value* step = stepValue ? stepValue : generateExpression(symtab, builder, forLoop->stepValue());
+    llvm::Value* oldValue = builder.CreateLoad(variableType, variableStorage);
+    builder.CreateStore(isFloatingPoint ? builder.CreateFAdd(oldValue, step) : builder.CreateAdd(oldValue, step),
+                        variableStorage);
+    builder.CreateBr(conditionBlock); // jump back to condition block after increment.
+
+    // Keep the blocks in source order.
+    endBlock->moveAfter(incrementBlock);
+
+    // Set end block as the insertion point for future instructions.
+    builder.SetInsertPoint(endBlock);
+}
+
+void CodeGenerator::generateSelect(SymbolTable& symtab, llvm::IRBuilder<>& builder, const Select* select)
+{
+    llvm::Function* parent = builder.GetInsertBlock()->getParent();
+    llvm::Value* value = generateExpression(symtab, builder, select->expression());
+    auto* stringTy = llvm::Type::getInt8PtrTy(ctx);
+    bool isString = value->getType() == stringTy;
+    if (isString)
+    {
+        // Commands may return null for an empty string.
+        llvm::Value* emptyString = builder.CreateBitCast(symtab.getOrAddStrLiteral(""), stringTy);
+        value = builder.CreateSelect(builder.CreateIsNull(value), emptyString, value);
+    }
+
+    // Create blocks.
+    const std::vector<Select::Case>& cases = select->cases();
+    std::vector<llvm::BasicBlock*> caseBlocks;
+    llvm::BasicBlock* endBlock = llvm::BasicBlock::Create(ctx, "selectEnd", parent);
+    llvm::BasicBlock* defaultBlock = nullptr;
+    for (const Select::Case& selectCase : cases)
+    {
+        caseBlocks.push_back(llvm::BasicBlock::Create(ctx, selectCase.condition ? "case" : "caseDefault", parent));
+        if (!selectCase.condition && !defaultBlock)
+        {
+            defaultBlock = caseBlocks.back();
+        }
+    }
+    if (!defaultBlock)
+    {
+        defaultBlock = endBlock;
+    }
+
+    llvm::Function* strcmpFunc = nullptr;
+    auto generateEquals = [&](llvm::Value* left, llvm::Value* right) -> llvm::Value* {
+        if (left->getType()->isFloatingPointTy())
+        {
+            return builder.CreateFCmpOEQ(left, right);
+        }
+        if (!isString)
+        {
+            return builder.CreateICmpEQ(left, right);
+        }
+        if (!strcmpFunc)
+        {
+            auto* int32Ty = llvm::Type::getInt32Ty(ctx);
+            strcmpFunc =
+                getOrCreateCFunction("strcmp", llvm::FunctionType::get(int32Ty, {stringTy, stringTy}, false));
+        }
+        return builder.CreateICmpEQ(builder.CreateCall(strcmpFunc, {left, right}), builder.getInt32(0));
+    };
+
+    bool hasConstantCases = std::all_of(cases.begin(), cases.end(), [](const Select::Case& selectCase) {
+        return !selectCase.condition || isConstantExpression(selectCase.condition.get());
+    });
+    bool hasStringLiteralCases = std::all_of(cases.begin(), cases.end(), [](const Select::Case& selectCase) {
+        return !selectCase.condition || selectCase.condition->kind() == ExpressionKind::StringLiteral;
+    });
+
+    // Constant expressions don't generate any instructions.
+    std::vector<llvm::ConstantInt*> caseValues;
+    if (value->getType()->isIntegerTy() && hasConstantCases)
+    {
+        for (const Select::Case& selectCase : cases)
+        {
+            caseValues.push_back(selectCase.condition ? llvm::dyn_cast<llvm::ConstantInt>(generateExpression(
+                                                            symtab, builder, selectCase.condition))
+                                                      : nullptr);
+            if (selectCase.condition && !caseValues.back())
+            {
+                hasConstantCases = false;
+            }
+        }
+    }
+
+    if (value->getType()->isIntegerTy() && hasConstantCases)
+    {
+        // LLVM lowers a switch to a jump table if the values are dense enough,
+        // and to a binary search otherwise.
+        auto* switchInst = builder.CreateSwitch(value, defaultBlock, cases.size());
+        for (std::size_t i = 0; i != cases.size(); ++i)
+        {
+            // The first of several cases with the same value runs.
+            if (caseValues[i] && switchInst->findCaseValue(caseValues[i]) == switchInst->case_default())
+            {
+                switchInst->addCase(caseValues[i], caseBlocks[i]);
+            }
+        }
+    }
+    else if (isString && hasStringLiteralCases)
+    {
+        // Switch on the hash of the string, then compare with the cases that
+        // have the same hash.
+        std::vector<std::uint32_t> hashes;
+        std::unordered_map<std::uint32_t, std::vector<std::size_t>> casesByHash;
+        for (std::size_t i = 0; i != cases.size(); ++i)
+        {
+            if (cases[i].condition)
+            {
+                std::uint32_t hash = hashString(static_cast<const StringLiteral*>(cases[i].condition.get())->value());
+                if (casesByHash[hash].empty())
+                {
+                    hashes.push_back(hash);
+                }
+                casesByHash[hash].push_back(i);
+            }
+        }
+        llvm::Value* hash = builder.CreateCall(getOrCreateStringHashFunction(), {value}, "hash");
+        auto* switchInst = builder.CreateSwitch(hash, defaultBlock, hashes.size());
+        for (std::uint32_t caseHash : hashes)
+        {
+            llvm::BasicBlock* compareBlock = llvm::BasicBlock::Create(ctx, "caseCompare", parent);
+            switchInst->addCase(builder.getInt32(caseHash), compareBlock);
+            builder.SetInsertPoint(compareBlock);
+            for (std::size_t i : casesByHash[caseHash])
+            {
+                llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(ctx, "caseCompare", parent);
+                builder.CreateCondBr(generateEquals(value, generateExpression(symtab, builder, cases[i].condition)),
+                                     caseBlocks[i], nextBlock);
+                builder.SetInsertPoint(nextBlock);
+            }
+            builder.CreateBr(defaultBlock);
+        }
+    }
+    else
+    {
+        // Compare with one case after the other, evaluating the conditions as
+        // they are reached.
+        for (std::size_t i = 0; i != cases.size(); ++i)
+        {
+            if (!cases[i].condition)
+            {
+                continue;
+            }
+            llvm::BasicBlock* nextBlock = llvm::BasicBlock::Create(ctx, "caseCompare", parent);
+            builder.CreateCondBr(generateEquals(value, generateExpression(symtab, builder, cases[i].condition)),
+                                 caseBlocks[i], nextBlock);
+            builder.SetInsertPoint(nextBlock);
+        }
+        builder.CreateBr(defaultBlock);
+    }
+
+    // Generate case bodies.
+    llvm::BasicBlock* lastBlock = nullptr;
+    for (std::size_t i = 0; i != cases.size(); ++i)
+    {
+        lastBlock = generateBlock(symtab, caseBlocks[i], cases[i].statements);
+        builder.SetInsertPoint(lastBlock);
+        builder.CreateBr(endBlock);
+    }
+    if (lastBlock)
+    {
+        endBlock->moveAfter(lastBlock);
+    }
+
+    // Set end block as the insertion point for future instructions.
+    builder.SetInsertPoint(endBlock);
+}
+
+llvm::Function* CodeGenerator::getOrCreateStringHashFunction()
+{
+    llvm::Function* function = module.getFunction("selectStringHash");
+    if (function)
+    {
+        return function;
+    }
+
+    auto* int32Ty = llvm::Type::getInt32Ty(ctx);
+    auto* int64Ty = llvm::Type::getInt64Ty(ctx);
+    auto* int8Ty = llvm::Type::getInt8Ty(ctx);
+    function = llvm::Function::Create(llvm::FunctionType::get(int32Ty, {llvm::Type::getInt8PtrTy(ctx)}, false),
+                                      llvm::Function::InternalLinkage, "selectStringHash", module);
+    function->getArg(0)->setName("str");
+
+    auto* entryBlock = llvm::BasicBlock::Create(ctx, "", function);
+    auto* loopBlock = llvm::BasicBlock::Create(ctx, "loop", function);
+    auto* bodyBlock = llvm::BasicBlock::Create(ctx, "body", function);
+    auto* endBlock = llvm::BasicBlock::Create(ctx, "end", function);
+    llvm::IRBuilder<> builder(entryBlock);
+    builder.CreateBr(loopBlock);
+
+    builder.SetInsertPoint(loopBlock);
+    llvm::PHINode* index = builder.CreatePHI(int64Ty, 2, "index");
+    llvm::PHINode* hash = builder.CreatePHI(int32Ty, 2, "hash");
+    llvm::Value* c = builder.CreateLoad(int8Ty, builder.CreateGEP(int8Ty, function->getArg(0), index), "c");
+    builder.CreateCondBr(builder.CreateICmpEQ(c, builder.getInt8(0)), endBlock, bodyBlock);
+
+    builder.SetInsertPoint(bodyBlock);
+    llvm::Value* nextHash =
+        builder.CreateMul(builder.CreateXor(hash, builder.CreateZExt(c, int32Ty)), builder.getInt32(16777619u));
+    llvm::Value* nextIndex = builder.CreateAdd(index, builder.getInt64(1));
+    builder.CreateBr(loopBlock);
+
+    index->addIncoming(builder.getInt64(0), entryBlock);
+    index->addIncoming(nextIndex, bodyBlock);
+    hash->addIncoming(builder.getInt32(2166136261u), entryBlock);
+    hash->addIncoming(nextHash, bodyBlock);
+
+    builder.SetInsertPoint(endBlock);
+    builder.CreateRet(hash);
+    return function;
+}
+
 llvm::Function* CodeGenerator::generateFunctionPrototype(const FunctionDefinition& irFunction)
 {
     std::string functionName = "__DB" + irFunction.name();
@@ -771,17 +1302,14 @@ llvm::Function* CodeGenerator::generateFunctionPrototype(const FunctionDefinitio
 void CodeGenerator::generateFunctionBody(llvm::Function* function, const FunctionDefinition& irFunction,
                                          bool isMainFunction)
 {
+    TraceScope trace("codegen", "generate function", irFunction.name());
     auto& symtab = *symbolTables[function];
 
     auto* initialBlock = llvm::BasicBlock::Create(ctx, "entry", function);
     llvm::IRBuilder<> builder(ctx);
     builder.SetInsertPoint(initialBlock);
 
-    // Gosub stack.
-    // TODO: Only generate this if the function contains gosubs.
-    symtab.gosubStack = builder.CreateAlloca(gosubStackType, nullptr, "gosubStack");
-    symtab.gosubStackPointer = builder.CreateAlloca(llvm::Type::getInt64Ty(ctx), nullptr, "gosubSP");
-    builder.CreateStore(llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0), symtab.gosubStackPointer);
+    generateGosubStack(symtab, builder, irFunction);
 
     // Variables.
     for (Variable* var : irFunction.variables().list())
@@ -819,6 +1347,15 @@ void CodeGenerator::generateFunctionBody(llvm::Function* function, const Functio
         symtab.addVar(var, variableStorage);
     }
 
+    // Arguments.
+    for (std::size_t i = 0; i < irFunction.arguments().size(); ++i)
+    {
+        if (const Variable* var = irFunction.argumentVariable(i))
+        {
+            builder.CreateStore(function->getArg(i), symtab.getVar(var));
+        }
+    }
+
     // Statements.
     auto* lastBlock = generateBlock(symtab, initialBlock, irFunction.statements());
 
@@ -828,13 +1365,68 @@ void CodeGenerator::generateFunctionBody(llvm::Function* function, const Functio
         builder.SetInsertPoint(lastBlock);
         builder.CreateRetVoid();
     }
+
+    freeGosubStack(symtab, function);
+}
+
+void CodeGenerator::generateGosubStack(SymbolTable& symtab, llvm::IRBuilder<>& builder,
+                                       const FunctionDefinition& irFunction)
+{
+    GosubUsage usage = analyzeGosubUsage(irFunction);
+    if (!usage.usesGosub)
+    {
+        return;
+    }
+
+    auto* addressTy = llvm::Type::getInt8PtrTy(ctx);
+    auto* int64Ty = llvm::Type::getInt64Ty(ctx);
+    if (usage.maxDepth && *usage.maxDepth <= MaxStaticGosubDepth)
+    {
+        // The stack can't overflow, so it lives in the stack frame. A function
+        // that returns without any gosub gets one entry, because LLVM has no
+        // empty arrays. It is never read, since gosubPopAddress traps first.
+        auto* stackTy = llvm::ArrayType::get(addressTy, std::max<std::uint32_t>(*usage.maxDepth, 1));
+        auto* storage = builder.CreateAlloca(stackTy, nullptr, "gosubStack");
+        symtab.gosubStack = builder.CreateConstInBoundsGEP2_64(stackTy, storage, 0, 0);
+    }
+    else
+    {
+        // Grown by gosubPushAddressGrowable as needed, and freed on return.
+        symtab.gosubStack = builder.CreateAlloca(addressTy->getPointerTo(), nullptr, "gosubStack");
+        builder.CreateStore(llvm::ConstantPointerNull::get(addressTy->getPointerTo()), symtab.gosubStack);
+        symtab.gosubStackCapacity = builder.CreateAlloca(int64Ty, nullptr, "gosubCapacity");
+        builder.CreateStore(llvm::ConstantInt::get(int64Ty, 0), symtab.gosubStackCapacity);
+    }
+    symtab.gosubStackPointer = builder.CreateAlloca(int64Ty, nullptr, "gosubSP");
+    builder.CreateStore(llvm::ConstantInt::get(int64Ty, 0), symtab.gosubStackPointer);
+}
+
+void CodeGenerator::freeGosubStack(SymbolTable& symtab, llvm::Function* function)
+{
+    if (!symtab.gosubStackCapacity)
+    {
+        return;
+    }
+
+    auto* addressTy = llvm::Type::getInt8PtrTy(ctx);
+    llvm::Function* freeFunc =
+        getOrCreateCFunction("free", llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {addressTy}, false));
+    llvm::IRBuilder<> builder(ctx);
+    for (llvm::BasicBlock& block : *function)
+    {
+        if (auto* ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(block.getTerminator()))
+        {
+            builder.SetInsertPoint(ret);
+            auto* stack = builder.CreateLoad(addressTy->getPointerTo(), symtab.gosubStack, "gosubStack");
+            builder.CreateCall(freeFunc, {builder.CreateBitCast(stack, addressTy)});
+        }
+    }
 }
 
 bool CodeGenerator::generateModule(const Program& program, std::vector<DynamicLibrary*> pluginsToLoad)
 {
     GlobalSymbolTable globalSymbolTable(module, engineInterface);
 
-    gosubStackType = llvm::ArrayType::get(llvm::Type::getInt8PtrTy(ctx), 32);
     generateGosubHelperFunctions();
 
     // Generate main function.
@@ -880,12 +1472,15 @@ bool CodeGenerator::generateModule(const Program& program, std::vector<DynamicLi
 void CodeGenerator::generateGosubHelperFunctions()
 {
     llvm::IRBuilder<> builder{ctx};
+    auto* addressTy = llvm::Type::getInt8PtrTy(ctx);
+    auto* stackTy = addressTy->getPointerTo();
+    auto* int64Ty = llvm::Type::getInt64Ty(ctx);
+    auto* one = llvm::ConstantInt::get(int64Ty, 1);
 
     // Generate gosub push address function.
     gosubPushAddress = llvm::Function::Create(
-        llvm::FunctionType::get(
-            llvm::Type::getVoidTy(ctx),
-            {gosubStackType->getPointerTo(), llvm::Type::getInt64PtrTy(ctx), llvm::Type::getInt8PtrTy(ctx)}, false),
+        llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {stackTy, llvm::Type::getInt64PtrTy(ctx), addressTy},
+                                false),
         llvm::Function::InternalLinkage, "gosubPushAddress", module);
     gosubPushAddress->getArg(0)->setName("stack");
     gosubPushAddress->getArg(1)->setName("sp");
@@ -895,35 +1490,121 @@ void CodeGenerator::generateGosubHelperFunctions()
         auto* stack = gosubPushAddress->getArg(0);
         auto* sp = gosubPushAddress->getArg(1);
         auto* val = gosubPushAddress->getArg(2);
-        auto* index = builder.CreateLoad(sp, "index");
-        auto* addr = builder.CreateGEP(stack, {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0), index}, "addr");
+        auto* index = builder.CreateLoad(int64Ty, sp, "index");
+        auto* addr = builder.CreateGEP(addressTy, stack, index, "addr");
         builder.CreateStore(val, addr);
-        auto* newIndex = builder.CreateAdd(index, llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 1), "newIndex");
+        auto* newIndex = builder.CreateAdd(index, one, "newIndex");
         builder.CreateStore(newIndex, sp);
         builder.CreateRetVoid();
     }
 
+    // Generate the push address function for stacks on the heap, which
+    // doubles the capacity when the stack is full.
+    gosubPushAddressGrowable = llvm::Function::Create(
+        llvm::FunctionType::get(
+            llvm::Type::getVoidTy(ctx),
+            {stackTy->getPointerTo(), llvm::Type::getInt64PtrTy(ctx), llvm::Type::getInt64PtrTy(ctx), addressTy},
+            false),
+        llvm::Function::InternalLinkage, "gosubPushAddressGrowable", module);
+    gosubPushAddressGrowable->getArg(0)->setName("stack");
+    gosubPushAddressGrowable->getArg(1)->setName("capacity");
+    gosubPushAddressGrowable->getArg(2)->setName("sp");
+    gosubPushAddressGrowable->getArg(3)->setName("val");
+    {
+        auto* stack = gosubPushAddressGrowable->getArg(0);
+        auto* capacity = gosubPushAddressGrowable->getArg(1);
+        auto* sp = gosubPushAddressGrowable->getArg(2);
+        auto* val = gosubPushAddressGrowable->getArg(3);
+        auto* entryBlock = llvm::BasicBlock::Create(ctx, "", gosubPushAddressGrowable);
+        auto* growBlock = llvm::BasicBlock::Create(ctx, "grow", gosubPushAddressGrowable);
+        auto* outOfMemoryBlock = llvm::BasicBlock::Create(ctx, "outOfMemory", gosubPushAddressGrowable);
+        auto* grownBlock = llvm::BasicBlock::Create(ctx, "grown", gosubPushAddressGrowable);
+        auto* pushBlock = llvm::BasicBlock::Create(ctx, "push", gosubPushAddressGrowable);
+
+        builder.SetInsertPoint(entryBlock);
+        auto* index = builder.CreateLoad(int64Ty, sp, "index");
+        auto* oldCapacity = builder.CreateLoad(int64Ty, capacity, "oldCapacity");
+        builder.CreateCondBr(builder.CreateICmpUGE(index, oldCapacity, "isFull"), growBlock, pushBlock);
+
+        // realloc() takes a size_t, which is as wide as a pointer on the target.
+        builder.SetInsertPoint(growBlock);
+        auto* sizeTy = module.getDataLayout().getIntPtrType(ctx);
+        llvm::Function* reallocFunc =
+            getOrCreateCFunction("realloc", llvm::FunctionType::get(addressTy, {addressTy, sizeTy}, false));
+        auto* newCapacity =
+            builder.CreateSelect(builder.CreateICmpEQ(oldCapacity, llvm::ConstantInt::get(int64Ty, 0)),
+                                 llvm::ConstantInt::get(int64Ty, 16), builder.CreateShl(oldCapacity, one),
+                                 "newCapacity");
+        auto* size = builder.CreateMul(builder.CreateZExtOrTrunc(newCapacity, sizeTy),
+                                       llvm::ConstantInt::get(sizeTy, module.getDataLayout().getPointerSize()),
+                                       "size");
+        auto* oldStack = builder.CreateLoad(stackTy, stack, "oldStack");
+        auto* newStack = builder.CreateCall(reallocFunc, {builder.CreateBitCast(oldStack, addressTy), size});
+        builder.CreateCondBr(builder.CreateIsNull(newStack), outOfMemoryBlock, grownBlock);
+
+        builder.SetInsertPoint(outOfMemoryBlock);
+        builder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+        builder.CreateUnreachable();
+
+        builder.SetInsertPoint(grownBlock);
+        builder.CreateStore(builder.CreateBitCast(newStack, stackTy), stack);
+        builder.CreateStore(newCapacity, capacity);
+        builder.CreateBr(pushBlock);
+
+        builder.SetInsertPoint(pushBlock);
+        auto* currentStack = builder.CreateLoad(stackTy, stack, "currentStack");
+        auto* addr = builder.CreateGEP(addressTy, currentStack, index, "addr");
+        builder.CreateStore(val, addr);
+        builder.CreateStore(builder.CreateAdd(index, one, "newIndex"), sp);
+        builder.CreateRetVoid();
+    }
+
     // Generate gosub pop address function.
     gosubPopAddress = llvm::Function::Create(
-        llvm::FunctionType::get(llvm::Type::getInt8PtrTy(ctx),
-                                {gosubStackType->getPointerTo(), llvm::Type::getInt64PtrTy(ctx)}, false),
+        llvm::FunctionType::get(addressTy, {stackTy, llvm::Type::getInt64PtrTy(ctx)}, false),
         llvm::Function::InternalLinkage, "gosubPopAddress", module);
     gosubPopAddress->getArg(0)->setName("stack");
     gosubPopAddress->getArg(1)->setName("sp");
     {
-        builder.SetInsertPoint(llvm::BasicBlock::Create(ctx, "", gosubPopAddress));
         auto* stack = gosubPopAddress->getArg(0);
         auto* sp = gosubPopAddress->getArg(1);
-        auto* index = builder.CreateLoad(sp, "index");
-        auto* topIndex = builder.CreateSub(index, llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 1), "topIndex");
-        auto* addr =
-            builder.CreateGEP(stack, {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0), topIndex}, "addr");
-        auto* val = builder.CreateLoad(addr, "val");
+        auto* entryBlock = llvm::BasicBlock::Create(ctx, "", gosubPopAddress);
+        auto* emptyBlock = llvm::BasicBlock::Create(ctx, "returnWithoutGosub", gosubPopAddress);
+        auto* popBlock = llvm::BasicBlock::Create(ctx, "pop", gosubPopAddress);
+
+        // A return without a gosub has no address to jump to. The interpreter
+        // reports this as a runtime error, compiled code reports it and traps.
+        builder.SetInsertPoint(entryBlock);
+        auto* index = builder.CreateLoad(int64Ty, sp, "index");
+        builder.CreateCondBr(builder.CreateICmpEQ(index, llvm::ConstantInt::get(int64Ty, 0), "isEmpty"), emptyBlock,
+                             popBlock);
+
+        builder.SetInsertPoint(emptyBlock);
+        printString(builder, builder.CreateGlobalStringPtr("Runtime error: Return without gosub"));
+        builder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+        builder.CreateUnreachable();
+
+        builder.SetInsertPoint(popBlock);
+        auto* topIndex = builder.CreateSub(index, one, "topIndex");
+        auto* addr = builder.CreateGEP(addressTy, stack, topIndex, "addr");
+        auto* val = builder.CreateLoad(addressTy, addr, "val");
         builder.CreateStore(topIndex, sp);
         builder.CreateRet(val);
     }
 }
 
+llvm::Function* CodeGenerator::getOrCreateCFunction(const char* name, llvm::FunctionType* type)
+{
+    llvm::Function* function = module.getFunction(name);
+    if (!function)
+    {
+        function = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, module);
+        function->setCallingConv(llvm::CallingConv::C);
+        function->setDLLStorageClass(llvm::Function::DLLImportStorageClass);
+    }
+    return function;
+}
+
 void CodeGenerator::printString(llvm::IRBuilder<>& builder, llvm::Value* string)
 {
     llvm::Function* putsFunc = module.getFunction("puts");
@@ -45,8 +45,12 @@ public:
         llvm::Value* getOrAddStrLiteral(const std::string& literal);
         llvm::BasicBlock* getOrAddLabelBlock(const Label* label);
 
-        llvm::Value* gosubStack;
-        llvm::Value* gosubStackPointer;
+        // Return addresses of the function's gosubs, all null if it doesn't
+        // use gosub. If gosubStackCapacity is set, the stack is on the heap
+        // and gosubStack points to the pointer to it.
+        llvm::Value* gosubStack = nullptr;
+        llvm::Value* gosubStackPointer = nullptr;
+        llvm::Value* gosubStackCapacity = nullptr;
 
         void addGosubReturnPoint(llvm::BasicBlock* returnPoint);
         void addGosubIndirectBr(llvm::IndirectBrInst* indirectBrInst);
@@ -90,11 +94,18 @@ private:
     // Variable symbol table.
     std::unordered_map<llvm::Function*, std::unique_ptr<SymbolTable>> symbolTables;
 
-    llvm::ArrayType* gosubStackType;
     llvm::Function* gosubPushAddress;
+    llvm::Function* gosubPushAddressGrowable;
     llvm::Function* gosubPopAddress;
 
+    void generateForLoop(SymbolTable& symtab, llvm::IRBuilder<>& builder, const ForLoop* forLoop);
+    void generateSelect(SymbolTable& symtab, llvm::IRBuilder<>& builder, const Select* select);
+    llvm::Function* getOrCreateStringHashFunction();
+
     void generateGosubHelperFunctions();
+    void generateGosubStack(SymbolTable& symtab, llvm::IRBuilder<>& builder, const FunctionDefinition& irFunction);
+    void freeGosubStack(SymbolTable& symtab, llvm::Function* function);
+    llvm::Function* getOrCreateCFunction(const char* name, llvm::FunctionType* type);
     void printString(llvm::IRBuilder<>& builder, llvm::Value* string);
 };
 } // namespace odb::ir
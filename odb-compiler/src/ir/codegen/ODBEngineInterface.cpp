@@ -12,7 +12,10 @@ ODBEngineInterface::ODBEngineInterface(llvm::Module& module) : EngineInterface(m
 llvm::Function* ODBEngineInterface::generateCommandCall(const cmd::Command& command, const std::string& functionName,
                                                         llvm::FunctionType* functionType)
 {
-    return llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, functionName, module);
+    llvm::Function* function =
+        llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, functionName, module);
+    commandFunctions_.emplace_back(function, &command);
+    return function;
 }
 
 void ODBEngineInterface::generateEntryPoint(llvm::Function* gameEntryPoint, std::vector<DynamicLibrary*> pluginsToLoad)
@@ -27,4 +30,9 @@ void ODBEngineInterface::generateEntryPoint(llvm::Function* gameEntryPoint, std:
     builder.CreateCall(gameEntryPoint, {});
     builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0));
 }
+
+const std::vector<std::pair<llvm::Function*, const cmd::Command*>>& ODBEngineInterface::commandFunctions() const
+{
+    return commandFunctions_;
+}
 } // namespace odb::ir
@@ -11,5 +11,13 @@ public:
     llvm::Function* generateCommandCall(const cmd::Command& command, const std::string& functionName,
                                         llvm::FunctionType* functionType) override;
     void generateEntryPoint(llvm::Function* gameEntryPoint, std::vector<DynamicLibrary*> pluginsToLoad) override;
+
+    // Every function declared by generateCommandCall() along with the command
+    // it stands for. A linker resolves these against the plugins, but when
+    // executing the module in-process they have to be resolved by hand.
+    const std::vector<std::pair<llvm::Function*, const cmd::Command*>>& commandFunctions() const;
+
+private:
+    std::vector<std::pair<llvm::Function*, const cmd::Command*>> commandFunctions_;
 };
 } // namespace odb::ir
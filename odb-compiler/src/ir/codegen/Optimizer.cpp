@@ -0,0 +1,104 @@
+#include "Optimizer.hpp"
+#include "odb-compiler/Trace.hpp"
+
+namespace odb::ir {
+namespace {
+// Records each pass that runs as a trace event. Passes nest (e.g. a function
+// pass manager runs inside a module pass), so the start times are kept on a
+// stack.
+class PassTracer
+{
+public:
+    void registerCallbacks(llvm::PassInstrumentationCallbacks& callbacks)
+    {
+        callbacks.registerBeforeNonSkippedPassCallback([this](llvm::StringRef pass, llvm::Any ir) {
+            std::string name = pass.str();
+            if (llvm::any_isa<const llvm::Function*>(ir))
+            {
+                name += " ";
+                name += llvm::any_cast<const llvm::Function*>(ir)->getName().str();
+            }
+            started_.push_back({std::move(name), Trace::now()});
+        });
+        callbacks.registerAfterPassCallback(
+            [this](llvm::StringRef, llvm::Any, const llvm::PreservedAnalyses&) { finishPass(); });
+        callbacks.registerAfterPassInvalidatedCallback(
+            [this](llvm::StringRef, const llvm::PreservedAnalyses&) { finishPass(); });
+    }
+
+private:
+    void finishPass()
+    {
+        auto& [name, start] = started_.back();
+        Trace::addEvent({"llvm", std::move(name), start, Trace::now() - start, Trace::threadId()});
+        started_.pop_back();
+    }
+
+    std::vector<std::pair<std::string, int64_t>> started_;
+};
+} // namespace
+
+// ----------------------------------------------------------------------------
+llvm::CodeGenOpt::Level getCodeGenOptLevel(OptimizationLevel level)
+{
+    switch (level)
+    {
+    case OptimizationLevel::O0:
+        return llvm::CodeGenOpt::None;
+    case OptimizationLevel::O1:
+        return llvm::CodeGenOpt::Less;
+    case OptimizationLevel::O2:
+    case OptimizationLevel::Os:
+        return llvm::CodeGenOpt::Default;
+    case OptimizationLevel::O3:
+        return llvm::CodeGenOpt::Aggressive;
+    }
+    return llvm::CodeGenOpt::None;
+}
+
+// ----------------------------------------------------------------------------
+void optimizeModule(llvm::Module& module, llvm::TargetMachine* targetMachine, OptimizationLevel level)
+{
+    // Every variable is emitted as an alloca with loads and stores, so even -O1
+    // makes a big difference (mem2reg, instcombine, simplifycfg).
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+
+    llvm::PassInstrumentationCallbacks callbacks;
+    PassTracer tracer;
+    if (Trace::enabled())
+    {
+        tracer.registerCallbacks(callbacks);
+    }
+
+    llvm::PassBuilder passBuilder(targetMachine, llvm::PipelineTuningOptions(), llvm::None, &callbacks);
+    passBuilder.registerModuleAnalyses(mam);
+    passBuilder.registerCGSCCAnalyses(cgam);
+    passBuilder.registerFunctionAnalyses(fam);
+    passBuilder.registerLoopAnalyses(lam);
+    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+    llvm::ModulePassManager mpm;
+    switch (level)
+    {
+    case OptimizationLevel::O0:
+        mpm = passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+        break;
+    case OptimizationLevel::O1:
+        mpm = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O1);
+        break;
+    case OptimizationLevel::O2:
+        mpm = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+        break;
+    case OptimizationLevel::O3:
+        mpm = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+        break;
+    case OptimizationLevel::Os:
+        mpm = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::Os);
+        break;
+    }
+    mpm.run(module, mam);
+}
+} // namespace odb::ir
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "LLVM.hpp"
+#include "odb-compiler/ir/Codegen.hpp"
+
+namespace odb::ir {
+// Maps an optimization level to the level used by the backend (instruction
+// selection, register allocation, scheduling).
+llvm::CodeGenOpt::Level getCodeGenOptLevel(OptimizationLevel level);
+
+// Runs LLVM's default per-module pipeline for the given level. The target
+// machine is optional and only provides cost models to the passes.
+void optimizeModule(llvm::Module& module, llvm::TargetMachine* targetMachine, OptimizationLevel level);
+} // namespace odb::ir
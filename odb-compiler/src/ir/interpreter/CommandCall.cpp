@@ -0,0 +1,85 @@
+#include "CommandCall.hpp"
+
+#include <type_traits>
+#include <utility>
+
+namespace odb::ir {
+namespace {
+template <typename R, typename... Args, std::size_t... I>
+void invoke(const void* function, const Value* arguments, Value* result, std::index_sequence<I...>)
+{
+    auto* typedFunction = reinterpret_cast<R (*)(Args...)>(const_cast<void*>(function));
+    if constexpr (std::is_void_v<R>)
+    {
+        (void)result;
+        typedFunction(arguments[I].template get<Args>()...);
+    }
+    else
+    {
+        result->set<R>(typedFunction(arguments[I].template get<Args>()...));
+    }
+}
+
+template <typename R, typename... Args> void invokeCommand(const void* function, const Value* arguments, Value* result)
+{
+    invoke<R, Args...>(function, arguments, result, std::index_sequence_for<Args...>{});
+}
+
+// Appends the C++ type of each remaining argument to Args, one argument at a
+// time. Dword is passed as a 32-bit int, which is also what CodeGenerator
+// declares it as.
+template <typename R, typename... Args>
+CommandInvoker selectInvoker(std::vector<cmd::Command::Type>::const_iterator arg,
+                             std::vector<cmd::Command::Type>::const_iterator end)
+{
+    if (arg == end)
+    {
+        return &invokeCommand<R, Args...>;
+    }
+
+    if constexpr (sizeof...(Args) < MaxCommandInvokerArguments)
+    {
+        switch (*arg)
+        {
+        case cmd::Command::Type::Integer:
+        case cmd::Command::Type::Dword:
+            return selectInvoker<R, Args..., std::int32_t>(arg + 1, end);
+        case cmd::Command::Type::Long:
+            return selectInvoker<R, Args..., std::int64_t>(arg + 1, end);
+        case cmd::Command::Type::Float:
+            return selectInvoker<R, Args..., float>(arg + 1, end);
+        case cmd::Command::Type::Double:
+            return selectInvoker<R, Args..., double>(arg + 1, end);
+        case cmd::Command::Type::String:
+            return selectInvoker<R, Args..., const char*>(arg + 1, end);
+        case cmd::Command::Type::Void:
+            break;
+        }
+    }
+
+    return nullptr;
+}
+} // namespace
+
+CommandInvoker getCommandInvoker(cmd::Command::Type returnType,
+                                 const std::vector<cmd::Command::Type>& argumentTypes)
+{
+    switch (returnType)
+    {
+    case cmd::Command::Type::Integer:
+    case cmd::Command::Type::Dword:
+        return selectInvoker<std::int32_t>(argumentTypes.begin(), argumentTypes.end());
+    case cmd::Command::Type::Long:
+        return selectInvoker<std::int64_t>(argumentTypes.begin(), argumentTypes.end());
+    case cmd::Command::Type::Float:
+        return selectInvoker<float>(argumentTypes.begin(), argumentTypes.end());
+    case cmd::Command::Type::Double:
+        return selectInvoker<double>(argumentTypes.begin(), argumentTypes.end());
+    case cmd::Command::Type::String:
+        return selectInvoker<const char*>(argumentTypes.begin(), argumentTypes.end());
+    case cmd::Command::Type::Void:
+        return selectInvoker<void>(argumentTypes.begin(), argumentTypes.end());
+    }
+    return nullptr;
+}
+} // namespace odb::ir
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "odb-compiler/commands/Command.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace odb::ir {
+// A register of the interpreter. Every builtin scalar type (and string
+// pointers) fits into one, stored in the first bytes of the slot.
+struct Value
+{
+    template <typename T> T get() const
+    {
+        static_assert(sizeof(T) <= sizeof(bits));
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    template <typename T> void set(T value)
+    {
+        static_assert(sizeof(T) <= sizeof(bits));
+        std::memcpy(&bits, &value, sizeof(T));
+    }
+
+    std::uint64_t bits = 0;
+};
+
+// Calls a plugin function with the arguments read from an array of values,
+// and stores the return value (if any) in result.
+using CommandInvoker = void (*)(const void* function, const Value* arguments, Value* result);
+
+// Commands taking more arguments than this can't be called from the
+// interpreter, because a call stub is instantiated for every combination of
+// argument types.
+constexpr std::size_t MaxCommandInvokerArguments = 3;
+
+// Returns the stub that calls functions with the given signature, or nullptr
+// if the signature isn't supported.
+CommandInvoker getCommandInvoker(cmd::Command::Type returnType,
+                                 const std::vector<cmd::Command::Type>& argumentTypes);
+} // namespace odb::ir
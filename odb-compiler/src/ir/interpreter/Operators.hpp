@@ -0,0 +1,168 @@
+#pragma once
+
+#include "odb-compiler/ir/Node.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace odb::ir {
+// Operators of the interpreter. Passes that evaluate expressions at compile
+// time use the same ones, so they can't disagree with the interpreter about
+// the result. Integer arithmetic is done on 64-bit unsigned values, so it wraps
+// around instead of being undefined on overflow. The LLVM code generator has to
+// match these: Dword, Word, Byte and Boolean are unsigned (see isUnsignedType())
+// and shift amounts wrap around at the width of the type.
+template <typename T, typename F> T wrapping(T a, T b, F f)
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        return T(f(std::uint64_t(a), std::uint64_t(b)));
+    }
+    else
+    {
+        return f(a, b);
+    }
+}
+
+struct Add
+{
+    template <typename T> static T apply(T a, T b) { return wrapping(a, b, [](auto x, auto y) { return x + y; }); }
+};
+struct Sub
+{
+    template <typename T> static T apply(T a, T b) { return wrapping(a, b, [](auto x, auto y) { return x - y; }); }
+};
+struct Mul
+{
+    template <typename T> static T apply(T a, T b) { return wrapping(a, b, [](auto x, auto y) { return x * y; }); }
+};
+struct Divide
+{
+    template <typename T> static T apply(T a, T b) { return a / b; }
+};
+struct Modulo
+{
+    template <typename T> static T apply(T a, T b) { return std::fmod(a, b); }
+};
+// Integer division and modulo. The caller has to rule out division by zero.
+template <bool IsModulo> struct IntegerDivide
+{
+    template <typename T> static T apply(T a, T b)
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            // The minimum value divided by -1 overflows
+            if (b == T(-1))
+            {
+                return IsModulo ? T(0) : Sub::apply(T(0), a);
+            }
+        }
+        return IsModulo ? T(a % b) : T(a / b);
+    }
+};
+struct Power
+{
+    template <typename T> static T apply(T a, T b) { return T(std::pow(a, b)); }
+};
+struct ShiftLeft
+{
+    template <typename T> static T apply(T a, T b) { return T(std::uint64_t(a) << (b & (sizeof(T) * 8 - 1))); }
+};
+struct ShiftRight
+{
+    template <typename T> static T apply(T a, T b) { return T(a >> (b & (sizeof(T) * 8 - 1))); }
+};
+struct BitwiseOr
+{
+    template <typename T> static T apply(T a, T b) { return T(a | b); }
+};
+struct BitwiseAnd
+{
+    template <typename T> static T apply(T a, T b) { return T(a & b); }
+};
+struct BitwiseXor
+{
+    template <typename T> static T apply(T a, T b) { return T(a ^ b); }
+};
+struct Less
+{
+    template <typename T> static bool apply(T a, T b) { return a < b; }
+};
+struct LessEqual
+{
+    template <typename T> static bool apply(T a, T b) { return a <= b; }
+};
+struct Greater
+{
+    template <typename T> static bool apply(T a, T b) { return a > b; }
+};
+struct GreaterEqual
+{
+    template <typename T> static bool apply(T a, T b) { return a >= b; }
+};
+struct Equal
+{
+    template <typename T> static bool apply(T a, T b) { return a == b; }
+};
+struct NotEqual
+{
+    template <typename T> static bool apply(T a, T b) { return a != b; }
+};
+struct LogicalOr
+{
+    template <typename T> static bool apply(T a, T b) { return a != T(0) || b != T(0); }
+};
+struct LogicalAnd
+{
+    template <typename T> static bool apply(T a, T b) { return a != T(0) && b != T(0); }
+};
+struct LogicalXor
+{
+    template <typename T> static bool apply(T a, T b) { return (a != T(0)) != (b != T(0)); }
+};
+
+// Calls f with a value of the C++ type the interpreter stores the builtin
+// type as, and returns what f returns. Types outside of the group return a
+// value-initialized result.
+template <typename F> auto forIntegralType(BuiltinType type, F&& f) -> decltype(f(std::int64_t{}))
+{
+    switch (type)
+    {
+    case BuiltinType::DoubleInteger:
+        return f(std::int64_t{});
+    case BuiltinType::Integer:
+        return f(std::int32_t{});
+    case BuiltinType::Dword:
+        return f(std::uint32_t{});
+    case BuiltinType::Word:
+        return f(std::uint16_t{});
+    case BuiltinType::Byte:
+        return f(std::uint8_t{});
+    default:
+        return {};
+    }
+}
+
+template <typename F> auto forNumericType(BuiltinType type, F&& f) -> decltype(f(std::int64_t{}))
+{
+    switch (type)
+    {
+    case BuiltinType::DoubleFloat:
+        return f(double{});
+    case BuiltinType::Float:
+        return f(float{});
+    default:
+        return forIntegralType(type, f);
+    }
+}
+
+template <typename F> auto forScalarType(BuiltinType type, F&& f) -> decltype(f(std::int64_t{}))
+{
+    if (type == BuiltinType::Boolean)
+    {
+        return f(bool{});
+    }
+    return forNumericType(type, f);
+}
+} // namespace odb::ir
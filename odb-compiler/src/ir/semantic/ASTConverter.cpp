@@ -1,6 +1,7 @@
 #include "ASTConverter.hpp"
 
 #include "odb-compiler/ir/Node.hpp"
+#include "odb-compiler/Trace.hpp"
 
 #include "odb-compiler/ast/AnnotatedSymbol.hpp"
 #include "odb-compiler/ast/ArgList.hpp"
@@ -26,6 +27,7 @@
 #include "odb-compiler/ast/Literal.hpp"
 #include "odb-compiler/ast/Loop.hpp"
 #include "odb-compiler/ast/ScopedAnnotatedSymbol.hpp"
+#include "odb-compiler/ast/SelectCase.hpp"
 #include "odb-compiler/ast/SourceLocation.hpp"
 #include "odb-compiler/ast/Statement.hpp"
 #include "odb-compiler/ast/Subroutine.hpp"
@@ -60,6 +62,16 @@ template <typename... Args> [[noreturn]] void fatalError(const char* message, Ar
 }
 } // namespace
 
+ASTConverter::ASTConverter(const cmd::CommandIndex& cmdIndex)
+    : cmdIndex_(cmdIndex)
+    , errorOccurred_(false)
+    , mainFunction_(
+          std::make_unique<FunctionDefinition>(new ast::InlineSourceLocation("", "", 0, 0, 0, 1), "main"))
+    , reachedEndOfMain_(false)
+    , currentFunction_(nullptr)
+{
+}
+
 Type ASTConverter::getTypeFromAnnotation(Variable::Annotation annotation)
 {
     switch (annotation)
@@ -123,11 +135,11 @@ Reference<Variable> ASTConverter::resolveVariableRef(const ast::VarRef* varRef)
 {
     auto annotation = getAnnotation(varRef->symbol()->annotation());
     // TODO: This should take arguments into account as well.
-    Reference<Variable> variable = currentFunction_->variables().lookup(varRef->symbol()->name(), annotation);
+    Reference<Variable> variable = currentFunction_->variables().lookup(varRef->symbol()->atom(), annotation);
     if (!variable)
     {
         // If the variable doesn't exist, it gets implicitly declared with the annotation type.
-        variable = new Variable(varRef->symbol()->location(), varRef->symbol()->name(), annotation,
+        variable = new Variable(varRef->symbol()->location(), varRef->symbol()->atom(), varRef->symbol()->name(), annotation,
                                 getTypeFromAnnotation(annotation));
         currentFunction_->variables().add(variable);
     }
@@ -171,6 +183,16 @@ bool ASTConverter::isTypeConvertible(Type sourceType, Type targetType) const
 
 Ptr<Expression> ASTConverter::ensureType(Ptr<Expression> expression, Type targetType)
 {
+    if (hasPendingType(expression.get()))
+    {
+        // The cast is checked once the type is known. If it turns out to be
+        // the target type already, the cast does nothing.
+        auto cast = std::make_unique<CastExpression>(expression->location(), std::move(expression), targetType);
+        CastExpression* castExpression = cast.get();
+        resolveTypeLater([this, castExpression] { checkConversion(castExpression); });
+        return cast;
+    }
+
     Type expressionType = expression->getType();
 
     if (expressionType == targetType)
@@ -191,30 +213,161 @@ Ptr<Expression> ASTConverter::ensureType(Ptr<Expression> expression, Type target
     return expression;
 }
 
-FunctionCallExpression ASTConverter::convertCommandCallExpression(ast::SourceLocation* location,
-                                                                  const std::string& commandName,
-                                                                  const MaybeNull<ast::ArgList>& astArgs)
+bool ASTConverter::hasPendingType(const Expression* expression) const
 {
-    // Extract arguments.
-    PtrVector<Expression> args;
-    if (astArgs.notNull())
+    if (pendingTypes_.empty())
     {
-        for (ast::Expression* argExpr : astArgs->expressions())
+        return false;
+    }
+    switch (expression->kind())
+    {
+    case ExpressionKind::Unary:
+        return hasPendingType(static_cast<const UnaryExpression*>(expression)->expression());
+    case ExpressionKind::Binary: {
+        // Comparisons are boolean no matter what the operands are. Otherwise
+        // the type is the one of the left operand, which is void until it's
+        // known.
+        auto* binary = static_cast<const BinaryExpression*>(expression);
+        return binary->getType().isVoid() && hasPendingType(binary->left());
+    }
+    default:
+        return pendingTypes_.count(expression) > 0;
+    }
+}
+
+Ptr<CastExpression> ASTConverter::castLater(Ptr<Expression> expression)
+{
+    auto cast = std::make_unique<CastExpression>(expression->location(), std::move(expression), Type{});
+    pendingTypes_.insert(cast.get());
+    return cast;
+}
+
+void ASTConverter::resolveCast(CastExpression* cast, Type targetType)
+{
+    cast->setTargetType(targetType);
+    pendingTypes_.erase(cast);
+    checkConversion(cast);
+}
+
+void ASTConverter::checkConversion(const CastExpression* cast)
+{
+    Type expressionType = cast->expression()->getType();
+    if (!isTypeConvertible(expressionType, cast->targetType()))
+    {
+        semanticError(cast->location(), "Failed to convert %s to %s.", expressionType.toString().c_str(),
+                      cast->targetType().toString().c_str());
+    }
+}
+
+void ASTConverter::resolveTypeLater(std::function<void()> resolve)
+{
+    pendingTypeResolutions_[currentFunction_].emplace_back(std::move(resolve));
+}
+
+void ASTConverter::resolveFunctionCallLater(FunctionCallExpression* call, const ast::AnnotatedSymbol* symbol)
+{
+    // Calls to declared functions only have to wait if the return type of the
+    // function depends on calls that are still pending
+    FunctionDefinition* function = call->userFunction();
+    if (function && !(function->returnExpression() && hasPendingType(function->returnExpression().get())))
+    {
+        return;
+    }
+
+    pendingTypes_.insert(call);
+    resolveTypeLater([this, call, atom = symbol->atom(), name = symbol->name()] {
+        auto functionEntry = functionMap_.find(atom);
+        if (functionEntry == functionMap_.end())
         {
-            args.emplace_back(convertExpression(argExpr));
+            semanticError(call->location(), "Function %s is not defined.", name.c_str());
+            return;
         }
+        FunctionDefinition* function = functionEntry->second;
+        resolvePendingTypes(function);
+
+        if (!call->userFunction())
+        {
+            const auto& functionDefArgs = function->arguments();
+            if (functionDefArgs.size() != call->arguments().size())
+            {
+                semanticError(call->location(), "Function '%s' requires %d arguments, but %d were provided.",
+                              name.c_str(), functionDefArgs.size(), call->arguments().size());
+                return;
+            }
+            for (std::size_t i = 0; i < functionDefArgs.size(); ++i)
+            {
+                resolveCast(static_cast<CastExpression*>(call->arguments()[i].get()), functionDefArgs[i].type);
+            }
+        }
+
+        Type returnType;
+        if (function->returnExpression())
+        {
+            returnType = function->returnExpression()->getType();
+        }
+        call->setUserFunction(function, returnType);
+        pendingTypes_.erase(call);
+    });
+}
+
+void ASTConverter::resolveCommandCallLater(FunctionCallExpression* call, const std::string& commandName)
+{
+    // If any argument's type is pending, all of them were wrapped in a cast
+    const PtrVector<Expression>& args = call->arguments();
+    if (args.empty() || pendingTypes_.count(args.front().get()) == 0)
+    {
+        return;
+    }
+
+    pendingTypes_.insert(call);
+    resolveTypeLater([this, call, commandName] {
+        const PtrVector<Expression>& args = call->arguments();
+        std::vector<Type> argTypes;
+        for (const Ptr<Expression>& arg : args)
+        {
+            argTypes.emplace_back(static_cast<const CastExpression*>(arg.get())->expression()->getType());
+        }
+        const cmd::Command* command = selectCommandOverload(call->location(), commandName, argTypes);
+        for (std::size_t i = 0; i < args.size(); ++i)
+        {
+            resolveCast(static_cast<CastExpression*>(args[i].get()), getTypeFromCommandType(command->args()[i].type));
+        }
+        call->setCommand(command, getTypeFromCommandType(command->returnType()));
+        pendingTypes_.erase(call);
+    });
+}
+
+void ASTConverter::resolvePendingTypes(const FunctionDefinition* function)
+{
+    auto it = pendingTypeResolutions_.find(function);
+    if (it == pendingTypeResolutions_.end())
+    {
+        return;
     }
 
+    // They're taken out first, so a function that ends up calling itself
+    // sees its return type as it is at that point
+    std::vector<std::function<void()>> resolutions = std::move(it->second);
+    pendingTypeResolutions_.erase(it);
+    for (const auto& resolve : resolutions)
+    {
+        resolve();
+    }
+}
+
+const cmd::Command* ASTConverter::selectCommandOverload(SourceLocation* location, const std::string& commandName,
+                                                       const std::vector<Type>& argTypes)
+{
     auto candidates = cmdIndex_.lookup(commandName);
     const cmd::Command* command = candidates.front();
 
     // If there are arguments, then we will need to perform overload resolution.
-    if (!args.empty())
+    if (!argTypes.empty())
     {
         // Remove candidates which don't have the correct number of arguments.
         candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
                                         [&](const Reference<cmd::Command>& candidate)
-                                        { return candidate->args().size() != args.size(); }),
+                                        { return candidate->args().size() != argTypes.size(); }),
                          candidates.end());
 
         // Remove candidates where arguments can not be converted.
@@ -228,7 +381,7 @@ FunctionCallExpression ASTConverter::convertCommandCallExpression(ast::SourceLoc
                 {
                     return true;
                 }
-                if (!isTypeConvertible(args[i]->getType(), getTypeFromCommandType(candidateArgCommandType)))
+                if (!isTypeConvertible(argTypes[i], getTypeFromCommandType(candidateArgCommandType)))
                 {
                     return true;
                 }
@@ -266,7 +419,7 @@ FunctionCallExpression ASTConverter::convertCommandCallExpression(ast::SourceLoc
                 for (std::size_t i = 0; i < overload->args().size(); ++i)
                 {
                     auto overloadType = getTypeFromCommandType(overload->args()[i].type);
-                    auto argType = args[i]->getType();
+                    const Type& argType = argTypes[i];
                     if (overloadType == argType)
                     {
                         score += 10;
@@ -291,6 +444,40 @@ FunctionCallExpression ASTConverter::convertCommandCallExpression(ast::SourceLoc
         std::sort(candidates.begin(), candidates.end(), candidateRankFunction);
         command = candidates.back();
     }
+    return command;
+}
+
+FunctionCallExpression ASTConverter::convertCommandCallExpression(ast::SourceLocation* location,
+                                                                  const std::string& commandName,
+                                                                  const MaybeNull<ast::ArgList>& astArgs)
+{
+    // Extract arguments.
+    PtrVector<Expression> args;
+    if (astArgs.notNull())
+    {
+        for (ast::Expression* argExpr : astArgs->expressions())
+        {
+            args.emplace_back(convertExpression(argExpr));
+        }
+    }
+
+    // The overload can only be chosen once the types of all arguments are known.
+    // Until then, the first candidate stands in for it.
+    if (std::any_of(args.begin(), args.end(), [this](const Ptr<Expression>& arg) { return hasPendingType(arg.get()); }))
+    {
+        for (Ptr<Expression>& arg : args)
+        {
+            arg = castLater(std::move(arg));
+        }
+        return FunctionCallExpression{location, cmdIndex_.lookup(commandName).front().get(), std::move(args), Type{}};
+    }
+
+    std::vector<Type> argTypes;
+    for (const Ptr<Expression>& arg : args)
+    {
+        argTypes.emplace_back(arg->getType());
+    }
+    const cmd::Command* command = selectCommandOverload(location, commandName, argTypes);
 
     // Now we have selected an overload, we may need to insert cast operations when passing arguments (in case the
     // overload is not perfect). Do that now.
@@ -306,15 +493,22 @@ FunctionCallExpression ASTConverter::convertFunctionCallExpression(ast::SourceLo
                                                                    ast::AnnotatedSymbol* symbol,
                                                                    const MaybeNull<ast::ArgList>& astArgs)
 {
-    // Lookup function.
-    auto functionName = symbol->name();
-    auto functionEntry = functionMap_.find(functionName);
+    // Lookup function. If it isn't declared yet, it may still be declared
+    // further down, so the call is resolved by finishProgram().
+    auto functionEntry = functionMap_.find(symbol->atom());
     if (functionEntry == functionMap_.end())
     {
-        semanticError(location, "Function %s is not defined.", functionName.c_str());
-        std::terminate();
+        PtrVector<Expression> args;
+        if (astArgs.notNull())
+        {
+            for (ast::Expression* argExpr : astArgs->expressions())
+            {
+                args.emplace_back(castLater(convertExpression(argExpr)));
+            }
+        }
+        return FunctionCallExpression{location, static_cast<FunctionDefinition*>(nullptr), std::move(args), Type{}};
     }
-    auto* functionDefinition = functionEntry->second.functionDefinition;
+    auto* functionDefinition = functionEntry->second;
 
     // Verify argument list.
     std::size_t astArgCount = 0;
@@ -324,7 +518,7 @@ FunctionCallExpression ASTConverter::convertFunctionCallExpression(ast::SourceLo
     }
     if (functionDefinition->arguments().size() != astArgCount)
     {
-        semanticError(location, "Function '%s' requires %d arguments, but %d were provided.", functionName.c_str(),
+        semanticError(location, "Function '%s' requires %d arguments, but %d were provided.", symbol->name().c_str(),
                       functionDefinition->arguments().size(), astArgs->expressions().size());
         std::terminate();
     }
@@ -346,48 +540,67 @@ FunctionCallExpression ASTConverter::convertFunctionCallExpression(ast::SourceLo
         returnType = functionDefinition->returnExpression()->getType();
     }
 
-    return FunctionCallExpression{location, functionEntry->second.functionDefinition, std::move(args), returnType};
+    return FunctionCallExpression{location, functionDefinition, std::move(args), returnType};
 }
 
 Ptr<Expression> ASTConverter::convertExpression(const ast::Expression* expression)
 {
     auto* location = expression->location();
-    if (auto* unaryOp = dynamic_cast<const ast::UnaryOp*>(expression))
+    switch (expression->kind())
     {
+    case ast::NodeKind::UnaryOp: {
+        auto* unaryOp = static_cast<const ast::UnaryOp*>(expression);
         UnaryOp unaryOpType = static_cast<UnaryOp>(unaryOp->op());
         return std::make_unique<UnaryExpression>(location, unaryOpType, convertExpression(unaryOp->expr()));
     }
-    else if (auto* binaryOp = dynamic_cast<const ast::BinaryOp*>(expression))
-    {
+    case ast::NodeKind::BinaryOp: {
+        auto* binaryOp = static_cast<const ast::BinaryOp*>(expression);
         BinaryOp binaryOpType = static_cast<BinaryOp>(binaryOp->op());
         auto lhs = convertExpression(binaryOp->lhs());
         auto rhs = convertExpression(binaryOp->rhs());
+        if (hasPendingType(lhs.get()))
+        {
+            // The common type is only known once the calls in the left operand
+            // are resolved
+            auto right = castLater(std::move(rhs));
+            CastExpression* rightCast = right.get();
+            auto binary = std::make_unique<BinaryExpression>(location, binaryOpType, std::move(lhs), std::move(right));
+            resolveTypeLater([this, binary = binary.get(), rightCast] {
+                resolveCast(rightCast, getBinaryOpCommonType(binary->op(), binary->left(), rightCast->expression()));
+            });
+            return binary;
+        }
         auto commonType = getBinaryOpCommonType(binaryOpType, lhs.get(), rhs.get());
         return std::make_unique<BinaryExpression>(location, binaryOpType, ensureType(std::move(lhs), commonType),
                                                   ensureType(std::move(rhs), commonType));
     }
-    else if (auto* varRef = dynamic_cast<const ast::VarRef*>(expression))
-    {
+    case ast::NodeKind::VarRef: {
+        auto* varRef = static_cast<const ast::VarRef*>(expression);
         return std::make_unique<VarRefExpression>(location, resolveVariableRef(varRef));
     }
-    else if (auto* literal = dynamic_cast<const ast::Literal*>(expression))
-    {
 #define X(dbname, cppname)                                                                                             \
-    if (auto* ast##dbname##Literal = dynamic_cast<const ast::dbname##Literal*>(literal))                               \
-        return std::make_unique<dbname##Literal>(literal->location(), ast##dbname##Literal->value());
+    case ast::NodeKind::dbname##Literal:                                                                                \
+        return std::make_unique<dbname##Literal>(location,                                                             \
+                                                 static_cast<const ast::dbname##Literal*>(expression)->value());
         ODB_DATATYPE_LIST
 #undef X
-    }
-    else if (auto* command = dynamic_cast<const ast::CommandExpr*>(expression))
-    {
+    case ast::NodeKind::CommandExpr: {
+        auto* command = static_cast<const ast::CommandExpr*>(expression);
         // TODO: Perform type checking of arguments.
-        return std::make_unique<FunctionCallExpression>(
+        auto call = std::make_unique<FunctionCallExpression>(
             convertCommandCallExpression(location, command->command(), command->args()));
+        resolveCommandCallLater(call.get(), command->command());
+        return call;
     }
-    else if (auto* funcCall = dynamic_cast<const ast::FuncCallExpr*>(expression))
-    {
-        return std::make_unique<FunctionCallExpression>(
+    case ast::NodeKind::FuncCallExpr: {
+        auto* funcCall = static_cast<const ast::FuncCallExpr*>(expression);
+        auto call = std::make_unique<FunctionCallExpression>(
             convertFunctionCallExpression(location, funcCall->symbol(), funcCall->args()));
+        resolveFunctionCallLater(call.get(), funcCall->symbol());
+        return call;
+    }
+    default:
+        break;
     }
     fatalError("Unknown expression type");
 }
@@ -395,13 +608,16 @@ Ptr<Expression> ASTConverter::convertExpression(const ast::Expression* expressio
 Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* currentLoop)
 {
     auto* location = statement->location();
-    if (auto* constDeclStatement = dynamic_cast<ast::ConstDecl*>(statement))
+    ast::NodeKind kind = statement->kind();
+    switch (kind)
     {
-        (void)constDeclStatement;
+    case ast::NodeKind::ConstDecl:
         fatalError("Unimplemented ast::ConstDecl");
-    }
-    else if (auto* varDeclSt = dynamic_cast<ast::VarDecl*>(statement))
-    {
+#define X(dbname, cppname) case ast::NodeKind::dbname##VarDecl:
+        ODB_DATATYPE_LIST
+#undef X
+    case ast::NodeKind::UDTVarDecl: {
+        auto* varDeclSt = static_cast<ast::VarDecl*>(statement);
         // Get var ref and type.
         // TheComet: All initializers are now ArgList instead of Expression
         //           because the math datatypes have multiple initializer values
@@ -411,21 +627,27 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         //           type.
         Type varType;
         ast::Expression* initialValue = nullptr;
-#define X(dbname, cppname)                                                    \
-    if (auto* dbname##Ref = dynamic_cast<ast::dbname##VarDecl*>(varDeclSt))   \
-    {                                                                         \
-        varType = Type{BuiltinType::dbname};                                  \
-        initialValue = dbname##Ref->initializer()->expressions()[0];          \
+        switch (kind)
+        {
+#define X(dbname, cppname)                                                                                             \
+    case ast::NodeKind::dbname##VarDecl: {                                                                              \
+        auto* dbname##Ref = static_cast<ast::dbname##VarDecl*>(varDeclSt);                                             \
+        varType = Type{BuiltinType::dbname};                                                                           \
+        initialValue = dbname##Ref->initializer()->expressions()[0];                                                   \
+        break;                                                                                                         \
     }
-        ODB_DATATYPE_LIST
+            ODB_DATATYPE_LIST
 #undef X
+        default:
+            break;
+        }
         // TODO: Implement UDTs.
         // TheComet: UDTVarDecl::initializer() may be nullptr for UDT declarations
         //           specifically. In all other cases it should not be null.
 
         // If we're declaring a new variable, it must not exist already.
         auto annotation = getAnnotation(varDeclSt->symbol()->annotation());
-        Reference<Variable> variable = currentFunction_->variables().lookup(varDeclSt->symbol()->name(), annotation);
+        Reference<Variable> variable = currentFunction_->variables().lookup(varDeclSt->symbol()->atom(), annotation);
         if (variable)
         {
             semanticError(varDeclSt->symbol()->location(), "Variable %s has already been declared as type %s.",
@@ -435,37 +657,69 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         }
 
         // Declare new variable.
-        variable = new Variable(varDeclSt->symbol()->location(), varDeclSt->symbol()->name(), annotation, varType);
+        variable = new Variable(varDeclSt->symbol()->location(), varDeclSt->symbol()->atom(), varDeclSt->symbol()->name(),
+                                annotation, varType);
         currentFunction_->variables().add(variable);
 
         return std::make_unique<VarAssignment>(location, currentFunction_, variable,
                                                ensureType(convertExpression(initialValue), varType));
     }
-    else if (auto* assignmentSt = dynamic_cast<ast::VarAssignment*>(statement))
-    {
+    case ast::NodeKind::VarAssignment: {
+        auto* assignmentSt = static_cast<ast::VarAssignment*>(statement);
         auto variable = resolveVariableRef(assignmentSt->variable());
         auto expression = ensureType(convertExpression(assignmentSt->expression()), variable->type());
         return std::make_unique<VarAssignment>(location, currentFunction_, std::move(variable), std::move(expression));
     }
-    else if (auto* conditionalSt = dynamic_cast<ast::Conditional*>(statement))
-    {
+    case ast::NodeKind::Conditional: {
+        auto* conditionalSt = static_cast<ast::Conditional*>(statement);
         return std::make_unique<Conditional>(
             location, currentFunction_,
             ensureType(convertExpression(conditionalSt->condition()), Type{BuiltinType::Boolean}),
             convertBlock(conditionalSt->trueBranch(), currentLoop),
             convertBlock(conditionalSt->falseBranch(), currentLoop));
     }
-    else if (auto* subReturnSt = dynamic_cast<ast::SubReturn*>(statement))
-    {
-        (void)subReturnSt;
+    case ast::NodeKind::Select: {
+        auto* selectSt = static_cast<ast::Select*>(statement);
+        auto expression = convertExpression(selectSt->expression());
+        Type type = expression->getType();
+        std::vector<Select::Case> cases;
+        if (selectSt->cases().notNull())
+        {
+            for (const auto& caseSt : selectSt->cases()->cases())
+            {
+                Select::Case& selectCase = cases.emplace_back();
+                if (hasPendingType(expression.get()))
+                {
+                    auto condition = castLater(convertExpression(caseSt->expression()));
+                    resolveTypeLater([this, subject = expression.get(), condition = condition.get()] {
+                        resolveCast(condition, subject->getType());
+                    });
+                    selectCase.condition = std::move(condition);
+                }
+                else
+                {
+                    selectCase.condition = ensureType(convertExpression(caseSt->expression()), type);
+                }
+                selectCase.statements = convertBlock(caseSt->body(), currentLoop);
+            }
+            // The default case runs if no other case matches, wherever it is.
+            auto defaultCase = selectSt->cases()->defaultCase();
+            if (defaultCase.notNull())
+            {
+                cases.emplace_back().statements = convertBlock(defaultCase->body(), currentLoop);
+            }
+        }
+        return std::make_unique<Select>(location, currentFunction_, std::move(expression), std::move(cases));
+    }
+    case ast::NodeKind::SubReturn: {
         return std::make_unique<SubReturn>(location, currentFunction_);
     }
-    else if (auto* funcExitSt = dynamic_cast<ast::FuncExit*>(statement))
-    {
+    case ast::NodeKind::FuncExit: {
+        auto* funcExitSt = static_cast<ast::FuncExit*>(statement);
         return std::make_unique<ExitFunction>(location, currentFunction_, convertExpression(funcExitSt->returnValue()));
     }
-    else if (auto* forLoopSt = dynamic_cast<ast::ForLoop*>(statement))
-    {
+    case ast::NodeKind::ForLoop: {
+        auto* forLoopSt = static_cast<ast::ForLoop*>(statement);
         auto* astVarAssignment = static_cast<ast::VarAssignment*>(forLoopSt->counter());
         auto variable = resolveVariableRef(astVarAssignment->variable());
         // TODO: Ensure variable is a valid for loop counter.
@@ -488,28 +742,28 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         forLoop->appendStatements(convertBlock(forLoopSt->body(), forLoop.get()));
         return forLoop;
     }
-    else if (auto* whileLoopSt = dynamic_cast<ast::WhileLoop*>(statement))
-    {
+    case ast::NodeKind::WhileLoop: {
+        auto* whileLoopSt = static_cast<ast::WhileLoop*>(statement);
         auto whileLoop = std::make_unique<WhileLoop>(location, currentFunction_,
                                                      convertExpression(whileLoopSt->continueCondition()));
         whileLoop->appendStatements(convertBlock(whileLoopSt->body(), whileLoop.get()));
         return whileLoop;
     }
-    else if (auto* untilLoopSt = dynamic_cast<ast::UntilLoop*>(statement))
-    {
+    case ast::NodeKind::UntilLoop: {
+        auto* untilLoopSt = static_cast<ast::UntilLoop*>(statement);
         auto untilLoop =
             std::make_unique<UntilLoop>(location, currentFunction_, convertExpression(untilLoopSt->exitCondition()));
         untilLoop->appendStatements(convertBlock(untilLoopSt->body(), untilLoop.get()));
         return untilLoop;
     }
-    else if (auto* infiniteLoopSt = dynamic_cast<ast::InfiniteLoop*>(statement))
-    {
+    case ast::NodeKind::InfiniteLoop: {
+        auto* infiniteLoopSt = static_cast<ast::InfiniteLoop*>(statement);
         auto infiniteLoop = std::make_unique<InfiniteLoop>(location, currentFunction_);
         infiniteLoop->appendStatements(convertBlock(infiniteLoopSt->body(), infiniteLoop.get()));
         return infiniteLoop;
     }
-    else if (auto* exitSt = dynamic_cast<ast::Exit*>(statement))
-    {
+    case ast::NodeKind::Exit: {
+        auto* exitSt = static_cast<ast::Exit*>(statement);
         if (!currentLoop)
         {
             semanticError(exitSt->location(), "Encountered 'exit' statement outside a loop body.");
@@ -517,10 +771,10 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         }
         return std::make_unique<Exit>(location, currentFunction_, currentLoop);
     }
-    else if (auto* labelSt = dynamic_cast<ast::Label*>(statement))
-    {
-        auto labelName = labelSt->symbol()->name();
-        auto irLabel = std::make_unique<Label>(location, currentFunction_, labelName);
+    case ast::NodeKind::Label: {
+        auto* labelSt = static_cast<ast::Label*>(statement);
+        ast::Atom labelName = labelSt->symbol()->atom();
+        auto irLabel = std::make_unique<Label>(location, currentFunction_, labelSt->symbol()->name());
         auto pendingGotoStatements = pendingGotoStatements_.equal_range(labelName);
         auto pendingGosubStatements = pendingGosubStatements_.equal_range(labelName);
         for (auto it = pendingGotoStatements.first; it != pendingGotoStatements.second; ++it)
@@ -536,15 +790,17 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         labels_.emplace(labelName, irLabel.get());
         return irLabel;
     }
-    else if (auto* funcCallSt = dynamic_cast<ast::FuncCallStmnt*>(statement))
-    {
-        return std::make_unique<FunctionCall>(
+    case ast::NodeKind::FuncCallStmnt: {
+        auto* funcCallSt = static_cast<ast::FuncCallStmnt*>(statement);
+        auto funcCall = std::make_unique<FunctionCall>(
             location, currentFunction_,
             convertFunctionCallExpression(funcCallSt->location(), funcCallSt->symbol(), funcCallSt->args()));
+        resolveFunctionCallLater(&funcCall->expression(), funcCallSt->symbol());
+        return funcCall;
     }
-    else if (auto* gotoSt = dynamic_cast<ast::Goto*>(statement))
-    {
-        std::string labelName = gotoSt->label()->name();
+    case ast::NodeKind::Goto: {
+        auto* gotoSt = static_cast<ast::Goto*>(statement);
+        ast::Atom labelName = gotoSt->label()->atom();
         auto labelIt = labels_.find(labelName);
         Label* label = labelIt != labels_.end() ? labelIt->second : nullptr;
         auto irGotoSt = std::make_unique<Goto>(location, currentFunction_, label);
@@ -554,9 +810,9 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         }
         return irGotoSt;
     }
-    else if (auto* subCallSt = dynamic_cast<ast::SubCall*>(statement))
-    {
-        std::string labelName = subCallSt->label()->name();
+    case ast::NodeKind::SubCall: {
+        auto* subCallSt = static_cast<ast::SubCall*>(statement);
+        ast::Atom labelName = subCallSt->label()->atom();
         auto labelIt = labels_.find(labelName);
         Label* label = labelIt != labels_.end() ? labelIt->second : nullptr;
         auto irGosubSt = std::make_unique<Gosub>(location, currentFunction_, label);
@@ -566,16 +822,18 @@ Ptr<Statement> ASTConverter::convertStatement(ast::Statement* statement, Loop* c
         }
         return irGosubSt;
     }
-    else if (auto* commandSt = dynamic_cast<ast::CommandStmnt*>(statement))
-    {
-        return std::make_unique<FunctionCall>(
+    case ast::NodeKind::CommandStmnt: {
+        auto* commandSt = static_cast<ast::CommandStmnt*>(statement);
+        auto commandCall = std::make_unique<FunctionCall>(
             location, currentFunction_,
             convertCommandCallExpression(commandSt->location(), commandSt->command(), commandSt->args()));
+        resolveCommandCallLater(&commandCall->expression(), commandSt->command());
+        return commandCall;
     }
-    else
-    {
-        fatalError("Unknown statement type.");
+    default:
+        break;
     }
+    fatalError("Unknown statement type.");
 }
 
 StatementBlock ASTConverter::convertBlock(const MaybeNull<ast::Block>& ast, Loop* currentLoop)
@@ -620,63 +878,75 @@ std::unique_ptr<FunctionDefinition> ASTConverter::convertFunctionWithoutBody(ast
     return std::make_unique<FunctionDefinition>(funcDecl->location(), funcDecl->symbol()->name(), std::move(args));
 }
 
-std::unique_ptr<Program> ASTConverter::generateProgram(const ast::Block* ast)
+void ASTConverter::convertFunctionBody(const ast::FuncDecl* funcDecl, FunctionDefinition* functionDefinition)
 {
-    bool reachedEndOfMain = false;
-
-    PtrVector<FunctionDefinition> functionDefinitions;
+    TraceScope trace("semantic", "convert function", funcDecl->symbol()->name());
+    currentFunction_ = functionDefinition;
+    functionDefinition->appendStatements(convertBlock(funcDecl->body(), nullptr));
+    if (funcDecl->returnValue().notNull())
+    {
+        functionDefinition->setReturnExpression(convertExpression(funcDecl->returnValue()));
+    }
+}
 
-    // Extract main function statements, and populate function table.
-    std::vector<Reference<ast::Statement>> astMainStatements;
-    for (const Reference<ast::Statement>& s : ast->statements())
+void ASTConverter::addStatement(ast::Statement* statement)
+{
+    auto* astFuncDecl = dynamic_cast<ast::FuncDecl*>(statement);
+    if (!astFuncDecl)
     {
-        auto* astFuncDecl = dynamic_cast<ast::FuncDecl*>(s.get());
-        if (!astFuncDecl)
+        // If we've reached the end of the main function, we should only processing functions.
+        if (reachedEndOfMain_)
         {
-            // If we've reached the end of the main function, we should only processing functions.
-            if (reachedEndOfMain)
-            {
-                // TODO: Handle error properly.
-                std::cerr << "We've reached the end of main, but encountered a node "
-                             "that isn't a function.";
-                std::terminate();
-            }
-            else
-            {
-                // Append to main block.
-                astMainStatements.emplace_back(s);
-            }
+            // TODO: Handle error properly.
+            std::cerr << "We've reached the end of main, but encountered a node "
+                         "that isn't a function.";
+            std::terminate();
         }
-        else
-        {
-            // We've reached the end of main once we hit a function declaration.
-            reachedEndOfMain = true;
 
-            // Generate function definition.
-            functionDefinitions.emplace_back(convertFunctionWithoutBody(astFuncDecl));
-            functionMap_.emplace(astFuncDecl->symbol()->name(),
-                                 Function{astFuncDecl, functionDefinitions.back().get()});
-        }
+        currentFunction_ = mainFunction_.get();
+        StatementBlock block;
+        block.emplace_back(convertStatement(statement, nullptr));
+        mainFunction_->appendStatements(std::move(block));
+        return;
     }
 
-    // Generate functions bodies.
-    FunctionDefinition mainFunction(new ast::InlineSourceLocation("", "", 0, 0, 0, 1), "main");
-    currentFunction_ = &mainFunction;
-    mainFunction.appendStatements(convertBlock(astMainStatements, nullptr));
-    for (auto& [_, funcDetails] : functionMap_)
+    // We've reached the end of main once we hit a function declaration.
+    reachedEndOfMain_ = true;
+
+    // Generate function definition. Declaring it before converting the body
+    // allows functions to call themselves.
+    functionDefinitions_.emplace_back(convertFunctionWithoutBody(astFuncDecl));
+    FunctionDefinition* functionDefinition = functionDefinitions_.back().get();
+    functionMap_.emplace(astFuncDecl->symbol()->atom(), functionDefinition);
+    convertFunctionBody(astFuncDecl, functionDefinition);
+}
+
+std::unique_ptr<Program> ASTConverter::finishProgram()
+{
+    // Every function is declared by now, so the calls to functions that
+    // weren't declared yet when they were converted can be resolved.
     {
-        currentFunction_ = funcDetails.functionDefinition;
-        funcDetails.functionDefinition->appendStatements(convertBlock(funcDetails.ast->body()->statements(), nullptr));
-        if (funcDetails.ast->returnValue().notNull())
+        TraceScope trace("semantic", "resolve pending calls");
+        for (const auto& functionDefinition : functionDefinitions_)
         {
-            funcDetails.functionDefinition->setReturnExpression(convertExpression(funcDetails.ast->returnValue()));
+            resolvePendingTypes(functionDefinition.get());
         }
+        resolvePendingTypes(mainFunction_.get());
     }
 
     if (errorOccurred_)
     {
         return nullptr;
     }
-    return std::make_unique<Program>(std::move(mainFunction), std::move(functionDefinitions));
+    return std::make_unique<Program>(std::move(*mainFunction_), std::move(functionDefinitions_));
+}
+
+std::unique_ptr<Program> ASTConverter::generateProgram(const ast::Block* ast)
+{
+    for (const Reference<ast::Statement>& s : ast->statements())
+    {
+        addStatement(s);
+    }
+    return finishProgram();
 }
 } // namespace odb::ir
@@ -7,33 +7,49 @@
 #include "odb-compiler/ir/Node.hpp"
 
 #include <array>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace odb::ir {
 class ASTConverter
 {
 public:
-    struct Function
-    {
-        ast::FuncDecl* ast;
-        FunctionDefinition* functionDefinition;
-    };
-
-    explicit ASTConverter(const cmd::CommandIndex& cmdIndex) : cmdIndex_(cmdIndex), errorOccurred_(false) {}
+    explicit ASTConverter(const cmd::CommandIndex& cmdIndex);
 
     std::unique_ptr<Program> generateProgram(const ast::Block* ast);
 
+    // Converts the top-level statements of a program one at a time, in the
+    // order they appear in the source, so the AST of each one can be freed
+    // before the rest of the program was parsed. Calls to functions that
+    // aren't declared yet are resolved by finishProgram().
+    void addStatement(ast::Statement* statement);
+    std::unique_ptr<Program> finishProgram();
+
 private:
     const cmd::CommandIndex& cmdIndex_;
-    std::unordered_map<std::string, Function> functionMap_;
+    std::unordered_map<ast::Atom, FunctionDefinition*> functionMap_;
 
     bool errorOccurred_;
 
+    std::unique_ptr<FunctionDefinition> mainFunction_;
+    PtrVector<FunctionDefinition> functionDefinitions_;
+    bool reachedEndOfMain_;
+
     FunctionDefinition* currentFunction_;
-    std::unordered_multimap<std::string, Goto*> pendingGotoStatements_;
-    std::unordered_multimap<std::string, Gosub*> pendingGosubStatements_;
-    std::unordered_map<std::string, Label*> labels_;
+    std::unordered_multimap<ast::Atom, Goto*> pendingGotoStatements_;
+    std::unordered_multimap<ast::Atom, Gosub*> pendingGosubStatements_;
+
+    // Calls to functions that aren't declared yet have no target and a void
+    // type until finishProgram() resolves them. So do the expressions whose
+    // type depends on them, and the casts that convert them to whatever type
+    // is expected. Everything that has to happen once a type is known is
+    // kept with the function it's in, in the order it has to happen in.
+    std::unordered_set<const Expression*> pendingTypes_;
+    std::unordered_map<const FunctionDefinition*, std::vector<std::function<void()>>> pendingTypeResolutions_;
+
+    std::unordered_map<ast::Atom, Label*> labels_;
 
 private:
     template <typename... T> void semanticWarning(SourceLocation* location, const char* format, T... args)
@@ -64,12 +80,24 @@ private:
 
     bool isTypeConvertible(Type sourceType, Type targetType) const;
     Ptr<Expression> ensureType(Ptr<Expression> expression, Type targetType);
+
+    bool hasPendingType(const Expression* expression) const;
+    Ptr<CastExpression> castLater(Ptr<Expression> expression);
+    void resolveCast(CastExpression* cast, Type targetType);
+    void checkConversion(const CastExpression* cast);
+    void resolveTypeLater(std::function<void()> resolve);
+    void resolveFunctionCallLater(FunctionCallExpression* call, const ast::AnnotatedSymbol* symbol);
+    void resolveCommandCallLater(FunctionCallExpression* call, const std::string& commandName);
+    void resolvePendingTypes(const FunctionDefinition* function);
     Reference<Variable> resolveVariableRef(const ast::VarRef* varRef);
 
+    const cmd::Command* selectCommandOverload(SourceLocation* location, const std::string& commandName,
+                                              const std::vector<Type>& argTypes);
     FunctionCallExpression convertCommandCallExpression(SourceLocation* location, const std::string& commandName,
                                                         const MaybeNull<ast::ArgList>& astArgs);
     FunctionCallExpression convertFunctionCallExpression(SourceLocation* location, ast::AnnotatedSymbol* symbol,
                                                          const MaybeNull<ast::ArgList>& astArgs);
+
     Ptr<Expression> convertExpression(const ast::Expression* expression);
 
     Ptr<Statement> convertStatement(ast::Statement* statement, Loop* currentLoop);
@@ -77,5 +105,6 @@ private:
     StatementBlock convertBlock(const std::vector<Reference<ast::Statement>>& ast, Loop* currentLoop);
 
     std::unique_ptr<FunctionDefinition> convertFunctionWithoutBody(ast::FuncDecl* funcDecl);
+    void convertFunctionBody(const ast::FuncDecl* funcDecl, FunctionDefinition* functionDefinition);
 };
 } // namespace odb::ir
@@ -0,0 +1,463 @@
+#include "odb-compiler/irpost/FoldConstants.hpp"
+#include "odb-compiler/ir/AssignmentAnalysis.hpp"
+#include "odb-compiler/ir/Node.hpp"
+
+#include "../ir/interpreter/CommandCall.hpp"
+#include "../ir/interpreter/Operators.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace odb::irpost {
+
+namespace {
+// ----------------------------------------------------------------------------
+// Value of a scalar literal, stored the same way as in an interpreter register
+struct Constant
+{
+    ir::BuiltinType type;
+    ir::Value value;
+
+    bool operator==(const Constant& other) const
+    {
+        return type == other.type && value.bits == other.value.bits;
+    }
+};
+
+template <typename T>
+std::optional<Constant> makeConstant(T value)
+{
+    Constant constant{ir::LiteralType<T>::type, {}};
+    constant.value.set<T>(value);
+    return constant;
+}
+
+// ----------------------------------------------------------------------------
+std::optional<Constant> literalValue(const ir::Expression* e)
+{
+    switch (e->kind())
+    {
+    case ir::ExpressionKind::DoubleIntegerLiteral:
+        return makeConstant(static_cast<const ir::DoubleIntegerLiteral*>(e)->value());
+    case ir::ExpressionKind::IntegerLiteral:
+        return makeConstant(static_cast<const ir::IntegerLiteral*>(e)->value());
+    case ir::ExpressionKind::DwordLiteral:
+        return makeConstant(static_cast<const ir::DwordLiteral*>(e)->value());
+    case ir::ExpressionKind::WordLiteral:
+        return makeConstant(static_cast<const ir::WordLiteral*>(e)->value());
+    case ir::ExpressionKind::ByteLiteral:
+        return makeConstant(static_cast<const ir::ByteLiteral*>(e)->value());
+    case ir::ExpressionKind::BooleanLiteral:
+        return makeConstant(static_cast<const ir::BooleanLiteral*>(e)->value());
+    case ir::ExpressionKind::DoubleFloatLiteral:
+        return makeConstant(static_cast<const ir::DoubleFloatLiteral*>(e)->value());
+    case ir::ExpressionKind::FloatLiteral:
+        return makeConstant(static_cast<const ir::FloatLiteral*>(e)->value());
+    default:
+        return std::nullopt;
+    }
+}
+
+ir::Ptr<ir::Expression> createLiteral(ir::SourceLocation* location, const Constant& constant)
+{
+    return ir::forScalarType(constant.type, [&](auto t) -> ir::Ptr<ir::Expression> {
+        using T = decltype(t);
+        return std::make_unique<ir::LiteralTemplate<T>>(location, constant.value.get<T>());
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Converting a floating point value that doesn't fit into the target type is
+// undefined, so those are left for the runtime to deal with.
+template <typename To, typename From>
+bool isRepresentable(From value)
+{
+    if constexpr (std::is_floating_point_v<From> && std::is_integral_v<To> && !std::is_same_v<To, bool>)
+    {
+        return double(value) > double(std::numeric_limits<To>::min()) - 1.0 &&
+               double(value) < double(std::numeric_limits<To>::max()) + 1.0;
+    }
+    else if constexpr (std::is_same_v<From, double> && std::is_same_v<To, float>)
+    {
+        return !std::isfinite(value) || std::fabs(value) <= double(FLT_MAX);
+    }
+    else
+    {
+        return true;
+    }
+}
+
+std::optional<Constant> foldCast(const Constant& operand, ir::BuiltinType targetType)
+{
+    return ir::forScalarType(operand.type, [&](auto from) -> std::optional<Constant> {
+        using From = decltype(from);
+        return ir::forScalarType(targetType, [&](auto to) -> std::optional<Constant> {
+            using To = decltype(to);
+            From value = operand.value.get<From>();
+            if (!isRepresentable<To>(value))
+                return std::nullopt;
+            return makeConstant(static_cast<To>(value));
+        });
+    });
+}
+
+std::optional<Constant> foldUnary(ir::UnaryOp op, const Constant& operand)
+{
+    switch (op)
+    {
+    case ir::UnaryOp::NEGATE:
+        return ir::forNumericType(operand.type, [&](auto t) -> std::optional<Constant> {
+            using T = decltype(t);
+            return makeConstant(ir::Sub::apply(T(0), operand.value.get<T>()));
+        });
+    case ir::UnaryOp::BITWISE_NOT:
+        return ir::forIntegralType(operand.type, [&](auto t) -> std::optional<Constant> {
+            using T = decltype(t);
+            return makeConstant(T(~operand.value.get<T>()));
+        });
+    case ir::UnaryOp::LOGICAL_NOT:
+        if (operand.type != ir::BuiltinType::Boolean)
+            return std::nullopt;
+        return makeConstant(!operand.value.get<bool>());
+    }
+    return std::nullopt;
+}
+
+// ----------------------------------------------------------------------------
+// The types each operator is folded for are the ones the interpreter
+// implements it for
+template <typename Op>
+std::optional<Constant> foldIntegral(const Constant& left, const Constant& right)
+{
+    return ir::forIntegralType(left.type, [&](auto t) -> std::optional<Constant> {
+        using T = decltype(t);
+        return makeConstant(Op::apply(left.value.get<T>(), right.value.get<T>()));
+    });
+}
+
+template <typename Op>
+std::optional<Constant> foldNumeric(const Constant& left, const Constant& right)
+{
+    return ir::forNumericType(left.type, [&](auto t) -> std::optional<Constant> {
+        using T = decltype(t);
+        return makeConstant(Op::apply(left.value.get<T>(), right.value.get<T>()));
+    });
+}
+
+template <typename Op>
+std::optional<Constant> foldScalar(const Constant& left, const Constant& right)
+{
+    return ir::forScalarType(left.type, [&](auto t) -> std::optional<Constant> {
+        using T = decltype(t);
+        return makeConstant(Op::apply(left.value.get<T>(), right.value.get<T>()));
+    });
+}
+
+template <typename Op>
+std::optional<Constant> foldDivision(const Constant& left, const Constant& right)
+{
+    return ir::forNumericType(left.type, [&](auto t) -> std::optional<Constant> {
+        using T = decltype(t);
+        T a = left.value.get<T>();
+        T b = right.value.get<T>();
+        if constexpr (std::is_integral_v<T>)
+        {
+            // This is a runtime error
+            if (b == T(0))
+                return std::nullopt;
+            return makeConstant(ir::IntegerDivide<std::is_same_v<Op, ir::Modulo>>::apply(a, b));
+        }
+        else
+        {
+            return makeConstant(Op::apply(a, b));
+        }
+    });
+}
+
+std::optional<Constant> foldPower(const Constant& left, const Constant& right)
+{
+    return ir::forNumericType(left.type, [&](auto t) -> std::optional<Constant> {
+        using T = decltype(t);
+        if (!isRepresentable<T>(std::pow(left.value.get<T>(), right.value.get<T>())))
+            return std::nullopt;
+        return makeConstant(ir::Power::apply(left.value.get<T>(), right.value.get<T>()));
+    });
+}
+
+std::optional<Constant> foldBinary(ir::BinaryOp op, const Constant& left, const Constant& right)
+{
+    if (left.type != right.type)
+        return std::nullopt;
+
+    switch (op)
+    {
+    case ir::BinaryOp::ADD: return foldNumeric<ir::Add>(left, right);
+    case ir::BinaryOp::SUB: return foldNumeric<ir::Sub>(left, right);
+    case ir::BinaryOp::MUL: return foldNumeric<ir::Mul>(left, right);
+    case ir::BinaryOp::DIV: return foldDivision<ir::Divide>(left, right);
+    case ir::BinaryOp::MOD: return foldDivision<ir::Modulo>(left, right);
+    case ir::BinaryOp::POW: return foldPower(left, right);
+    case ir::BinaryOp::SHIFT_LEFT: return foldIntegral<ir::ShiftLeft>(left, right);
+    case ir::BinaryOp::SHIFT_RIGHT: return foldIntegral<ir::ShiftRight>(left, right);
+    case ir::BinaryOp::BITWISE_OR: return foldIntegral<ir::BitwiseOr>(left, right);
+    case ir::BinaryOp::BITWISE_AND: return foldIntegral<ir::BitwiseAnd>(left, right);
+    case ir::BinaryOp::BITWISE_XOR: return foldIntegral<ir::BitwiseXor>(left, right);
+    case ir::BinaryOp::LESS_THAN: return foldScalar<ir::Less>(left, right);
+    case ir::BinaryOp::LESS_EQUAL: return foldScalar<ir::LessEqual>(left, right);
+    case ir::BinaryOp::GREATER_THAN: return foldScalar<ir::Greater>(left, right);
+    case ir::BinaryOp::GREATER_EQUAL: return foldScalar<ir::GreaterEqual>(left, right);
+    case ir::BinaryOp::EQUAL: return foldScalar<ir::Equal>(left, right);
+    case ir::BinaryOp::NOT_EQUAL: return foldScalar<ir::NotEqual>(left, right);
+    case ir::BinaryOp::LOGICAL_OR: return foldScalar<ir::LogicalOr>(left, right);
+    case ir::BinaryOp::LOGICAL_AND: return foldScalar<ir::LogicalAnd>(left, right);
+    case ir::BinaryOp::LOGICAL_XOR: return foldScalar<ir::LogicalXor>(left, right);
+
+    // Only exists in the AST, where it gets rewritten into a unary op
+    case ir::BinaryOp::BITWISE_NOT: break;
+    }
+    return std::nullopt;
+}
+
+// ----------------------------------------------------------------------------
+class Folder
+{
+public:
+    void foldFunction(ir::FunctionDefinition* function)
+    {
+        known_.clear();
+        foldBlock(function->statements());
+        if (function->returnExpression())
+            if (auto literal = fold(function->returnExpression().get()))
+                function->setReturnExpression(std::move(literal));
+    }
+
+private:
+    // Folds the children of the expression in place. Returns the literal to
+    // replace the expression with, or nullptr if it isn't constant.
+    ir::Ptr<ir::Expression> fold(ir::Expression* e)
+    {
+        std::optional<Constant> result;
+        switch (e->kind())
+        {
+        case ir::ExpressionKind::Cast: {
+            auto* cast = static_cast<ir::CastExpression*>(e);
+            if (auto literal = fold(cast->expression()))
+                cast->setExpression(std::move(literal));
+            auto operand = literalValue(cast->expression());
+            auto targetType = cast->targetType().getBuiltinType();
+            if (operand && targetType)
+                result = foldCast(*operand, *targetType);
+            break;
+        }
+        case ir::ExpressionKind::Unary: {
+            auto* unary = static_cast<ir::UnaryExpression*>(e);
+            if (auto literal = fold(unary->expression()))
+                unary->setExpression(std::move(literal));
+            if (auto operand = literalValue(unary->expression()))
+                result = foldUnary(unary->op(), *operand);
+            break;
+        }
+        case ir::ExpressionKind::Binary: {
+            auto* binary = static_cast<ir::BinaryExpression*>(e);
+            if (auto literal = fold(binary->left()))
+                binary->setLeft(std::move(literal));
+            if (auto literal = fold(binary->right()))
+                binary->setRight(std::move(literal));
+            auto left = literalValue(binary->left());
+            auto right = literalValue(binary->right());
+            if (left && right)
+                result = foldBinary(binary->op(), *left, *right);
+            break;
+        }
+        case ir::ExpressionKind::VarRef: {
+            auto it = known_.find(static_cast<ir::VarRefExpression*>(e)->variable());
+            if (it != known_.end())
+                result = it->second;
+            break;
+        }
+        case ir::ExpressionKind::FunctionCall:
+            foldArguments(static_cast<ir::FunctionCallExpression*>(e));
+            break;
+        default:
+            break;
+        }
+
+        if (!result)
+            return nullptr;
+        return createLiteral(e->location(), *result);
+    }
+
+    void foldArguments(ir::FunctionCallExpression* call)
+    {
+        for (std::size_t i = 0; i != call->arguments().size(); ++i)
+            if (auto literal = fold(call->arguments()[i].get()))
+                call->setArgument(i, std::move(literal));
+    }
+
+    // ------------------------------------------------------------------------
+    void foldAssignment(ir::VarAssignment* assignment)
+    {
+        if (auto literal = fold(assignment->expression()))
+            assignment->setExpression(std::move(literal));
+
+        const ir::Variable* variable = assignment->variable();
+        auto value = literalValue(assignment->expression());
+        if (value && variable->type() == ir::Type{value->type})
+            known_[variable] = *value;
+        else
+            known_.erase(variable);
+    }
+
+    void foldBlock(const ir::StatementBlock& block)
+    {
+        for (const auto& s : block)
+            foldStatement(s.get());
+    }
+
+    // Keeps only what is known on both paths
+    void mergeWith(const std::unordered_map<const ir::Variable*, Constant>& other)
+    {
+        for (auto it = known_.begin(); it != known_.end();)
+        {
+            auto otherIt = other.find(it->first);
+            if (otherIt == other.end() || !(otherIt->second == it->second))
+                it = known_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // Forgets everything the loop may change, so what is left holds at the
+    // start of every iteration and after the loop
+    void enterLoop(const ir::Loop* loop)
+    {
+        std::unordered_set<const ir::Variable*> assigned;
+        if (!ir::collectAssignedVariables(loop->statements(), assigned))
+        {
+            known_.clear();
+            return;
+        }
+        if (loop->kind() == ir::StatementKind::ForLoop)
+            assigned.insert(static_cast<const ir::ForLoop*>(loop)->assignment().variable());
+        for (const ir::Variable* variable : assigned)
+            known_.erase(variable);
+    }
+
+    void foldLoopBody(const ir::Loop* loop)
+    {
+        auto atLoopStart = known_;
+        foldBlock(loop->statements());
+        known_ = std::move(atLoopStart);
+    }
+
+    void foldStatement(ir::Statement* s)
+    {
+        switch (s->kind())
+        {
+        case ir::StatementKind::VarAssignment:
+            foldAssignment(static_cast<ir::VarAssignment*>(s));
+            break;
+        case ir::StatementKind::Conditional: {
+            auto* conditional = static_cast<ir::Conditional*>(s);
+            if (auto literal = fold(conditional->expression()))
+                conditional->setExpression(std::move(literal));
+            auto beforeBranches = known_;
+            foldBlock(conditional->trueBranch());
+            auto afterTrueBranch = std::move(known_);
+            known_ = std::move(beforeBranches);
+            foldBlock(conditional->falseBranch());
+            mergeWith(afterTrueBranch);
+            break;
+        }
+        case ir::StatementKind::Select: {
+            auto* select = static_cast<ir::Select*>(s);
+            if (auto literal = fold(select->expression()))
+                select->setExpression(std::move(literal));
+            // No case may match, so what was known before is one of the paths
+            auto beforeCases = known_;
+            auto afterCases = known_;
+            for (const auto& case_ : select->cases())
+            {
+                if (case_.condition)
+                    fold(case_.condition.get());
+                known_ = beforeCases;
+                foldBlock(case_.statements);
+                mergeWith(afterCases);
+                afterCases = std::move(known_);
+            }
+            known_ = std::move(afterCases);
+            break;
+        }
+        case ir::StatementKind::ForLoop: {
+            auto* forLoop = static_cast<ir::ForLoop*>(s);
+            foldAssignment(&forLoop->assignment());
+            enterLoop(forLoop);
+            if (auto literal = fold(forLoop->endValue()))
+                forLoop->setEndValue(std::move(literal));
+            if (auto literal = fold(forLoop->stepValue()))
+                forLoop->setStepValue(std::move(literal));
+            foldLoopBody(forLoop);
+            break;
+        }
+        case ir::StatementKind::WhileLoop: {
+            auto* whileLoop = static_cast<ir::WhileLoop*>(s);
+            enterLoop(whileLoop);
+            if (auto literal = fold(whileLoop->expression()))
+                whileLoop->setExpression(std::move(literal));
+            foldLoopBody(whileLoop);
+            break;
+        }
+        case ir::StatementKind::UntilLoop: {
+            auto* untilLoop = static_cast<ir::UntilLoop*>(s);
+            enterLoop(untilLoop);
+            if (auto literal = fold(untilLoop->expression()))
+                untilLoop->setExpression(std::move(literal));
+            foldLoopBody(untilLoop);
+            break;
+        }
+        case ir::StatementKind::InfiniteLoop:
+            enterLoop(static_cast<ir::Loop*>(s));
+            foldLoopBody(static_cast<ir::Loop*>(s));
+            break;
+        case ir::StatementKind::Label:
+        case ir::StatementKind::Gosub:
+            // Control can arrive from any goto, or come back from a
+            // subroutine that changed anything
+            known_.clear();
+            break;
+        case ir::StatementKind::FunctionCall:
+            foldArguments(&static_cast<ir::FunctionCall*>(s)->expression());
+            break;
+        case ir::StatementKind::ExitFunction: {
+            auto* exitFunction = static_cast<ir::ExitFunction*>(s);
+            if (exitFunction->expression())
+                if (auto literal = fold(exitFunction->expression()))
+                    exitFunction->setExpression(std::move(literal));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    std::unordered_map<const ir::Variable*, Constant> known_;
+};
+}
+
+// ----------------------------------------------------------------------------
+bool FoldConstants::execute(ir::Program* program)
+{
+    Folder folder;
+    folder.foldFunction(&program->mainFunction());
+    for (const auto& function : program->functions())
+        folder.foldFunction(function.get());
+
+    return true;
+}
+
+}
@@ -0,0 +1,30 @@
+#include "odb-compiler/irpost/Process.hpp"
+#include "odb-compiler/irpost/FoldConstants.hpp"
+
+namespace odb::irpost {
+
+// ----------------------------------------------------------------------------
+void ProcessGroup::addProcess(std::unique_ptr<Process> process)
+{
+    processes_.push_back(std::move(process));
+}
+
+// ----------------------------------------------------------------------------
+bool ProcessGroup::execute(ir::Program* program)
+{
+    for (const auto& process : processes_)
+        if (process->execute(program) == false)
+            return false;
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+ProcessGroup createDefaultProcessGroup()
+{
+    ProcessGroup group;
+    group.addProcess(std::make_unique<FoldConstants>());
+    return group;
+}
+
+}
@@ -5,22 +5,31 @@
 #include "odb-compiler/ast/Block.hpp"
 #include "odb-compiler/ast/SourceLocation.hpp"
 #include "odb-compiler/ast/Literal.hpp"
+#include "odb-compiler/ast/Statement.hpp"
 #include "odb-compiler/ast/Symbol.hpp"
 #include "odb-compiler/ast/UDTField.hpp"
 #include "odb-compiler/ast/VarRef.hpp"
 #include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-compiler/parsers/db/FastScanner.hpp"
 #include "odb-compiler/parsers/db/Parser.y.hpp"
 #include "odb-compiler/parsers/db/Scanner.hpp"
 #include "odb-compiler/parsers/db/KeywordToken.hpp"
 #include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/Stats.hpp"
+#include "odb-sdk/Arena.hpp"
 #include "odb-sdk/Log.hpp"
+#include "odb-sdk/MappedFile.hpp"
 #include "odb-sdk/Str.hpp"
 #include "odb-sdk/FileSystem.hpp"
 
 #include <cassert>
 #include <cstring>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <optional>
+#include <string_view>
 
 #if defined(ODBCOMPILER_VERBOSE_BISON)
 extern int dbdebug;
@@ -45,31 +54,63 @@ static bool tokenHasFreeableString(int pushedChar)
 }
 
 // ----------------------------------------------------------------------------
-ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::CommandMatcher& commandMatcher)
+void Driver::setUseArena(bool enable)
+{
+    useArena_ = enable;
+}
+
+// ----------------------------------------------------------------------------
+void Driver::setUseFastScanner(bool enable)
+{
+    useFastScanner_ = enable;
+}
+
+// ----------------------------------------------------------------------------
+void Driver::setStatementConsumer(StatementConsumer* consumer)
+{
+    statementConsumer_ = consumer;
+}
+
+// ----------------------------------------------------------------------------
+ast::Block* Driver::doParse(dbscan_t scanner, FastScanner* fastScanner, dbpstate* parser, const cmd::CommandMatcher& commandMatcher)
 {
     int parseResult;
     DBLTYPE loc = {1, 1, 1, 1};
 
+    // Everything allocated while the scope is active is owned by the arena.
+    // The scope only needs to cover the parse, the arena itself stays alive
+    // for as long as any of the nodes do. The arena isn't thread safe, so it
+    // can't be used if statements may be freed on another thread.
+    std::optional<ArenaScope> arenaScope;
+    if (useArena_ && statementConsumer_ == nullptr)
+        arenaScope.emplace(new Arena);
+
     struct Token
     {
         int pushedChar;
         DBSTYPE pushedValue;
         DBLTYPE loc;
-        std::string str;
-    };
 
-    struct MergedTokenOffset
-    {
-        int lookAheadEnd;
-        int cmdlen;
+        // Tokens that don't carry their own string refer to their text in
+        // the scanned buffer. FLEX only overwrites the character following
+        // the last token, so the text stays valid until the parse is done.
+        std::string_view scannedText;
+
+        std::string_view text() const
+        {
+            if (pushedChar == TOK_SYMBOL)
+                return pushedValue.string;
+            return scannedText;
+        }
     };
 
 #if defined(ODBCOMPILER_VERBOSE_BISON)
     dbdebug = 1;
 #endif
 
-    // This is used as a buffer to assemble a command out of multiple tokens
-    // and check it against the command matcher.
+    // This is used as a buffer to assemble a command out of multiple tokens.
+    // Matching is done incrementally with a cursor, so the buffer is only
+    // ever appended to and is used to create the merged command string.
     std::string possibleCommand;
     possibleCommand.reserve(commandMatcher.longestCommandLength());
 
@@ -78,11 +119,36 @@ ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::Comma
     std::vector<Token> tokens;
     tokens.reserve(commandMatcher.longestCommandWordCount());
 
+    // Counted locally and added to the stats once the parse is done, so
+    // parallel parses don't contend on the counters for every token
+    uint64_t tokensLexed = 0;
+    uint64_t commandLookups = 0;
+
     // Scans the next token and stores it in "tokens"
     auto scanNextToken = [&](){
         DBSTYPE pushedValue;
-        int pushedChar = dblex(&pushedValue, &loc, scanner);
-        tokens.push_back({pushedChar, pushedValue, loc, ""});
+        int pushedChar = fastScanner ?
+            fastScanner->lex(&pushedValue, &loc) : dblex(&pushedValue, &loc, scanner);
+        tokens.push_back({pushedChar, pushedValue, loc, {}});
+        ++tokensLexed;
+
+        // Symbols own a copy of their text which the token can refer to
+        if (pushedChar != TOK_SYMBOL)
+            tokens.back().scannedText = fastScanner ?
+                fastScanner->text() : std::string_view(dbget_text(scanner), dbget_leng(scanner));
+    };
+
+    // Feeds a token's text to the cursor and the command buffer. Tokens too
+    // long to be part of a command, such as most string literals, are turned
+    // away before they are copied into the buffer.
+    auto appendToCommand = [&](cmd::CommandMatcher::Cursor& cursor, std::string_view text) -> bool {
+        if (possibleCommand.size() + text.size() > (size_t)commandMatcher.longestCommandLength())
+            return false;
+        possibleCommand.append(text);
+#if defined(ODBCOMPILER_VERBOSE_FLEX)
+        fprintf(stderr, "cursor.advance(\"%.*s\")\n", (int)text.size(), text.data());
+#endif
+        return cursor.advance(text);
     };
 
     // Scans ahead to get as many TOK_SYMBOL type tokens
@@ -92,40 +158,31 @@ ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::Comma
 #endif
         struct
         {
-            cmd::CommandMatcher::MatchResult match;
+            int cmdlen;
             int tokenIdx;
         } result = {};
 
-        // The main parser loop deliberately doesn't set the string to save on
-        // memory allocations because it never stores more than one token, which
-        // means the string is always accessible through dbget_text(). Now that
-        // we have to store more than one token, it's necessary to store the
-        // string too.
-        if (tokens.back().str.empty())
-            tokens.back().str = dbget_text(scanner);
+        possibleCommand.clear();
+        cmd::CommandMatcher::Cursor cursor = commandMatcher.cursor();
+        ++commandLookups;
+        if (!appendToCommand(cursor, tokens[0].text()))
+            return;
 
-        possibleCommand = tokens[0].str;
         bool lastSymbolWasInteger = false;
-        for (int i = 1; (int)possibleCommand.length() <= commandMatcher.longestCommandLength(); ++i)
+        for (int i = 1; ; ++i)
         {
-#if defined(ODBCOMPILER_VERBOSE_FLEX)
-            fprintf(stderr, "findLongestCommandMatching(\"%s\")\n", possibleCommand.c_str());
-#endif
-            auto match = commandMatcher.findLongestCommandMatching(possibleCommand);
-            if (match.found && match.matchedLength == (int)possibleCommand.size())
-                result = {match, i};
+            // Only accept matches that end on a token boundary
+            if (cursor.isCommand())
+                result = {cursor.matchedLength(), i};
 
 #if defined(ODBCOMPILER_VERBOSE_FLEX)
-            fprintf(stderr, "found==%d, matchedLength: %d\n", match.found, match.matchedLength);
+            fprintf(stderr, "isCommand==%d, matchedLength: %d\n", cursor.isCommand(), cursor.matchedLength());
 #endif
 
             // Maybe need to scan for the next token, or maybe there's enough
             // in the queue.
             if (i == (int)tokens.size())
-            {
                 scanNextToken();
-                tokens.back().str = dbget_text(scanner);
-            }
 
             // EOF or error
             if (tokens[i].pushedChar == TOK_END || tokens[i].pushedChar == TOK_DBEMPTY)
@@ -137,14 +194,21 @@ ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::Comma
             // can end in type annotation characters such as $ or #, in which
             // case we also do not want to append a space.
             if (!lastSymbolWasInteger && !ast::isAnnotation(tokens[i].pushedChar))
-                possibleCommand += " ";
+            {
+                if (!appendToCommand(cursor, " "))
+                    break;
+            }
             else if (result.tokenIdx == i && ast::isAnnotation(tokens[i].pushedChar))
-                result.match.found = false;
-            possibleCommand += tokens[i].str;
+                result = {0, 0};
+
+            // Once no command can begin with what was assembled so far,
+            // there's no point in scanning further ahead
+            if (!appendToCommand(cursor, tokens[i].text()))
+                break;
             lastSymbolWasInteger = (tokens[i].pushedChar == TOK_INTEGER_LITERAL);
         }
 
-        if (result.match.found)
+        if (result.tokenIdx > 0)
         {
             // All tokens we scanned leading up to the last one can
             // be discarded, because they can all be merged into
@@ -155,7 +219,7 @@ ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::Comma
             tokens.erase(tokens.begin() + 1, tokens.begin() + result.tokenIdx);
 
             // Ownership of the string is passed to BISON
-            tokens[0].pushedValue.string = str::newCStrRange(possibleCommand.c_str(), 0, result.match.matchedLength);
+            tokens[0].pushedValue.string = str::newCStrRange(possibleCommand.c_str(), 0, result.cmdlen);
             tokens[0].pushedChar = TOK_COMMAND;
 #if defined(ODBCOMPILER_VERBOSE_FLEX)
             fprintf(stderr, "Merged into command: \"%s\"\n", tokens[0].pushedValue.string);
@@ -267,6 +331,14 @@ ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::Comma
             default: break;
         }
 
+        // Whatever is still a symbol at this point is an identifier. Intern it
+        // here so the parser can give the atom to the AST node directly.
+        if (tokens[0].pushedChar == TOK_SYMBOL)
+        {
+            char* name = tokens[0].pushedValue.string;
+            tokens[0].pushedValue.symbol_token = {name, ast::AtomTable::intern(name)};
+        }
+
         parseResult = dbpush_parse(parser, tokens[0].pushedChar, &tokens[0].pushedValue, &tokens[0].loc, scanner);
         tokens.erase(tokens.begin());
     } while (parseResult == YYPUSH_MORE);
@@ -276,6 +348,9 @@ ast::Block* Driver::doParse(dbscan_t scanner, dbpstate* parser, const cmd::Comma
         if (tokenHasFreeableString(token.pushedChar))
             str::deleteCStr(token.pushedValue.string);
 
+    Stats::add(Stats::TokensLexed, tokensLexed);
+    Stats::add(Stats::CommandLookups, commandLookups);
+
     if (parseResult == 0)
     {
         ast::Block* program = program_;
@@ -298,6 +373,20 @@ void Driver::giveProgram(ast::Block* program)
     program_ = program;
 }
 
+// ----------------------------------------------------------------------------
+void Driver::giveTopLevelStatement(ast::Block* program, ast::Statement* statement)
+{
+    if (statementConsumer_ == nullptr)
+    {
+        program->appendStatement(statement);
+        return;
+    }
+
+    // Once passed on, the statement may be in use on another thread
+    program->location()->unionize(statement->location());
+    statementConsumer_->consumeStatement(statement);
+}
+
 // ----------------------------------------------------------------------------
 ast::Literal* Driver::newIntLikeLiteral(int64_t value, ast::SourceLocation* location) const
 {
@@ -389,55 +478,149 @@ ast::Assignment* Driver::newIncDecUDTField(ast::UDTFieldOuter* value, IncDecDir
         loc);
 }
 
+// ----------------------------------------------------------------------------
+void Driver::addScannedText(const char* text, int length)
+{
+    const char* end = text + length;
+    for (const char* p = text; (p = (const char*)memchr(p, '\n', end - p)) != nullptr; )
+    {
+        ++p;
+        lineStarts_.push_back((uint32_t)(scanOffset_ + (p - text)));
+    }
+    scanOffset_ += length;
+}
+
+// ----------------------------------------------------------------------------
+void Driver::beginSource(ast::SourceFileId id, size_t length)
+{
+    sourceFileId_ = id;
+    sourceLength_ = length;
+    scanOffset_ = 0;
+    lineStarts_.clear();
+    lineStarts_.push_back(0);
+}
+
+// ----------------------------------------------------------------------------
+void Driver::endSource()
+{
+    // A parse error stops the scanner early, in which case the index would be
+    // incomplete. The table will build its own index if it needs one.
+    if (scanOffset_ == sourceLength_)
+        ast::SourceFileTable::setLineIndex(sourceFileId_, std::move(lineStarts_));
+    lineStarts_.clear();
+
+    // The locations created while parsing hold their own references, so the
+    // source is removed here if none of them survived
+    ast::SourceFileTable::release(sourceFileId_);
+}
+
+// ----------------------------------------------------------------------------
+ast::SourceLocation* Driver::newLocation(const DBLTYPE* loc) const
+{
+    return new ast::SourceLocation(sourceFileId_, loc->first_line, loc->last_line, loc->first_column, loc->last_column);
+}
+
+// ----------------------------------------------------------------------------
+void FileParserDriver::setUseMemoryMap(bool enable)
+{
+    useMemoryMap_ = enable;
+}
+
 // ----------------------------------------------------------------------------
 ast::Block* FileParserDriver::parse(const std::string& fileName,
                                     const cmd::CommandMatcher& commandMatcher)
 {
-    FILE* fp = fopen(fileName.c_str(), "r");
-    if (fp == nullptr)
+    // If the file can't be mapped, fall back to reading it
+    if (useMemoryMap_)
+    {
+        Reference<MappedFile> file = MappedFile::open(fileName.c_str());
+        if (file.notNull())
+            return parse(file, commandMatcher);
+    }
+
+    // The file is read once and handed to the source file table, so that
+    // diagnostics can later be rendered without touching the disk again
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open())
     {
         Log::dbParserFailedToOpenFile(fileName.c_str());
         return nullptr;
     }
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
 
-    // Create new parser and lexer instances and initialize lexer to point at
-    // file
+    ast::SourceFileId id = ast::SourceFileTable::addFile(fileName, std::move(text));
+    std::string_view code;
+    ast::SourceFileTable::text(id, &code);
+    beginSource(id, code.length());
+
+    // Create new parser and lexer instances and initialize buffer to point at
+    // file contents. The FLEX scanner is needed even if it doesn't scan
+    // anything, because the parser gets to the driver through it.
     dbscan_t scanner;
     dbpstate* parser = dbpstate_new();
     dblex_init_extra(this, &scanner);
-    dbset_in(fp, scanner);
+    std::optional<FastScanner> fastScanner;
+    YY_BUFFER_STATE buf = nullptr;
+    if (useFastScanner_)
+        fastScanner.emplace(this, code.data(), code.length());
+    else
+        buf = db_scan_bytes(code.data(), (int)code.length(), scanner);
 
-    fileName_ = &fileName;
-    ast::Block* program = doParse(scanner, parser, commandMatcher);
-    fileName_ = nullptr;
+    ast::Block* program = doParse(scanner, fastScanner ? &*fastScanner : nullptr, parser, commandMatcher);
+    endSource();
 
     // Destroy parser and lexer
+    if (buf)
+        db_delete_buffer(buf, scanner);
     dbpstate_delete(parser);
     dblex_destroy(scanner);
-    fclose(fp);
 
     return program;
 }
 
 // ----------------------------------------------------------------------------
-ast::Block* StringParserDriver::parse(const std::string& sourceName,
-                                      const std::string& str,
-                                      const cmd::CommandMatcher& commandMatcher)
+ast::Block* FileParserDriver::parse(MappedFile* file,
+                                    const cmd::CommandMatcher& commandMatcher)
 {
-    // Create new parser and lexer instances and initialize buffer to point at
-    // input string
+    // FLEX temporarily NUL-terminates each token inside the buffer it scans,
+    // which would garble any diagnostic that renders a source line from the
+    // shared mapping while the file is being parsed. It gets a second private
+    // mapping instead, whose pages are only copied once FLEX writes to them.
+    // The two padding bytes are the end of buffer marker db_scan_buffer()
+    // expects.
+    Reference<MappedFile> scanFile;
+    if (!useFastScanner_)
+    {
+        scanFile = MappedFile::open(file->getFilename(), 2);
+        if (scanFile.isNull() || scanFile->size() != file->size())
+        {
+            Log::dbParserFailedToOpenFile(file->getFilename());
+            return nullptr;
+        }
+    }
+
+    // The mapping is shared with the source file table, so locations and
+    // diagnostics read from the same pages the scanner ran over
+    beginSource(ast::SourceFileTable::addFile(file->getFilename(), file), file->size());
+
+    // The FLEX scanner is needed even if it doesn't scan anything, because
+    // the parser gets to the driver through it
     dbscan_t scanner;
     dbpstate* parser = dbpstate_new();
     dblex_init_extra(this, &scanner);
-    YY_BUFFER_STATE buf = db_scan_bytes(str.data(), (int)str.length(), scanner);
+    std::optional<FastScanner> fastScanner;
+    YY_BUFFER_STATE buf = nullptr;
+    if (useFastScanner_)
+        fastScanner.emplace(this, file->data(), file->size());
+    else
+        buf = db_scan_buffer(scanFile->data(), scanFile->size() + 2, scanner);
 
-    code_ = &str;
-    sourceName_ = &sourceName;
-    ast::Block* program = doParse(scanner, parser, commandMatcher);
-    sourceName_ = nullptr;
-    code_ = nullptr;
+    ast::Block* program = doParse(scanner, fastScanner ? &*fastScanner : nullptr, parser, commandMatcher);
+    endSource();
 
-    db_delete_buffer(buf, scanner);
+    if (buf)
+        db_delete_buffer(buf, scanner);
     dbpstate_delete(parser);
     dblex_destroy(scanner);
 
@@ -445,18 +628,33 @@ ast::Block* StringParserDriver::parse(const std::string& sourceName,
 }
 
 // ----------------------------------------------------------------------------
-ast::SourceLocation* FileParserDriver::newLocation(const DBLTYPE* loc) const
+ast::Block* StringParserDriver::parse(const std::string& sourceName,
+                                      const std::string& str,
+                                      const cmd::CommandMatcher& commandMatcher)
 {
-    assert(fileName_);
-    return new ast::FileSourceLocation(*fileName_, loc->first_line, loc->last_line, loc->first_column, loc->last_column);
-}
+    beginSource(ast::SourceFileTable::addString(sourceName, str), str.length());
 
-// ----------------------------------------------------------------------------
-ast::SourceLocation* StringParserDriver::newLocation(const DBLTYPE* loc) const
-{
-    assert(sourceName_);
-    assert(code_);
-    return new ast::InlineSourceLocation(*sourceName_, *code_, loc->first_line, loc->last_line, loc->first_column, loc->last_column);
+    // Create new parser and lexer instances and initialize buffer to point at
+    // input string
+    dbscan_t scanner;
+    dbpstate* parser = dbpstate_new();
+    dblex_init_extra(this, &scanner);
+    std::optional<FastScanner> fastScanner;
+    YY_BUFFER_STATE buf = nullptr;
+    if (useFastScanner_)
+        fastScanner.emplace(this, str.data(), str.length());
+    else
+        buf = db_scan_bytes(str.data(), (int)str.length(), scanner);
+
+    ast::Block* program = doParse(scanner, fastScanner ? &*fastScanner : nullptr, parser, commandMatcher);
+    endSource();
+
+    if (buf)
+        db_delete_buffer(buf, scanner);
+    dbpstate_delete(parser);
+    dblex_destroy(scanner);
+
+    return program;
 }
 
 }
@@ -0,0 +1,618 @@
+#include "odb-compiler/parsers/db/FastScanner.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-compiler/parsers/db/Parser.y.hpp"
+#include "odb-sdk/Str.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define ODBCOMPILER_SCANNER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define ODBCOMPILER_SCANNER_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace odb {
+namespace db {
+
+// ----------------------------------------------------------------------------
+static int countTrailingZeros(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+static int highestBit(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, bits);
+    return (int)index;
+#else
+    return 31 - __builtin_clz(bits);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+static int popCount(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    return (int)((((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#else
+    return __builtin_popcount(bits);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Each block of input is compared against a set of characters at once. The
+// result is a bitmask with one bit per character of the block.
+#if defined(ODBCOMPILER_SCANNER_AVX2)
+#   define ODBCOMPILER_SCANNER_SIMD
+typedef __m256i Block;
+static const ptrdiff_t blockSize = 32;
+static const uint32_t fullMask = 0xFFFFFFFFu;
+static Block load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+static Block splat(char c) { return _mm256_set1_epi8(c); }
+static Block equal(Block a, Block b) { return _mm256_cmpeq_epi8(a, b); }
+static Block either(Block a, Block b) { return _mm256_or_si256(a, b); }
+static uint32_t bitmask(Block a) { return (uint32_t)_mm256_movemask_epi8(a); }
+#elif defined(ODBCOMPILER_SCANNER_SSE2)
+#   define ODBCOMPILER_SCANNER_SIMD
+typedef __m128i Block;
+static const ptrdiff_t blockSize = 16;
+static const uint32_t fullMask = 0xFFFFu;
+static Block load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+static Block splat(char c) { return _mm_set1_epi8(c); }
+static Block equal(Block a, Block b) { return _mm_cmpeq_epi8(a, b); }
+static Block either(Block a, Block b) { return _mm_or_si128(a, b); }
+static uint32_t bitmask(Block a) { return (uint32_t)_mm_movemask_epi8(a); }
+#endif
+
+// ----------------------------------------------------------------------------
+struct CharIs
+{
+    char c;
+
+    bool operator()(char x) const { return x == c; }
+#if defined(ODBCOMPILER_SCANNER_SIMD)
+    uint32_t operator()(Block b) const { return bitmask(equal(b, splat(c))); }
+#endif
+};
+
+// ----------------------------------------------------------------------------
+// Matches a letter in either case. The letter must be given in lower case.
+struct LetterIs
+{
+    char c;
+
+    bool operator()(char x) const { return (x | 0x20) == c; }
+#if defined(ODBCOMPILER_SCANNER_SIMD)
+    uint32_t operator()(Block b) const { return bitmask(equal(either(b, splat(0x20)), splat(c))); }
+#endif
+};
+
+// ----------------------------------------------------------------------------
+// Matches everything except the whitespace Scanner.lex skips over
+struct IsNotBlank
+{
+    bool operator()(char x) const { return x != ' ' && x != '\t' && x != '\r'; }
+#if defined(ODBCOMPILER_SCANNER_SIMD)
+    uint32_t operator()(Block b) const
+    {
+        Block blanks = either(either(equal(b, splat(' ')), equal(b, splat('\t'))), equal(b, splat('\r')));
+        return ~bitmask(blanks) & fullMask;
+    }
+#endif
+};
+
+// ----------------------------------------------------------------------------
+template <typename Matcher>
+static const char* findFirst(const char* p, const char* end, Matcher matches)
+{
+#if defined(ODBCOMPILER_SCANNER_SIMD)
+    for (; end - p >= blockSize; p += blockSize)
+    {
+        uint32_t bits = matches(load(p));
+        if (bits)
+            return p + countTrailingZeros(bits);
+    }
+#endif
+    for (; p != end; ++p)
+        if (matches(*p))
+            return p;
+    return end;
+}
+
+// ----------------------------------------------------------------------------
+struct Newlines
+{
+    int count = 0;
+    const char* last = nullptr;
+    bool hasNul = false;
+};
+
+static Newlines countNewlines(const char* p, const char* end)
+{
+    Newlines newlines;
+#if defined(ODBCOMPILER_SCANNER_SIMD)
+    const Block newline = splat('\n');
+    const Block nul = splat('\0');
+    for (; end - p >= blockSize; p += blockSize)
+    {
+        Block b = load(p);
+        uint32_t bits = bitmask(equal(b, newline));
+        if (bitmask(equal(b, nul)))
+            newlines.hasNul = true;
+        if (bits)
+        {
+            newlines.count += popCount(bits);
+            newlines.last = p + highestBit(bits);
+        }
+    }
+#endif
+    for (; p != end; ++p)
+    {
+        if (*p == '\n')
+        {
+            newlines.count++;
+            newlines.last = p;
+        }
+        else if (*p == '\0')
+            newlines.hasNul = true;
+    }
+    return newlines;
+}
+
+// ----------------------------------------------------------------------------
+// Moves the end of the location past [begin, end), where every character was
+// a separate match in Scanner.lex. YY_USER_ACTION stops counting a match at
+// the first NUL, so NULs don't move the location at all.
+static void advanceChars(const char* begin, const char* end, DBLTYPE* loc)
+{
+    Newlines newlines = countNewlines(begin, end);
+    if (newlines.hasNul)
+    {
+        for (const char* p = begin; p != end; ++p)
+        {
+            if (*p == '\n')
+            {
+                loc->last_line++;
+                loc->last_column = 1;
+            }
+            else if (*p != '\0')
+                loc->last_column++;
+        }
+    }
+    else if (newlines.count > 0)
+    {
+        loc->last_line += newlines.count;
+        loc->last_column = 1 + (int)(end - newlines.last - 1);
+    }
+    else
+        loc->last_column += (int)(end - begin);
+}
+
+// ----------------------------------------------------------------------------
+// Sets the location of a single match
+static void advanceMatch(const char* begin, const char* end, DBLTYPE* loc)
+{
+    loc->first_line = loc->last_line;
+    loc->first_column = loc->last_column;
+    advanceChars(begin, findFirst(begin, end, CharIs{'\0'}), loc);
+}
+
+// ----------------------------------------------------------------------------
+// Skips over [begin, end) without returning a token. The location ends up the
+// same as after FLEX matched the same text, which depends on where the last
+// match started.
+static void skip(const char* begin, const char* lastMatch, const char* end, DBLTYPE* loc)
+{
+    advanceChars(begin, lastMatch, loc);
+    advanceMatch(lastMatch, end, loc);
+}
+
+// ----------------------------------------------------------------------------
+// Returns the first "remend" in [p, end) in any case, or end
+static const char* findRemEnd(const char* p, const char* end)
+{
+    for (; (p = findFirst(p, end, LetterIs{'r'})) != end; ++p)
+    {
+        if (end - p < 6)
+            return end;
+        if ((p[1] | 0x20) == 'e' && (p[2] | 0x20) == 'm' && (p[3] | 0x20) == 'e'
+                && (p[4] | 0x20) == 'n' && (p[5] | 0x20) == 'd')
+            return p;
+    }
+    return end;
+}
+
+// ----------------------------------------------------------------------------
+// Returns the first "*/" in [p, end), or end
+static const char* findCommentEnd(const char* p, const char* end)
+{
+    for (; (p = findFirst(p, end, CharIs{'*'})) != end; ++p)
+    {
+        if (end - p < 2)
+            return end;
+        if (p[1] == '/')
+            return p;
+    }
+    return end;
+}
+
+// ----------------------------------------------------------------------------
+// Compares with a lower case word, ignoring the case of the text
+static bool equalsWord(const char* text, size_t length, const char* word)
+{
+    if (length != strlen(word))
+        return false;
+    for (size_t i = 0; i != length; ++i)
+        if ((text[i] | 0x20) != word[i])
+            return false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// ----------------------------------------------------------------------------
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        return (c | 0x20) - 'a' + 10;
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+static bool isSymbolStart(char c)
+{
+    return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_';
+}
+
+// ----------------------------------------------------------------------------
+static bool isSymbolChar(char c)
+{
+    return isSymbolStart(c) || isDigit(c);
+}
+
+// ----------------------------------------------------------------------------
+static int imagToken(char c)
+{
+    switch (c)
+    {
+        case 'i': case 'I': return TOK_IMAG_I;
+        case 'j': case 'J': return TOK_IMAG_J;
+        case 'k': case 'K': return TOK_IMAG_K;
+        default: return 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Digits are accumulated while they are scanned. strtol() saturates instead
+// of overflowing, and so does this.
+class IntegerAccumulator
+{
+public:
+    explicit IntegerAccumulator(unsigned base) : base_(base) {}
+
+    void add(unsigned digit)
+    {
+        if (value_ > (limit - digit) / base_)
+            overflow_ = true;
+        else
+            value_ = value_ * base_ + digit;
+    }
+
+    int64_t value() const { return overflow_ ? (int64_t)limit : (int64_t)value_; }
+
+private:
+    static constexpr uint64_t limit = (uint64_t)std::numeric_limits<long>::max();
+    uint64_t value_ = 0;
+    unsigned base_;
+    bool overflow_ = false;
+};
+
+// ----------------------------------------------------------------------------
+// Same result as atof(), which Scanner.lex uses
+static double parseDouble(const char* begin, const char* end, std::chars_format format = std::chars_format::general)
+{
+    double value = 0.0;
+    if (std::from_chars(begin, end, value, format).ec == std::errc::result_out_of_range)
+    {
+        // strtod() still returns something sensible for values that don't fit
+        std::string text = format == std::chars_format::hex ? "0x" : "";
+        text.append(begin, end);
+        value = strtod(text.c_str(), nullptr);
+    }
+    return value;
+}
+
+// ----------------------------------------------------------------------------
+FastScanner::FastScanner(Driver* driver, const char* data, size_t length) :
+    driver_(driver),
+    pos_(data),
+    end_(data + length)
+{
+}
+
+// ----------------------------------------------------------------------------
+int FastScanner::lex(DBSTYPE* value, DBLTYPE* loc)
+{
+    const char* begin = pos_;
+    int result = scan(value, loc);
+    if (driver_ && pos_ != begin)
+        driver_->addScannedText(begin, (int)(pos_ - begin));
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+std::string_view FastScanner::text() const
+{
+    return text_;
+}
+
+// ----------------------------------------------------------------------------
+int FastScanner::scan(DBSTYPE* value, DBLTYPE* loc)
+{
+    while (pos_ != end_)
+    {
+        const char* p = pos_;
+        const char next = p + 1 != end_ ? p[1] : '\0';
+        switch (*p)
+        {
+            case ' ':
+            case '\t':
+            case '\r': {
+                const char* blanksEnd = findFirst(p, end_, IsNotBlank());
+                skip(p, blanksEnd - 1, blanksEnd, loc);
+                pos_ = blanksEnd;
+            } continue;
+
+            case '`':
+                skipComment(p, p + 1, findFirst(p + 1, end_, CharIs{'\n'}), 1, loc);
+                continue;
+
+            case '/':
+                if (next == '/')
+                {
+                    skipComment(p, p + 2, findFirst(p + 2, end_, CharIs{'\n'}), 1, loc);
+                    continue;
+                }
+                if (next == '*')
+                {
+                    skipComment(p, p + 2, findCommentEnd(p + 2, end_), 2, loc);
+                    continue;
+                }
+                return token('/', p + 1, loc);
+
+            case '"': {
+                const char* closing = findFirst(p + 1, end_, CharIs{'"'});
+                if (closing == end_)
+                    return token('"', p + 1, loc);
+
+                // Scanner.lex uses strlen() on the match, which stops at NUL
+                int result = token(TOK_STRING_LITERAL, closing + 1, loc);
+                size_t len = std::min(text_.find('\0'), text_.size());
+                value->string = str::newCStrRange(text_.data(), 1, len > 1 ? len - 1 : 1);
+                return result;
+            }
+
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                return scanNumber(value, loc);
+
+            case '.':
+                if (isDigit(next))
+                    return scanNumber(value, loc);
+                if (next == '.')
+                    return token(TOK_BNOT, p + 2, loc);
+                return token('.', p + 1, loc);
+
+            case '%':
+                if (next == '0' || next == '1')
+                    return scanNumber(value, loc);
+                return token('%', p + 1, loc);
+
+            case '#':
+                if (end_ - p >= 9 && memcmp(p + 1, "constant", 8) == 0)
+                    return token(TOK_CONSTANT, p + 9, loc);
+                return token('#', p + 1, loc);
+
+            case '<':
+                if (next == '<') return token(TOK_BSHL, p + 2, loc);
+                if (next == '>') return token(TOK_NE, p + 2, loc);
+                if (next == '=') return token(TOK_LE, p + 2, loc);
+                return token('<', p + 1, loc);
+
+            case '>':
+                if (next == '>') return token(TOK_BSHR, p + 2, loc);
+                if (next == '=') return token(TOK_GE, p + 2, loc);
+                return token('>', p + 1, loc);
+
+            case '|':
+                if (next == '|') return token(TOK_BOR, p + 2, loc);
+                return token('|', p + 1, loc);
+
+            case '&':
+                if (next == '&') return token(TOK_BAND, p + 2, loc);
+                return token('&', p + 1, loc);
+
+            case '~':
+                if (next == '~') return token(TOK_BXOR, p + 2, loc);
+                return token('~', p + 1, loc);
+
+            default:
+                break;
+        }
+
+        // Every other character is a token of its own
+        if (!isSymbolStart(*p))
+            return token(*p, p + 1, loc);
+
+        // Keywords such as "rem" only apply if they aren't the beginning of a
+        // longer symbol
+        const char* symbolEnd = p + 1;
+        while (symbolEnd != end_ && isSymbolChar(*symbolEnd))
+            ++symbolEnd;
+        size_t len = symbolEnd - p;
+
+        if (equalsWord(p, len, "rem"))
+        {
+            skipComment(p, symbolEnd, findFirst(symbolEnd, end_, CharIs{'\n'}), 1, loc);
+            continue;
+        }
+        if (equalsWord(p, len, "remstart"))
+        {
+            skipComment(p, symbolEnd, findRemEnd(symbolEnd, end_), 6, loc);
+            continue;
+        }
+        if (equalsWord(p, len, "true") || equalsWord(p, len, "false"))
+        {
+            value->boolean_value = (len == 4);
+            return token(TOK_BOOLEAN_LITERAL, symbolEnd, loc);
+        }
+
+        value->string = str::newCStrRange(p, 0, len);
+        return token(TOK_SYMBOL, symbolEnd, loc);
+    }
+
+    text_ = {};
+    return TOK_END;
+}
+
+// ----------------------------------------------------------------------------
+int FastScanner::scanNumber(DBSTYPE* value, DBLTYPE* loc)
+{
+    const char* p = pos_;
+    const char* end = end_;
+
+    if (*p == '%')
+    {
+        IntegerAccumulator integer(2);
+        const char* q = p + 1;
+        for (; q != end && (*q == '0' || *q == '1'); ++q)
+            integer.add(*q - '0');
+
+        // atof() doesn't understand the % prefix
+        if (q != end && imagToken(*q))
+        {
+            value->float_value = 0.0f;
+            return token(imagToken(*q), q + 1, loc);
+        }
+        value->integer_value = integer.value();
+        return token(TOK_INTEGER_LITERAL, q, loc);
+    }
+
+    if (*p == '0' && end - p > 2 && (p[1] | 0x20) == 'x' && hexDigit(p[2]) >= 0)
+    {
+        IntegerAccumulator integer(16);
+        const char* q = p + 2;
+        for (int digit; q != end && (digit = hexDigit(*q)) >= 0; ++q)
+            integer.add(digit);
+
+        // atof() reads the text as a hexadecimal floating point number
+        if (q != end && imagToken(*q))
+        {
+            value->float_value = (float)parseDouble(p + 2, q, std::chars_format::hex);
+            return token(imagToken(*q), q + 1, loc);
+        }
+        value->integer_value = integer.value();
+        return token(TOK_INTEGER_LITERAL, q, loc);
+    }
+
+    IntegerAccumulator integer(10);
+    bool isDouble = false;
+    const char* q = p;
+    for (; q != end && isDigit(*q); ++q)
+        integer.add(*q - '0');
+    if (q != end && *q == '.')
+    {
+        isDouble = true;
+        for (++q; q != end && isDigit(*q); ++q) {}
+    }
+
+    // The exponent is only part of the number if it has digits
+    if (q != end && (*q | 0x20) == 'e')
+    {
+        const char* exponent = q + 1;
+        if (exponent != end && (*exponent == '+' || *exponent == '-'))
+            ++exponent;
+        if (exponent != end && isDigit(*exponent))
+        {
+            isDouble = true;
+            for (q = exponent; q != end && isDigit(*q); ++q) {}
+        }
+    }
+
+    if (q != end && (*q | 0x20) == 'f')
+    {
+        value->float_value = (float)parseDouble(p, q);
+        return token(TOK_FLOAT_LITERAL, q + 1, loc);
+    }
+    if (q != end && imagToken(*q))
+    {
+        value->float_value = (float)parseDouble(p, q);
+        return token(imagToken(*q), q + 1, loc);
+    }
+    if (isDouble)
+    {
+        value->double_value = parseDouble(p, q);
+        return token(TOK_DOUBLE_LITERAL, q, loc);
+    }
+
+    value->integer_value = integer.value();
+    return token(TOK_INTEGER_LITERAL, q, loc);
+}
+
+// ----------------------------------------------------------------------------
+void FastScanner::skipComment(const char* begin, const char* bodyBegin,
+                              const char* terminator, size_t terminatorLength,
+                              DBLTYPE* loc)
+{
+    // Unterminated comments run until the end of the input. Every character
+    // of the body is a match of its own.
+    if (terminator == end_)
+    {
+        skip(begin, end_ != bodyBegin ? end_ - 1 : begin, end_, loc);
+        pos_ = end_;
+        return;
+    }
+
+    pos_ = terminator + terminatorLength;
+    skip(begin, terminator, pos_, loc);
+}
+
+// ----------------------------------------------------------------------------
+int FastScanner::token(int kind, const char* end, DBLTYPE* loc)
+{
+    advanceMatch(pos_, end, loc);
+    text_ = std::string_view(pos_, end - pos_);
+    pos_ = end;
+    return kind;
+}
+
+}
+}
@@ -50,6 +50,7 @@
 
 %code requires
 {
+    #include "odb-compiler/ast/Atom.hpp"
     #include <stdint.h>
 
     typedef void* dbscan_t;
@@ -106,6 +107,18 @@
             class VarRef;
             class WhileLoop;
         }
+        namespace db {
+            /*
+             * An identifier as the parser receives it. The driver interns the
+             * name after deciding it isn't a keyword, so the AST nodes get
+             * the atom instead of looking the name up a second time.
+             */
+            struct SymbolToken
+            {
+                char* string;
+                odb::ast::Atom atom;
+            };
+        }
     }
 }
 
@@ -154,6 +167,7 @@
     float float_value;
     double double_value;
     char* string;
+    odb::db::SymbolToken symbol_token;
     char scope;
 
     odb::ast::AnnotatedSymbol* annotated_symbol;
@@ -200,6 +214,7 @@
 }
 
 %destructor { str::deleteCStr($$); } <string>
+%destructor { str::deleteCStr($$.string); } <symbol_token>
 %destructor { TouchRef($$); } <symbol>
 %destructor { TouchRef($$); } <annotated_symbol>
 %destructor { TouchRef($$); } <array_decl>
@@ -342,11 +357,12 @@
 %token LAND "and"
 %token LNOT "not"
 
-%token<string> SYMBOL "symbol"
+%token<symbol_token> SYMBOL "symbol"
 %token<string> COMMAND "command"
 
 %type<assignment> assignment
 %type<block> program
+%type<block> program_block
 %type<block> block
 %type<stmnt> stmnt
 %type<case_> case
@@ -441,9 +457,13 @@
 
 %%
 program
-  : seps_maybe block seps_maybe                               { $$ = $2; driver->giveProgram($2); }
+  : seps_maybe program_block seps_maybe                       { $$ = $2; driver->giveProgram($2); }
   | seps_maybe                                                { $$ = nullptr; }
   ;
+program_block
+  : program_block seps stmnt                                  { $$ = $1; driver->giveTopLevelStatement($$, $3); }
+  | stmnt                                                     { $$ = new Block(driver->newLocation(&@$)); driver->giveTopLevelStatement($$, $1); }
+  ;
 sep : '\n' | ':' | ';' ;
 seps : seps sep | sep;
 seps_maybe : seps | ;
@@ -653,12 +673,12 @@ scope
   : GLOBAL                                                    { $$ = static_cast<char>(Scope::GLOBAL); }
   | LOCAL                                                     { $$ = static_cast<char>(Scope::LOCAL); }
   ;
-var_int_sym          : SYMBOL %prec NO_ANNOTATION             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::NONE, $1, driver->newLocation(&@$)); str::deleteCStr($1); };
-var_double_int_sym   : SYMBOL '&'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::DOUBLE_INTEGER, $1, driver->newLocation(&@$)); str::deleteCStr($1); };
-var_word_sym         : SYMBOL '%'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::WORD, $1, driver->newLocation(&@$)); str::deleteCStr($1); };
-var_double_float_sym : SYMBOL '!'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::DOUBLE_FLOAT, $1, driver->newLocation(&@$)); str::deleteCStr($1); };
-var_float_sym        : SYMBOL '#'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::FLOAT, $1, driver->newLocation(&@$)); str::deleteCStr($1); };
-var_str_sym          : SYMBOL '$'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::STRING, $1, driver->newLocation(&@$)); str::deleteCStr($1); };
+var_int_sym          : SYMBOL %prec NO_ANNOTATION             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::NONE, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); };
+var_double_int_sym   : SYMBOL '&'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::DOUBLE_INTEGER, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); };
+var_word_sym         : SYMBOL '%'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::WORD, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); };
+var_double_float_sym : SYMBOL '!'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::DOUBLE_FLOAT, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); };
+var_float_sym        : SYMBOL '#'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::FLOAT, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); };
+var_str_sym          : SYMBOL '$'                             { $$ = new ScopedAnnotatedSymbol(Scope::LOCAL, Annotation::STRING, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); };
 
 udt_decl
   : TYPE symbol seps udt_body_decl seps ENDTYPE               { $$ = new UDTDecl($2, $4, driver->newLocation(&@$)); }
@@ -672,7 +692,7 @@ udt_body_decl
   | array_decl_as_type                                        { $$ = new UDTDeclBody($1, driver->newLocation(&@$)); }
   ;
 udt_ref
-  : SYMBOL %prec NO_ANNOTATION                                { $$ = new UDTRef($1, driver->newLocation(&@$)); str::deleteCStr($1); }
+  : SYMBOL %prec NO_ANNOTATION                                { $$ = new UDTRef($1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
   ;
 udt_field_lvalue
   : var_ref '.' udt_field_inner                               { $$ = new UDTFieldOuter($1, $3, driver->newLocation(&@$)); }
@@ -735,15 +755,15 @@ literal
   | IMAG_K                                                    { $$ = new QuatLiteral({0, 0, 0, $1}, driver->newLocation(&@$)); }
   ;
 annotated_symbol
-  : SYMBOL %prec NO_ANNOTATION                                { $$ = new AnnotatedSymbol(Annotation::NONE, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
-  | SYMBOL '&'                                                { $$ = new AnnotatedSymbol(Annotation::DOUBLE_INTEGER, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
-  | SYMBOL '%'                                                { $$ = new AnnotatedSymbol(Annotation::WORD, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
-  | SYMBOL '!'                                                { $$ = new AnnotatedSymbol(Annotation::DOUBLE_FLOAT, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
-  | SYMBOL '#'                                                { $$ = new AnnotatedSymbol(Annotation::FLOAT, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
-  | SYMBOL '$'                                                { $$ = new AnnotatedSymbol(Annotation::STRING, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
+  : SYMBOL %prec NO_ANNOTATION                                { $$ = new AnnotatedSymbol(Annotation::NONE, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
+  | SYMBOL '&'                                                { $$ = new AnnotatedSymbol(Annotation::DOUBLE_INTEGER, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
+  | SYMBOL '%'                                                { $$ = new AnnotatedSymbol(Annotation::WORD, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
+  | SYMBOL '!'                                                { $$ = new AnnotatedSymbol(Annotation::DOUBLE_FLOAT, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
+  | SYMBOL '#'                                                { $$ = new AnnotatedSymbol(Annotation::FLOAT, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
+  | SYMBOL '$'                                                { $$ = new AnnotatedSymbol(Annotation::STRING, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
   ;
 symbol
-  : SYMBOL                                                    { $$ = new Symbol($1, driver->newLocation(&@$)); str::deleteCStr($1); }
+  : SYMBOL                                                    { $$ = new Symbol($1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
   ;
 conditional
   : cond_oneline                                              { $$ = $1; }
@@ -830,8 +850,8 @@ loop_for
   | FOR assignment TO expr seps NEXT                          { $$ = new ForLoop($2, $4, driver->newLocation(&@$)); }
   ;
 loop_next_sym
-  : SYMBOL %prec NO_ANNOTATION                                { $$ = new AnnotatedSymbol(Annotation::NONE, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
-  | SYMBOL '#'                                                { $$ = new AnnotatedSymbol(Annotation::FLOAT, $1, driver->newLocation(&@$)); str::deleteCStr($1); }
+  : SYMBOL %prec NO_ANNOTATION                                { $$ = new AnnotatedSymbol(Annotation::NONE, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
+  | SYMBOL '#'                                                { $$ = new AnnotatedSymbol(Annotation::FLOAT, $1.atom, $1.string, driver->newLocation(&@$)); str::deleteCStr($1.string); }
   ;
 exit
   : EXIT                                                      { $$ = new Exit(driver->newLocation(&@$)); }
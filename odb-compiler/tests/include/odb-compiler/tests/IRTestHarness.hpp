@@ -0,0 +1,35 @@
+#pragma once
+
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/ir/Node.hpp"
+#include "odb-sdk/Reference.hpp"
+#include "gmock/gmock.h"
+
+/*!
+ * Base fixture for tests that build IR by hand. Every node shares the same
+ * location, and the helpers create the nodes most tests need.
+ */
+class IRTestHarness : public testing::Test
+{
+public:
+    IRTestHarness();
+
+    odb::ir::Ptr<odb::ir::Expression> integer(int32_t value);
+    odb::ir::Ptr<odb::ir::Expression> boolean(bool value);
+    odb::ir::Ptr<odb::ir::Expression> ref(odb::Reference<odb::ir::Variable> variable);
+    odb::ir::Ptr<odb::ir::Expression> binary(odb::ir::BinaryOp op,
+                                             odb::ir::Ptr<odb::ir::Expression> left,
+                                             odb::ir::Ptr<odb::ir::Expression> right);
+
+    // Creates a variable and adds it to the function's variables
+    odb::Reference<odb::ir::Variable> variable(odb::ir::FunctionDefinition& function, const std::string& name,
+                                               odb::ir::BuiltinType type = odb::ir::BuiltinType::Integer);
+
+    odb::ir::Ptr<odb::ir::Statement> assign(odb::ir::FunctionDefinition& function,
+                                            odb::Reference<odb::ir::Variable> variable,
+                                            odb::ir::Ptr<odb::ir::Expression> expression);
+
+    odb::Reference<odb::ast::SourceLocation> location_;
+    odb::cmd::CommandIndex cmdIndex_;
+};
@@ -16,6 +16,7 @@ class ParserTestHarness : public testing::Test
 {
 public:
     void checkParentConnectionConsistencies(const odb::ast::Block* ast);
+    void checkNodeKinds(const odb::ast::Block* ast);
     void SetUp() override;
     void TearDown() override;
 
@@ -0,0 +1,253 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/commands/Command.hpp"
+#include "odb-compiler/commands/CommandCache.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandLoader.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-sdk/DynamicLibrary.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#define NAME cmd_cache
+
+using namespace testing;
+using namespace odb;
+
+namespace {
+// The test plugins aren't real libraries, so they all fail to load
+class PluginListLoader : public cmd::CommandLoader
+{
+public:
+    PluginListLoader(const std::vector<std::filesystem::path>& plugins) :
+        CommandLoader(""),
+        plugins_(plugins)
+    {}
+
+    bool populateIndex(cmd::CommandIndex* index) override
+    {
+        return populateIndexFromPlugins(index, plugins_);
+    }
+
+    bool populateIndexFromLibrary(cmd::CommandIndex* index, DynamicLibrary* library) override
+    {
+        return true;
+    }
+
+private:
+    std::vector<std::filesystem::path> plugins_;
+};
+}
+
+class NAME : public Test
+{
+public:
+    void SetUp() override
+    {
+        cacheFile_ = std::tmpnam(nullptr);
+        pluginA_ = std::tmpnam(nullptr);
+        pluginB_ = std::tmpnam(nullptr);
+
+        // The plugins are never loaded, they only need to exist so the cache
+        // can record their modification time and size
+        writeFile(pluginA_, "plugin a");
+        writeFile(pluginB_, "plugin b");
+    }
+
+    void TearDown() override
+    {
+        std::remove(cacheFile_.c_str());
+        std::remove(pluginA_.c_str());
+        std::remove(pluginB_.c_str());
+    }
+
+    void writeFile(const std::string& fileName, const std::string& contents)
+    {
+        std::ofstream out(fileName, std::ios::binary);
+        out << contents;
+    }
+
+    void populateIndex(cmd::CommandIndex* index)
+    {
+        Reference<DynamicLibrary> a = DynamicLibrary::openDeferred(pluginA_.c_str());
+        Reference<DynamicLibrary> b = DynamicLibrary::openDeferred(pluginB_.c_str());
+        index->addCommand(new cmd::Command(a, "Randomize", "randomize", cmd::Command::Type::Void, {}));
+        index->addCommand(new cmd::Command(a, "randomize matrix", "randomizeMatrix", cmd::Command::Type::Void,
+            {{cmd::Command::Type::Integer, "matrix", "Matrix ID"}}));
+        index->addCommand(new cmd::Command(b, "rnd", "rndInt", cmd::Command::Type::Integer,
+            {{cmd::Command::Type::Integer, "range", ""}}, "help/rnd.htm"));
+        index->addCommand(new cmd::Command(b, "rnd", "rndFloat", cmd::Command::Type::Float,
+            {{cmd::Command::Type::Float, "range", ""}}, "help/rnd.htm"));
+    }
+
+    std::string cacheFile_;
+    std::string pluginA_;
+    std::string pluginB_;
+};
+
+TEST_F(NAME, missing_file_returns_null)
+{
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    EXPECT_THAT(cache.get(), IsNull());
+}
+
+TEST_F(NAME, commands_round_trip)
+{
+    cmd::CommandIndex index;
+    populateIndex(&index);
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index), IsTrue());
+
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+    EXPECT_THAT(cache->pluginCount(), Eq(2));
+
+    cmd::CommandIndex loaded(*cache);
+    ASSERT_THAT(loaded.commands().size(), Eq(4u));
+
+    auto rnd = loaded.lookup("RND");
+    ASSERT_THAT(rnd.size(), Eq(2u));
+    const cmd::Command* rndInt = rnd[0]->cppSymbol() == "rndInt" ? rnd[0] : rnd[1];
+    EXPECT_THAT(rndInt->returnType(), Eq(cmd::Command::Type::Integer));
+    EXPECT_THAT(rndInt->helpFile(), StrEq("help/rnd.htm"));
+    ASSERT_THAT(rndInt->args().size(), Eq(1u));
+    EXPECT_THAT(rndInt->args()[0].type, Eq(cmd::Command::Type::Integer));
+    EXPECT_THAT(rndInt->args()[0].symName, StrEq("range"));
+    EXPECT_THAT(std::filesystem::path(rndInt->library()->getFilename()).filename(),
+                Eq(std::filesystem::path(pluginB_).filename()));
+
+    auto matrix = loaded.lookup("randomize matrix");
+    ASSERT_THAT(matrix.size(), Eq(1u));
+    ASSERT_THAT(matrix[0]->args().size(), Eq(1u));
+    EXPECT_THAT(matrix[0]->args()[0].description, StrEq("Matrix ID"));
+
+    // Commands of the same plugin share a library handle
+    EXPECT_THAT(loaded.librariesAsList().size(), Eq(2u));
+}
+
+TEST_F(NAME, single_plugin_is_loaded)
+{
+    cmd::CommandIndex index;
+    populateIndex(&index);
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index), IsTrue());
+
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+
+    cmd::CommandIndex loaded;
+    EXPECT_THAT(cache->populateIndexFromPlugin(&loaded, pluginA_), IsTrue());
+    EXPECT_THAT(loaded.commands().size(), Eq(2u));
+    EXPECT_THAT(cache->populateIndexFromPlugin(&loaded, cacheFile_), IsFalse());
+}
+
+TEST_F(NAME, modified_plugin_is_out_of_date)
+{
+    cmd::CommandIndex index;
+    populateIndex(&index);
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index), IsTrue());
+
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+    EXPECT_THAT(cache->isUpToDate(pluginA_), IsTrue());
+    EXPECT_THAT(cache->isUpToDate(pluginB_), IsTrue());
+    EXPECT_THAT(cache->isUpToDate(cacheFile_), IsFalse());
+
+    writeFile(pluginA_, "plugin a, but bigger");
+    EXPECT_THAT(cache->isUpToDate(pluginA_), IsFalse());
+    EXPECT_THAT(cache->isUpToDate(pluginB_), IsTrue());
+}
+
+TEST_F(NAME, matcher_from_cache_matches_matcher_from_index)
+{
+    cmd::CommandIndex index;
+    populateIndex(&index);
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index), IsTrue());
+
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+    ASSERT_THAT(cache->commandNameCount(), Eq(3));
+    EXPECT_THAT(cache->commandNameAt(0), Eq("randomize"));
+
+    cmd::CommandMatcher fromIndex, fromCache;
+    fromIndex.updateFromIndex(&index);
+    fromCache.updateFromCache(cache);
+
+    for (const char* str : {"randomize", "RANDOMIZE MATRIX 1", "randomize mesh", "rnd(5)", "rn", "print"})
+    {
+        auto expected = fromIndex.findLongestCommandMatching(str);
+        auto result = fromCache.findLongestCommandMatching(str);
+        EXPECT_THAT(result.found, Eq(expected.found)) << str;
+        EXPECT_THAT(result.matchedLength, Eq(expected.matchedLength)) << str;
+    }
+    EXPECT_THAT(fromCache.longestCommandLength(), Eq(fromIndex.longestCommandLength()));
+    EXPECT_THAT(fromCache.longestCommandWordCount(), Eq(fromIndex.longestCommandWordCount()));
+}
+
+TEST_F(NAME, truncated_image_is_rejected)
+{
+    cmd::CommandIndex index;
+    populateIndex(&index);
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index), IsTrue());
+
+    std::filesystem::resize_file(cacheFile_, std::filesystem::file_size(cacheFile_) - 8);
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    EXPECT_THAT(cache.get(), IsNull());
+}
+
+TEST_F(NAME, commands_without_library_are_skipped)
+{
+    cmd::CommandIndex index;
+    index.addCommand(new cmd::Command(nullptr, "print", "", cmd::Command::Type::Void, {}));
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index), IsTrue());
+
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+    EXPECT_THAT(cache->pluginCount(), Eq(0));
+    EXPECT_THAT(cache->commandNameCount(), Eq(0));
+}
+
+TEST_F(NAME, plugins_without_commands_are_recorded)
+{
+    std::string pluginC = std::tmpnam(nullptr);
+    writeFile(pluginC, "plugin c");
+
+    // Plugins that don't exist can't be recorded
+    cmd::CommandIndex index;
+    populateIndex(&index);
+    ASSERT_THAT(cmd::CommandCache::write(cacheFile_, index, {pluginA_, pluginB_, pluginC, pluginC + ".missing"}),
+                IsTrue());
+
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+    EXPECT_THAT(cache->pluginCount(), Eq(3));
+    EXPECT_THAT(cache->isUpToDate(pluginC), IsTrue());
+
+    cmd::CommandIndex loaded;
+    EXPECT_THAT(cache->populateIndexFromPlugin(&loaded, pluginC), IsTrue());
+    EXPECT_THAT(loaded.commands().size(), Eq(0u));
+
+    cache.reset();
+    std::remove(pluginC.c_str());
+}
+
+TEST_F(NAME, plugins_that_fail_to_load_do_not_invalidate_the_cache)
+{
+    PluginListLoader loader({pluginA_, pluginB_});
+    loader.setCommandCacheFile(cacheFile_);
+
+    cmd::CommandIndex index;
+    ASSERT_THAT(loader.populateIndex(&index), IsTrue());
+    Reference<cmd::CommandCache> cache = cmd::CommandCache::open(cacheFile_);
+    ASSERT_THAT(cache.get(), NotNull());
+    EXPECT_THAT(cache->pluginCount(), Eq(2));
+    cache.reset();
+
+    // The image must not be rewritten if no plugin changed
+    auto writeTime = std::filesystem::last_write_time(cacheFile_) - std::chrono::hours(1);
+    std::filesystem::last_write_time(cacheFile_, writeTime);
+    cmd::CommandIndex again;
+    ASSERT_THAT(loader.populateIndex(&again), IsTrue());
+    EXPECT_THAT(std::filesystem::last_write_time(cacheFile_), Eq(writeTime));
+}
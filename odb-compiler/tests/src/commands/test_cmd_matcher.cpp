@@ -122,3 +122,72 @@ TEST_F(NAME, match_when_multiple_options_include_spaces_and_non_spaces)
     EXPECT_THAT(result.found, IsTrue());
     EXPECT_THAT(result.matchedLength, Eq(strlen("delete object")));
 }
+
+TEST_F(NAME, match_is_case_insensitive)
+{
+    cmd::CommandIndex cmdIndex;
+    cmdIndex.addCommand(new cmd::Command(nullptr, "Make Object Cube", "", cmd::Command::Type::Void, {}));
+    cmdIndex.addCommand(new cmd::Command(nullptr, "make object", "", cmd::Command::Type::Void, {}));
+    matcher->updateFromIndex(&cmdIndex);
+
+    auto result = matcher->findLongestCommandMatching("MAKE OBJECT CUBE 1, 10");
+
+    EXPECT_THAT(result.found, IsTrue());
+    EXPECT_THAT(result.matchedLength, Eq(strlen("make object cube")));
+}
+
+TEST_F(NAME, overloaded_commands_match_once)
+{
+    cmd::CommandIndex cmdIndex;
+    cmdIndex.addCommand(new cmd::Command(nullptr, "print", "", cmd::Command::Type::Void, {}));
+    cmdIndex.addCommand(new cmd::Command(nullptr, "print", "", cmd::Command::Type::Void, {}));
+    cmdIndex.addCommand(new cmd::Command(nullptr, "PRINT", "", cmd::Command::Type::Void, {}));
+    matcher->updateFromIndex(&cmdIndex);
+
+    auto result = matcher->findLongestCommandMatching("print");
+
+    EXPECT_THAT(result.found, IsTrue());
+    EXPECT_THAT(result.matchedLength, Eq(5));
+}
+
+TEST_F(NAME, partial_match_of_multi_word_command_falls_back_to_shorter_command)
+{
+    cmd::CommandIndex cmdIndex;
+    cmdIndex.addCommand(new cmd::Command(nullptr, "set", "", cmd::Command::Type::Void, {}));
+    cmdIndex.addCommand(new cmd::Command(nullptr, "set camera range", "", cmd::Command::Type::Void, {}));
+    matcher->updateFromIndex(&cmdIndex);
+
+    auto result = matcher->findLongestCommandMatching("set camera view");
+
+    EXPECT_THAT(result.found, IsTrue());
+    EXPECT_THAT(result.matchedLength, Eq(3));
+}
+
+TEST_F(NAME, cursor_matches_incrementally)
+{
+    cmd::CommandIndex cmdIndex;
+    cmdIndex.addCommand(new cmd::Command(nullptr, "make object", "", cmd::Command::Type::Void, {}));
+    cmdIndex.addCommand(new cmd::Command(nullptr, "make object cube", "", cmd::Command::Type::Void, {}));
+    matcher->updateFromIndex(&cmdIndex);
+
+    auto cursor = matcher->cursor();
+    EXPECT_THAT(cursor.advance("Make"), IsTrue());
+    EXPECT_THAT(cursor.isCommand(), IsFalse());
+    EXPECT_THAT(cursor.advance(" OBJECT"), IsTrue());
+    EXPECT_THAT(cursor.isCommand(), IsTrue());
+    EXPECT_THAT(cursor.matchedLength(), Eq(11));
+    EXPECT_THAT(cursor.advance(" cube"), IsTrue());
+    EXPECT_THAT(cursor.isCommand(), IsTrue());
+    EXPECT_THAT(cursor.advance(" 1"), IsFalse());
+    EXPECT_THAT(cursor.isValid(), IsFalse());
+    EXPECT_THAT(cursor.isCommand(), IsFalse());
+    EXPECT_THAT(cursor.matchedLength(), Eq(16));
+}
+
+TEST_F(NAME, cursor_on_empty_db_is_invalid)
+{
+    auto cursor = matcher->cursor();
+    EXPECT_THAT(cursor.advance('a'), IsFalse());
+    EXPECT_THAT(cursor.isValid(), IsFalse());
+    EXPECT_THAT(cursor.matchedLength(), Eq(0));
+}
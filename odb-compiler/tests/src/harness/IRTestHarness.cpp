@@ -0,0 +1,44 @@
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+using namespace odb;
+
+IRTestHarness::IRTestHarness() :
+    location_(new ast::InlineSourceLocation("test", "", 1, 1, 1, 1))
+{
+}
+
+ir::Ptr<ir::Expression> IRTestHarness::integer(int32_t value)
+{
+    return std::make_unique<ir::IntegerLiteral>(location_, value);
+}
+
+ir::Ptr<ir::Expression> IRTestHarness::boolean(bool value)
+{
+    return std::make_unique<ir::BooleanLiteral>(location_, value);
+}
+
+ir::Ptr<ir::Expression> IRTestHarness::ref(Reference<ir::Variable> variable)
+{
+    return std::make_unique<ir::VarRefExpression>(location_, variable);
+}
+
+ir::Ptr<ir::Expression> IRTestHarness::binary(ir::BinaryOp op, ir::Ptr<ir::Expression> left,
+                                              ir::Ptr<ir::Expression> right)
+{
+    return std::make_unique<ir::BinaryExpression>(location_, op, std::move(left), std::move(right));
+}
+
+Reference<ir::Variable> IRTestHarness::variable(ir::FunctionDefinition& function, const std::string& name,
+                                                ir::BuiltinType type)
+{
+    Reference<ir::Variable> variable =
+        new ir::Variable(location_, name, ir::Variable::Annotation::None, ir::Type{type});
+    function.variables().add(variable);
+    return variable;
+}
+
+ir::Ptr<ir::Statement> IRTestHarness::assign(ir::FunctionDefinition& function, Reference<ir::Variable> variable,
+                                             ir::Ptr<ir::Expression> expression)
+{
+    return std::make_unique<ir::VarAssignment>(location_, &function, variable, std::move(expression));
+}
@@ -1,17 +1,115 @@
+#include "odb-compiler/ast/AnnotatedSymbol.hpp"
+#include "odb-compiler/ast/ArgList.hpp"
+#include "odb-compiler/ast/ArrayDecl.hpp"
+#include "odb-compiler/ast/ArrayRef.hpp"
+#include "odb-compiler/ast/Assignment.hpp"
+#include "odb-compiler/ast/BinaryOp.hpp"
 #include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/ast/CommandExpr.hpp"
+#include "odb-compiler/ast/CommandStmnt.hpp"
+#include "odb-compiler/ast/Conditional.hpp"
+#include "odb-compiler/ast/ConstDecl.hpp"
+#include "odb-compiler/ast/Exit.hpp"
 #include "odb-compiler/ast/Exporters.hpp"
+#include "odb-compiler/ast/FuncCall.hpp"
+#include "odb-compiler/ast/FuncDecl.hpp"
+#include "odb-compiler/ast/Goto.hpp"
+#include "odb-compiler/ast/InitializerList.hpp"
+#include "odb-compiler/ast/Label.hpp"
+#include "odb-compiler/ast/Literal.hpp"
+#include "odb-compiler/ast/Loop.hpp"
+#include "odb-compiler/ast/ScopedAnnotatedSymbol.hpp"
+#include "odb-compiler/ast/SelectCase.hpp"
+#include "odb-compiler/ast/Subroutine.hpp"
+#include "odb-compiler/ast/Symbol.hpp"
+#include "odb-compiler/ast/UDTDecl.hpp"
+#include "odb-compiler/ast/UDTField.hpp"
+#include "odb-compiler/ast/UDTRef.hpp"
+#include "odb-compiler/ast/UnaryOp.hpp"
+#include "odb-compiler/ast/VarDecl.hpp"
+#include "odb-compiler/ast/VarRef.hpp"
+#include "odb-compiler/ast/Visitor.hpp"
 #include "odb-compiler/parsers/db/Driver.hpp"
 #include "odb-compiler/tests/ASTParentConsistenciesChecker.hpp"
 #include "odb-compiler/tests/ParserTestHarness.hpp"
 #include <cstdio>
 #include <filesystem>
 
+namespace {
+// Checks that every node reports the kind of the class it was visited as
+class NodeKindChecker : public odb::ast::ConstVisitor
+{
+public:
+#define CHECK_KIND(name)                                                      \
+    void visit##name(const odb::ast::name* node) override                     \
+    {                                                                         \
+        EXPECT_THAT(node->kind(), testing::Eq(odb::ast::NodeKind::name));     \
+    }
+    CHECK_KIND(AnnotatedSymbol)
+    CHECK_KIND(ArgList)
+    CHECK_KIND(ArrayAssignment)
+    CHECK_KIND(ArrayRef)
+    CHECK_KIND(BinaryOp)
+    CHECK_KIND(Block)
+    CHECK_KIND(Case)
+    CHECK_KIND(CaseList)
+    CHECK_KIND(CommandExpr)
+    CHECK_KIND(CommandStmnt)
+    CHECK_KIND(Conditional)
+    CHECK_KIND(ConstDecl)
+    CHECK_KIND(ConstDeclExpr)
+    CHECK_KIND(DefaultCase)
+    CHECK_KIND(Exit)
+    CHECK_KIND(ForLoop)
+    CHECK_KIND(FuncCallExpr)
+    CHECK_KIND(FuncCallExprOrArrayRef)
+    CHECK_KIND(FuncCallStmnt)
+    CHECK_KIND(FuncDecl)
+    CHECK_KIND(FuncExit)
+    CHECK_KIND(Goto)
+    CHECK_KIND(InfiniteLoop)
+    CHECK_KIND(InitializerList)
+    CHECK_KIND(Label)
+    CHECK_KIND(ScopedAnnotatedSymbol)
+    CHECK_KIND(Select)
+    CHECK_KIND(SubCall)
+    CHECK_KIND(SubReturn)
+    CHECK_KIND(Symbol)
+    CHECK_KIND(UDTArrayDecl)
+    CHECK_KIND(UDTDecl)
+    CHECK_KIND(UDTDeclBody)
+    CHECK_KIND(UDTFieldAssignment)
+    CHECK_KIND(UDTFieldOuter)
+    CHECK_KIND(UDTFieldInner)
+    CHECK_KIND(UDTRef)
+    CHECK_KIND(UDTVarDecl)
+    CHECK_KIND(UnaryOp)
+    CHECK_KIND(UntilLoop)
+    CHECK_KIND(VarAssignment)
+    CHECK_KIND(VarRef)
+    CHECK_KIND(WhileLoop)
+#define X(dbname, cppname)                                                    \
+    CHECK_KIND(dbname##Literal)                                               \
+    CHECK_KIND(dbname##VarDecl)                                               \
+    CHECK_KIND(dbname##ArrayDecl)
+    ODB_DATATYPE_LIST
+#undef X
+#undef CHECK_KIND
+};
+}
+
 void ParserTestHarness::checkParentConnectionConsistencies(const odb::ast::Block* ast)
 {
     ASTParentConsistenciesChecker checker;
     ast->accept(&checker);
 }
 
+void ParserTestHarness::checkNodeKinds(const odb::ast::Block* ast)
+{
+    NodeKindChecker checker;
+    ast->accept(&checker);
+}
+
 void ParserTestHarness::SetUp()
 {
     ast = nullptr;
@@ -21,7 +119,10 @@ void ParserTestHarness::SetUp()
 void ParserTestHarness::TearDown()
 {
     if (ast)
+    {
         checkParentConnectionConsistencies(ast);
+        checkNodeKinds(ast);
+    }
 
     if (ast)
     {
@@ -0,0 +1,213 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ir/Bytecode.hpp"
+#include "odb-compiler/ir/Interpreter.hpp"
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+#include <algorithm>
+
+#define NAME ir_bytecode
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public IRTestHarness
+{
+public:
+    // function f(a) : s = "text" : endfunction
+    // for i = 1 to 10 : f(i) : next i
+    std::unique_ptr<ir::Program> createProgram()
+    {
+        ir::PtrVector<ir::FunctionDefinition> functions;
+        functions.emplace_back(std::make_unique<ir::FunctionDefinition>(
+            location_, "f", std::vector<ir::FunctionDefinition::Argument>{{ir::Type{ir::BuiltinType::Integer}, "a"}}));
+        ir::FunctionDefinition* f = functions.back().get();
+        variable(*f, "a", ir::BuiltinType::Integer);
+        auto s = variable(*f, "s", ir::BuiltinType::String);
+        ir::StatementBlock fStatements;
+        fStatements.emplace_back(std::make_unique<ir::VarAssignment>(
+            location_, f, s, std::make_unique<ir::StringLiteral>(location_, "text")));
+        f->appendStatements(std::move(fStatements));
+
+        ir::FunctionDefinition mainFunction(location_, "main");
+        auto i = variable(mainFunction, "i", ir::BuiltinType::Integer);
+        ir::PtrVector<ir::Expression> args;
+        args.emplace_back(ref(i));
+        ir::StatementBlock body;
+        body.emplace_back(std::make_unique<ir::FunctionCall>(
+            location_, &mainFunction, ir::FunctionCallExpression(location_, f, std::move(args), ir::Type{})));
+        ir::StatementBlock statements;
+        statements.emplace_back(std::make_unique<ir::ForLoop>(
+            location_, &mainFunction, ir::VarAssignment(location_, &mainFunction, i, integer(1)), integer(10),
+            integer(1), std::move(body)));
+        mainFunction.appendStatements(std::move(statements));
+
+        return std::make_unique<ir::Program>(std::move(mainFunction), std::move(functions));
+    }
+};
+
+TEST_F(NAME, serialized_module_reads_back_identically)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+    EXPECT_THAT(module->functions.size(), Eq(2u));
+    EXPECT_THAT(module->strings, ElementsAre("text"));
+
+    std::vector<uint8_t> data;
+    ir::serializeBytecode(&data, *module);
+    auto readBack = ir::deserializeBytecode(data.data(), data.size());
+    ASSERT_THAT(readBack, NotNull());
+
+    std::vector<uint8_t> dataReadBack;
+    ir::serializeBytecode(&dataReadBack, *readBack);
+    EXPECT_THAT(dataReadBack, Eq(data));
+    EXPECT_THAT(readBack->functions[1].name, StrEq("f"));
+    EXPECT_THAT(readBack->canCompile, Eq(module->canCompile));
+}
+
+TEST_F(NAME, deserialized_module_runs)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+    std::vector<uint8_t> data;
+    ir::serializeBytecode(&data, *module);
+    auto readBack = ir::deserializeBytecode(data.data(), data.size());
+    ASSERT_THAT(readBack, NotNull());
+
+    auto interpreter = ir::Interpreter::load(*readBack, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*program->functions()[0]), Eq(10u));
+    EXPECT_THAT(interpreter->backEdgeCount(program->mainFunction()), Eq(10u));
+    // Without the IR there is nothing to compile
+    EXPECT_THAT(interpreter->isCompiled(*program->functions()[0]), IsFalse());
+}
+
+TEST_F(NAME, truncated_data_is_rejected)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+    std::vector<uint8_t> data;
+    ir::serializeBytecode(&data, *module);
+
+    for (size_t size = 0; size < data.size(); ++size)
+        EXPECT_THAT(ir::deserializeBytecode(data.data(), size), IsNull()) << "size " << size;
+}
+
+TEST_F(NAME, jump_out_of_function_is_rejected)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+
+    for (auto& instruction : module->functions[0].code)
+        if (instruction.op == ir::BytecodeOp::BackEdge)
+            instruction.target = int32_t(module->functions[0].code.size());
+
+    EXPECT_THAT(ir::Interpreter::load(*module, cmdIndex_), IsNull());
+}
+
+TEST_F(NAME, opcode_with_wrong_type_is_rejected)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+
+    for (auto& instruction : module->functions[0].code)
+        if (instruction.op == ir::BytecodeOp::Add)
+            instruction.type = ir::BuiltinType::String;
+
+    EXPECT_THAT(ir::Interpreter::load(*module, cmdIndex_), IsNull());
+}
+
+TEST_F(NAME, missing_command_is_rejected)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+
+    ir::BytecodeCommand command;
+    command.dbSymbol = "print";
+    command.cppSymbol = "?print@@YAXPBD@Z";
+    command.argumentTypes.push_back(cmd::Command::Type::String);
+    module->commands.push_back(command);
+
+    EXPECT_THAT(ir::Interpreter::load(*module, cmdIndex_), IsNull());
+}
+
+TEST_F(NAME, string_arguments_are_accepted)
+{
+    // function g(s$) : endfunction
+    // g("text") : t$ = "text" : g(t$)
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(
+        location_, "g", std::vector<ir::FunctionDefinition::Argument>{{ir::Type{ir::BuiltinType::String}, "s"}}));
+    ir::FunctionDefinition* g = functions.back().get();
+    variable(*g, "s", ir::BuiltinType::String);
+
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto t = variable(mainFunction, "t", ir::BuiltinType::String);
+    ir::StatementBlock statements;
+    ir::PtrVector<ir::Expression> literalArgs;
+    literalArgs.emplace_back(std::make_unique<ir::StringLiteral>(location_, "text"));
+    statements.emplace_back(std::make_unique<ir::FunctionCall>(
+        location_, &mainFunction, ir::FunctionCallExpression(location_, g, std::move(literalArgs), ir::Type{})));
+    statements.emplace_back(std::make_unique<ir::VarAssignment>(
+        location_, &mainFunction, t, std::make_unique<ir::StringLiteral>(location_, "text")));
+    ir::PtrVector<ir::Expression> variableArgs;
+    variableArgs.emplace_back(ref(t));
+    statements.emplace_back(std::make_unique<ir::FunctionCall>(
+        location_, &mainFunction, ir::FunctionCallExpression(location_, g, std::move(variableArgs), ir::Type{})));
+    mainFunction.appendStatements(std::move(statements));
+    ir::Program program(std::move(mainFunction), std::move(functions));
+
+    auto module = ir::generateBytecode(program);
+    ASSERT_THAT(module, NotNull());
+    auto interpreter = ir::Interpreter::load(*module, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*program.functions()[0]), Eq(2u));
+}
+
+TEST_F(NAME, integer_passed_for_string_argument_is_rejected)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+
+    // f's argument now expects a string, but main still passes the loop
+    // counter
+    ir::BytecodeFunction& f = module->functions[1];
+    ASSERT_THAT(f.argumentRegisters.size(), Eq(1u));
+    f.stringRegisters.push_back(f.argumentRegisters[0]);
+
+    EXPECT_THAT(ir::Interpreter::load(*module, cmdIndex_), IsNull());
+}
+
+TEST_F(NAME, string_loaded_into_integer_argument_is_rejected)
+{
+    auto program = createProgram();
+    auto module = ir::generateBytecode(*program);
+    ASSERT_THAT(module, NotNull());
+
+    // Pass a string instead of the loop counter to f
+    ir::BytecodeFunction& mainFunction = module->functions[0];
+    ASSERT_THAT(mainFunction.callSites.size(), Eq(1u));
+    auto call = std::find_if(mainFunction.code.begin(), mainFunction.code.end(),
+                             [](const auto& instruction) { return instruction.op == ir::BytecodeOp::CallFunction; });
+    ASSERT_THAT(call, Ne(mainFunction.code.end()));
+    int32_t callIndex = int32_t(call - mainFunction.code.begin());
+    for (auto& instruction : mainFunction.code)
+        if (instruction.op != ir::BytecodeOp::CallFunction && instruction.target > callIndex)
+            ++instruction.target;
+
+    ir::BytecodeInstruction loadString;
+    loadString.op = ir::BytecodeOp::LoadString;
+    loadString.dst = mainFunction.registerCount++;
+    mainFunction.code.insert(call, loadString);
+    mainFunction.callSites[0].argumentRegisters[0] = loadString.dst;
+
+    EXPECT_THAT(ir::Interpreter::load(*module, cmdIndex_), IsNull());
+}
@@ -0,0 +1,116 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ir/Codegen.hpp"
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+#include <sstream>
+
+#define NAME ir_codegen
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public IRTestHarness
+{
+public:
+    // i = i + 1 : f()
+    ir::StatementBlock incrementAndCall(ir::FunctionDefinition& function, Reference<ir::Variable> i,
+                                        ir::FunctionDefinition* f)
+    {
+        ir::StatementBlock body;
+        body.emplace_back(std::make_unique<ir::VarAssignment>(location_, &function, i,
+                                                              binary(ir::BinaryOp::ADD, ref(i), integer(1))));
+        body.emplace_back(std::make_unique<ir::FunctionCall>(location_, &function,
+                                                             ir::FunctionCallExpression(location_, f, {}, ir::Type{})));
+        return body;
+    }
+
+    std::string generateLLVMIR(ir::Program& program)
+    {
+        std::stringstream ss;
+        ir::TargetTriple targetTriple{ir::TargetTriple::Arch::x86_64, ir::TargetTriple::Platform::Linux};
+        EXPECT_THAT(ir::generateCode(SDKType::ODB, ir::OutputType::LLVMIR, targetTriple, ss, "test", program,
+                                     cmdIndex_),
+                    IsTrue());
+        return ss.str();
+    }
+};
+
+TEST_F(NAME, while_loop_checks_condition_before_body)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // while i < 10 : i = i + 1 : f() : endwhile
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::WhileLoop>(location_, &mainFunction,
+                                                            binary(ir::BinaryOp::LESS_THAN, ref(i), integer(10)),
+                                                            incrementAndCall(mainFunction, i, f)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    std::string ir = generateLLVMIR(program);
+
+    EXPECT_THAT(ir, HasSubstr("br label %whileLoopCond"));
+    EXPECT_THAT(ir, ContainsRegex("whileLoopCond:.*\n.*icmp slt i32 .*, 10"));
+    EXPECT_THAT(ir, ContainsRegex("br i1 %[0-9]+, label %whileLoopBody, label %whileLoopEnd"));
+    EXPECT_THAT(ir, ContainsRegex("whileLoopBody:(.*\n)*.*call void @__DBf\\(\\)(.*\n)*.*br label %whileLoopCond"));
+}
+
+TEST_F(NAME, repeat_loop_runs_body_before_checking_condition)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // repeat : i = i + 1 : f() : until i = 10
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::UntilLoop>(location_, &mainFunction,
+                                                            binary(ir::BinaryOp::EQUAL, ref(i), integer(10)),
+                                                            incrementAndCall(mainFunction, i, f)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    std::string ir = generateLLVMIR(program);
+
+    EXPECT_THAT(ir, HasSubstr("br label %repeatLoopBody"));
+    EXPECT_THAT(ir, ContainsRegex("repeatLoopBody:(.*\n)*.*call void @__DBf\\(\\)(.*\n)*.*icmp eq i32 .*, 10"));
+    EXPECT_THAT(ir, ContainsRegex("br i1 %[0-9]+, label %repeatLoopEnd, label %repeatLoopBody"));
+}
+
+TEST_F(NAME, integer_power_is_computed_in_double_precision)
+{
+    // i = i ^ 3
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::VarAssignment>(location_, &mainFunction, i,
+                                                                binary(ir::BinaryOp::POW, ref(i), integer(3))));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), {});
+    std::string ir = generateLLVMIR(program);
+
+    EXPECT_THAT(ir, ContainsRegex("sitofp i32 %[0-9]+ to double"));
+    EXPECT_THAT(ir, ContainsRegex("call double @llvm.pow.f64\\(double %[0-9]+, double 3"));
+    EXPECT_THAT(ir, ContainsRegex("fptosi double %[0-9]+ to i32"));
+}
+
+TEST_F(NAME, return_without_gosub_traps)
+{
+    // return
+    ir::FunctionDefinition mainFunction(location_, "main");
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::SubReturn>(location_, &mainFunction));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), {});
+    std::string ir = generateLLVMIR(program);
+
+    EXPECT_THAT(ir, ContainsRegex("icmp eq i64 %index, 0\n.*br i1 %isEmpty, label %returnWithoutGosub, label %pop"));
+    EXPECT_THAT(ir, ContainsRegex("returnWithoutGosub:(.*\n)*.*call void @llvm.trap\\(\\)\n.*unreachable"));
+}
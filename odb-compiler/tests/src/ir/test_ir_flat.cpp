@@ -0,0 +1,129 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ir/Bytecode.hpp"
+#include "odb-compiler/ir/FlatIR.hpp"
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+#define NAME ir_flat
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public IRTestHarness
+{
+public:
+    // function f(a) : s = "text" : endfunction a * 2
+    // for i = 1 to 10 : f(i) : if i = 5 then exit : next i
+    // again: goto again
+    std::unique_ptr<ir::Program> createProgram()
+    {
+        ir::PtrVector<ir::FunctionDefinition> functions;
+        functions.emplace_back(std::make_unique<ir::FunctionDefinition>(
+            location_, "f", std::vector<ir::FunctionDefinition::Argument>{{ir::Type{ir::BuiltinType::Integer}, "a"}}));
+        ir::FunctionDefinition* f = functions.back().get();
+        auto a = variable(*f, "a", ir::BuiltinType::Integer);
+        auto s = variable(*f, "s", ir::BuiltinType::String);
+        ir::StatementBlock fStatements;
+        fStatements.emplace_back(std::make_unique<ir::VarAssignment>(
+            location_, f, s, std::make_unique<ir::StringLiteral>(location_, "text")));
+        f->appendStatements(std::move(fStatements));
+        f->setReturnExpression(std::make_unique<ir::BinaryExpression>(location_, ir::BinaryOp::MUL, ref(a), integer(2)));
+
+        ir::FunctionDefinition mainFunction(location_, "main");
+        auto i = variable(mainFunction, "i", ir::BuiltinType::Integer);
+        auto loop = std::make_unique<ir::ForLoop>(location_, &mainFunction,
+                                                  ir::VarAssignment(location_, &mainFunction, i, integer(1)),
+                                                  integer(10), integer(1));
+        ir::PtrVector<ir::Expression> args;
+        args.emplace_back(ref(i));
+        ir::StatementBlock body;
+        body.emplace_back(std::make_unique<ir::FunctionCall>(
+            location_, &mainFunction,
+            ir::FunctionCallExpression(location_, f, std::move(args), ir::Type{ir::BuiltinType::Integer})));
+        ir::StatementBlock exitBlock;
+        exitBlock.emplace_back(std::make_unique<ir::Exit>(location_, &mainFunction, loop.get()));
+        body.emplace_back(std::make_unique<ir::Conditional>(
+            location_, &mainFunction,
+            std::make_unique<ir::BinaryExpression>(location_, ir::BinaryOp::EQUAL, ref(i), integer(5)),
+            std::move(exitBlock), ir::StatementBlock{}));
+        loop->appendStatements(std::move(body));
+
+        ir::StatementBlock statements;
+        statements.emplace_back(std::move(loop));
+        auto label = std::make_unique<ir::Label>(location_, &mainFunction, "again");
+        statements.emplace_back(std::make_unique<ir::Goto>(location_, &mainFunction, label.get()));
+        statements.emplace_back(std::move(label));
+        mainFunction.appendStatements(std::move(statements));
+
+        return std::make_unique<ir::Program>(std::move(mainFunction), std::move(functions));
+    }
+};
+
+TEST_F(NAME, functions_and_statements_are_flattened_in_order)
+{
+    auto program = createProgram();
+    auto flat = ir::flattenProgram(*program);
+    ASSERT_THAT(flat, NotNull());
+
+    ASSERT_THAT(flat->functions.size(), Eq(2u));
+    const ir::FlatFunction& mainFunction = flat->functions[0];
+    const ir::FlatFunction& f = flat->functions[1];
+    EXPECT_THAT(mainFunction.name, StrEq("main"));
+    EXPECT_THAT(f.name, StrEq("f"));
+    EXPECT_THAT(f.argumentTypes, ElementsAre(ir::Type{ir::BuiltinType::Integer}));
+    EXPECT_THAT(f.argumentVariables, ElementsAre(0u));
+    EXPECT_THAT(f.variableTypes,
+                ElementsAre(ir::Type{ir::BuiltinType::Integer}, ir::Type{ir::BuiltinType::String}));
+    EXPECT_THAT(flat->strings, ElementsAre("text"));
+
+    // for, goto, label
+    ASSERT_THAT(mainFunction.listSize(mainFunction.body), Eq(3u));
+    const ir::FlatIndex* body = mainFunction.listBegin(mainFunction.body);
+    EXPECT_THAT(mainFunction.statements.kinds[body[0]], Eq(ir::StatementKind::ForLoop));
+    EXPECT_THAT(mainFunction.statements.kinds[body[1]], Eq(ir::StatementKind::Goto));
+    EXPECT_THAT(mainFunction.statements.kinds[body[2]], Eq(ir::StatementKind::Label));
+    EXPECT_THAT(mainFunction.statements.a[body[1]], Eq(body[2]));
+}
+
+TEST_F(NAME, shared_locations_are_stored_once)
+{
+    auto program = createProgram();
+    auto flat = ir::flattenProgram(*program);
+    ASSERT_THAT(flat, NotNull());
+
+    ASSERT_THAT(flat->locations.size(), Eq(1u));
+    EXPECT_THAT(flat->locations[0], StrEq(location_->getFileLineColumn()));
+    EXPECT_THAT(flat->functions[0].statements.locations, Each(Eq(0u)));
+    EXPECT_THAT(flat->functions[1].expressions.locations, Each(Eq(0u)));
+}
+
+TEST_F(NAME, flat_program_doesnt_refer_to_the_tree)
+{
+    auto program = createProgram();
+    auto flat = ir::flattenProgram(*program);
+    ASSERT_THAT(flat, NotNull());
+    auto fromTree = ir::generateBytecode(*program);
+    program.reset();
+
+    auto fromCopy = ir::generateBytecode(*flat);
+    ASSERT_THAT(fromTree, NotNull());
+    ASSERT_THAT(fromCopy, NotNull());
+
+    std::vector<uint8_t> expected, actual;
+    ir::serializeBytecode(&expected, *fromTree);
+    ir::serializeBytecode(&actual, *fromCopy);
+    EXPECT_THAT(actual, Eq(expected));
+}
+
+TEST_F(NAME, variable_of_different_function_is_rejected)
+{
+    ir::FunctionDefinition other(location_, "other");
+    auto foreign = variable(other, "x", ir::BuiltinType::Integer);
+
+    ir::FunctionDefinition mainFunction(location_, "main");
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::VarAssignment>(location_, &mainFunction, foreign, integer(1)));
+    mainFunction.appendStatements(std::move(statements));
+    ir::Program program(std::move(mainFunction), {});
+
+    EXPECT_THAT(ir::flattenProgram(program), IsNull());
+}
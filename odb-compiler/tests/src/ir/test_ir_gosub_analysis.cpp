@@ -0,0 +1,129 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ir/GosubAnalysis.hpp"
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+#define NAME ir_gosub_analysis
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public IRTestHarness
+{
+public:
+    NAME() : function_(location_, "main") {}
+
+    ir::Label* label(const std::string& name)
+    {
+        auto label = std::make_unique<ir::Label>(location_, &function_, name);
+        labels_[name] = label.get();
+        statements_.emplace_back(std::move(label));
+        return labels_[name];
+    }
+
+    // Labels can be used before they appear, so they're resolved in analyze().
+    void gosub(const std::string& name)
+    {
+        auto gosub = std::make_unique<ir::Gosub>(location_, &function_, nullptr);
+        gosubs_.emplace_back(gosub.get(), name);
+        statements_.emplace_back(std::move(gosub));
+    }
+
+    void jump(const std::string& name)
+    {
+        auto jump = std::make_unique<ir::Goto>(location_, &function_, nullptr);
+        gotos_.emplace_back(jump.get(), name);
+        statements_.emplace_back(std::move(jump));
+    }
+
+    void subReturn() { statements_.emplace_back(std::make_unique<ir::SubReturn>(location_, &function_)); }
+
+    ir::GosubUsage analyze()
+    {
+        for (auto& [gosub, name] : gosubs_)
+        {
+            gosub->setLabel(labels_.at(name));
+        }
+        for (auto& [jump, name] : gotos_)
+        {
+            jump->setLabel(labels_.at(name));
+        }
+        function_.appendStatements(std::move(statements_));
+        return ir::analyzeGosubUsage(function_);
+    }
+
+    ir::FunctionDefinition function_;
+    ir::StatementBlock statements_;
+    std::unordered_map<std::string, ir::Label*> labels_;
+    std::vector<std::pair<ir::Gosub*, std::string>> gosubs_;
+    std::vector<std::pair<ir::Goto*, std::string>> gotos_;
+};
+
+TEST_F(NAME, function_without_gosub_needs_no_stack)
+{
+    jump("done");
+    label("done");
+    auto usage = analyze();
+    EXPECT_THAT(usage.usesGosub, IsFalse());
+    EXPECT_THAT(usage.maxDepth, Optional(0u));
+}
+
+TEST_F(NAME, single_subroutine_has_depth_one)
+{
+    // gosub sub : gosub sub : goto done : sub: return : done:
+    gosub("sub");
+    gosub("sub");
+    jump("done");
+    label("sub");
+    subReturn();
+    label("done");
+    auto usage = analyze();
+    EXPECT_THAT(usage.usesGosub, IsTrue());
+    EXPECT_THAT(usage.maxDepth, Optional(1u));
+}
+
+TEST_F(NAME, nested_subroutines_add_up)
+{
+    // gosub a : a: gosub b : return : b: gosub c : return : c: return
+    gosub("a");
+    label("a");
+    gosub("b");
+    subReturn();
+    label("b");
+    gosub("c");
+    subReturn();
+    label("c");
+    subReturn();
+    auto usage = analyze();
+    EXPECT_THAT(usage.maxDepth, Optional(3u));
+}
+
+TEST_F(NAME, recursion_is_unbounded)
+{
+    // gosub sub : sub: gosub sub : return
+    gosub("sub");
+    label("sub");
+    gosub("sub");
+    subReturn();
+    auto usage = analyze();
+    EXPECT_THAT(usage.usesGosub, IsTrue());
+    EXPECT_THAT(usage.maxDepth, Eq(std::nullopt));
+}
+
+TEST_F(NAME, goto_in_subroutine_is_unbounded)
+{
+    // gosub sub : sub: goto sub : return
+    gosub("sub");
+    label("sub");
+    jump("sub");
+    subReturn();
+    auto usage = analyze();
+    EXPECT_THAT(usage.maxDepth, Eq(std::nullopt));
+}
+
+TEST_F(NAME, return_without_gosub_uses_stack)
+{
+    subReturn();
+    auto usage = analyze();
+    EXPECT_THAT(usage.usesGosub, IsTrue());
+    EXPECT_THAT(usage.maxDepth, Optional(0u));
+}
@@ -0,0 +1,387 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ir/Interpreter.hpp"
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+#define NAME ir_interpreter
+
+using namespace testing;
+using namespace odb;
+
+// Tier-up is disabled in these tests (unless a program can't be compiled
+// anyway or the test is about tier-up), so the results only depend on the
+// interpreter.
+class NAME : public IRTestHarness
+{
+public:
+    ir::Ptr<ir::Expression> callExpression(ir::FunctionDefinition* callee, ir::PtrVector<ir::Expression> args = {})
+    {
+        ir::Type returnType = callee->returnExpression() ? callee->returnExpression()->getType() : ir::Type{};
+        return std::make_unique<ir::FunctionCallExpression>(location_, callee, std::move(args), returnType);
+    }
+
+    ir::Ptr<ir::Statement> call(ir::FunctionDefinition& function, ir::FunctionDefinition* callee)
+    {
+        return std::make_unique<ir::FunctionCall>(location_, &function,
+                                                  ir::FunctionCallExpression(location_, callee, {}, ir::Type{}));
+    }
+
+    // for i = 1 to count : <body> : next i
+    ir::Ptr<ir::Statement> forLoop(ir::FunctionDefinition& function, Reference<ir::Variable> i,
+                                   ir::Ptr<ir::Expression> count, ir::StatementBlock body)
+    {
+        return std::make_unique<ir::ForLoop>(location_, &function,
+                                             ir::VarAssignment(location_, &function, i, integer(1)),
+                                             std::move(count), integer(1), std::move(body));
+    }
+};
+
+TEST_F(NAME, for_loop_and_conditional)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // for i = 1 to 10 : if i > 5 then f() : next i
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock trueBranch;
+    trueBranch.emplace_back(call(mainFunction, f));
+    ir::StatementBlock body;
+    body.emplace_back(std::make_unique<ir::Conditional>(location_, &mainFunction,
+                                                        binary(ir::BinaryOp::GREATER_THAN, ref(i), integer(5)),
+                                                        std::move(trueBranch), ir::StatementBlock{}));
+    ir::StatementBlock statements;
+    statements.emplace_back(forLoop(mainFunction, i, integer(10), std::move(body)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(program.mainFunction()), Eq(1u));
+    EXPECT_THAT(interpreter->backEdgeCount(program.mainFunction()), Eq(10u));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(5u));
+    EXPECT_THAT(interpreter->isCompiled(*f), IsFalse());
+}
+
+TEST_F(NAME, gosub_returns_to_call_site)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // gosub sub : gosub sub : goto done : sub: f() : return : done:
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto sub = std::make_unique<ir::Label>(location_, &mainFunction, "sub");
+    auto done = std::make_unique<ir::Label>(location_, &mainFunction, "done");
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::Gosub>(location_, &mainFunction, sub.get()));
+    statements.emplace_back(std::make_unique<ir::Gosub>(location_, &mainFunction, sub.get()));
+    statements.emplace_back(std::make_unique<ir::Goto>(location_, &mainFunction, done.get()));
+    statements.emplace_back(std::move(sub));
+    statements.emplace_back(call(mainFunction, f));
+    statements.emplace_back(std::make_unique<ir::SubReturn>(location_, &mainFunction));
+    statements.emplace_back(std::move(done));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(2u));
+}
+
+TEST_F(NAME, arguments_and_return_values)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "g"));
+    ir::FunctionDefinition* g = functions.back().get();
+
+    // function double(a) : endfunction a * 2
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(
+        location_, "double", std::vector<ir::FunctionDefinition::Argument>{{ir::Type{ir::BuiltinType::Integer}, "a"}}));
+    ir::FunctionDefinition* twice = functions.back().get();
+    auto a = variable(*twice, "a");
+    twice->setReturnExpression(binary(ir::BinaryOp::MUL, ref(a), integer(2)));
+
+    // for i = 1 to double(3) : g() : next i
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::PtrVector<ir::Expression> args;
+    args.emplace_back(integer(3));
+    ir::StatementBlock body;
+    body.emplace_back(call(mainFunction, g));
+    ir::StatementBlock statements;
+    statements.emplace_back(forLoop(mainFunction, i, callExpression(twice, std::move(args)), std::move(body)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*g), Eq(6u));
+    // The end value is evaluated on every iteration
+    EXPECT_THAT(interpreter->entryCount(*twice), Eq(7u));
+}
+
+TEST_F(NAME, step_is_evaluated_on_every_iteration)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // s = 1 : for i = 1 to 10 step s : s = s + 1 : f() : next i
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    auto s = variable(mainFunction, "s");
+    ir::StatementBlock body;
+    body.emplace_back(assign(mainFunction, s, binary(ir::BinaryOp::ADD, ref(s), integer(1))));
+    body.emplace_back(call(mainFunction, f));
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, s, integer(1)));
+    statements.emplace_back(std::make_unique<ir::ForLoop>(location_, &mainFunction,
+                                                          ir::VarAssignment(location_, &mainFunction, i, integer(1)),
+                                                          integer(10), ref(s), std::move(body)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    // i = 1, 3, 6, 10
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(4u));
+}
+
+TEST_F(NAME, floating_point_counter_counts_down)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // for x# = 2.0 to 0.0 step -0.5 : f() : next x#
+    ir::FunctionDefinition mainFunction(location_, "main");
+    Reference<ir::Variable> x =
+        new ir::Variable(location_, "x", ir::Variable::Annotation::Float, ir::Type{ir::BuiltinType::Float});
+    mainFunction.variables().add(x);
+    auto floating = [this](float value) { return std::make_unique<ir::FloatLiteral>(location_, value); };
+    ir::StatementBlock body;
+    body.emplace_back(call(mainFunction, f));
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::ForLoop>(
+        location_, &mainFunction, ir::VarAssignment(location_, &mainFunction, x, floating(2.0f)), floating(0.0f),
+        floating(-0.5f), std::move(body)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(5u));
+}
+
+TEST_F(NAME, select_runs_first_matching_case_or_default)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    for (const char* name : {"f", "g", "h"})
+    {
+        functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, name));
+    }
+    ir::FunctionDefinition* f = functions[0].get();
+    ir::FunctionDefinition* g = functions[1].get();
+    ir::FunctionDefinition* h = functions[2].get();
+
+    // for i = 1 to 10
+    //   select i : case 2 : f() : case 5 : g() : case 2 : g() : case default : h() : endselect
+    // next i
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    std::vector<ir::Select::Case> cases;
+    auto addCase = [&](ir::Ptr<ir::Expression> condition, ir::FunctionDefinition* callee) {
+        ir::Select::Case& selectCase = cases.emplace_back();
+        selectCase.condition = std::move(condition);
+        selectCase.statements.emplace_back(call(mainFunction, callee));
+    };
+    addCase(integer(2), f);
+    addCase(integer(5), g);
+    addCase(integer(2), g);
+    addCase(nullptr, h);
+    ir::StatementBlock body;
+    body.emplace_back(std::make_unique<ir::Select>(location_, &mainFunction, ref(i), std::move(cases)));
+    ir::StatementBlock statements;
+    statements.emplace_back(forLoop(mainFunction, i, integer(10), std::move(body)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(1u));
+    EXPECT_THAT(interpreter->entryCount(*g), Eq(1u));
+    EXPECT_THAT(interpreter->entryCount(*h), Eq(8u));
+}
+
+TEST_F(NAME, exit_leaves_while_loop)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // while true : i = i + 1 : if i = 7 then exit : f() : endwhile
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    auto loop = std::make_unique<ir::WhileLoop>(location_, &mainFunction, boolean(true));
+    ir::StatementBlock exitBranch;
+    exitBranch.emplace_back(std::make_unique<ir::Exit>(location_, &mainFunction, loop.get()));
+    ir::StatementBlock body;
+    body.emplace_back(assign(mainFunction, i, binary(ir::BinaryOp::ADD, ref(i), integer(1))));
+    body.emplace_back(std::make_unique<ir::Conditional>(location_, &mainFunction,
+                                                        binary(ir::BinaryOp::EQUAL, ref(i), integer(7)),
+                                                        std::move(exitBranch), ir::StatementBlock{}));
+    body.emplace_back(call(mainFunction, f));
+    loop->appendStatements(std::move(body));
+    ir::StatementBlock statements;
+    statements.emplace_back(std::move(loop));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(6u));
+    EXPECT_THAT(interpreter->backEdgeCount(program.mainFunction()), Eq(6u));
+    EXPECT_THAT(interpreter->isCompiled(*f), IsFalse());
+}
+
+TEST_F(NAME, division_by_zero_aborts)
+{
+    // i = 1 / i
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, i, binary(ir::BinaryOp::DIV, integer(1), ref(i))));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), {});
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+
+    EXPECT_THAT(interpreter->run(), Eq(1));
+}
+
+TEST_F(NAME, unbounded_recursion_aborts)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // function f() : f() : endfunction
+    // f has no variables, so it doesn't use any stack slots
+    ir::StatementBlock body;
+    body.emplace_back(call(*f, f));
+    f->appendStatements(std::move(body));
+
+    ir::FunctionDefinition mainFunction(location_, "main");
+    ir::StatementBlock statements;
+    statements.emplace_back(call(mainFunction, f));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(0);
+
+    EXPECT_THAT(interpreter->run(), Eq(1));
+
+    // Including main, 4096 frames fit, so the 4096th call to f is rejected.
+    // The call depth is back to zero afterwards, so the program can run again
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(4096u));
+    EXPECT_THAT(interpreter->run(), Eq(1));
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(2u * 4096u));
+}
+
+TEST_F(NAME, hot_loop_compiles_function_for_next_call)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "f"));
+    ir::FunctionDefinition* f = functions.back().get();
+
+    // function f() : for j = 1 to 20 : next j : endfunction
+    auto j = variable(*f, "j");
+    ir::StatementBlock body;
+    body.emplace_back(forLoop(*f, j, integer(20), ir::StatementBlock{}));
+    f->appendStatements(std::move(body));
+
+    // f()
+    ir::FunctionDefinition mainFunction(location_, "main");
+    ir::StatementBlock statements;
+    statements.emplace_back(call(mainFunction, f));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(10);
+
+    // f is only entered once, so only its loop can cross the threshold. The
+    // call finishes in the interpreter, the next one would run compiled code
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->isCompiled(*f), IsTrue());
+    EXPECT_THAT(interpreter->entryCount(*f), Eq(1u));
+    EXPECT_THAT(interpreter->backEdgeCount(*f), Eq(20u));
+}
+
+TEST_F(NAME, functions_returning_values_stay_interpreted)
+{
+    ir::PtrVector<ir::FunctionDefinition> functions;
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "g"));
+    ir::FunctionDefinition* g = functions.back().get();
+
+    // function three() : endfunction 3
+    functions.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "three"));
+    ir::FunctionDefinition* three = functions.back().get();
+    three->setReturnExpression(integer(3));
+
+    // for i = 1 to three() : g() : next i
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock body;
+    body.emplace_back(call(mainFunction, g));
+    ir::StatementBlock statements;
+    statements.emplace_back(forLoop(mainFunction, i, callExpression(three), std::move(body)));
+    mainFunction.appendStatements(std::move(statements));
+
+    ir::Program program(std::move(mainFunction), std::move(functions));
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    interpreter->setTierUpThreshold(1);
+
+    EXPECT_THAT(interpreter->run(), Eq(0));
+    EXPECT_THAT(interpreter->isCompiled(*three), IsFalse());
+    EXPECT_THAT(interpreter->entryCount(*g), Eq(3u));
+    EXPECT_THAT(interpreter->entryCount(*three), Eq(4u));
+}
+
+TEST_F(NAME, unsupported_types_are_rejected)
+{
+    ir::FunctionDefinition mainFunction(location_, "main");
+    mainFunction.variables().add(
+        new ir::Variable(location_, "v", ir::Variable::Annotation::None, ir::Type{ir::BuiltinType::Vec3}));
+
+    ir::Program program(std::move(mainFunction), {});
+    EXPECT_THAT(ir::Interpreter::compile(program, cmdIndex_), IsNull());
+}
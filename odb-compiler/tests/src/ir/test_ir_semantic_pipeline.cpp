@@ -0,0 +1,239 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include <sstream>
+
+#define NAME ir_semantic_pipeline
+
+using namespace testing;
+using namespace odb;
+
+namespace {
+// Main calls functions before they are declared, which the pipeline has to
+// resolve at the end. The remaining calls can be resolved right away.
+const char* source =
+    "x = 5\n"
+    "y = twice() + 1\n"
+    "goto done\n"
+    "y = 0\n"
+    "done:\n"
+    "for i = 1 to 3\n"
+    "    y = y + i\n"
+    "next i\n"
+    "function helper(n)\n"
+    "endfunction n * 2\n"
+    "function twice()\n"
+    "    helper(3)\n"
+    "    r = five() * 2\n"
+    "endfunction r\n"
+    "function fact(n)\n"
+    "    if n > 1 then fact(n - 1)\n"
+    "endfunction n\n"
+    "function five()\n"
+    "endfunction 5\n";
+
+// Prints the program like source code, with the type of every cast and call
+class Printer
+{
+public:
+    std::string print(const ir::Program& program)
+    {
+        printFunction(program.mainFunction());
+        for (const auto& function : program.functions())
+            printFunction(*function);
+        return os_.str();
+    }
+
+private:
+    void printFunction(const ir::FunctionDefinition& function)
+    {
+        os_ << "function " << function.name() << "\n";
+        printBlock(function.statements(), 1);
+        os_ << "endfunction";
+        if (function.returnExpression())
+            os_ << " " << expression(function.returnExpression().get());
+        os_ << "\n";
+    }
+
+    void printBlock(const ir::StatementBlock& block, int depth)
+    {
+        for (const auto& s : block)
+            printStatement(s.get(), depth);
+    }
+
+    void printStatement(const ir::Statement* s, int depth)
+    {
+        std::string indent(depth * 4, ' ');
+        switch (s->kind())
+        {
+        case ir::StatementKind::VarAssignment: {
+            auto* assignment = static_cast<const ir::VarAssignment*>(s);
+            os_ << indent << assignment->variable()->name() << " = " << expression(assignment->expression()) << "\n";
+            break;
+        }
+        case ir::StatementKind::Conditional: {
+            auto* conditional = static_cast<const ir::Conditional*>(s);
+            os_ << indent << "if " << expression(conditional->expression()) << "\n";
+            printBlock(conditional->trueBranch(), depth + 1);
+            os_ << indent << "else\n";
+            printBlock(conditional->falseBranch(), depth + 1);
+            os_ << indent << "endif\n";
+            break;
+        }
+        case ir::StatementKind::ForLoop: {
+            auto* loop = static_cast<const ir::ForLoop*>(s);
+            os_ << indent << "for " << loop->assignment().variable()->name() << " = "
+                << expression(loop->assignment().expression()) << " to " << expression(loop->endValue()) << " step "
+                << expression(loop->stepValue()) << "\n";
+            printBlock(loop->statements(), depth + 1);
+            os_ << indent << "next\n";
+            break;
+        }
+        case ir::StatementKind::Label:
+            os_ << indent << static_cast<const ir::Label*>(s)->name() << ":\n";
+            break;
+        case ir::StatementKind::Goto:
+            os_ << indent << "goto " << static_cast<const ir::Goto*>(s)->label()->name() << "\n";
+            break;
+        case ir::StatementKind::FunctionCall:
+            os_ << indent << expression(&static_cast<const ir::FunctionCall*>(s)->expression()) << "\n";
+            break;
+        default:
+            os_ << indent << "<statement " << int(s->kind()) << ">\n";
+            break;
+        }
+    }
+
+    std::string expression(const ir::Expression* e)
+    {
+        switch (e->kind())
+        {
+        case ir::ExpressionKind::Cast: {
+            auto* cast = static_cast<const ir::CastExpression*>(e);
+            return "(" + expression(cast->expression()) + " as " + cast->targetType().toString() + ")";
+        }
+        case ir::ExpressionKind::Binary: {
+            auto* binary = static_cast<const ir::BinaryExpression*>(e);
+            return "(" + expression(binary->left()) + " " + binaryOp(binary->op()) + " " +
+                   expression(binary->right()) + ")";
+        }
+        case ir::ExpressionKind::VarRef:
+            return static_cast<const ir::VarRefExpression*>(e)->variable()->name();
+        case ir::ExpressionKind::IntegerLiteral:
+            return std::to_string(static_cast<const ir::IntegerLiteral*>(e)->value());
+        case ir::ExpressionKind::ByteLiteral:
+            return std::to_string(static_cast<const ir::ByteLiteral*>(e)->value()) + "b";
+        case ir::ExpressionKind::FunctionCall: {
+            auto* call = static_cast<const ir::FunctionCallExpression*>(e);
+            std::string result = call->isUserFunction() ? call->userFunction()->name() : "<unresolved>";
+            result += "(";
+            for (const auto& argument : call->arguments())
+                result += (&argument == &call->arguments().front() ? "" : ", ") + expression(argument.get());
+            return result + ") as " + call->getType().toString();
+        }
+        default:
+            return "<expression " + std::to_string(int(e->kind())) + ">";
+        }
+    }
+
+    static std::string binaryOp(ir::BinaryOp op)
+    {
+        switch (op)
+        {
+        case ir::BinaryOp::ADD: return "+";
+        case ir::BinaryOp::SUB: return "-";
+        case ir::BinaryOp::MUL: return "*";
+        case ir::BinaryOp::GREATER_THAN: return ">";
+        default: return "<op " + std::to_string(int(op)) + ">";
+        }
+    }
+
+    std::ostringstream os_;
+};
+
+std::string print(const ir::Program& program)
+{
+    return Printer().print(program);
+}
+}
+
+class NAME : public Test
+{
+public:
+    cmd::CommandIndex cmdIndex;
+    cmd::CommandMatcher matcher;
+};
+
+TEST_F(NAME, calls_to_functions_declared_later_are_resolved)
+{
+    ir::SemanticCheckPipeline pipeline(cmdIndex);
+    db::StringParserDriver driver;
+    driver.setStatementConsumer(&pipeline);
+    Reference<ast::Block> ast = driver.parse("test", source, matcher);
+    ASSERT_THAT(ast, NotNull());
+    EXPECT_THAT(ast->statements(), IsEmpty());
+    auto program = pipeline.finish();
+    ASSERT_THAT(program, NotNull());
+
+    EXPECT_THAT(print(*program), Eq("function main\n"
+                                    "    x = (5b as Integer)\n"
+                                    "    y = ((twice() as Integer + (1b as Integer)) as Integer)\n"
+                                    "    goto done\n"
+                                    "    y = (0b as Integer)\n"
+                                    "    done:\n"
+                                    "    for i = (1b as Integer) to (3b as Integer) step 1\n"
+                                    "        y = (y + i)\n"
+                                    "    next\n"
+                                    "endfunction\n"
+                                    "function helper\n"
+                                    "endfunction (n * (2b as Integer))\n"
+                                    "function twice\n"
+                                    "    helper((3b as Integer)) as Integer\n"
+                                    "    r = ((five() as Byte * (2b as Byte)) as Integer)\n"
+                                    "endfunction r\n"
+                                    "function fact\n"
+                                    "    if (n > (1b as Integer))\n"
+                                    "        fact((n - (1b as Integer))) as void\n"
+                                    "    else\n"
+                                    "    endif\n"
+                                    "endfunction n\n"
+                                    "function five\n"
+                                    "endfunction 5b\n"));
+}
+
+TEST_F(NAME, files_are_merged_in_the_order_they_are_parsed)
+{
+    ir::SemanticCheckPipeline pipeline(cmdIndex);
+    db::StringParserDriver driver;
+    driver.setStatementConsumer(&pipeline);
+    ASSERT_THAT(driver.parse("main", "x = one() + 1\n", matcher), NotNull());
+    ASSERT_THAT(driver.parse("functions", "function one()\nendfunction 1\n", matcher), NotNull());
+    auto program = pipeline.finish();
+    ASSERT_THAT(program, NotNull());
+
+    EXPECT_THAT(print(*program), Eq("function main\n"
+                                    "    x = ((one() as Byte + (1b as Byte)) as Integer)\n"
+                                    "endfunction\n"
+                                    "function one\n"
+                                    "endfunction 1b\n"));
+}
+
+TEST_F(NAME, pipeline_can_be_abandoned_after_parse_error)
+{
+    // main calls a function that is never declared, because parsing stops
+    // before it. Discarding the pipeline must not try to convert it.
+    ir::SemanticCheckPipeline pipeline(cmdIndex);
+    db::StringParserDriver driver;
+    driver.setStatementConsumer(&pipeline);
+    Reference<ast::Block> ast = driver.parse("test",
+        "x = 1\n"
+        "y = f()\n"
+        "z = (\n"
+        "function f()\n"
+        "endfunction 1\n",
+        matcher);
+    EXPECT_THAT(ast, IsNull());
+}
@@ -0,0 +1,454 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ir/Codegen.hpp"
+#include "odb-compiler/ir/Interpreter.hpp"
+#include "odb-compiler/irpost/FoldConstants.hpp"
+#include "odb-compiler/tests/IRTestHarness.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <regex>
+#include <sstream>
+
+#define NAME irpost_fold_constants
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public IRTestHarness
+{
+public:
+    using Operand = std::function<ir::Ptr<ir::Expression>()>;
+    using Build = std::function<ir::Ptr<ir::Expression>(ir::Ptr<ir::Expression>, ir::Ptr<ir::Expression>)>;
+
+    template <typename T> Operand literal(T value)
+    {
+        return [this, value] { return std::make_unique<ir::LiteralTemplate<T>>(location_, value); };
+    }
+
+    using IRTestHarness::binary;
+    Build binary(ir::BinaryOp op)
+    {
+        return [this, op](ir::Ptr<ir::Expression> left, ir::Ptr<ir::Expression> right) {
+            return binary(op, std::move(left), std::move(right));
+        };
+    }
+
+    Build unary(ir::UnaryOp op)
+    {
+        return [this, op](ir::Ptr<ir::Expression> operand, ir::Ptr<ir::Expression>) -> ir::Ptr<ir::Expression> {
+            return std::make_unique<ir::UnaryExpression>(location_, op, std::move(operand));
+        };
+    }
+
+    Build cast(ir::BuiltinType targetType)
+    {
+        return [this, targetType](ir::Ptr<ir::Expression> operand, ir::Ptr<ir::Expression>) -> ir::Ptr<ir::Expression> {
+            return std::make_unique<ir::CastExpression>(location_, std::move(operand), ir::Type{targetType});
+        };
+    }
+
+    // if <condition> then hit()
+    ir::Ptr<ir::Statement> hitIf(ir::FunctionDefinition& function, ir::Ptr<ir::Expression> condition)
+    {
+        if (hit_ == nullptr)
+        {
+            functions_.emplace_back(std::make_unique<ir::FunctionDefinition>(location_, "hit"));
+            hit_ = functions_.back().get();
+        }
+        ir::StatementBlock trueBranch;
+        trueBranch.emplace_back(std::make_unique<ir::FunctionCall>(
+            location_, &function, ir::FunctionCallExpression(location_, hit_, {}, ir::Type{})));
+        return std::make_unique<ir::Conditional>(location_, &function, std::move(condition), std::move(trueBranch),
+                                                 ir::StatementBlock{});
+    }
+
+    std::unique_ptr<ir::Program> createProgram(ir::FunctionDefinition mainFunction, ir::StatementBlock statements)
+    {
+        mainFunction.appendStatements(std::move(statements));
+        return std::make_unique<ir::Program>(std::move(mainFunction), std::move(functions_));
+    }
+
+    // Number of times the program calls hit(), or -1 if it didn't run
+    int runProgram(const ir::Program& program)
+    {
+        auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+        if (interpreter == nullptr || interpreter->run() != 0)
+            return -1;
+        return int(interpreter->entryCount(*hit_));
+    }
+
+    // function compute(a, b) : endfunction <expression of a and b>
+    // if compute(x, y) = <expression of x and y> then hit()
+    //
+    // The expression in main folds into a literal, while compute() still
+    // evaluates it at runtime, so hit() is only called if the two agree.
+    void expectSameResultAsInterpreter(ir::BuiltinType type, const Build& build, const Operand& x, const Operand& y)
+    {
+        functions_.clear();
+        hit_ = nullptr;
+        functions_.emplace_back(std::make_unique<ir::FunctionDefinition>(
+            location_, "compute",
+            std::vector<ir::FunctionDefinition::Argument>{{ir::Type{type}, "a"}, {ir::Type{type}, "b"}}));
+        ir::FunctionDefinition* compute = functions_.back().get();
+        auto a = variable(*compute, "a", type);
+        auto b = variable(*compute, "b", type);
+        compute->setReturnExpression(build(ref(a), ref(b)));
+
+        ir::FunctionDefinition mainFunction(location_, "main");
+        ir::PtrVector<ir::Expression> args;
+        args.emplace_back(x());
+        args.emplace_back(y());
+        auto call = std::make_unique<ir::FunctionCallExpression>(location_, compute, std::move(args),
+                                                                 compute->returnExpression()->getType());
+        ir::StatementBlock statements;
+        statements.emplace_back(
+            hitIf(mainFunction, binary(ir::BinaryOp::EQUAL)(std::move(call), build(x(), y()))));
+        mainFunction.appendStatements(std::move(statements));
+        ir::Program program(std::move(mainFunction), std::move(functions_));
+
+        ASSERT_THAT(irpost::FoldConstants().execute(&program), IsTrue());
+        auto* condition = static_cast<const ir::BinaryExpression*>(
+            static_cast<const ir::Conditional*>(program.mainFunction().statements()[0].get())->expression());
+        EXPECT_THAT(dynamic_cast<const ir::Literal*>(condition->right()), NotNull());
+
+        auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+        ASSERT_THAT(interpreter, NotNull());
+        EXPECT_THAT(interpreter->run(), Eq(0));
+        EXPECT_THAT(interpreter->entryCount(*hit_), Eq(1u));
+    }
+
+    template <typename T> void expectBinaryOpsMatch(const std::vector<ir::BinaryOp>& ops, T x, T y)
+    {
+        for (ir::BinaryOp op : ops)
+        {
+            SCOPED_TRACE(testing::Message() << "op " << int(op) << ", type " << int(ir::LiteralType<T>::type));
+            expectSameResultAsInterpreter(ir::LiteralType<T>::type, binary(op), literal(x), literal(y));
+        }
+    }
+
+    // Returns the constant the LLVM code for "result = <expression of x and y>"
+    // stores in result. The IR builder evaluates instructions with constant
+    // operands while creating them, so if the expression isn't folded first,
+    // this is the result of the generated code.
+    std::string generatedResult(const Build& build, const Operand& x, const Operand& y, bool fold)
+    {
+        ir::FunctionDefinition mainFunction(location_, "main");
+        auto expression = build(x(), y());
+        auto result = variable(mainFunction, "result", *expression->getType().getBuiltinType());
+        ir::StatementBlock statements;
+        statements.emplace_back(assign(mainFunction, result, std::move(expression)));
+        mainFunction.appendStatements(std::move(statements));
+        ir::Program program(std::move(mainFunction), {});
+        if (fold)
+        {
+            EXPECT_THAT(irpost::FoldConstants().execute(&program), IsTrue());
+        }
+
+        std::stringstream ss;
+        ir::TargetTriple targetTriple{ir::TargetTriple::Arch::x86_64, ir::TargetTriple::Platform::Linux};
+        EXPECT_THAT(ir::generateCode(SDKType::ODB, ir::OutputType::LLVMIR, targetTriple, ss, "test", program,
+                                     cmdIndex_),
+                    IsTrue());
+
+        // The first store initializes the variable
+        std::string ir = ss.str();
+        std::regex store("store (\\w+ [^%,]+), \\w+\\* %result,");
+        std::string value;
+        for (auto it = std::sregex_iterator(ir.begin(), ir.end(), store); it != std::sregex_iterator(); ++it)
+            value = (*it)[1];
+        return value;
+    }
+
+    template <typename T> void expectBinaryOpsMatchGeneratedCode(const std::vector<ir::BinaryOp>& ops, T x, T y)
+    {
+        for (ir::BinaryOp op : ops)
+        {
+            SCOPED_TRACE(testing::Message() << "op " << int(op) << ", type " << int(ir::LiteralType<T>::type));
+            std::string unfolded = generatedResult(binary(op), literal(x), literal(y), false);
+            EXPECT_THAT(unfolded, Not(IsEmpty()));
+            EXPECT_THAT(generatedResult(binary(op), literal(x), literal(y), true), Eq(unfolded));
+        }
+    }
+
+    ir::PtrVector<ir::FunctionDefinition> functions_;
+    ir::FunctionDefinition* hit_ = nullptr;
+};
+
+using ir::BinaryOp;
+
+static const std::vector<BinaryOp> integralOps = {
+    BinaryOp::ADD,         BinaryOp::SUB,          BinaryOp::MUL,        BinaryOp::DIV,
+    BinaryOp::MOD,         BinaryOp::SHIFT_LEFT,   BinaryOp::SHIFT_RIGHT, BinaryOp::BITWISE_OR,
+    BinaryOp::BITWISE_AND, BinaryOp::BITWISE_XOR,  BinaryOp::LESS_THAN,  BinaryOp::LESS_EQUAL,
+    BinaryOp::GREATER_THAN, BinaryOp::GREATER_EQUAL, BinaryOp::EQUAL,    BinaryOp::NOT_EQUAL,
+    BinaryOp::LOGICAL_OR,  BinaryOp::LOGICAL_AND,  BinaryOp::LOGICAL_XOR};
+
+static const std::vector<BinaryOp> floatingPointOps = {
+    BinaryOp::ADD,          BinaryOp::SUB,        BinaryOp::MUL,           BinaryOp::DIV,
+    BinaryOp::MOD,          BinaryOp::POW,        BinaryOp::LESS_THAN,     BinaryOp::LESS_EQUAL,
+    BinaryOp::GREATER_THAN, BinaryOp::GREATER_EQUAL, BinaryOp::EQUAL,      BinaryOp::NOT_EQUAL,
+    BinaryOp::LOGICAL_OR,   BinaryOp::LOGICAL_AND, BinaryOp::LOGICAL_XOR};
+
+static const std::vector<BinaryOp> booleanOps = {
+    BinaryOp::LESS_THAN, BinaryOp::LESS_EQUAL, BinaryOp::GREATER_THAN, BinaryOp::GREATER_EQUAL, BinaryOp::EQUAL,
+    BinaryOp::NOT_EQUAL, BinaryOp::LOGICAL_OR, BinaryOp::LOGICAL_AND,  BinaryOp::LOGICAL_XOR};
+
+TEST_F(NAME, binary_ops_match_interpreter)
+{
+    expectBinaryOpsMatch<int64_t>(integralOps, -7000000000, 3);
+    expectBinaryOpsMatch<int32_t>(integralOps, 1234567, -5);
+    expectBinaryOpsMatch<int32_t>(integralOps, std::numeric_limits<int32_t>::min(), -1);
+    expectBinaryOpsMatch<uint32_t>(integralOps, 4000000000u, 35);
+    expectBinaryOpsMatch<uint16_t>(integralOps, 65000, 600);
+    expectBinaryOpsMatch<uint8_t>(integralOps, 200, 100);
+    expectBinaryOpsMatch<double>(floatingPointOps, 2.5, -1.75);
+    expectBinaryOpsMatch<float>(floatingPointOps, 6.5f, -0.25f);
+    expectBinaryOpsMatch<bool>(booleanOps, true, false);
+}
+
+// The IR builder can't evaluate calls to pow(), so POW is left out here
+static const std::vector<BinaryOp> generatedIntegralOps = {
+    BinaryOp::ADD,        BinaryOp::SUB,         BinaryOp::MUL,          BinaryOp::DIV,
+    BinaryOp::MOD,        BinaryOp::SHIFT_LEFT,  BinaryOp::SHIFT_RIGHT,  BinaryOp::BITWISE_OR,
+    BinaryOp::BITWISE_AND, BinaryOp::BITWISE_XOR, BinaryOp::LESS_THAN,   BinaryOp::LESS_EQUAL,
+    BinaryOp::GREATER_THAN, BinaryOp::GREATER_EQUAL, BinaryOp::EQUAL,    BinaryOp::NOT_EQUAL};
+
+static const std::vector<BinaryOp> generatedFloatingPointOps = {
+    BinaryOp::ADD,          BinaryOp::SUB,           BinaryOp::MUL,   BinaryOp::DIV,      BinaryOp::MOD,
+    BinaryOp::LESS_THAN,    BinaryOp::LESS_EQUAL,    BinaryOp::GREATER_THAN, BinaryOp::GREATER_EQUAL,
+    BinaryOp::EQUAL,        BinaryOp::NOT_EQUAL};
+
+TEST_F(NAME, binary_ops_match_generated_code)
+{
+    expectBinaryOpsMatchGeneratedCode<int64_t>(generatedIntegralOps, -7000000000, 3);
+    expectBinaryOpsMatchGeneratedCode<int32_t>(generatedIntegralOps, -1234567, 5);
+    expectBinaryOpsMatchGeneratedCode<int32_t>(generatedIntegralOps, 1234567, 35);
+    expectBinaryOpsMatchGeneratedCode<uint32_t>(generatedIntegralOps, 4000000000u, 35);
+    expectBinaryOpsMatchGeneratedCode<uint16_t>(generatedIntegralOps, 65000, 600);
+    expectBinaryOpsMatchGeneratedCode<uint8_t>(generatedIntegralOps, 200, 100);
+    expectBinaryOpsMatchGeneratedCode<double>(generatedFloatingPointOps, 2.5, -1.75);
+    expectBinaryOpsMatchGeneratedCode<float>(generatedFloatingPointOps, 6.5f, -0.25f);
+    expectBinaryOpsMatchGeneratedCode<bool>(
+        {BinaryOp::LESS_THAN, BinaryOp::GREATER_THAN, BinaryOp::EQUAL, BinaryOp::NOT_EQUAL, BinaryOp::LOGICAL_OR,
+         BinaryOp::LOGICAL_AND, BinaryOp::LOGICAL_XOR},
+        true, false);
+}
+
+TEST_F(NAME, casts_match_generated_code)
+{
+    auto expectMatch = [this](ir::BuiltinType targetType, const Operand& x) {
+        SCOPED_TRACE(testing::Message() << "target type " << int(targetType));
+        std::string unfolded = generatedResult(cast(targetType), x, x, false);
+        EXPECT_THAT(unfolded, Not(IsEmpty()));
+        EXPECT_THAT(generatedResult(cast(targetType), x, x, true), Eq(unfolded));
+    };
+    expectMatch(ir::BuiltinType::Integer, literal<uint8_t>(200));
+    expectMatch(ir::BuiltinType::DoubleInteger, literal<uint32_t>(4000000000u));
+    expectMatch(ir::BuiltinType::Byte, literal<int32_t>(-1));
+    expectMatch(ir::BuiltinType::DoubleFloat, literal<uint32_t>(4000000000u));
+    expectMatch(ir::BuiltinType::Float, literal<int32_t>(-3));
+    expectMatch(ir::BuiltinType::Dword, literal(3000000000.0));
+    expectMatch(ir::BuiltinType::Integer, literal(-3.75));
+    expectMatch(ir::BuiltinType::Integer, literal(true));
+    expectMatch(ir::BuiltinType::Boolean, literal<int32_t>(2));
+    expectMatch(ir::BuiltinType::Boolean, literal(0.5f));
+}
+
+TEST_F(NAME, integer_power_matches_interpreter)
+{
+    expectSameResultAsInterpreter(ir::BuiltinType::Integer, binary(BinaryOp::POW), literal<int32_t>(3),
+                                  literal<int32_t>(7));
+    expectSameResultAsInterpreter(ir::BuiltinType::Byte, binary(BinaryOp::POW), literal<uint8_t>(2),
+                                  literal<uint8_t>(7));
+}
+
+TEST_F(NAME, unary_ops_match_interpreter)
+{
+    expectSameResultAsInterpreter(ir::BuiltinType::Integer, unary(ir::UnaryOp::NEGATE),
+                                  literal(std::numeric_limits<int32_t>::min()), literal<int32_t>(0));
+    expectSameResultAsInterpreter(ir::BuiltinType::Word, unary(ir::UnaryOp::NEGATE), literal<uint16_t>(5),
+                                  literal<uint16_t>(0));
+    expectSameResultAsInterpreter(ir::BuiltinType::Float, unary(ir::UnaryOp::NEGATE), literal(1.5f), literal(0.0f));
+    expectSameResultAsInterpreter(ir::BuiltinType::Byte, unary(ir::UnaryOp::BITWISE_NOT), literal<uint8_t>(0x0f),
+                                  literal<uint8_t>(0));
+    expectSameResultAsInterpreter(ir::BuiltinType::DoubleInteger, unary(ir::UnaryOp::BITWISE_NOT),
+                                  literal<int64_t>(12), literal<int64_t>(0));
+    expectSameResultAsInterpreter(ir::BuiltinType::Boolean, unary(ir::UnaryOp::LOGICAL_NOT), literal(false),
+                                  literal(false));
+}
+
+TEST_F(NAME, casts_match_interpreter)
+{
+    expectSameResultAsInterpreter(ir::BuiltinType::Integer, cast(ir::BuiltinType::Byte), literal<int32_t>(-1),
+                                  literal<int32_t>(0));
+    expectSameResultAsInterpreter(ir::BuiltinType::Integer, cast(ir::BuiltinType::Float), literal<int32_t>(16777217),
+                                  literal<int32_t>(0));
+    expectSameResultAsInterpreter(ir::BuiltinType::DoubleFloat, cast(ir::BuiltinType::Integer), literal(-3.75),
+                                  literal(0.0));
+    expectSameResultAsInterpreter(ir::BuiltinType::Float, cast(ir::BuiltinType::Boolean), literal(0.5f),
+                                  literal(0.0f));
+    expectSameResultAsInterpreter(ir::BuiltinType::Boolean, cast(ir::BuiltinType::DoubleInteger), literal(true),
+                                  literal(false));
+    expectSameResultAsInterpreter(ir::BuiltinType::Dword, cast(ir::BuiltinType::Word), literal<uint32_t>(0x12345),
+                                  literal<uint32_t>(0));
+}
+
+TEST_F(NAME, nested_expressions_fold_completely)
+{
+    // i = (1 + 2) * -(4 << 1)
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(
+        mainFunction, i,
+        binary(BinaryOp::MUL)(binary(BinaryOp::ADD)(integer(1), integer(2)),
+                              unary(ir::UnaryOp::NEGATE)(binary(BinaryOp::SHIFT_LEFT)(integer(4), integer(1)),
+                                                         nullptr))));
+    mainFunction.appendStatements(std::move(statements));
+    ir::Program program(std::move(mainFunction), {});
+
+    ASSERT_THAT(irpost::FoldConstants().execute(&program), IsTrue());
+    auto* assignment = static_cast<const ir::VarAssignment*>(program.mainFunction().statements()[0].get());
+    ASSERT_THAT(assignment->expression()->kind(), Eq(ir::ExpressionKind::IntegerLiteral));
+    EXPECT_THAT(static_cast<const ir::IntegerLiteral*>(assignment->expression())->value(), Eq(-24));
+}
+
+TEST_F(NAME, division_by_zero_is_left_for_runtime)
+{
+    // i = 1 / 0
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, i, binary(BinaryOp::DIV)(integer(1), integer(0))));
+    mainFunction.appendStatements(std::move(statements));
+    ir::Program program(std::move(mainFunction), {});
+
+    ASSERT_THAT(irpost::FoldConstants().execute(&program), IsTrue());
+    auto* assignment = static_cast<const ir::VarAssignment*>(program.mainFunction().statements()[0].get());
+    EXPECT_THAT(assignment->expression()->kind(), Eq(ir::ExpressionKind::Binary));
+
+    auto interpreter = ir::Interpreter::compile(program, cmdIndex_);
+    ASSERT_THAT(interpreter, NotNull());
+    EXPECT_THAT(interpreter->run(), Eq(1));
+}
+
+TEST_F(NAME, out_of_range_float_to_integer_cast_is_not_folded)
+{
+    // i = 1e10 as integer
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, i, cast(ir::BuiltinType::Integer)(literal(1e10)(), nullptr)));
+    mainFunction.appendStatements(std::move(statements));
+    ir::Program program(std::move(mainFunction), {});
+
+    ASSERT_THAT(irpost::FoldConstants().execute(&program), IsTrue());
+    auto* assignment = static_cast<const ir::VarAssignment*>(program.mainFunction().statements()[0].get());
+    EXPECT_THAT(assignment->expression()->kind(), Eq(ir::ExpressionKind::Cast));
+}
+
+TEST_F(NAME, assigned_constants_propagate)
+{
+    // a = 6 : b = a * 7 : if b = 42 then hit()
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto a = variable(mainFunction, "a");
+    auto b = variable(mainFunction, "b");
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, a, integer(6)));
+    statements.emplace_back(assign(mainFunction, b, binary(BinaryOp::MUL)(ref(a), integer(7))));
+    statements.emplace_back(hitIf(mainFunction, binary(BinaryOp::EQUAL)(ref(b), integer(42))));
+    auto program = createProgram(std::move(mainFunction), std::move(statements));
+
+    ASSERT_THAT(irpost::FoldConstants().execute(program.get()), IsTrue());
+    const ir::StatementBlock& folded = program->mainFunction().statements();
+    auto* assignment = static_cast<const ir::VarAssignment*>(folded[1].get());
+    ASSERT_THAT(assignment->expression()->kind(), Eq(ir::ExpressionKind::IntegerLiteral));
+    EXPECT_THAT(static_cast<const ir::IntegerLiteral*>(assignment->expression())->value(), Eq(42));
+    auto* conditional = static_cast<const ir::Conditional*>(folded[2].get());
+    ASSERT_THAT(conditional->expression()->kind(), Eq(ir::ExpressionKind::BooleanLiteral));
+    EXPECT_THAT(static_cast<const ir::BooleanLiteral*>(conditional->expression())->value(), IsTrue());
+    EXPECT_THAT(runProgram(*program), Eq(1));
+}
+
+TEST_F(NAME, variables_changed_by_loops_are_not_propagated)
+{
+    // a = 1 : n = 3
+    // for i = 1 to n : a = a + 1 : next i
+    // if a = 4 then hit()
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto a = variable(mainFunction, "a");
+    auto n = variable(mainFunction, "n");
+    auto i = variable(mainFunction, "i");
+    ir::StatementBlock body;
+    body.emplace_back(assign(mainFunction, a, binary(BinaryOp::ADD)(ref(a), integer(1))));
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, a, integer(1)));
+    statements.emplace_back(assign(mainFunction, n, integer(3)));
+    statements.emplace_back(std::make_unique<ir::ForLoop>(location_, &mainFunction,
+                                                          ir::VarAssignment(location_, &mainFunction, i, integer(1)),
+                                                          ref(n), integer(1), std::move(body)));
+    statements.emplace_back(hitIf(mainFunction, binary(BinaryOp::EQUAL)(ref(a), integer(4))));
+    auto program = createProgram(std::move(mainFunction), std::move(statements));
+
+    ASSERT_THAT(irpost::FoldConstants().execute(program.get()), IsTrue());
+    // n isn't changed by the loop, so the end value is still known
+    auto* loop = static_cast<const ir::ForLoop*>(program->mainFunction().statements()[2].get());
+    EXPECT_THAT(loop->endValue()->kind(), Eq(ir::ExpressionKind::IntegerLiteral));
+    EXPECT_THAT(runProgram(*program), Eq(1));
+}
+
+TEST_F(NAME, branches_only_propagate_what_they_agree_on)
+{
+    // if c then a = 2 : b = 3 else a = 2 : b = 4 endif
+    // if a = 2 then hit()
+    // if b = 4 then hit()
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto a = variable(mainFunction, "a");
+    auto b = variable(mainFunction, "b");
+    auto c = variable(mainFunction, "c", ir::BuiltinType::Boolean);
+    ir::StatementBlock trueBranch, falseBranch;
+    trueBranch.emplace_back(assign(mainFunction, a, integer(2)));
+    trueBranch.emplace_back(assign(mainFunction, b, integer(3)));
+    falseBranch.emplace_back(assign(mainFunction, a, integer(2)));
+    falseBranch.emplace_back(assign(mainFunction, b, integer(4)));
+    ir::StatementBlock statements;
+    statements.emplace_back(std::make_unique<ir::Conditional>(location_, &mainFunction, ref(c), std::move(trueBranch),
+                                                              std::move(falseBranch)));
+    statements.emplace_back(hitIf(mainFunction, binary(BinaryOp::EQUAL)(ref(a), integer(2))));
+    statements.emplace_back(hitIf(mainFunction, binary(BinaryOp::EQUAL)(ref(b), integer(4))));
+    auto program = createProgram(std::move(mainFunction), std::move(statements));
+
+    ASSERT_THAT(irpost::FoldConstants().execute(program.get()), IsTrue());
+    const ir::StatementBlock& folded = program->mainFunction().statements();
+    EXPECT_THAT(static_cast<const ir::Conditional*>(folded[1].get())->expression()->kind(),
+                Eq(ir::ExpressionKind::BooleanLiteral));
+    EXPECT_THAT(static_cast<const ir::Conditional*>(folded[2].get())->expression()->kind(),
+                Eq(ir::ExpressionKind::Binary));
+    // c starts out false
+    EXPECT_THAT(runProgram(*program), Eq(2));
+}
+
+TEST_F(NAME, gosub_forgets_known_values)
+{
+    // a = 1 : gosub sub : if a = 2 then hit() : goto done
+    // sub: a = 2 : return
+    // done:
+    ir::FunctionDefinition mainFunction(location_, "main");
+    auto a = variable(mainFunction, "a");
+    auto sub = std::make_unique<ir::Label>(location_, &mainFunction, "sub");
+    auto done = std::make_unique<ir::Label>(location_, &mainFunction, "done");
+    ir::StatementBlock statements;
+    statements.emplace_back(assign(mainFunction, a, integer(1)));
+    statements.emplace_back(std::make_unique<ir::Gosub>(location_, &mainFunction, sub.get()));
+    statements.emplace_back(hitIf(mainFunction, binary(BinaryOp::EQUAL)(ref(a), integer(2))));
+    statements.emplace_back(std::make_unique<ir::Goto>(location_, &mainFunction, done.get()));
+    statements.emplace_back(std::move(sub));
+    statements.emplace_back(assign(mainFunction, a, integer(2)));
+    statements.emplace_back(std::make_unique<ir::SubReturn>(location_, &mainFunction));
+    statements.emplace_back(std::move(done));
+    auto program = createProgram(std::move(mainFunction), std::move(statements));
+
+    ASSERT_THAT(irpost::FoldConstants().execute(program.get()), IsTrue());
+    EXPECT_THAT(runProgram(*program), Eq(1));
+}
@@ -0,0 +1,262 @@
+#include <gmock/gmock.h>
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/ast/Serialization.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-compiler/parsers/db/FastScanner.hpp"
+#include "odb-compiler/parsers/db/Parser.y.hpp"
+#include "odb-compiler/parsers/db/Scanner.hpp"
+#include "odb-sdk/Str.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+#define NAME db_scanner_differential
+
+using namespace testing;
+using namespace odb;
+using namespace std::string_literals;
+
+namespace {
+struct Token
+{
+    int kind;
+    std::string text;
+    std::string value;
+    int firstLine, firstColumn, lastLine, lastColumn;
+
+    bool operator==(const Token& other) const
+    {
+        return kind == other.kind && text == other.text && value == other.value
+            && firstLine == other.firstLine && firstColumn == other.firstColumn
+            && lastLine == other.lastLine && lastColumn == other.lastColumn;
+    }
+};
+
+void PrintTo(const Token& token, std::ostream* os)
+{
+    *os << "{" << token.kind << " \"" << token.text << "\" " << token.value << " "
+        << token.firstLine << ":" << token.firstColumn << "-"
+        << token.lastLine << ":" << token.lastColumn << "}";
+}
+
+// Takes ownership of the value's string, if there is one
+Token makeToken(int kind, DBSTYPE* value, const DBLTYPE& loc, std::string_view text)
+{
+    Token token = {kind, std::string(text), "", loc.first_line, loc.first_column, loc.last_line, loc.last_column};
+    char buf[64] = "";
+    switch (kind)
+    {
+        case TOK_SYMBOL:
+        case TOK_STRING_LITERAL:
+            token.value = value->string;
+            str::deleteCStr(value->string);
+            break;
+        case TOK_BOOLEAN_LITERAL:
+            token.value = value->boolean_value ? "true" : "false";
+            break;
+        case TOK_INTEGER_LITERAL:
+            snprintf(buf, sizeof(buf), "%lld", (long long)value->integer_value);
+            break;
+        case TOK_DOUBLE_LITERAL:
+            snprintf(buf, sizeof(buf), "%a", value->double_value);
+            break;
+        case TOK_FLOAT_LITERAL:
+        case TOK_IMAG_I:
+        case TOK_IMAG_J:
+        case TOK_IMAG_K:
+            snprintf(buf, sizeof(buf), "%a", (double)value->float_value);
+            break;
+        default:
+            break;
+    }
+    if (buf[0])
+        token.value = buf;
+    return token;
+}
+
+std::vector<Token> scanWithFlex(const std::string& source)
+{
+    db::StringParserDriver driver;
+    dbscan_t scanner;
+    dblex_init_extra(&driver, &scanner);
+    YY_BUFFER_STATE buf = db_scan_bytes(source.data(), (int)source.length(), scanner);
+
+    std::vector<Token> tokens;
+    DBLTYPE loc = {1, 1, 1, 1};
+    int kind;
+    do {
+        DBSTYPE value;
+        kind = dblex(&value, &loc, scanner);
+        std::string_view text;
+        if (kind != TOK_END)
+            text = std::string_view(dbget_text(scanner), dbget_leng(scanner));
+        tokens.push_back(makeToken(kind, &value, loc, text));
+    } while (kind != TOK_END);
+
+    db_delete_buffer(buf, scanner);
+    dblex_destroy(scanner);
+    return tokens;
+}
+
+std::vector<Token> scanWithFastScanner(const std::string& source)
+{
+    db::StringParserDriver driver;
+    db::FastScanner scanner(&driver, source.data(), source.length());
+
+    std::vector<Token> tokens;
+    DBLTYPE loc = {1, 1, 1, 1};
+    int kind;
+    do {
+        DBSTYPE value;
+        kind = scanner.lex(&value, &loc);
+        tokens.push_back(makeToken(kind, &value, loc, kind == TOK_END ? std::string_view() : scanner.text()));
+    } while (kind != TOK_END);
+
+    return tokens;
+}
+
+std::vector<std::filesystem::path> corpus()
+{
+    std::vector<std::filesystem::path> files;
+    for (const char* dir : {"dba-sources", "afl/testcases"})
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(ODB_SOURCE_ROOT) / dir))
+            if (entry.path().extension() == ".dba")
+                files.push_back(entry.path());
+    return files;
+}
+
+std::string readFile(const std::filesystem::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void expectIdenticalParses(db::FileParserDriver* expectedDriver, db::FileParserDriver* actualDriver)
+{
+    cmd::CommandMatcher matcher;
+    for (const auto& file : corpus())
+    {
+        SCOPED_TRACE(file.string());
+        Reference<ast::Block> expected = expectedDriver->parse(file.string(), matcher);
+        Reference<ast::Block> actual = actualDriver->parse(file.string(), matcher);
+        ASSERT_THAT(actual.get() == nullptr, Eq(expected.get() == nullptr));
+        if (expected == nullptr)
+            continue;
+
+        // Sources are serialized by file name, so this compares the trees
+        // including all of their locations
+        std::vector<uint8_t> expectedData, actualData;
+        ast::serialize(&expectedData, expected);
+        ast::serialize(&actualData, actual);
+        EXPECT_THAT(actualData, Eq(expectedData));
+    }
+}
+}
+
+class NAME : public Test
+{
+};
+
+TEST_F(NAME, corpus_scans_identically)
+{
+    std::vector<std::filesystem::path> files = corpus();
+    ASSERT_THAT(files, Not(IsEmpty()));
+    for (const auto& file : files)
+    {
+        SCOPED_TRACE(file.string());
+        std::string source = readFile(file);
+        EXPECT_THAT(scanWithFastScanner(source), ContainerEq(scanWithFlex(source)));
+    }
+}
+
+TEST_F(NAME, truncated_corpus_scans_identically)
+{
+    // Cutting files at arbitrary points leaves strings and remarks open, and
+    // numbers and keywords half finished
+    for (const auto& file : corpus())
+    {
+        std::string source = readFile(file);
+        for (size_t length = 0; length < source.length(); length += 97)
+        {
+            SCOPED_TRACE(file.string() + " cut at " + std::to_string(length));
+            std::string truncated = source.substr(0, length);
+            ASSERT_THAT(scanWithFastScanner(truncated), ContainerEq(scanWithFlex(truncated)));
+        }
+    }
+}
+
+TEST_F(NAME, edge_cases_scan_identically)
+{
+    const char* sources[] = {
+        "",
+        "   \t\r  ",
+        "rem\nREM x\nremark\nrem1\nremend\nRemStart\nfoo\nREMEND bar",
+        "remstartx y remstart a remEND b",
+        "remstart never ends\n\n",
+        "remstart",
+        "x /* a * / b */ y /**/ z /*/ w */",
+        "/* open",
+        "/*",
+        "// comment\n` comment\n`\n//",
+        "a$ = \"multi\nline\" + \"\" + \"open",
+        "\"",
+        "1 12 1.5 1. .5 1.5e3 1e3 1e+3 1e-3 1e 1e+ 1.e5 1..2 1.5.3",
+        "1f 1.5f 1e3F .5f 1i 1.5j 2.5e2K .5i",
+        "0x 0x1F 0XaBc 0x1g 0x1Fi 0xFFFFFFFFFFFFFFFFF 0x1e5k",
+        "%101 %2 %1i %012 % 1",
+        "99999999999999999999 9223372036854775807 9223372036854775808",
+        "1e400 1e-400 1e400f 2.5e-50f",
+        "true false TRUE False truex falsey",
+        "#constant #constantx # constant #Constant",
+        "<< >> || && ~~ .. <> <= >= = < > | & ~ ...",
+        "+-*/^(),:;#$%&.\n\n\r\n",
+        "@ ! ? { } [ ] \\ ' \x7f \xc3\xa4",
+        "a\tb \t\t c_d _e F9",
+    };
+    for (const char* source : sources)
+    {
+        SCOPED_TRACE(source);
+        EXPECT_THAT(scanWithFastScanner(source), ContainerEq(scanWithFlex(source)));
+    }
+}
+
+TEST_F(NAME, long_runs_cross_simd_blocks)
+{
+    std::string blanks(100, ' ');
+    std::string text(100, 'x');
+    std::string lines(100, '\n');
+    const std::string sources[] = {
+        blanks + "a" + blanks,
+        "/*" + text + lines + text + "*" + text + "*/ a",
+        "remstart" + text + "REM" + lines + "RemEnd" + text,
+        "rem " + text + "\n" + blanks + "b",
+        "\"" + text + lines + text + "\" c",
+        "x /*\0\n\0\0*/ y\0z"s,
+        "\"a\0b\nc\""s,
+    };
+    for (const std::string& source : sources)
+    {
+        SCOPED_TRACE(source);
+        EXPECT_THAT(scanWithFastScanner(source), ContainerEq(scanWithFlex(source)));
+    }
+}
+
+TEST_F(NAME, parse_results_are_identical)
+{
+    db::FileParserDriver flexDriver;
+    db::FileParserDriver fastDriver;
+    fastDriver.setUseFastScanner(true);
+    expectIdenticalParses(&flexDriver, &fastDriver);
+}
+
+TEST_F(NAME, mapped_files_parse_like_read_files)
+{
+    // FLEX scans its own private mapping of the file
+    db::FileParserDriver readDriver;
+    db::FileParserDriver mappedDriver;
+    mappedDriver.setUseMemoryMap(true);
+    expectIdenticalParses(&readDriver, &mappedDriver);
+}
@@ -0,0 +1,104 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-sdk/Arena.hpp"
+#include <thread>
+
+#define NAME Arena
+
+using namespace testing;
+using namespace odb;
+
+TEST(NAME, no_arena_is_active_by_default)
+{
+    EXPECT_THAT(Arena::current(), IsNull());
+}
+
+TEST(NAME, locations_are_allocated_from_active_arena)
+{
+    Reference<Arena> arena = new Arena;
+    Reference<ast::SourceLocation> location;
+    {
+        ArenaScope scope(arena);
+        EXPECT_THAT(Arena::current(), Eq(arena.get()));
+        location = new ast::InlineSourceLocation("test", "some command", 1, 1, 1, 5);
+    }
+
+    // One allocation for the object and one for its refcount
+    EXPECT_THAT(Arena::current(), IsNull());
+    EXPECT_THAT(arena->allocationCount(), Eq(2));
+    EXPECT_THAT(arena->blockCount(), Eq(1));
+}
+
+TEST(NAME, objects_keep_arena_alive)
+{
+    Reference<ast::SourceLocation> location;
+    {
+        Reference<Arena> arena = new Arena;
+        ArenaScope scope(arena);
+        location = new ast::InlineSourceLocation("test", "some command", 1, 1, 1, 5);
+    }
+
+    EXPECT_THAT(location->getFileLineColumn(), StrEq("test:1:1"));
+}
+
+TEST(NAME, nested_scopes_restore_previous_arena)
+{
+    Reference<Arena> outer = new Arena;
+    Reference<Arena> inner = new Arena;
+    {
+        ArenaScope outerScope(outer);
+        {
+            ArenaScope innerScope(inner);
+            EXPECT_THAT(Arena::current(), Eq(inner.get()));
+        }
+        EXPECT_THAT(Arena::current(), Eq(outer.get()));
+    }
+    EXPECT_THAT(Arena::current(), IsNull());
+}
+
+TEST(NAME, oversized_allocations_get_their_own_block)
+{
+    Reference<Arena> arena = new Arena(64);
+    Reference<ast::SourceLocation> location;
+    {
+        ArenaScope scope(arena);
+        location = new ast::InlineSourceLocation("test", "some command", 1, 1, 1, 5);
+    }
+
+    EXPECT_THAT(arena->blockCount(), Ge(1));
+    EXPECT_THAT(location->getFileLineColumn(), StrEq("test:1:1"));
+}
+
+TEST(NAME, allocations_outside_a_scope_come_from_the_heap)
+{
+    Reference<Arena> arena = new Arena;
+    {
+        ArenaScope scope(arena);
+        Reference<ast::SourceLocation> location = new ast::InlineSourceLocation("test", "", 1, 1, 1, 5);
+    }
+
+    Reference<ast::SourceLocation> location = new ast::InlineSourceLocation("test", "", 1, 1, 1, 5);
+    EXPECT_THAT(arena->allocationCount(), Eq(2));
+}
+
+TEST(NAME, objects_can_be_destroyed_on_another_thread)
+{
+    std::vector<Reference<ast::SourceLocation>> locations;
+    {
+        Reference<Arena> arena = new Arena(256);
+        ArenaScope scope(arena);
+        for (int i = 0; i != 100; ++i)
+            locations.push_back(new ast::InlineSourceLocation("test", "", i + 1, 1, i + 1, 5));
+    }
+
+    std::thread first([&locations] {
+        for (size_t i = 0; i < locations.size(); i += 2)
+            locations[i].reset();
+    });
+    std::thread second([&locations] {
+        for (size_t i = 1; i < locations.size(); i += 2)
+            locations[i].reset();
+    });
+    first.join();
+    second.join();
+}
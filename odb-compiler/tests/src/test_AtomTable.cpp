@@ -0,0 +1,160 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/Atom.hpp"
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-compiler/ast/Symbol.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/ir/Node.hpp"
+#include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include <thread>
+#include <vector>
+
+#define NAME AtomTable
+
+using namespace testing;
+using namespace odb;
+using namespace odb::ast;
+
+TEST(NAME, names_differing_in_case_are_the_same_atom)
+{
+    Atom a1 = AtomTable::intern("PlayerX");
+    Atom a2 = AtomTable::intern("playerx");
+    Atom a3 = AtomTable::intern("PLAYERX");
+    EXPECT_THAT(a1, Eq(a2));
+    EXPECT_THAT(a1, Eq(a3));
+}
+
+TEST(NAME, different_names_are_different_atoms)
+{
+    Atom a1 = AtomTable::intern("atom_a");
+    Atom a2 = AtomTable::intern("atom_b");
+    Atom a3 = AtomTable::intern("atom_a_");
+    EXPECT_THAT(a1, Ne(a2));
+    EXPECT_THAT(a1, Ne(a3));
+}
+
+TEST(NAME, name_is_stored_in_lower_case)
+{
+    Atom atom = AtomTable::intern("Mixed_Case9");
+    EXPECT_THAT(std::string(AtomTable::name(atom)), StrEq("mixed_case9"));
+}
+
+TEST(NAME, symbol_keeps_original_spelling)
+{
+    Reference<Symbol> symbol = new Symbol("MyLabel", new InlineSourceLocation("test", "MyLabel", 1, 1, 1, 7));
+    EXPECT_THAT(symbol->name(), StrEq("MyLabel"));
+    EXPECT_THAT(symbol->atom(), Eq(AtomTable::intern("mylabel")));
+}
+
+TEST(NAME, variable_lookup_ignores_case)
+{
+    SourceLocation* location = new InlineSourceLocation("test", "", 1, 1, 1, 1);
+    ir::FunctionDefinition function(location, "main");
+    Reference<ir::Variable> variable = new ir::Variable(location, "Score", ir::Variable::Annotation::None,
+                                                        ir::Type{ir::BuiltinType::Integer});
+    function.variables().add(variable);
+
+    EXPECT_THAT(function.variables().lookup(AtomTable::intern("SCORE"), ir::Variable::Annotation::None).get(),
+                Eq(variable.get()));
+    EXPECT_THAT(function.variables().lookup(AtomTable::intern("score"), ir::Variable::Annotation::String).get(),
+                IsNull());
+    EXPECT_THAT(function.variables().lookup(AtomTable::intern("scores"), ir::Variable::Annotation::None).get(),
+                IsNull());
+}
+
+TEST(NAME, threads_intern_the_same_atoms)
+{
+    // Every other thread spells the names in upper case
+    const char* names[2][4] = {{"Alpha", "beta", "GAMMA", "delta_1"}, {"ALPHA", "BETA", "gamma", "DELTA_1"}};
+    std::vector<Atom> atoms[4];
+    std::vector<std::thread> threads;
+    for (int i = 0; i != 4; ++i)
+        threads.emplace_back([&, i]() {
+            for (int repeat = 0; repeat != 100; ++repeat)
+                for (const char* name : names[i % 2])
+                    atoms[i].push_back(AtomTable::intern(name));
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int i = 1; i != 4; ++i)
+        EXPECT_THAT(atoms[i], Eq(atoms[0]));
+    EXPECT_THAT(atoms[0][0], Eq(AtomTable::intern("ALPHA")));
+}
+
+TEST(NAME, table_is_cleared_when_last_scope_ends)
+{
+    AtomTable::clear();
+    Atom atom;
+    {
+        AtomTable::Scope outer;
+        atom = AtomTable::intern("scoped_name");
+        {
+            AtomTable::Scope inner;
+        }
+        EXPECT_THAT(std::string(AtomTable::name(atom)), StrEq("scoped_name"));
+    }
+
+    // The scoped name was the only one in the table, so a new name can only
+    // get its ID if the table was emptied
+    EXPECT_THAT(AtomTable::intern("after_scope").id(), Eq(atom.id()));
+}
+
+TEST(NAME, cached_atoms_are_forgotten_when_table_is_cleared)
+{
+    AtomTable::clear();
+    Atom before = AtomTable::intern("cached_name");
+    AtomTable::clear();
+    Atom other = AtomTable::intern("other_name");
+    Atom after = AtomTable::intern("Cached_Name");
+
+    // The other name reuses the ID of the cached one, so a stale cache entry
+    // would return the wrong atom
+    EXPECT_THAT(other.id(), Eq(before.id()));
+    EXPECT_THAT(after, Ne(other));
+    EXPECT_THAT(std::string(AtomTable::name(after)), StrEq("cached_name"));
+}
+
+TEST(NAME, functions_and_labels_are_resolved_ignoring_case)
+{
+    cmd::CommandIndex cmdIndex;
+    cmd::CommandMatcher matcher;
+    db::StringParserDriver driver;
+    Reference<Block> block = driver.parse("test",
+        "x = twice() + TWICE()\n"
+        "goto Done\n"
+        "x = 0\n"
+        "DONE:\n"
+        "function Twice()\n"
+        "endfunction 2\n",
+        matcher);
+    ASSERT_THAT(block, NotNull());
+    auto program = ir::runSemanticChecks(block, cmdIndex);
+    ASSERT_THAT(program, NotNull());
+
+    ASSERT_THAT(program->functions().size(), Eq(1u));
+    const ir::FunctionDefinition* twice = program->functions()[0].get();
+    const ir::StatementBlock& statements = program->mainFunction().statements();
+    ASSERT_THAT(statements.size(), Eq(4u));
+
+    // Skips the casts the semantic checks add around the calls
+    auto uncast = [](const ir::Expression* e) {
+        while (e->kind() == ir::ExpressionKind::Cast)
+            e = static_cast<const ir::CastExpression*>(e)->expression();
+        return e;
+    };
+    auto* assignment = static_cast<const ir::VarAssignment*>(statements[0].get());
+    auto* sum = static_cast<const ir::BinaryExpression*>(uncast(assignment->expression()));
+    ASSERT_THAT(sum->kind(), Eq(ir::ExpressionKind::Binary));
+    for (const ir::Expression* operand : {uncast(sum->left()), uncast(sum->right())})
+    {
+        ASSERT_THAT(operand->kind(), Eq(ir::ExpressionKind::FunctionCall));
+        EXPECT_THAT(static_cast<const ir::FunctionCallExpression*>(operand)->userFunction(), Eq(twice));
+    }
+
+    auto* jump = static_cast<const ir::Goto*>(statements[1].get());
+    ASSERT_THAT(jump->kind(), Eq(ir::StatementKind::Goto));
+    EXPECT_THAT(jump->label(), Eq(statements[3].get()));
+}
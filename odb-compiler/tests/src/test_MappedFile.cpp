@@ -0,0 +1,94 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/SourceFileTable.hpp"
+#include "odb-sdk/MappedFile.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <cstdio>
+#include <string>
+
+#define NAME MappedFile
+
+using namespace testing;
+
+class NAME : public Test
+{
+public:
+    void SetUp() override { fileName_ = std::tmpnam(nullptr); }
+    void TearDown() override { std::remove(fileName_.c_str()); }
+
+    void writeFile(const std::string& contents)
+    {
+        FILE* fp = fopen(fileName_.c_str(), "wb");
+        ASSERT_THAT(fp, NotNull());
+        fwrite(contents.data(), 1, contents.size(), fp);
+        fclose(fp);
+    }
+
+    std::string fileName_;
+};
+
+TEST_F(NAME, missing_file_returns_null)
+{
+    EXPECT_THAT(odb::MappedFile::open(fileName_.c_str()), IsNull());
+}
+
+TEST_F(NAME, contents_match_file)
+{
+    writeFile("print \"hello\"\n");
+    odb::Reference<odb::MappedFile> file = odb::MappedFile::open(fileName_.c_str(), 2);
+    ASSERT_THAT(file.get(), NotNull());
+    EXPECT_THAT(file->size(), Eq(14u));
+    EXPECT_THAT(std::string(file->data(), file->size()), StrEq("print \"hello\"\n"));
+    EXPECT_THAT(file->data()[14], Eq('\0'));
+    EXPECT_THAT(file->data()[15], Eq('\0'));
+}
+
+TEST_F(NAME, padding_is_zero_when_file_fills_last_page)
+{
+    std::string contents(4096, 'x');
+    writeFile(contents);
+    odb::Reference<odb::MappedFile> file = odb::MappedFile::open(fileName_.c_str(), 2);
+    ASSERT_THAT(file.get(), NotNull());
+    ASSERT_THAT(file->size(), Eq(4096u));
+    EXPECT_THAT(file->data()[4096], Eq('\0'));
+    EXPECT_THAT(file->data()[4097], Eq('\0'));
+}
+
+TEST_F(NAME, empty_file_has_padding)
+{
+    writeFile("");
+    odb::Reference<odb::MappedFile> file = odb::MappedFile::open(fileName_.c_str(), 2);
+    ASSERT_THAT(file.get(), NotNull());
+    EXPECT_THAT(file->size(), Eq(0u));
+    EXPECT_THAT(file->data()[0], Eq('\0'));
+    EXPECT_THAT(file->data()[1], Eq('\0'));
+}
+
+TEST_F(NAME, writes_are_not_visible_in_file)
+{
+    writeFile("abc");
+    {
+        odb::Reference<odb::MappedFile> file = odb::MappedFile::open(fileName_.c_str());
+        ASSERT_THAT(file.get(), NotNull());
+        file->data()[0] = '\0';
+    }
+    odb::Reference<odb::MappedFile> file = odb::MappedFile::open(fileName_.c_str());
+    ASSERT_THAT(file.get(), NotNull());
+    EXPECT_THAT(std::string(file->data(), file->size()), StrEq("abc"));
+}
+
+TEST_F(NAME, source_file_table_serves_mapped_text)
+{
+    writeFile("print 1\nprint 2\n");
+    odb::ast::SourceFileId id;
+    {
+        odb::Reference<odb::MappedFile> file = odb::MappedFile::open(fileName_.c_str());
+        ASSERT_THAT(file.get(), NotNull());
+        id = odb::ast::SourceFileTable::addFile(fileName_, file);
+    }
+
+    // The table keeps the mapping alive
+    std::string_view line;
+    ASSERT_THAT(odb::ast::SourceFileTable::line(id, 2, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq("print 2"));
+    odb::ast::SourceFileTable::release(id);
+}
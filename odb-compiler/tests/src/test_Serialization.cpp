@@ -0,0 +1,155 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/ASTCache.hpp"
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/ast/Serialization.hpp"
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-compiler/ast/Statement.hpp"
+#include "odb-compiler/commands/Command.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-compiler/tests/ParserTestHarness.hpp"
+#include <filesystem>
+
+#define NAME ast_serialization
+
+using namespace testing;
+using namespace odb;
+using namespace ast;
+
+class NAME : public ParserTestHarness
+{
+public:
+    // Round trips the AST and checks that writing the result again produces
+    // the exact same bytes, which covers every node type, value and location
+    // that appears in the source
+    void expectRoundTrip(const char* code)
+    {
+        ast = driver->parse("test", code, matcher);
+        ASSERT_THAT(ast, NotNull());
+
+        std::vector<uint8_t> data;
+        serialize(&data, ast);
+        Reference<Node> copy = deserialize(data.data(), data.size());
+        ASSERT_THAT(copy, NotNull());
+
+        std::vector<uint8_t> data2;
+        serialize(&data2, copy);
+        EXPECT_THAT(data2, ContainerEq(data));
+
+        ast = dynamic_cast<Block*>(copy.get());
+        ASSERT_THAT(ast, NotNull());
+    }
+};
+
+TEST_F(NAME, literals)
+{
+    expectRoundTrip(
+        "#constant mybool true\n"
+        "#constant myint 2147483647\n"
+        "#constant mydouble 5.2\n"
+        "#constant mystring \"hello world!\"\n"
+        "#constant mycomplex 1 + 2i\n"
+        "a = 5\n"
+        "b = 5000000000\n");
+}
+
+TEST_F(NAME, declarations)
+{
+    expectRoundTrip(
+        "global var# as double float = 5.4\n"
+        "local dim arr(2, 3) as word\n"
+        "type udt\n"
+        "    local var as integer\n"
+        "    local dim arr(2, 3) as byte\n"
+        "endtype\n"
+        "a.b.c(x) = value\n"
+        "inc a, b+c\n");
+}
+
+TEST_F(NAME, control_flow)
+{
+    expectRoundTrip(
+        "function myfunc(a, b)\n"
+        "    if a = 3 then foo() else bar()\n"
+        "    if a = 3\n"
+        "        foo1()\n"
+        "    endif\n"
+        "endfunction a+b\n"
+        "for n=1 to 5\nfoo(n)\nnext n\n"
+        "while cond\nexit\nendwhile\n"
+        "repeat\n    foo()\nuntil cond\n"
+        "do\nloop\n"
+        "select var1\n"
+        "    case var2\n"
+        "    endcase\n"
+        "    case default\n"
+        "    endcase\n"
+        "endselect\n"
+        "goto label\n"
+        "label:\n"
+        "    foo()\n"
+        "return\n");
+}
+
+TEST_F(NAME, commands)
+{
+    cmdIndex.addCommand(new cmd::Command(nullptr, "make object sphere", "", cmd::Command::Type::Void, {}));
+    matcher.updateFromIndex(&cmdIndex);
+    expectRoundTrip("make object sphere 1, 10\n");
+}
+
+TEST_F(NAME, locations_are_preserved)
+{
+    expectRoundTrip("a = 5\nb = a * 2\n");
+    Statement* stmnt = ast->statements()[1];
+    EXPECT_THAT(stmnt->location()->firstLine(), Eq(2));
+    EXPECT_THAT(stmnt->location()->getFileLineColumn(), StrEq("test:2:1"));
+}
+
+TEST_F(NAME, truncated_data_is_rejected)
+{
+    ast = driver->parse("test", "a = 5\nfor n = 1 to 10\nprint n\nnext n\n", matcher);
+    ASSERT_THAT(ast, NotNull());
+
+    std::vector<uint8_t> data;
+    serialize(&data, ast);
+    for (size_t size = 0; size < data.size(); ++size)
+        EXPECT_THAT(deserialize(data.data(), size), IsNull()) << "size " << size;
+}
+
+TEST_F(NAME, wrong_version_is_rejected)
+{
+    ast = driver->parse("test", "a = 5\n", matcher);
+    ASSERT_THAT(ast, NotNull());
+
+    std::vector<uint8_t> data;
+    serialize(&data, ast);
+    data[6]++;
+    EXPECT_THAT(deserialize(data.data(), data.size()), IsNull());
+}
+
+TEST_F(NAME, cache_hits_only_for_same_source_and_commands)
+{
+    const char* code = "a = 5\n";
+    ast = driver->parse("test", code, matcher);
+    ASSERT_THAT(ast, NotNull());
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "odb-ast-cache-test";
+    std::filesystem::remove_all(dir);
+
+    ASTCache cache(dir, cmdIndex);
+    EXPECT_THAT(cache.load("test", code), IsNull());
+    ASSERT_THAT(cache.store("test", code, ast), IsTrue());
+
+    Reference<Block> cached = cache.load("test", code);
+    ASSERT_THAT(cached, NotNull());
+    EXPECT_THAT(cached->statements().size(), Eq(1u));
+
+    EXPECT_THAT(cache.load("test", "a = 6\n"), IsNull());
+    EXPECT_THAT(cache.load("other", code), IsNull());
+
+    cmdIndex.addCommand(new cmd::Command(nullptr, "a", "", cmd::Command::Type::Void, {}));
+    ASTCache otherCommands(dir, cmdIndex);
+    EXPECT_THAT(otherCommands.load("test", code), IsNull());
+
+    std::filesystem::remove_all(dir);
+}
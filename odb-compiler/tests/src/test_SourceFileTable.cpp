@@ -0,0 +1,157 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/SourceFileTable.hpp"
+#include "odb-compiler/ast/SourceLocation.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <cstdio>
+
+#define NAME SourceFileTable
+
+using namespace testing;
+using namespace odb;
+using namespace odb::ast;
+
+TEST(NAME, identical_sources_are_stored_once)
+{
+    SourceFileId id1 = SourceFileTable::addString("interned", "print 1\nprint 2\n");
+    SourceFileId id2 = SourceFileTable::addString("interned", "print 1\nprint 2\n");
+    EXPECT_THAT(id1, Eq(id2));
+    SourceFileTable::release(id1);
+    SourceFileTable::release(id2);
+}
+
+TEST(NAME, changed_sources_get_new_entry)
+{
+    SourceFileId id1 = SourceFileTable::addString("changed", "print 1\n");
+    SourceFileId id2 = SourceFileTable::addString("changed", "print 2\n");
+    EXPECT_THAT(id1, Ne(id2));
+
+    std::string_view text;
+    ASSERT_THAT(SourceFileTable::text(id1, &text), IsTrue());
+    EXPECT_THAT(std::string(text), StrEq("print 1\n"));
+    ASSERT_THAT(SourceFileTable::text(id2, &text), IsTrue());
+    EXPECT_THAT(std::string(text), StrEq("print 2\n"));
+    SourceFileTable::release(id1);
+    SourceFileTable::release(id2);
+}
+
+TEST(NAME, locations_share_source_text)
+{
+    InlineSourceLocation sl1("shared", "some command 1, 2, 3", 1, 1, 1, 5);
+    InlineSourceLocation sl2("shared", "some command 1, 2, 3", 1, 1, 6, 13);
+    EXPECT_THAT(sl1.fileId(), Eq(sl2.fileId()));
+    EXPECT_THAT(SourceFileTable::name(sl1.fileId()), StrEq("shared"));
+}
+
+TEST(NAME, file_is_loaded_lazily)
+{
+    const char* fileName = "test_SourceFileTable_lazy.dba";
+    FILE* fp = fopen(fileName, "w");
+    ASSERT_THAT(fp, NotNull());
+    fputs("print \"hello\"\n", fp);
+    fclose(fp);
+
+    FileSourceLocation sl(fileName, 1, 1, 7, 14);
+    remove(fileName);
+
+    // The file was deleted before anything tried to read it
+    std::vector<std::string> sh = sl.getUnderlinedSection();
+    EXPECT_THAT(sh[0], StrEq("(source file was removed)"));
+}
+
+TEST(NAME, preloaded_file_does_not_touch_disk)
+{
+    SourceFileId id = SourceFileTable::addFile("does/not/exist.dba", "print \"hello\"\n");
+    SourceLocation sl(id, 1, 1, 7, 14);
+    SourceFileTable::release(id);
+
+    std::vector<std::string> sh = sl.getUnderlinedSection();
+    EXPECT_THAT(sh[0], StrEq("print \"hello\""));
+    EXPECT_THAT(sh[1], StrEq("      ^~~~~~~"));
+}
+
+TEST(NAME, line_lookup)
+{
+    SourceFileId id = SourceFileTable::addString("lines", "first\n\nthird\nlast");
+
+    std::string_view line;
+    ASSERT_THAT(SourceFileTable::line(id, 1, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq("first"));
+    ASSERT_THAT(SourceFileTable::line(id, 2, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq(""));
+    ASSERT_THAT(SourceFileTable::line(id, 3, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq("third"));
+    ASSERT_THAT(SourceFileTable::line(id, 4, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq("last"));
+    EXPECT_THAT(SourceFileTable::line(id, 5, &line), IsFalse());
+    EXPECT_THAT(SourceFileTable::line(id, 0, &line), IsFalse());
+    SourceFileTable::release(id);
+}
+
+TEST(NAME, trailing_newline_is_followed_by_empty_line)
+{
+    SourceFileId id = SourceFileTable::addString("trailing", "first\n");
+
+    std::string_view line;
+    ASSERT_THAT(SourceFileTable::line(id, 2, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq(""));
+    EXPECT_THAT(SourceFileTable::line(id, 3, &line), IsFalse());
+    SourceFileTable::release(id);
+}
+
+TEST(NAME, line_index_from_lexer_is_used)
+{
+    SourceFileId id = SourceFileTable::addString("lexed", "a\nbb\nccc");
+    SourceFileTable::setLineIndex(id, {0, 2, 5});
+
+    std::string_view line;
+    ASSERT_THAT(SourceFileTable::line(id, 2, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq("bb"));
+    ASSERT_THAT(SourceFileTable::line(id, 3, &line), IsTrue());
+    EXPECT_THAT(std::string(line), StrEq("ccc"));
+    SourceFileTable::release(id);
+}
+
+TEST(NAME, source_is_removed_with_last_location)
+{
+    int count = SourceFileTable::count();
+    {
+        SourceFileId id = SourceFileTable::addString("removed", "print 1\n");
+        Reference<SourceLocation> sl1 = new SourceLocation(id, 1, 1, 1, 6);
+        Reference<SourceLocation> sl2 = new SourceLocation(id, 1, 1, 7, 8);
+        SourceFileTable::release(id);
+        EXPECT_THAT(SourceFileTable::count(), Eq(count + 1));
+
+        sl1.reset();
+        EXPECT_THAT(SourceFileTable::count(), Eq(count + 1));
+        EXPECT_THAT(SourceFileTable::name(sl2->fileId()), StrEq("removed"));
+    }
+    EXPECT_THAT(SourceFileTable::count(), Eq(count));
+}
+
+TEST(NAME, adding_source_again_keeps_it)
+{
+    SourceFileId id1 = SourceFileTable::addString("kept", "print 1\n");
+    SourceFileId id2 = SourceFileTable::addString("kept", "print 1\n");
+    SourceFileTable::release(id1);
+
+    std::string_view text;
+    ASSERT_THAT(SourceFileTable::text(id2, &text), IsTrue());
+    EXPECT_THAT(std::string(text), StrEq("print 1\n"));
+    SourceFileTable::release(id2);
+}
+
+TEST(NAME, removed_ids_are_reused)
+{
+    SourceFileId id1 = SourceFileTable::addString("first", "print 1\n");
+    SourceFileTable::release(id1);
+    SourceFileId id2 = SourceFileTable::addString("second", "print 2\n");
+    EXPECT_THAT(id2, Eq(id1));
+
+    // The old source can't be found under its name anymore
+    SourceFileId id3 = SourceFileTable::addString("first", "print 1\n");
+    EXPECT_THAT(id3, Ne(id2));
+    EXPECT_THAT(SourceFileTable::name(id2), StrEq("second"));
+    EXPECT_THAT(SourceFileTable::name(id3), StrEq("first"));
+    SourceFileTable::release(id2);
+    SourceFileTable::release(id3);
+}
@@ -0,0 +1,77 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-compiler/Stats.hpp"
+
+#define NAME compiler_stats
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public Test
+{
+public:
+    void SetUp() override { Stats::reset(); }
+    void TearDown() override
+    {
+        Stats::setEnabled(false);
+        Stats::reset();
+    }
+
+    cmd::CommandMatcher matcher;
+};
+
+TEST_F(NAME, nothing_is_recorded_while_disabled)
+{
+    db::StringParserDriver driver;
+    Reference<ast::Block> ast = driver.parse("test", "x = 1 + 2\n", matcher);
+    ASSERT_THAT(ast, NotNull());
+    {
+        PhaseTimer timer("phase");
+    }
+
+    EXPECT_THAT(Stats::get(Stats::TokensLexed), Eq(0u));
+    EXPECT_THAT(Stats::get(Stats::ASTNodes), Eq(0u));
+    EXPECT_THAT(Stats::timings(), IsEmpty());
+}
+
+TEST_F(NAME, parse_counts_tokens_and_nodes)
+{
+    Stats::setEnabled(true);
+    db::StringParserDriver driver;
+    Reference<ast::Block> ast = driver.parse("test", "x = 1 + 2\n", matcher);
+    ASSERT_THAT(ast, NotNull());
+
+    // x, =, 1, +, 2, newline, end
+    EXPECT_THAT(Stats::get(Stats::TokensLexed), Eq(7u));
+    EXPECT_THAT(Stats::get(Stats::CommandLookups), Gt(0u));
+    EXPECT_THAT(Stats::get(Stats::ASTNodes), Gt(0u));
+    EXPECT_THAT(Stats::get(Stats::ASTAllocations), Gt(Stats::get(Stats::ASTNodes)));
+    EXPECT_THAT(Stats::get(Stats::ASTBytes), Gt(Stats::get(Stats::ASTAllocations)));
+}
+
+TEST_F(NAME, phase_timer_records_phase_and_file)
+{
+    Stats::setEnabled(true);
+    {
+        PhaseTimer timer("phase");
+        PhaseTimer fileTimer("parse", "test.dba");
+    }
+
+    std::vector<Stats::Timing> timings = Stats::timings();
+    ASSERT_THAT(timings.size(), Eq(2u));
+    EXPECT_THAT(timings[0].phase, StrEq("parse"));
+    EXPECT_THAT(timings[0].file, StrEq("test.dba"));
+    EXPECT_THAT(timings[1].phase, StrEq("phase"));
+    EXPECT_THAT(timings[1].file, IsEmpty());
+    EXPECT_THAT(timings[1].wallSeconds, Ge(0.0));
+    EXPECT_THAT(timings[1].cpuSeconds, Ge(0.0));
+}
+
+TEST_F(NAME, counter_keys_are_unique)
+{
+    for (int i = 0; i != Stats::COUNTER_COUNT; ++i)
+        for (int j = i + 1; j != Stats::COUNTER_COUNT; ++j)
+            EXPECT_THAT(Stats::key((Stats::Counter)i), StrNe(Stats::key((Stats::Counter)j)));
+}
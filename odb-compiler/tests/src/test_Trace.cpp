@@ -0,0 +1,90 @@
+#include "gmock/gmock.h"
+#include "odb-compiler/ast/Block.hpp"
+#include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
+#include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-compiler/Trace.hpp"
+#include <thread>
+
+#define NAME compiler_trace
+
+using namespace testing;
+using namespace odb;
+
+class NAME : public Test
+{
+public:
+    void SetUp() override { Trace::reset(); }
+    void TearDown() override
+    {
+        Trace::setEnabled(false);
+        Trace::reset();
+    }
+};
+
+TEST_F(NAME, nothing_is_recorded_while_disabled)
+{
+    {
+        TraceScope trace("test", "scope");
+    }
+    EXPECT_THAT(Trace::events(), IsEmpty());
+}
+
+TEST_F(NAME, nested_scopes_are_recorded_inside_each_other)
+{
+    Trace::setEnabled(true);
+    {
+        TraceScope outer("test", "outer");
+        TraceScope inner("test", "inner", "detail");
+    }
+
+    std::vector<Trace::Event> events = Trace::events();
+    ASSERT_THAT(events.size(), Eq(2u));
+    EXPECT_THAT(events[0].name, StrEq("inner detail"));
+    EXPECT_THAT(events[1].name, StrEq("outer"));
+    EXPECT_THAT(events[0].category, StrEq("test"));
+    EXPECT_THAT(events[0].startMicros, Ge(events[1].startMicros));
+    EXPECT_THAT(events[0].startMicros + events[0].durationMicros,
+                Le(events[1].startMicros + events[1].durationMicros));
+    EXPECT_THAT(events[0].threadId, Eq(events[1].threadId));
+}
+
+TEST_F(NAME, threads_have_different_ids)
+{
+    Trace::setEnabled(true);
+    {
+        TraceScope trace("test", "main thread");
+    }
+    std::thread thread([] { TraceScope trace("test", "other thread"); });
+    thread.join();
+
+    std::vector<Trace::Event> events = Trace::events();
+    ASSERT_THAT(events.size(), Eq(2u));
+    EXPECT_THAT(events[0].threadId, Ne(events[1].threadId));
+}
+
+TEST_F(NAME, each_function_conversion_is_recorded)
+{
+    cmd::CommandIndex cmdIndex;
+    cmd::CommandMatcher matcher;
+    db::StringParserDriver driver;
+    Reference<ast::Block> ast = driver.parse("test",
+        "x = 1\n"
+        "function foo()\n"
+        "endfunction 1\n"
+        "function bar()\n"
+        "endfunction 2\n",
+        matcher);
+    ASSERT_THAT(ast, NotNull());
+
+    Trace::setEnabled(true);
+    ASSERT_THAT(ir::runSemanticChecks(ast, cmdIndex), NotNull());
+
+    std::vector<std::string> names;
+    for (const Trace::Event& event : Trace::events())
+        if (std::string(event.category) == "semantic")
+            names.push_back(event.name);
+    EXPECT_THAT(names, Contains(StrEq("convert function foo")));
+    EXPECT_THAT(names, Contains(StrEq("convert function bar")));
+}
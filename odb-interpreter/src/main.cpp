@@ -1,27 +1,244 @@
-#include "odb-compiler/parsers/db/Driver.hpp"
-#include "odb-compiler/commands/Command.hpp"
+#include "odb-compiler/ast/Atom.hpp"
+#include "odb-compiler/ast/Block.hpp"
 #include "odb-compiler/commands/CommandIndex.hpp"
+#include "odb-compiler/commands/CommandMatcher.hpp"
 #include "odb-compiler/commands/ODBCommandLoader.hpp"
-#include "odb-compiler/commands/SDKType.hpp"
-#include "odb-sdk/DynamicLibrary.hpp"
+#include "odb-compiler/ir/Bytecode.hpp"
+#include "odb-compiler/ir/Interpreter.hpp"
+#include "odb-compiler/ir/JIT.hpp"
+#include "odb-compiler/ir/SemanticChecker.hpp"
+#include "odb-compiler/irpost/Process.hpp"
+#include "odb-compiler/parsers/db/Driver.hpp"
+#include "odb-sdk/FileSystem.hpp"
 #include "odb-sdk/Log.hpp"
+#include "odb-sdk/MappedFile.hpp"
+#include "odb-sdk/Reference.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace odb;
+
+namespace {
+struct Options
+{
+    std::filesystem::path sdkRoot;
+    std::vector<std::filesystem::path> pluginDirs;
+    std::vector<std::string> files;
+    std::string emitBytecode;
+    ir::OptimizationLevel optimizationLevel = ir::OptimizationLevel::O0;
+    int tierUpThreshold = 1000;
+    bool jitOnly = false;
+    bool runBytecode = false;
+};
+} // namespace
+
+// ----------------------------------------------------------------------------
+static void printUsage(const char* programName)
+{
+    Log::info.print("Usage: %s [options] <file.dba> [files...]\n", programName);
+    Log::info.print("  --sdk-root <path>  Path to the ODB SDK. Defaults to the odb-sdk folder next to %s\n",
+                    programName);
+    Log::info.print("  --plugins <path>   Additional directory to scan for plugins. Can be repeated\n");
+    Log::info.print("  -O<0|1|2|3|s>      Optimization level. Defaults to 0\n");
+    Log::info.print("  --tier-up <n>      Compile a function once it was called or looped this many times.\n");
+    Log::info.print("                     0 never compiles. Defaults to 1000. The main program and\n");
+    Log::info.print("                     functions that return a value are always interpreted\n");
+    Log::info.print("  --jit              Compile the whole program before running it\n");
+    Log::info.print("  --emit-bytecode <file>\n");
+    Log::info.print("                     Write the program's bytecode to a file before running it\n");
+    Log::info.print("  --bytecode         The input is a bytecode file written with --emit-bytecode\n");
+}
+
+// ----------------------------------------------------------------------------
+static bool parseOptimizationLevel(const char* level, ir::OptimizationLevel* result)
+{
+    if (strcmp(level, "0") == 0)
+        *result = ir::OptimizationLevel::O0;
+    else if (strcmp(level, "1") == 0)
+        *result = ir::OptimizationLevel::O1;
+    else if (strcmp(level, "2") == 0)
+        *result = ir::OptimizationLevel::O2;
+    else if (strcmp(level, "3") == 0)
+        *result = ir::OptimizationLevel::O3;
+    else if (strcmp(level, "s") == 0)
+        *result = ir::OptimizationLevel::Os;
+    else
+        return false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static bool parseCommandLine(int argc, char** argv, Options* options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--sdk-root") == 0 && i + 1 < argc)
+            options->sdkRoot = argv[++i];
+        else if (strcmp(argv[i], "--plugins") == 0 && i + 1 < argc)
+            options->pluginDirs.emplace_back(argv[++i]);
+        else if (strcmp(argv[i], "--tier-up") == 0 && i + 1 < argc)
+            options->tierUpThreshold = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--jit") == 0)
+            options->jitOnly = true;
+        else if (strcmp(argv[i], "--emit-bytecode") == 0 && i + 1 < argc)
+            options->emitBytecode = argv[++i];
+        else if (strcmp(argv[i], "--bytecode") == 0)
+            options->runBytecode = true;
+        else if (strncmp(argv[i], "-O", 2) == 0)
+        {
+            if (!parseOptimizationLevel(argv[i] + 2, &options->optimizationLevel))
+            {
+                Log::info.print("Error: Unknown optimization level `%s`\n", argv[i]);
+                return false;
+            }
+        }
+        else if (argv[i][0] == '-')
+        {
+            Log::info.print("Error: Unrecognized option `%s`\n", argv[i]);
+            return false;
+        }
+        else
+            options->files.emplace_back(argv[i]);
+    }
+
+    if (options->files.empty())
+        return false;
+
+    if (options->sdkRoot.empty())
+        options->sdkRoot = FileSystem::getPathToSelf().replace_filename("odb-sdk");
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ----------------------------------------------------------------------------
+static bool writeBytecode(const std::string& fileName, const ir::Program& program)
+{
+    auto module = ir::generateBytecode(program);
+    if (!module)
+    {
+        Log::info.print("Error: The program can't be expressed as bytecode\n");
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    ir::serializeBytecode(&data, *module);
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out.write(reinterpret_cast<const char*>(data.data()), data.size()))
+    {
+        Log::info.print("Error: Failed to write `%s`\n", fileName.c_str());
+        return false;
+    }
+    return true;
+}
 
-#include <iostream>
+// ----------------------------------------------------------------------------
+static int runBytecodeFile(const std::string& fileName, const cmd::CommandIndex& cmdIndex)
+{
+    Reference<MappedFile> file = MappedFile::open(fileName.c_str());
+    if (file.isNull())
+    {
+        Log::info.print("Error: Failed to open `%s`\n", fileName.c_str());
+        return 1;
+    }
 
+    auto module = ir::deserializeBytecode(file->data(), file->size());
+    if (!module)
+    {
+        Log::info.print("Error: `%s` isn't a bytecode file of this version\n", fileName.c_str());
+        return 1;
+    }
+
+    auto interpreter = ir::Interpreter::load(*module, cmdIndex);
+    if (!interpreter)
+        return 1;
+    return interpreter->run();
+}
+
+// ----------------------------------------------------------------------------
 int main(int argc, char** argv)
 {
-    std::cout << "Loading plugin..." << std::endl;
-    auto p = odb::DynamicLibrary::open("odb-sdk/plugins/test-plugin/test-plugin.so");
-    if (p == nullptr)
+    Options options;
+    if (!parseCommandLine(argc, argv, &options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Declared first so the identifiers outlive every AST and IR built below
+    ast::AtomTable::Scope atoms;
+
+    auto start = std::chrono::steady_clock::now();
+
+    cmd::CommandIndex cmdIndex;
+    cmd::ODBCommandLoader loader(options.sdkRoot, options.pluginDirs);
+    if (!loader.populateIndex(&cmdIndex) || cmdIndex.findConflicts())
         return 1;
+    cmd::CommandMatcher cmdMatcher;
+    cmdMatcher.updateFromIndex(&cmdIndex);
+    double loadTime = millisecondsSince(start);
 
-    std::cout << "Reading commands..." << std::endl;
-    odb::cmd::CommandIndex cmdIndex;
-    odb::cmd::ODBCommandLoader loader("");
-    loader.populateIndexFromLibrary(&cmdIndex, p);
+    // Bytecode files don't need the parser or LLVM at all
+    if (options.runBytecode)
+        return runBytecodeFile(options.files.front(), cmdIndex);
+
+    // Files are merged in the order given, so the first file is where
+    // execution starts
+    auto parseStart = std::chrono::steady_clock::now();
+    Reference<ast::Block> ast;
+    db::FileParserDriver driver;
+    driver.setUseMemoryMap(true);
+    for (const auto& fileName : options.files)
+    {
+        Reference<ast::Block> block = driver.parse(fileName, cmdMatcher);
+        if (block == nullptr)
+            return 1;
+        if (ast == nullptr)
+            ast = block;
+        else
+            ast->merge(block);
+    }
+
+    auto program = ir::runSemanticChecks(ast, cmdIndex);
+    if (!program || !irpost::createDefaultProcessGroup().execute(program.get()))
+        return 1;
+    double parseTime = millisecondsSince(parseStart);
+
+    if (!options.emitBytecode.empty() && !writeBytecode(options.emitBytecode, *program))
+        return 1;
+
+    // Start in the interpreter, which only compiles hot functions. Programs
+    // the interpreter can't run are compiled up front instead.
+    auto compileStart = std::chrono::steady_clock::now();
+    std::unique_ptr<ir::Interpreter> interpreter;
+    if (!options.jitOnly)
+        interpreter = ir::Interpreter::compile(*program, cmdIndex);
+    if (interpreter)
+    {
+        interpreter->setTierUpThreshold(options.tierUpThreshold);
+        interpreter->setOptimizationLevel(options.optimizationLevel);
+        Log::info.print("Startup took %.1f ms (commands %.1f ms, parse %.1f ms, interpreter %.1f ms)\n",
+                        millisecondsSince(start), loadTime, parseTime, millisecondsSince(compileStart));
+        return interpreter->run();
+    }
+
+    auto jitProgram = ir::JITProgram::compile(*program, cmdIndex, options.optimizationLevel);
+    if (!jitProgram)
+        return 1;
 
-    for (const auto& name : cmdIndex.commandNamesAsList())
-        std::cout << name << std::endl;
+    Log::info.print("Startup took %.1f ms (commands %.1f ms, parse %.1f ms, JIT %.1f ms)\n",
+                    millisecondsSince(start), loadTime, parseTime, millisecondsSince(compileStart));
 
-    return 0;
+    return jitProgram->run();
 }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "odb-sdk/config.hpp"
+#include "odb-sdk/RefCounted.hpp"
+#include "odb-sdk/Reference.hpp"
+#include <cstddef>
+
+namespace odb {
+
+struct ArenaStorage;
+
+/*!
+ * @brief Bump allocator for objects that are created in bulk and share a
+ * common lifetime, such as all AST nodes produced by a single parse.
+ *
+ * Classes opt in by routing their operator new/delete through
+ * Arena::allocate() and Arena::deallocate(). If an arena is active on the
+ * calling thread (see ArenaScope), the memory comes from that arena, otherwise
+ * it comes from the heap.
+ *
+ * Heap allocations are passed straight to operator new without any extra
+ * bookkeeping. Arena allocations are recognized by the address range of the
+ * arena's blocks.
+ *
+ * Destructors still run as usual, so objects can keep using Reference<>.
+ * Deallocating an object only drops the reference it held on its arena's
+ * memory, which is counted atomically, so objects may be destroyed on any
+ * thread. The memory blocks are freed in bulk once the last object and the
+ * last Reference<Arena> are gone, so it is safe for objects to outlive the
+ * scope they were created in.
+ */
+class ODBSDK_PUBLIC_API Arena : public RefCounted
+{
+public:
+    explicit Arena(size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    /*!
+     * @brief Allocates memory from the arena active on the calling thread, or
+     * from the heap if there is none.
+     */
+    static void* allocate(size_t size);
+
+    /*!
+     * @brief Frees memory returned by allocate(). Works regardless of which
+     * thread or scope the memory was allocated in.
+     */
+    static void deallocate(void* ptr);
+
+    /*!
+     * @brief Returns the arena active on the calling thread, or nullptr.
+     */
+    static Arena* current();
+
+    int allocationCount() const;
+    int blockCount() const;
+    size_t bytesUsed() const;
+
+private:
+    void* allocateFromBlock(size_t size);
+
+private:
+    friend class ArenaScope;
+
+    ArenaStorage* storage_;
+};
+
+/*!
+ * @brief Makes an arena the active arena on the calling thread for as long as
+ * the scope exists. Scopes can be nested.
+ */
+class ODBSDK_PUBLIC_API ArenaScope
+{
+public:
+    explicit ArenaScope(Arena* arena);
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Reference<Arena> arena_;
+    Arena* previous_;
+};
+
+}
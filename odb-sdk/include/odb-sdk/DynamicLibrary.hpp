@@ -3,6 +3,7 @@
 #include "odb-sdk/config.hpp"
 #include "odb-sdk/RefCounted.hpp"
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -23,8 +24,23 @@ public:
      */
     static DynamicLibrary* open(const char* filename);
 
+    /*!
+     * @brief Creates a handle to a shared library or DLL without loading it.
+     * The library is loaded the first time one of its symbols is accessed,
+     * which lets code that only needs the file name (e.g. code generation)
+     * skip the cost of loading it. This never fails, but if loading fails
+     * later, the library behaves as if it had no symbols.
+     */
+    static DynamicLibrary* openDeferred(const char* filename);
+
     const char* getFilename() const;
 
+    /*!
+     * @brief Returns true if the library was loaded successfully. Libraries
+     * created with openDeferred() are loaded by this call if necessary.
+     */
+    bool isLoaded() const;
+
     /*!
      * @brief Looks up the address of a given symbol in the shared library or
      * DLL. This is equivalent to calling dlsym() on linux and GetProcAddress()
@@ -42,6 +58,14 @@ public:
      */
     const char* getSymbolAt(int idx) const;
 
+    /*!
+     * @brief Returns the address of the symbol at the specified index in the
+     * symbol table, or nullptr if the symbol is undefined. The value is read
+     * straight from the symbol table, which is much cheaper than looking the
+     * symbol up by name with lookupSymbolAddress().
+     */
+    void* getSymbolAddressAt(int idx) const;
+
     /*!
      * @brief Returns a copy of all strings in the string table.
      */
@@ -51,7 +75,10 @@ public:
 
 private:
     explicit DynamicLibrary(std::unique_ptr<DynLibPlatformData> data, const std::string& filename);
-    std::unique_ptr<DynLibPlatformData> data_;
+    bool load() const;
+
+    mutable std::unique_ptr<DynLibPlatformData> data_;
+    mutable std::once_flag loadFlag_;
     const std::string filename_;
 };
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "odb-sdk/config.hpp"
+#include "odb-sdk/RefCounted.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace odb {
+
+struct MappedFilePlatformData;
+
+/*!
+ * @brief Maps a file into memory so it can be read (and scanned) in place.
+ *
+ * The mapping is private and writable: modifications are never written back
+ * to the file and aren't visible to other mappings of the same file. The
+ * requested number of padding bytes directly following the file contents are
+ * guaranteed to be zero, which is what scanners like flex need to scan a
+ * buffer without copying it.
+ *
+ * On platforms without memory mapping support the file is read into a
+ * buffer instead, so callers don't need a fallback of their own.
+ */
+class ODBSDK_PUBLIC_API MappedFile : public RefCounted
+{
+public:
+    MappedFile() = delete;
+    ~MappedFile();
+
+    /*!
+     * @brief Maps the specified file with the given number of zeroed bytes
+     * appended to it.
+     * @return Returns nullptr on failure, otherwise returns a new instance of
+     * this class.
+     */
+    static MappedFile* open(const char* filename, size_t padding = 0);
+
+    const char* getFilename() const;
+
+    /*!
+     * @brief Start of the file contents. Always valid, even for empty files.
+     */
+    char* data() const;
+
+    /*!
+     * @brief Size of the file contents, not including the padding.
+     */
+    size_t size() const;
+
+private:
+    explicit MappedFile(std::unique_ptr<MappedFilePlatformData> data, const std::string& filename);
+    std::unique_ptr<MappedFilePlatformData> data_;
+    const std::string filename_;
+};
+
+}
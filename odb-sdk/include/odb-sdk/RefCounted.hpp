@@ -23,6 +23,7 @@
 #pragma once
 
 #include "odb-sdk/config.hpp"
+#include <cstddef>
 
 namespace odb {
 
@@ -44,6 +45,11 @@ struct ODBSDK_PUBLIC_API RefCount
         weakRefs_ = -1;
     }
 
+    /// Allocate from the active Arena, if any.
+    static void* operator new(size_t size);
+    /// Return memory to the Arena or heap it was allocated from.
+    static void operator delete(void* ptr);
+
     /// common::Reference< count. If below zero, the object has been destroyed.
     int refs_;
     /// Weak reference count.
@@ -0,0 +1,216 @@
+#include "odb-sdk/Arena.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <vector>
+
+namespace odb {
+
+// Allocations carry no header. Instead, every block an arena mallocs is
+// registered by address range, so deallocate() can tell arena memory apart
+// from heap memory. While no arena blocks exist the lookup is skipped
+// entirely.
+static constexpr size_t alignment = alignof(std::max_align_t);
+
+static thread_local Arena* currentArena_ = nullptr;
+
+// The blocks and bookkeeping of an arena. It is separate from Arena so that
+// it can outlive the last Reference<Arena>, and its refcount is atomic
+// because objects may be deallocated on any thread.
+struct ArenaStorage
+{
+    std::vector<char*> blocks;
+    char* head = nullptr;
+    size_t remaining = 0;
+    size_t blockSize;
+    size_t bytesUsed = 0;
+    int allocationCount = 0;
+    std::atomic<int> refs{1};
+};
+
+namespace {
+struct BlockRegistry
+{
+    std::shared_mutex mutex;
+    std::map<uintptr_t, std::pair<uintptr_t, ArenaStorage*>> blocks;
+    std::atomic<size_t> count{0};
+};
+}
+
+// ----------------------------------------------------------------------------
+static BlockRegistry& registry()
+{
+    // Never destroyed, so objects destroyed during static destruction can
+    // still be deallocated
+    static BlockRegistry* registry = new BlockRegistry;
+    return *registry;
+}
+
+// ----------------------------------------------------------------------------
+static size_t alignUp(size_t size)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// ----------------------------------------------------------------------------
+static char* newBlock(ArenaStorage* storage, size_t size)
+{
+    char* block = static_cast<char*>(malloc(size));
+    if (block == nullptr)
+        throw std::bad_alloc();
+
+    BlockRegistry& r = registry();
+    std::unique_lock<std::shared_mutex> lock(r.mutex);
+    r.blocks.emplace(reinterpret_cast<uintptr_t>(block),
+                     std::make_pair(reinterpret_cast<uintptr_t>(block) + size, storage));
+    r.count++;
+    storage->blocks.push_back(block);
+    return block;
+}
+
+// ----------------------------------------------------------------------------
+static void releaseStorage(ArenaStorage* storage)
+{
+    if (storage->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    BlockRegistry& r = registry();
+    {
+        std::unique_lock<std::shared_mutex> lock(r.mutex);
+        for (char* block : storage->blocks)
+            r.blocks.erase(reinterpret_cast<uintptr_t>(block));
+        r.count -= storage->blocks.size();
+    }
+
+    for (char* block : storage->blocks)
+        free(block);
+    delete storage;
+}
+
+// ----------------------------------------------------------------------------
+static ArenaStorage* findStorage(void* ptr)
+{
+    BlockRegistry& r = registry();
+    if (r.count.load(std::memory_order_acquire) == 0)
+        return nullptr;
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    std::shared_lock<std::shared_mutex> lock(r.mutex);
+    auto it = r.blocks.upper_bound(address);
+    if (it == r.blocks.begin())
+        return nullptr;
+    --it;
+    return address < it->second.first ? it->second.second : nullptr;
+}
+
+// ----------------------------------------------------------------------------
+Arena::Arena(size_t blockSize) :
+    storage_(new ArenaStorage)
+{
+    storage_->blockSize = blockSize;
+}
+
+// ----------------------------------------------------------------------------
+Arena::~Arena()
+{
+    releaseStorage(storage_);
+}
+
+// ----------------------------------------------------------------------------
+void* Arena::allocateFromBlock(size_t size)
+{
+    ArenaStorage* s = storage_;
+    if (size > s->remaining)
+    {
+        // Oversized allocations get their own block. The current block is
+        // kept, since it most likely still has room for smaller objects
+        if (size > s->blockSize)
+        {
+            char* block = newBlock(s, size);
+            s->bytesUsed += size;
+            s->allocationCount++;
+            return block;
+        }
+
+        s->head = newBlock(s, s->blockSize);
+        s->remaining = s->blockSize;
+    }
+
+    char* ptr = s->head;
+    s->head += size;
+    s->remaining -= size;
+    s->bytesUsed += size;
+    s->allocationCount++;
+    return ptr;
+}
+
+// ----------------------------------------------------------------------------
+void* Arena::allocate(size_t size)
+{
+    Arena* arena = currentArena_;
+    if (arena == nullptr)
+        return ::operator new(size);
+
+    // Zero sized allocations still need a unique address inside a block
+    void* ptr = arena->allocateFromBlock(alignUp(size ? size : 1));
+    arena->storage_->refs.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+// ----------------------------------------------------------------------------
+void Arena::deallocate(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    if (ArenaStorage* storage = findStorage(ptr))
+        releaseStorage(storage);
+    else
+        ::operator delete(ptr);
+}
+
+// ----------------------------------------------------------------------------
+Arena* Arena::current()
+{
+    return currentArena_;
+}
+
+// ----------------------------------------------------------------------------
+int Arena::allocationCount() const
+{
+    return storage_->allocationCount;
+}
+
+// ----------------------------------------------------------------------------
+int Arena::blockCount() const
+{
+    return (int)storage_->blocks.size();
+}
+
+// ----------------------------------------------------------------------------
+size_t Arena::bytesUsed() const
+{
+    return storage_->bytesUsed;
+}
+
+// ----------------------------------------------------------------------------
+ArenaScope::ArenaScope(Arena* arena) :
+    arena_(arena),
+    previous_(currentArena_)
+{
+    currentArena_ = arena;
+}
+
+// ----------------------------------------------------------------------------
+ArenaScope::~ArenaScope()
+{
+    assert(currentArena_ == arena_);
+    currentArena_ = previous_;
+}
+
+}
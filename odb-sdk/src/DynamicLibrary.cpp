@@ -23,6 +23,7 @@ struct DynLibPlatformData
 {
 #if defined(ODBSDK_PLATFORM_LINUX)
     void* handle;
+    ElfW(Addr) base = 0;
     const ElfW(Sym) * symtab = nullptr;
     const uint32_t* hashtab = nullptr;
     const uint32_t* gnuhashtab = nullptr;
@@ -36,7 +37,7 @@ struct DynLibPlatformData
 };
 
 // ----------------------------------------------------------------------------
-DynamicLibrary* DynamicLibrary::open(const char* filename)
+static std::unique_ptr<DynLibPlatformData> loadPlatformData(const char* filename)
 {
     auto data = std::make_unique<DynLibPlatformData>();
 
@@ -52,6 +53,9 @@ DynamicLibrary* DynamicLibrary::open(const char* filename)
         return nullptr;
     }
 
+    // Symbol values are relative to the address the library was loaded at
+    data->base = lm->l_addr;
+
     // Find dynamic symbol table and symbol hash table
     int entries_found = 0;
     for (const ElfW(Dyn)* dyn = lm->l_ld; dyn->d_tag != DT_NULL; ++dyn)
@@ -99,9 +103,25 @@ DynamicLibrary* DynamicLibrary::open(const char* filename)
     }
 #endif
 
+    return data;
+}
+
+// ----------------------------------------------------------------------------
+DynamicLibrary* DynamicLibrary::open(const char* filename)
+{
+    auto data = loadPlatformData(filename);
+    if (data == nullptr)
+        return nullptr;
+
     return new DynamicLibrary(std::move(data), filename);
 }
 
+// ----------------------------------------------------------------------------
+DynamicLibrary* DynamicLibrary::openDeferred(const char* filename)
+{
+    return new DynamicLibrary(nullptr, filename);
+}
+
 // ----------------------------------------------------------------------------
 DynamicLibrary::DynamicLibrary(std::unique_ptr<DynLibPlatformData> data, const std::string& filename)
     : data_(std::move(data)), filename_(filename)
@@ -111,6 +131,10 @@ DynamicLibrary::DynamicLibrary(std::unique_ptr<DynLibPlatformData> data, const s
 // ----------------------------------------------------------------------------
 DynamicLibrary::~DynamicLibrary()
 {
+    // Deferred libraries may never have been loaded
+    if (data_ == nullptr)
+        return;
+
 #if defined(ODBSDK_PLATFORM_LINUX)
     dlclose(data_->handle);
 #elif defined(ODBSDK_PLATFORM_MACOS)
@@ -126,9 +150,28 @@ const char* DynamicLibrary::getFilename() const
     return filename_.c_str();
 }
 
+// ----------------------------------------------------------------------------
+bool DynamicLibrary::load() const
+{
+    std::call_once(loadFlag_, [this]() {
+        if (data_ == nullptr)
+            data_ = loadPlatformData(filename_.c_str());
+    });
+    return data_ != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+bool DynamicLibrary::isLoaded() const
+{
+    return load();
+}
+
 // ----------------------------------------------------------------------------
 void* DynamicLibrary::lookupSymbolAddress(const char* name) const
 {
+    if (!load())
+        return nullptr;
+
 #if defined(ODBSDK_PLATFORM_LINUX)
     return dlsym(data_->handle, name);
 #elif defined(ODBSDK_PLATFORM_MACOS)
@@ -142,6 +185,9 @@ void* DynamicLibrary::lookupSymbolAddress(const char* name) const
 // ----------------------------------------------------------------------------
 int DynamicLibrary::getSymbolCount() const
 {
+    if (!load())
+        return 0;
+
 #if defined(ODBSDK_PLATFORM_LINUX)
     auto getSymbolCountInHashTable = [](const uint32_t* hashtab) -> int
     {
@@ -186,6 +232,9 @@ int DynamicLibrary::getSymbolCount() const
 // ----------------------------------------------------------------------------
 const char* DynamicLibrary::getSymbolAt(int idx) const
 {
+    if (!load())
+        return nullptr;
+
 #if defined(ODBSDK_PLATFORM_LINUX)
     const ElfW(Sym)* sym =
         reinterpret_cast<const ElfW(Sym)*>(reinterpret_cast<const char*>(data_->symtab) + data_->symsize * (idx + 1));
@@ -199,11 +248,34 @@ const char* DynamicLibrary::getSymbolAt(int idx) const
 #endif
 }
 
+// ----------------------------------------------------------------------------
+void* DynamicLibrary::getSymbolAddressAt(int idx) const
+{
+    if (!load())
+        return nullptr;
+
+#if defined(ODBSDK_PLATFORM_LINUX)
+    const ElfW(Sym)* sym =
+        reinterpret_cast<const ElfW(Sym)*>(reinterpret_cast<const char*>(data_->symtab) + data_->symsize * (idx + 1));
+
+    if (sym->st_shndx == SHN_UNDEF)
+        return nullptr;
+    return reinterpret_cast<void*>(data_->base + sym->st_value);
+#elif defined(ODBSDK_PLATFORM_MACOS)
+    // TODO
+    return nullptr;
+#elif defined(ODBSDK_PLATFORM_WIN32)
+    return nullptr;
+#endif
+}
+
 // ----------------------------------------------------------------------------
 #if defined(ODBSDK_PLATFORM_WIN32)
 std::vector<std::string> DynamicLibrary::getStringTable() const
 {
     std::vector<std::string> stringTable;
+    if (!load())
+        return stringTable;
 
     auto resourceCallback = [](HMODULE hModule, LPCSTR lpType, LPSTR lpName, LONG_PTR lParam) -> BOOL
     {
@@ -0,0 +1,131 @@
+#include "odb-sdk/MappedFile.hpp"
+#include <cstdio>
+#include <vector>
+
+#if defined(ODBSDK_PLATFORM_LINUX) || defined(ODBSDK_PLATFORM_MACOS)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#elif defined(ODBSDK_PLATFORM_WIN32)
+    // Files are read into a buffer
+#else
+#   error "Platform not supported"
+#endif
+
+namespace odb {
+
+struct MappedFilePlatformData
+{
+#if defined(ODBSDK_PLATFORM_LINUX) || defined(ODBSDK_PLATFORM_MACOS)
+    char* base = nullptr;
+    size_t mappedSize = 0;
+#elif defined(ODBSDK_PLATFORM_WIN32)
+    std::vector<char> buffer;
+#endif
+    size_t size = 0;
+};
+
+// ----------------------------------------------------------------------------
+MappedFile* MappedFile::open(const char* filename, size_t padding)
+{
+    auto data = std::make_unique<MappedFilePlatformData>();
+
+#if defined(ODBSDK_PLATFORM_LINUX) || defined(ODBSDK_PLATFORM_MACOS)
+    int fd = ::open(filename, O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // Reserve enough anonymous (zero-filled) memory for the file plus the
+    // padding, then map the file over the start of it. This guarantees the
+    // padding is zero even if the file size is a multiple of the page size,
+    // in which case there wouldn't be any slack at the end of the last page.
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    data->size = (size_t)st.st_size;
+    data->mappedSize = (data->size + padding + pageSize) & ~(pageSize - 1);
+    void* base = mmap(nullptr, data->mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+    data->base = static_cast<char*>(base);
+
+    if (data->size > 0)
+    {
+        base = mmap(data->base, data->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            munmap(data->base, data->mappedSize);
+            close(fd);
+            return nullptr;
+        }
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+#elif defined(ODBSDK_PLATFORM_WIN32)
+    FILE* fp = fopen(filename, "rb");
+    if (fp == nullptr)
+        return nullptr;
+
+    char chunk[4096];
+    size_t bytesRead;
+    while ((bytesRead = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        data->buffer.insert(data->buffer.end(), chunk, chunk + bytesRead);
+    bool failed = ferror(fp) != 0;
+    fclose(fp);
+    if (failed)
+        return nullptr;
+
+    data->size = data->buffer.size();
+    data->buffer.resize(data->size + padding + 1, '\0');
+#endif
+
+    return new MappedFile(std::move(data), filename);
+}
+
+// ----------------------------------------------------------------------------
+MappedFile::MappedFile(std::unique_ptr<MappedFilePlatformData> data, const std::string& filename)
+    : data_(std::move(data)), filename_(filename)
+{
+}
+
+// ----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+#if defined(ODBSDK_PLATFORM_LINUX) || defined(ODBSDK_PLATFORM_MACOS)
+    munmap(data_->base, data_->mappedSize);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+const char* MappedFile::getFilename() const
+{
+    return filename_.c_str();
+}
+
+// ----------------------------------------------------------------------------
+char* MappedFile::data() const
+{
+#if defined(ODBSDK_PLATFORM_LINUX) || defined(ODBSDK_PLATFORM_MACOS)
+    return data_->base;
+#elif defined(ODBSDK_PLATFORM_WIN32)
+    return data_->buffer.data();
+#endif
+}
+
+// ----------------------------------------------------------------------------
+size_t MappedFile::size() const
+{
+    return data_->size;
+}
+
+}
@@ -21,12 +21,25 @@
 //
 
 #include "odb-sdk/RefCounted.hpp"
+#include "odb-sdk/Arena.hpp"
 
 #include <cassert>
 #include <map>
 
 namespace odb {
 
+// ----------------------------------------------------------------------------
+void* RefCount::operator new(size_t size)
+{
+    return Arena::allocate(size);
+}
+
+// ----------------------------------------------------------------------------
+void RefCount::operator delete(void* ptr)
+{
+    Arena::deallocate(ptr);
+}
+
 // ----------------------------------------------------------------------------
 RefCounted::RefCounted() :
     refCount_(new RefCount())